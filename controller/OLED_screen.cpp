@@ -22,8 +22,6 @@ const int DIGIT_HEIGHT = 8;
 const int SCREEN_WIDTH  = 128;
 const int SCREEN_HEIGHT = 64;
 
-const unsigned long DISPLAY_UPD_PERIOD_MS = 100;
-
 const unsigned int STRINGS_IN_SCREEN = 5;
 
 struct rect screen[] = {
@@ -74,13 +72,13 @@ void handleMenu(int button_index) {
     Serial.println(msg);
 }
 
+// период - DISPLAY_UPD_PERIOD_MS, его выдерживает планировщик
 void display_regular_update() {
-    static unsigned long last_upd_ms = 0;
-    unsigned long now = millis();
-    if (now - last_upd_ms > DISPLAY_UPD_PERIOD_MS) {
-        display.display();
-        last_upd_ms = now;
-    }
+    display.display();
+}
+
+void OLED_screen_set_power(bool on) {
+    display.ssd1306_command(on ? SSD1306_DISPLAYON : SSD1306_DISPLAYOFF);
 }
 
 void prepare_rect(const struct rect* Rect) {
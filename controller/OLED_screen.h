@@ -1,9 +1,12 @@
 #pragma once
 
+const unsigned long DISPLAY_UPD_PERIOD_MS = 100;
+
 void OLED_screen_setup();
 
 void print_screen(String strings[], unsigned int count);
 void print_line(String str, unsigned int line_ind);
 void display_sensors();
 void display_regular_update();
+void OLED_screen_set_power(bool on);    // гасит панель, буфер сохраняется
 void handleMenu(int button_index);
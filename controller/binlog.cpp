@@ -0,0 +1,106 @@
+#include "binlog.h"
+#include "hal.h"
+#include <atomic>
+
+#if defined(ESP32)
+#include <Arduino.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+// кольцо =======================================================================================================================//
+//
+// Несколько писателей, один читатель. Писатель занимает номер записи CAS-ом по writeIndex
+// (только если кольцо не полно), заполняет ячейку и публикует ее, записав в seq номер + 1.
+// Читатель берет ячейку, только когда seq совпал, - недописанную запись он не увидит.
+
+struct BinlogSlot {
+    std::atomic<uint32_t> seq;
+    BinlogRecord record;
+};
+
+static BinlogSlot ring[BINLOG_RING_RECORDS];
+static std::atomic<uint32_t> writeIndex(0);
+static std::atomic<uint32_t> readIndex(0);
+static std::atomic<uint32_t> written(0);
+static std::atomic<uint32_t> dropped(0);
+static BinlogOutput output = BinlogOutput::BINARY;
+
+static_assert((BINLOG_RING_RECORDS & (BINLOG_RING_RECORDS - 1)) == 0, "ring size must be a power of two");
+
+void binlog_write_words(uint8_t level, BinlogEvent event, const uint32_t* args, int argCount) {
+    uint32_t index = writeIndex.load(std::memory_order_relaxed);
+    do {
+        if (index - readIndex.load(std::memory_order_acquire) >= (uint32_t)BINLOG_RING_RECORDS) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    } while (!writeIndex.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    BinlogSlot& slot = ring[index & (BINLOG_RING_RECORDS - 1)];
+    BinlogRecord& record = slot.record;
+    record.timestampUs = hal_micros();
+    record.event = (uint16_t)event;
+    record.level = level;
+    record.argCount = (argCount <= BINLOG_MAX_ARGS) ? argCount : BINLOG_MAX_ARGS;
+    memcpy(record.args, args, record.argCount * sizeof(uint32_t));
+    slot.seq.store(index + 1, std::memory_order_release);
+    written.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool binlog_take(BinlogRecord& record) {
+    uint32_t index = readIndex.load(std::memory_order_relaxed);
+    BinlogSlot& slot = ring[index & (BINLOG_RING_RECORDS - 1)];
+    if (slot.seq.load(std::memory_order_acquire) != index + 1) return false;
+    record = slot.record;
+    readIndex.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+// разбор =======================================================================================================================//
+
+int binlog_drain() {
+    BinlogRecord record;
+    int count = 0;
+    while (binlog_take(record)) {
+        if (output == BinlogOutput::BINARY) {
+            uint8_t frame[BINLOG_FRAME_MAX];
+            hal_write(frame, binlog_frame_encode(record, frame));   // кадр - одной записью, не рвется чужим print
+        } else {
+            char line[160];
+            binlog_format_record(record, line, sizeof(line));
+            hal_print(line);
+        }
+        count++;
+    }
+    return count;
+}
+
+static void drain_task(void*) {
+    while (true) {
+        binlog_drain();
+#if defined(ESP32)
+        delay(BINLOG_DRAIN_PERIOD_MS);
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(BINLOG_DRAIN_PERIOD_MS));
+#endif
+    }
+}
+
+void binlog_begin(BinlogOutput mode, bool startTask) {
+    output = mode;
+    if (!startTask) return;
+#if defined(ESP32)
+    xTaskCreatePinnedToCore(drain_task, "binlog", BINLOG_TASK_STACK, nullptr, BINLOG_TASK_PRIORITY, nullptr, BINLOG_TASK_CORE);
+#else
+    std::thread(drain_task, nullptr).detach();
+#endif
+}
+
+BinlogStats binlog_stats() {
+    BinlogStats stats;
+    stats.written = written.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "binlog_format.h"
+
+// Двоичный журнал для горячих путей: вместо сборки String и ожидания Serial на 115200 -
+// запись номера события и сырых аргументов в кольцо в RAM (несколько мкс). Кольцо без
+// блокировок, писать можно из любых задач; разбирает его задача низкого приоритета:
+// кадрами в Serial (текст - декодером на хосте) или текстом, если так выбрано в binlog_begin().
+// Кольцо полно - запись отбрасывается и считается, писатель никогда не ждет.
+//
+// Уровни ниже BINLOG_LEVEL вырезаются при компиляции вместе с вычислением аргументов:
+//   BINLOG_INFO(MOVE_TASK, dir, speed, target, current, duration);
+
+#ifndef BINLOG_LEVEL
+#define BINLOG_LEVEL BINLOG_LEVEL_INFO
+#endif
+
+const int BINLOG_RING_RECORDS = 128;                // степень двойки
+const unsigned long BINLOG_DRAIN_PERIOD_MS = 20;
+const int BINLOG_TASK_CORE = 0;
+const uint32_t BINLOG_TASK_STACK = 3072;
+const int BINLOG_TASK_PRIORITY = 0;                 // ниже управления и бота
+
+enum class BinlogOutput : uint8_t {
+    BINARY,             // кадры, tools/binlog_decode
+    TEXT                // текст на устройстве, для Serial Monitor
+};
+
+struct BinlogStats {
+    uint32_t written;
+    uint32_t dropped;   // кольцо было полно
+};
+
+void binlog_begin(BinlogOutput output = BinlogOutput::BINARY, bool startTask = true);
+void binlog_write_words(uint8_t level, BinlogEvent event, const uint32_t* args, int argCount);
+bool binlog_take(BinlogRecord& record);             // сторона разбора: false - кольцо пусто
+int binlog_drain();                                 // разобрать все в Serial, вернет число записей
+BinlogStats binlog_stats();
+
+inline uint32_t binlog_arg(float value) {
+    uint32_t word;
+    memcpy(&word, &value, sizeof(word));
+    return word;
+}
+inline uint32_t binlog_arg(double value) { return binlog_arg((float)value); }
+inline uint32_t binlog_arg(int value) { return (uint32_t)value; }
+inline uint32_t binlog_arg(long value) { return (uint32_t)value; }
+inline uint32_t binlog_arg(unsigned int value) { return value; }
+inline uint32_t binlog_arg(unsigned long value) { return (uint32_t)value; }
+inline uint32_t binlog_arg(bool value) { return value ? 1 : 0; }
+
+template <typename... Args>
+inline void binlog_write(uint8_t level, BinlogEvent event, Args... args) {
+    static_assert(sizeof...(Args) <= BINLOG_MAX_ARGS, "too many binlog arguments");
+    const uint32_t words[] = { binlog_arg(args)..., 0 };
+    binlog_write_words(level, event, words, sizeof...(Args));
+}
+
+#define BINLOG_AT(level, event, ...)                                        \
+    do {                                                                    \
+        if ((level) >= BINLOG_LEVEL) {                                      \
+            binlog_write((level), BinlogEvent::event, ##__VA_ARGS__);       \
+        }                                                                   \
+    } while (0)
+
+#define BINLOG_DEBUG(event, ...) BINLOG_AT(BINLOG_LEVEL_DEBUG, event, ##__VA_ARGS__)
+#define BINLOG_INFO(event, ...) BINLOG_AT(BINLOG_LEVEL_INFO, event, ##__VA_ARGS__)
+#define BINLOG_WARN(event, ...) BINLOG_AT(BINLOG_LEVEL_WARN, event, ##__VA_ARGS__)
+#define BINLOG_ERROR(event, ...) BINLOG_AT(BINLOG_LEVEL_ERROR, event, ##__VA_ARGS__)
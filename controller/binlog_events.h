@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+// Таблица событий двоичного журнала: в кадр идет только номер события, формат живет здесь,
+// и его же берет декодер на хосте. Новые события - только в конец, номера не переиспользуются,
+// иначе старые дампы расшифруются неверно. Аргументы - по 32 бита: %d %i %c - знаковые,
+// %u %x %X %o - беззнаковые, %f %e %g - float; строк нет.
+
+#define BINLOG_EVENTS(X)                                                                                    \
+    X(MOVE_TASK,            "Move Task: dir=%d, speed=%d, target=%u ticks (current: %d), profile=%.2fs")    \
+    X(DATA_COLLECTED,       "Data collected: pos=%d, metric=%.2f, time=%u")                                 \
+    X(POSITION_CANDIDATE,   "  Pos %d: base_metric=%.2f, adjusted_metric=%.2f, weight=%.2f, best=%d")       \
+    X(TEMP_READING,         "%d:%.2f")                                                                      \
+    X(HOMING_PROGRESS,      "Homing... Velocity: %.2f ticks/sec, Encoder: %d, Time: %.1fs")                 \
+    X(HOMING_RUNNING,       "Motor running after %u ms")                                                    \
+    X(HOMING_END_STOP,      "End stop reached - encoder velocity dropped to %.2f ticks/sec")                \
+    X(MOVE_COMPLETED,       "Move COMPLETED. Ticks: %d")                                                    \
+    X(MOVE_STALLED,         "Move STALLED at %d of %u ticks")
+
+enum class BinlogEvent : uint16_t {
+#define BINLOG_EVENT_ID(name, format) name,
+    BINLOG_EVENTS(BINLOG_EVENT_ID)
+#undef BINLOG_EVENT_ID
+    COUNT
+};
+
+const int BINLOG_EVENT_COUNT = (int)BinlogEvent::COUNT;
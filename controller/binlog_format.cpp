@@ -0,0 +1,170 @@
+#include "binlog_format.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* const EVENT_FORMATS[BINLOG_EVENT_COUNT] = {
+#define BINLOG_EVENT_FORMAT(name, format) format,
+    BINLOG_EVENTS(BINLOG_EVENT_FORMAT)
+#undef BINLOG_EVENT_FORMAT
+};
+
+static const char LEVEL_LETTERS[] = { 'D', 'I', 'W', 'E' };
+
+const char* binlog_event_format(uint16_t event) {
+    return (event < BINLOG_EVENT_COUNT) ? EVENT_FORMATS[event] : nullptr;
+}
+
+// кадр =========================================================================================================================//
+
+static void put_u32(uint8_t* out, uint32_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+}
+
+static uint32_t get_u32(const uint8_t* in) {
+    return in[0] | (in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+size_t binlog_frame_encode(const BinlogRecord& record, uint8_t* out) {
+    uint8_t argCount = (record.argCount <= BINLOG_MAX_ARGS) ? record.argCount : BINLOG_MAX_ARGS;
+    uint8_t length = BINLOG_FRAME_HEADER + 4 * argCount;
+    uint8_t* payload = out + 3;
+
+    out[0] = BINLOG_FRAME_SYNC0;
+    out[1] = BINLOG_FRAME_SYNC1;
+    out[2] = length;
+    payload[0] = record.event;
+    payload[1] = record.event >> 8;
+    payload[2] = record.level;
+    put_u32(payload + 3, record.timestampUs);
+    for (int i = 0; i < argCount; i++) {
+        put_u32(payload + BINLOG_FRAME_HEADER + 4 * i, record.args[i]);
+    }
+
+    uint8_t checksum = 0;
+    for (int i = 0; i < length; i++) {
+        checksum ^= payload[i];
+    }
+    payload[length] = checksum;
+    return 3 + length + 1;
+}
+
+BinlogFrameParser::Result BinlogFrameParser::feed(uint8_t byte) {
+    switch (state) {
+        case IDLE:
+            if (byte != BINLOG_FRAME_SYNC0) return TEXT;
+            state = SYNC;
+            return PENDING;
+
+        case SYNC:
+            state = IDLE;
+            if (byte != BINLOG_FRAME_SYNC1) return TEXT;    // одиночный 0x1E текстом не бывает - теряем его
+            state = LENGTH;
+            return PENDING;
+
+        case LENGTH:
+            if (byte < BINLOG_FRAME_HEADER || byte > sizeof(payload) || (byte - BINLOG_FRAME_HEADER) % 4 != 0) {
+                state = IDLE;
+                return BAD_FRAME;
+            }
+            length = byte;
+            received = 0;
+            state = PAYLOAD;
+            return PENDING;
+
+        case PAYLOAD:
+            payload[received++] = byte;
+            if (received == length) state = CHECKSUM;
+            return PENDING;
+
+        case CHECKSUM: {
+            state = IDLE;
+            uint8_t checksum = 0;
+            for (int i = 0; i < length; i++) {
+                checksum ^= payload[i];
+            }
+            if (checksum != byte) return BAD_FRAME;
+
+            parsed.event = payload[0] | (payload[1] << 8);
+            parsed.level = payload[2];
+            parsed.timestampUs = get_u32(payload + 3);
+            parsed.argCount = (length - BINLOG_FRAME_HEADER) / 4;
+            for (int i = 0; i < parsed.argCount; i++) {
+                parsed.args[i] = get_u32(payload + BINLOG_FRAME_HEADER + 4 * i);
+            }
+            return RECORD;
+        }
+    }
+    return TEXT;
+}
+
+// текст ========================================================================================================================//
+
+static size_t append(char*, size_t size, size_t pos, int written) {
+    if (written < 0) return pos;
+    pos += written;
+    return (pos < size) ? pos : size - 1;
+}
+
+// каждая спецификация формата печатается отдельно: тип аргумента - по букве преобразования
+size_t binlog_format_record(const BinlogRecord& record, char* out, size_t size) {
+    if (size == 0) return 0;
+    char level = (record.level < sizeof(LEVEL_LETTERS)) ? LEVEL_LETTERS[record.level] : '?';
+    size_t pos = append(out, size, 0, snprintf(out, size, "[%lu.%06lu] %c ",
+                                               (unsigned long)(record.timestampUs / 1000000UL),
+                                               (unsigned long)(record.timestampUs % 1000000UL), level));
+
+    const char* format = binlog_event_format(record.event);
+    if (format == nullptr) {
+        append(out, size, pos, snprintf(out + pos, size - pos, "unknown event %u", record.event));
+        return strlen(out);
+    }
+
+    int arg = 0;
+    for (const char* p = format; *p != '\0' && pos < size - 1; p++) {
+        if (*p != '%') {
+            out[pos++] = *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[pos++] = '%';
+            p++;
+            continue;
+        }
+
+        // %[флаги][ширина][.точность][l|h]буква, модификаторы длины выбрасываем
+        char spec[16];
+        size_t len = 0;
+        spec[len++] = '%';
+        const char* q = p + 1;
+        while (*q != '\0' && strchr("-+ #0123456789.", *q) != nullptr && len < sizeof(spec) - 3) {
+            spec[len++] = *q++;
+        }
+        while (*q == 'l' || *q == 'h') q++;
+        char conversion = *q;
+        spec[len++] = conversion;
+        spec[len] = '\0';
+        p = (*q != '\0') ? q : q - 1;
+
+        if (arg >= record.argCount || conversion == '\0' || strchr("diucxXofFeEgG", conversion) == nullptr) {
+            out[pos++] = '?';
+            continue;
+        }
+        uint32_t word = record.args[arg++];
+        int written;
+        if (strchr("fFeEgG", conversion) != nullptr) {
+            float value;
+            memcpy(&value, &word, sizeof(value));
+            written = snprintf(out + pos, size - pos, spec, (double)value);
+        } else if (strchr("di", conversion) != nullptr) {
+            written = snprintf(out + pos, size - pos, spec, (int)(int32_t)word);
+        } else {
+            written = snprintf(out + pos, size - pos, spec, (unsigned)word);
+        }
+        pos = append(out, size, pos, written);
+    }
+    out[pos] = '\0';
+    return pos;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "binlog_events.h"
+
+// Запись двоичного журнала, ее кадр на проводе и перевод обратно в текст.
+// Без Arduino: тот же код собирается в декодер дампов на хосте (tools/binlog_decode).
+//
+// Кадр: 0x1E 0xB1, длина полезной части, событие (2 байта LE), уровень, время в мкс (4 байта LE),
+// аргументы по 4 байта LE, xor полезной части. 0x1E в тексте Serial не встречается, поэтому
+// кадры и обычные строки можно писать в один порт, а декодер их разделит.
+
+const int BINLOG_MAX_ARGS = 6;
+const uint8_t BINLOG_FRAME_SYNC0 = 0x1E;
+const uint8_t BINLOG_FRAME_SYNC1 = 0xB1;
+const int BINLOG_FRAME_HEADER = 7;                  // событие, уровень, время
+const int BINLOG_FRAME_MAX = 3 + BINLOG_FRAME_HEADER + 4 * BINLOG_MAX_ARGS + 1;
+
+enum BinlogLevel : uint8_t {
+    BINLOG_LEVEL_DEBUG = 0,
+    BINLOG_LEVEL_INFO = 1,
+    BINLOG_LEVEL_WARN = 2,
+    BINLOG_LEVEL_ERROR = 3,
+    BINLOG_LEVEL_NONE = 4
+};
+
+struct BinlogRecord {
+    uint32_t timestampUs;
+    uint16_t event;
+    uint8_t level;
+    uint8_t argCount;
+    uint32_t args[BINLOG_MAX_ARGS];
+};
+
+const char* binlog_event_format(uint16_t event);    // nullptr - неизвестное событие
+
+size_t binlog_frame_encode(const BinlogRecord& record, uint8_t* out);   // out - не меньше BINLOG_FRAME_MAX
+
+// "[секунды.мкс] I текст" в out, возвращает длину строки
+size_t binlog_format_record(const BinlogRecord& record, char* out, size_t size);
+
+// разбирает поток с перемешанными кадрами и текстом побайтно
+class BinlogFrameParser {
+public:
+    enum Result {
+        TEXT,           // байт текста, вернуть как есть
+        PENDING,        // байт ушел в кадр
+        RECORD,         // кадр собран: record()
+        BAD_FRAME       // кадр испорчен, его байты пропущены
+    };
+
+    Result feed(uint8_t byte);
+    const BinlogRecord& record() const { return parsed; }
+
+private:
+    enum State { IDLE, SYNC, LENGTH, PAYLOAD, CHECKSUM };
+    State state = IDLE;
+    uint8_t payload[BINLOG_FRAME_HEADER + 4 * BINLOG_MAX_ARGS];
+    uint8_t length = 0;
+    uint8_t received = 0;
+    BinlogRecord parsed = {};
+};
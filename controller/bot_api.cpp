@@ -0,0 +1,430 @@
+#include "bot_api.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+BotApiClient::BotApiClient(BotSocket& socket, const char* token) : socket(socket), token(token) {
+}
+
+// JSON ==========================================================================================================================//
+//
+// Ответы Bot API разбираются на месте, без дерева: значение ищется по ключу на верхнем уровне
+// объекта, вложенные объекты и массивы пропускаются целиком.
+
+static const char* skip_space(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+    return p;
+}
+
+static const char* skip_string(const char* p, const char* end) {
+    for (p++; p < end; p++) {
+        if (*p == '\\') p++;
+        else if (*p == '"') return p + 1;
+    }
+    return nullptr;
+}
+
+// значение целиком: строка, объект, массив или литерал; nullptr - JSON оборван
+static const char* skip_value(const char* p, const char* end) {
+    p = skip_space(p, end);
+    if (p >= end) return nullptr;
+    if (*p == '"') return skip_string(p, end);
+    if (*p != '{' && *p != '[') {
+        while (p < end && *p != ',' && *p != '}' && *p != ']') p++;
+        return p;
+    }
+    int depth = 0;
+    while (p < end) {
+        if (*p == '"') {
+            p = skip_string(p, end);
+            if (p == nullptr) return nullptr;
+            continue;
+        }
+        if (*p == '{' || *p == '[') depth++;
+        else if (*p == '}' || *p == ']') {
+            if (--depth == 0) return p + 1;
+        }
+        p++;
+    }
+    return nullptr;
+}
+
+// значение ключа key объекта, начинающегося в object
+static const char* object_get(const char* object, const char* end, const char* key) {
+    if (object == nullptr) return nullptr;
+    const char* p = skip_space(object, end);
+    if (p >= end || *p != '{') return nullptr;
+    size_t keyLength = strlen(key);
+    p++;
+    while (true) {
+        p = skip_space(p, end);
+        if (p >= end || *p != '"') return nullptr;
+        const char* name = p + 1;
+        p = skip_string(p, end);
+        if (p == nullptr) return nullptr;
+        bool match = (size_t)(p - 1 - name) == keyLength && memcmp(name, key, keyLength) == 0;
+        p = skip_space(p, end);
+        if (p >= end || *p != ':') return nullptr;
+        p = skip_space(p + 1, end);
+        if (match) return p;
+        p = skip_value(p, end);
+        if (p == nullptr) return nullptr;
+        p = skip_space(p, end);
+        if (p >= end || *p != ',') return nullptr;
+        p++;
+    }
+}
+
+static void append_utf8(String& out, uint32_t code) {
+    char bytes[5] = {};
+    if (code < 0x80) {
+        bytes[0] = code;
+    } else if (code < 0x800) {
+        bytes[0] = 0xC0 | (code >> 6);
+        bytes[1] = 0x80 | (code & 0x3F);
+    } else if (code < 0x10000) {
+        bytes[0] = 0xE0 | (code >> 12);
+        bytes[1] = 0x80 | ((code >> 6) & 0x3F);
+        bytes[2] = 0x80 | (code & 0x3F);
+    } else {
+        bytes[0] = 0xF0 | (code >> 18);
+        bytes[1] = 0x80 | ((code >> 12) & 0x3F);
+        bytes[2] = 0x80 | ((code >> 6) & 0x3F);
+        bytes[3] = 0x80 | (code & 0x3F);
+    }
+    out += bytes;
+}
+
+static uint32_t read_hex4(const char* p) {
+    char digits[5] = { p[0], p[1], p[2], p[3], '\0' };
+    return strtoul(digits, nullptr, 16);
+}
+
+// строка JSON в UTF-8; Telegram присылает не-ASCII как \uXXXX, эмодзи - суррогатными парами
+static bool read_string(const char* p, const char* end, String& out) {
+    out = "";
+    if (p == nullptr || p >= end || *p != '"') return false;
+    const char* close = skip_string(p, end);
+    if (close == nullptr) return false;
+    close--;
+    for (p++; p < close; p++) {
+        if (*p != '\\') {
+            const char* run = p;
+            while (p < close && *p != '\\') p++;
+            char chunk[65];
+            while (run < p) {
+                size_t n = min((size_t)(p - run), sizeof(chunk) - 1);
+                memcpy(chunk, run, n);
+                chunk[n] = '\0';
+                out += chunk;
+                run += n;
+            }
+            p--;
+            continue;
+        }
+        p++;
+        switch (*p) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                if (close - p < 5) return false;
+                uint32_t code = read_hex4(p + 1);
+                p += 4;
+                if (code >= 0xD800 && code < 0xDC00 && close - p >= 7 && p[1] == '\\' && p[2] == 'u') {
+                    uint32_t low = read_hex4(p + 3);
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+                append_utf8(out, code);
+                break;
+            }
+            default: out += *p; break;      // \" \\ \/
+        }
+    }
+    return true;
+}
+
+// число как текст: chat id в String, update_id - через atol
+static bool read_number(const char* p, const char* end, char* out, size_t size) {
+    if (p == nullptr) return false;
+    size_t n = 0;
+    while (p < end && (*p == '-' || (*p >= '0' && *p <= '9')) && n < size - 1) {
+        out[n++] = *p++;
+    }
+    out[n] = '\0';
+    return n > 0;
+}
+
+static void add_json_string(MessageBuilder& out, const char* text) {
+    out.add("\"");
+    const char* run = text;
+    for (const char* p = text; ; p++) {
+        unsigned char c = *p;
+        if (c != '\0' && c != '"' && c != '\\' && c >= 0x20) continue;
+        out.add(run, p - run);
+        if (c == '\0') break;
+        switch (c) {
+            case '"': out.add("\\\""); break;
+            case '\\': out.add("\\\\"); break;
+            case '\n': out.add("\\n"); break;
+            case '\r': out.add("\\r"); break;
+            case '\t': out.add("\\t"); break;
+            default: out.addf("\\u%04x", c); break;
+        }
+        run = p + 1;
+    }
+    out.add("\"");
+}
+
+// методы ========================================================================================================================//
+
+// тело запроса - после места под заголовки, см. exchange()
+MessageBuilder BotApiClient::newBody() {
+    return MessageBuilder(requestBuffer + BOT_API_HEADER_RESERVE, sizeof(requestBuffer) - BOT_API_HEADER_RESERVE);
+}
+
+int BotApiClient::getUpdates(BotMessage* messages, int maxMessages, uint16_t waitS) {
+    MessageBuilder body = newBody();
+    body.addf("{\"offset\":%ld,\"timeout\":%u,\"limit\":%d,\"allowed_updates\":[\"message\",\"callback_query\"]}",
+              (long)offset, waitS, min(maxMessages, BOT_API_UPDATES_LIMIT));
+    if (request("getUpdates", body, waitS * 1000UL + BOT_API_TIMEOUT_MS) != 200) return 0;
+
+    const char* end = responseBuffer + responseLength;
+    char number[24];
+    if (responseTruncated) {
+        // сообщение не влезло в буфер: пропускаем его, иначе getUpdates будет отдавать его вечно
+        const char* id = strstr(responseBuffer, "\"update_id\":");
+        if (id != nullptr && read_number(id + 12, end, number, sizeof(number))) {
+            offset = atol(number) + 1;
+        }
+        Serial.println("Telegram: слишком длинное обновление пропущено");
+        return 0;
+    }
+
+    const char* result = object_get(responseBuffer, end, "result");
+    if (result == nullptr || *result != '[') return 0;
+    const char* p = result + 1;
+    int count = 0;
+    while (true) {
+        p = skip_space(p, end);
+        if (p >= end || *p != '{') break;
+        const char* update = p;
+        p = skip_value(p, end);
+        if (p == nullptr) break;
+
+        if (read_number(object_get(update, p, "update_id"), p, number, sizeof(number))) {
+            offset = atol(number) + 1;
+        }
+        // нажатие кнопки: чат - у сообщения с клавиатурой, текст - callback_data
+        const char* callback = object_get(update, p, "callback_query");
+        const char* message = (callback != nullptr) ? object_get(callback, p, "message") : object_get(update, p, "message");
+        const char* chatId = object_get(object_get(message, p, "chat"), p, "id");
+        if (count < maxMessages && read_number(chatId, p, number, sizeof(number))) {
+            BotMessage& out = messages[count];
+            bool parsed = (callback != nullptr)
+                ? read_string(object_get(callback, p, "data"), p, out.text) &&
+                  read_string(object_get(callback, p, "id"), p, out.callbackId)
+                : read_string(object_get(message, p, "text"), p, out.text);
+            if (parsed) {
+                if (callback == nullptr) out.callbackId = "";
+                out.chatId = number;
+                count++;
+            }
+        }
+
+        p = skip_space(p, end);
+        if (p >= end || *p != ',') break;
+        p++;
+    }
+    return count;
+}
+
+void BotApiClient::addMessageFields(MessageBuilder& body, const char* text, const char* parseMode,
+                                    const char* replyMarkup) {
+    body.add(",\"text\":");
+    add_json_string(body, text);
+    if (parseMode != nullptr && parseMode[0] != '\0') {
+        body.add(",\"parse_mode\":");
+        add_json_string(body, parseMode);
+    }
+    if (replyMarkup != nullptr) {
+        body.add(",\"reply_markup\":");
+        body.add(replyMarkup);
+    }
+    body.add("}");
+}
+
+BotSendResult BotApiClient::sendMessage(const char* chatId, const char* text, const char* parseMode,
+                                        const char* replyMarkup) {
+    MessageBuilder body = newBody();
+    body.add("{\"chat_id\":");
+    add_json_string(body, chatId);
+    addMessageFields(body, text, parseMode, replyMarkup);
+    return deliver("sendMessage", body);
+}
+
+BotSendResult BotApiClient::editMessageText(const char* chatId, int32_t messageId, const char* text,
+                                            const char* parseMode, const char* replyMarkup) {
+    MessageBuilder body = newBody();
+    body.add("{\"chat_id\":");
+    add_json_string(body, chatId);
+    body.addf(",\"message_id\":%ld", (long)messageId);
+    addMessageFields(body, text, parseMode, replyMarkup);
+    return deliver("editMessageText", body);
+}
+
+// без текста: Telegram только снимает часики с кнопки
+bool BotApiClient::answerCallbackQuery(const char* callbackId) {
+    MessageBuilder body = newBody();
+    body.add("{\"callback_query_id\":");
+    add_json_string(body, callbackId);
+    body.add("}");
+    return request("answerCallbackQuery", body, BOT_API_TIMEOUT_MS) == 200;
+}
+
+// отправка или правка сообщения: что ответил сервер и что с этим делать дальше
+BotSendResult BotApiClient::deliver(const char* method, const MessageBuilder& body) {
+    BotSendResult result = { BotSendStatus::REJECTED, 0, 0 };
+    if (body.truncated()) {
+        Serial.println("Telegram: сообщение не влезло в буфер запроса");
+        return result;
+    }
+
+    int status = request(method, body, BOT_API_TIMEOUT_MS);
+    const char* end = responseBuffer + responseLength;
+    char number[16];
+    if (status == 200) {
+        result.status = BotSendStatus::SENT;
+        const char* messageId = object_get(object_get(responseBuffer, end, "result"), end, "message_id");
+        if (read_number(messageId, end, number, sizeof(number))) result.messageId = atol(number);
+    } else if (status == 429) {
+        const char* retryAfter = object_get(object_get(responseBuffer, end, "parameters"), end, "retry_after");
+        result.status = BotSendStatus::RATE_LIMITED;
+        result.retryAfterS = read_number(retryAfter, end, number, sizeof(number)) ? atoi(number) : 1;
+    } else if (status == 0 || status >= 500) {
+        result.status = BotSendStatus::FAILED;
+    }
+    return result;
+}
+
+// HTTP ==========================================================================================================================//
+
+/**
+ * @brief Запрос к методу Bot API по постоянному соединению
+ * @return Код HTTP, 0 - сеть недоступна или соединение оборвалось
+ *
+ * Сервер мог молча закрыть простаивавшее соединение - тогда запрос повторяется один раз
+ * на новом. Не вышло и там - пауза перед следующей попыткой растет вдвое.
+ */
+int BotApiClient::request(const char* method, const MessageBuilder& body, uint32_t timeoutMs) {
+    if (backoffMs > 0 && (long)(millis() - retryAtMs) < 0) return 0;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = socket.connected();
+        if (!reused) {
+            if (!socket.open(BOT_API_HOST, BOT_API_PORT)) break;
+            counters.handshakes++;
+        }
+        int status = exchange(method, body, timeoutMs);
+        if (status > 0) {
+            backoffMs = 0;
+            return status;
+        }
+        socket.close();
+        if (!reused) break;
+    }
+    failed();
+    return 0;
+}
+
+void BotApiClient::failed() {
+    counters.failures++;
+    backoffMs = (backoffMs == 0) ? BOT_API_BACKOFF_MIN_MS : min(backoffMs * 2, BOT_API_BACKOFF_MAX_MS);
+    retryAtMs = millis() + backoffMs;
+    Serial.print("Telegram: нет связи с сервером, следующая попытка через ");
+    Serial.print(backoffMs);
+    Serial.println(" мс");
+}
+
+// заголовки - вплотную перед телом в requestBuffer: весь запрос уходит одним write()
+int BotApiClient::exchange(const char* method, const MessageBuilder& body, uint32_t timeoutMs) {
+    char headerBuffer[BOT_API_HEADER_RESERVE];
+    MessageBuilder header(headerBuffer, sizeof(headerBuffer));
+    header.addf("POST /bot%s/%s HTTP/1.1\r\n"
+                "Host: %s\r\n"
+                "Content-Type: application/json\r\n"
+                "Content-Length: %u\r\n"
+                "Connection: keep-alive\r\n\r\n",
+                token, method, BOT_API_HOST, (unsigned)body.length());
+    if (header.truncated()) return 0;
+    char* start = requestBuffer + BOT_API_HEADER_RESERVE - header.length();
+    memcpy(start, header.c_str(), header.length());
+    counters.requests++;
+    if (!socket.write(start, header.length() + body.length())) return 0;
+
+    int status = 0;
+    return readResponse(timeoutMs, status) ? status : 0;
+}
+
+static const char* find_header(const char* headers, const char* name) {
+    size_t length = strlen(name);
+    for (const char* line = strstr(headers, "\r\n"); line != nullptr; line = strstr(line + 2, "\r\n")) {
+        if (strncasecmp(line + 2, name, length) == 0) {
+            const char* value = line + 2 + length;
+            while (*value == ' ') value++;
+            return value;
+        }
+    }
+    return nullptr;
+}
+
+// статус, заголовки и тело с Content-Length; тело - в начало responseBuffer
+bool BotApiClient::readResponse(uint32_t timeoutMs, int& status) {
+    unsigned long start = millis();
+    size_t received = 0;
+    const char* headersEnd = nullptr;
+    while (headersEnd == nullptr) {
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= timeoutMs || received >= sizeof(responseBuffer) - 1) return false;
+        int n = socket.read(responseBuffer + received, sizeof(responseBuffer) - 1 - received, timeoutMs - elapsed);
+        if (n <= 0) return false;
+        received += n;
+        responseBuffer[received] = '\0';
+        headersEnd = strstr(responseBuffer, "\r\n\r\n");
+    }
+
+    if (sscanf(responseBuffer, "HTTP/1.%*d %d", &status) != 1) return false;
+    const char* lengthHeader = find_header(responseBuffer, "Content-Length:");
+    if (lengthHeader == nullptr) return false;          // chunked Bot API не присылает
+    size_t contentLength = strtoul(lengthHeader, nullptr, 10);
+    const char* connection = find_header(responseBuffer, "Connection:");
+    bool closeAfter = connection != nullptr && strncasecmp(connection, "close", 5) == 0;
+
+    size_t headerLength = headersEnd + 4 - responseBuffer;
+    size_t bodyReceived = received - headerLength;
+    memmove(responseBuffer, responseBuffer + headerLength, bodyReceived);
+
+    // что не влезло - дочитываем и выбрасываем, чтобы соединение осталось пригодным
+    responseTruncated = false;
+    size_t kept = min(bodyReceived, sizeof(responseBuffer) - 1);
+    while (bodyReceived < contentLength) {
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= timeoutMs) return false;
+        char scratch[128];
+        char* into = (kept < sizeof(responseBuffer) - 1) ? responseBuffer + kept : scratch;
+        size_t room = (into == scratch) ? sizeof(scratch) : sizeof(responseBuffer) - 1 - kept;
+        int n = socket.read(into, min(room, contentLength - bodyReceived), timeoutMs - elapsed);
+        if (n <= 0) return false;
+        bodyReceived += n;
+        if (into == scratch) responseTruncated = true;
+        else kept += n;
+    }
+    responseLength = min(kept, contentLength);
+    responseBuffer[responseLength] = '\0';
+
+    if (closeAfter) socket.close();
+    return true;
+}
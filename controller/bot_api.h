@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "message_builder.h"
+
+// Клиент Bot API поверх одного постоянного соединения: HTTP/1.1 keep-alive, запросы идут
+// друг за другом по тому же TLS, рукопожатие - только при первом подключении и после обрыва.
+// getUpdates - long polling: сервер держит запрос до waitS секунд и отвечает, как только
+// пришло сообщение. Обрыв: запрос повторяется один раз на новом соединении, дальше -
+// пауза с удвоением до BOT_API_BACKOFF_MAX_MS, пока сеть не вернется.
+//
+// Сокет - интерфейс: на ESP32 это WiFiClientSecure, в тестах - подставной сервер.
+// Буферы запроса и ответа - внутри клиента, куча на запрос не нужна. Заголовки HTTP
+// собираются прямо перед телом, и запрос уходит одной записью - одной записью TLS.
+
+const char BOT_API_HOST[] = "api.telegram.org";
+const uint16_t BOT_API_PORT = 443;
+const size_t BOT_API_REQUEST_CAPACITY = 3584;       // экранированный текст сообщения и JSON вокруг
+const size_t BOT_API_HEADER_RESERVE = 256;          // начало буфера запроса - под заголовки HTTP
+const size_t BOT_API_RESPONSE_CAPACITY = 6144;      // заголовки и getUpdates на BOT_API_UPDATES_LIMIT сообщений
+const int BOT_API_UPDATES_LIMIT = 4;
+const uint32_t BOT_API_TIMEOUT_MS = 5000;           // сверх времени long poll
+const uint32_t BOT_API_BACKOFF_MIN_MS = 1000;
+const uint32_t BOT_API_BACKOFF_MAX_MS = 60000;
+
+struct BotMessage {
+    String chatId;
+    String text;                // у нажатия кнопки - ее callback_data
+    String callbackId;          // пусто - обычное сообщение
+};
+
+// соединение с сервером; open() - TCP и рукопожатие TLS
+class BotSocket {
+public:
+    virtual ~BotSocket() {}
+    virtual bool open(const char* host, uint16_t port) = 0;
+    virtual bool connected() = 0;
+    virtual void close() = 0;
+    virtual bool write(const char* data, size_t length) = 0;
+    virtual int read(char* buffer, size_t size, uint32_t timeoutMs) = 0;    // 0 - таймаут, -1 - соединение закрыто
+};
+
+enum class BotSendStatus : uint8_t {
+    SENT,
+    RATE_LIMITED,       // 429: повторить не раньше retryAfterS
+    FAILED,             // сеть или 5xx: повторить позже
+    REJECTED            // 400, 403...: повтор не поможет
+};
+
+struct BotSendResult {
+    BotSendStatus status;
+    uint16_t retryAfterS;
+    int32_t messageId;          // SENT: id сообщения в чате
+};
+
+struct BotApiStats {
+    uint32_t requests;
+    uint32_t handshakes;        // успешные open()
+    uint32_t failures;          // запросы, оборвавшиеся на сети
+};
+
+class BotApiClient {
+public:
+    BotApiClient(BotSocket& socket, const char* token);
+
+    // новые сообщения, не больше maxMessages; waitS > 0 - long polling
+    int getUpdates(BotMessage* messages, int maxMessages, uint16_t waitS);
+    // replyMarkup - JSON клавиатуры как есть, nullptr - без нее
+    BotSendResult sendMessage(const char* chatId, const char* text, const char* parseMode,
+                              const char* replyMarkup = nullptr);
+    BotSendResult editMessageText(const char* chatId, int32_t messageId, const char* text, const char* parseMode,
+                                  const char* replyMarkup = nullptr);
+    bool answerCallbackQuery(const char* callbackId);
+
+    BotApiStats stats() const { return counters; }
+
+private:
+    MessageBuilder newBody();
+    void addMessageFields(MessageBuilder& body, const char* text, const char* parseMode, const char* replyMarkup);
+    BotSendResult deliver(const char* method, const MessageBuilder& body);
+    int request(const char* method, const MessageBuilder& body, uint32_t timeoutMs);
+    int exchange(const char* method, const MessageBuilder& body, uint32_t timeoutMs);
+    bool readResponse(uint32_t timeoutMs, int& status);
+    void failed();
+
+    BotSocket& socket;
+    const char* token;
+    int32_t offset = 0;                 // следующий update_id
+    unsigned long retryAtMs = 0;
+    uint32_t backoffMs = 0;             // 0 - сеть в порядке
+    bool responseTruncated = false;
+    size_t responseLength = 0;
+    BotApiStats counters = {};
+    char requestBuffer[BOT_API_REQUEST_CAPACITY];
+    char responseBuffer[BOT_API_RESPONSE_CAPACITY];
+};
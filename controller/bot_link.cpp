@@ -0,0 +1,191 @@
+#include "bot_link.h"
+#include <Arduino.h>
+#include <atomic>
+
+#if defined(ESP32)
+#include <esp_pm.h>
+#endif
+
+static std::atomic<uint32_t> commandsDropped(0);
+static std::atomic<uint32_t> repliesDropped(0);
+static std::atomic<bool> networkBusy(false);
+static uint32_t snapshotSeq = 0;           // пишет только управление
+
+#if defined(ESP32)
+
+// очереди FreeRTOS ==============================================================================================================//
+
+static QueueHandle_t commandQueue = nullptr;
+static QueueHandle_t replyQueue = nullptr;
+static QueueHandle_t snapshotBox = nullptr;   // длина 1: xQueueOverwrite / xQueuePeek
+static esp_pm_lock_handle_t networkLock = nullptr;     // без CONFIG_PM_ENABLE не создастся - и не нужна
+
+void bot_link_begin() {
+    if (commandQueue != nullptr) return;
+    commandQueue = xQueueCreate(BOT_COMMAND_QUEUE_LEN, sizeof(BotCommand));
+    replyQueue = xQueueCreate(BOT_REPLY_QUEUE_LEN, sizeof(BotReply));
+    snapshotBox = xQueueCreate(1, sizeof(BotStatusSnapshot));
+    esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "bot_net", &networkLock);
+}
+
+static void hold_network_lock(bool hold) {
+    if (networkLock == nullptr) return;
+    if (hold) {
+        esp_pm_lock_acquire(networkLock);
+    } else {
+        esp_pm_lock_release(networkLock);
+    }
+}
+
+static bool publish_snapshot(const BotStatusSnapshot& snapshot) {
+    return xQueueOverwrite(snapshotBox, &snapshot) == pdPASS;
+}
+
+bool bot_link_take_command(BotCommand& command) {
+    return xQueueReceive(commandQueue, &command, 0) == pdPASS;
+}
+
+static bool post_reply(const BotReply& reply) {
+    return xQueueSend(replyQueue, &reply, 0) == pdPASS;
+}
+
+static bool post_command(const BotCommand& command) {
+    return xQueueSend(commandQueue, &command, 0) == pdPASS;
+}
+
+bool bot_link_snapshot(BotStatusSnapshot& snapshot) {
+    return xQueuePeek(snapshotBox, &snapshot, 0) == pdPASS;
+}
+
+bool bot_link_take_reply(BotReply& reply, uint32_t waitMs) {
+    return xQueueReceive(replyQueue, &reply, pdMS_TO_TICKS(waitMs)) == pdPASS;
+}
+
+#else
+
+// хост: кольца под мьютексом ====================================================================================================//
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+template <typename T, int N>
+struct BoundedRing {
+    T items[N];
+    int head = 0;
+    int count = 0;
+
+    bool push(const T& item) {
+        if (count == N) return false;
+        items[(head + count) % N] = item;
+        count++;
+        return true;
+    }
+
+    bool pop(T& item) {
+        if (count == 0) return false;
+        item = items[head];
+        head = (head + 1) % N;
+        count--;
+        return true;
+    }
+};
+
+static std::mutex linkMutex;
+static std::condition_variable replyReady;
+static BoundedRing<BotCommand, BOT_COMMAND_QUEUE_LEN> commandRing;
+static BoundedRing<BotReply, BOT_REPLY_QUEUE_LEN> replyRing;
+static BotStatusSnapshot snapshotBox;
+static bool haveSnapshot = false;
+
+void bot_link_begin() {
+    std::lock_guard<std::mutex> lock(linkMutex);
+    commandRing = BoundedRing<BotCommand, BOT_COMMAND_QUEUE_LEN>();
+    replyRing = BoundedRing<BotReply, BOT_REPLY_QUEUE_LEN>();
+    haveSnapshot = false;
+}
+
+static bool publish_snapshot(const BotStatusSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(linkMutex);
+    snapshotBox = snapshot;
+    haveSnapshot = true;
+    return true;
+}
+
+bool bot_link_take_command(BotCommand& command) {
+    std::lock_guard<std::mutex> lock(linkMutex);
+    return commandRing.pop(command);
+}
+
+static bool post_reply(const BotReply& reply) {
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(linkMutex);
+        ok = replyRing.push(reply);
+    }
+    replyReady.notify_one();
+    return ok;
+}
+
+static bool post_command(const BotCommand& command) {
+    std::lock_guard<std::mutex> lock(linkMutex);
+    return commandRing.push(command);
+}
+
+bool bot_link_snapshot(BotStatusSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(linkMutex);
+    if (!haveSnapshot) return false;
+    snapshot = snapshotBox;
+    return true;
+}
+
+bool bot_link_take_reply(BotReply& reply, uint32_t waitMs) {
+    std::unique_lock<std::mutex> lock(linkMutex);
+    if (waitMs > 0) {
+        replyReady.wait_for(lock, std::chrono::milliseconds(waitMs), [] { return replyRing.count > 0; });
+    }
+    return replyRing.pop(reply);
+}
+
+#endif
+
+// общее =========================================================================================================================//
+
+void bot_link_publish(BotStatusSnapshot& snapshot) {
+    snapshot.seq = ++snapshotSeq;
+    snapshot.takenMs = millis();
+    publish_snapshot(snapshot);
+}
+
+bool bot_link_post_reply(const BotReply& reply) {
+    if (post_reply(reply)) return true;
+    repliesDropped.fetch_add(1, std::memory_order_relaxed);
+    Serial.println("Bot link: reply queue full, reply dropped");
+    return false;
+}
+
+bool bot_link_post_command(const BotCommand& command) {
+    if (post_command(command)) return true;
+    commandsDropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+// Блокировка берется самой задачей бота до первого байта в сеть: автоматический light sleep
+// не может вклиниться между проверкой и запросом, как было бы с флагом, который читает управление.
+void bot_link_set_network_busy(bool busy) {
+    if (networkBusy.exchange(busy, std::memory_order_relaxed) == busy) return;
+#if defined(ESP32)
+    hold_network_lock(busy);
+#endif
+}
+
+bool bot_link_network_busy() {
+    return networkBusy.load(std::memory_order_relaxed);
+}
+
+BotLinkStats bot_link_stats() {
+    BotLinkStats stats;
+    stats.commandsDropped = commandsDropped.load(std::memory_order_relaxed);
+    stats.repliesDropped = repliesDropped.load(std::memory_order_relaxed);
+    return stats;
+}
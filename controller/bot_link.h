@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include "window_controller.h"
+#include "position_store.h"
+#include "motor_impl.h"
+#include "power.h"
+
+// Канал между задачей бота (ядро 0, сеть) и управлением (loop(), ядро 1).
+// Бот не трогает WindowController и мотор: команды идут в ограниченную очередь команд,
+// результаты - в очередь ответов, а всё, что бот показывает, - из последнего снимка
+// состояния (почтовый ящик на одну запись, новый снимок затирает старый).
+// Очереди не блокируют управление: переполнение - команда или ответ отбрасываются и считаются.
+
+const int BOT_CHAT_ID_LEN = 24;
+const int BOT_COMMAND_QUEUE_LEN = 8;
+const int BOT_REPLY_QUEUE_LEN = 8;
+
+enum class BotCommandType : uint8_t {
+    SET_MODE,
+    SET_PARAM,
+    SET_POSITION,
+    HOMING
+};
+
+enum class BotParam : uint8_t {
+    TEMP_IDEAL,
+    TEMP_HIGH,
+    TEMP_LOW,
+    CO2_IDEAL,
+    CO2_HIGH
+};
+
+struct BotCommand {
+    BotCommandType type;
+    char chatId[BOT_CHAT_ID_LEN];
+    WindowMode mode;            // SET_MODE
+    BotParam param;             // SET_PARAM
+    float value;                // SET_PARAM
+    int position;               // SET_POSITION
+    bool quiet;                 // с кнопки панели: успех виден на ней, ответ сообщением не нужен
+};
+
+const int BOT_RESULT_OK = 0;
+const int BOT_RESULT_WRONG_MODE = -100;     // позиция задается только в MANUAL
+
+struct BotReply {
+    BotCommand command;
+    int result;                 // BOT_RESULT_*, у хоуминга - код get_homing_result()
+    WindowMode mode;            // режим на момент выполнения
+    float value;                // примененное значение параметра
+    unsigned long durationMs;   // хоуминг
+    int windowPosition;
+};
+
+struct BotStatusSnapshot {
+    uint32_t seq;               // 0 - снимка еще не было
+    unsigned long takenMs;
+    RecentData data;
+    WindowConfig config;
+    EmergencyType emergency;
+    PositionStoreStats journal;
+    MotorCalibration calibration;
+    float positionErrorTicks;
+    bool motorBusy;
+    PowerMode powerMode;
+    PowerModeStats power;       // по текущему режиму
+};
+
+struct BotLinkStats {
+    uint32_t commandsDropped;
+    uint32_t repliesDropped;
+};
+
+void bot_link_begin();
+
+// сторона управления: никогда не ждет
+void bot_link_publish(BotStatusSnapshot& snapshot);       // проставит seq и takenMs
+bool bot_link_take_command(BotCommand& command);
+bool bot_link_post_reply(const BotReply& reply);
+
+// сторона бота
+bool bot_link_post_command(const BotCommand& command);     // false - очередь полна
+bool bot_link_snapshot(BotStatusSnapshot& snapshot);       // false - снимка еще не было
+bool bot_link_take_reply(BotReply& reply, uint32_t waitMs);
+
+// задача бота держит флаг, пока ждет сеть: light sleep в это время оборвал бы запрос;
+// на ESP32 вместе с флагом берется блокировка питания ESP_PM_NO_LIGHT_SLEEP
+void bot_link_set_network_busy(bool busy);
+bool bot_link_network_busy();
+
+BotLinkStats bot_link_stats();
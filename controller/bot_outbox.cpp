@@ -0,0 +1,175 @@
+#include "bot_outbox.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+// корзина токенов ===============================================================================================================//
+
+static void refill(float& tokens, unsigned long& updatedMs, float rate, float burst, unsigned long nowMs) {
+    tokens = min(burst, tokens + (nowMs - updatedMs) * rate / 1000.0f);
+    updatedMs = nowMs;
+}
+
+// сколько ждать до целого токена
+static uint32_t token_wait_ms(float tokens, float rate) {
+    return (tokens >= 1.0f) ? 0 : (uint32_t)((1.0f - tokens) * 1000.0f / rate) + 1;
+}
+
+static bool settling(const BotOutMessage& message, unsigned long nowMs) {
+    return message.kind == BotOutKind::ALERT && message.attempts == 0 && (long)(message.notBeforeMs - nowMs) > 0;
+}
+
+// постановка ====================================================================================================================//
+
+bool BotOutbox::push(BotOutKind kind, const char* chatId, const char* text, const char* parseMode, unsigned long nowMs,
+                     int32_t editMessageId, const char* replyMarkup) {
+    BotOutMessage* slot = nullptr;
+    if (kind != BotOutKind::REPLY) {
+        for (BotOutMessage& queued : slots) {
+            if (!queued.used || strcmp(queued.chatId, chatId) != 0) continue;
+            // авария несет и сводку состояния: неотправленная сводка этому чату уже не нужна
+            bool superseded = queued.kind == kind || (kind == BotOutKind::ALERT && queued.kind == BotOutKind::STATUS);
+            if (!superseded) continue;
+            counters.coalesced++;
+            if (slot == nullptr) {
+                slot = &queued;
+            } else {
+                queued.used = false;
+                pending--;
+            }
+        }
+    }
+
+    if (slot == nullptr) {
+        for (BotOutMessage& free : slots) {
+            if (!free.used) {
+                slot = &free;
+                break;
+            }
+        }
+        if (slot == nullptr) {
+            counters.dropped++;
+            return false;
+        }
+        slot->used = true;
+        slot->seq = nextSeq++;
+        slot->attempts = 0;
+        slot->notBeforeMs = nowMs;
+        pending++;
+    }
+
+    slot->kind = kind;
+    slot->editMessageId = editMessageId;
+    slot->replyMarkup = replyMarkup;
+    if (kind == BotOutKind::ALERT && slot->attempts == 0) slot->notBeforeMs = nowMs + BOT_ALERT_SETTLE_MS;
+    snprintf(slot->chatId, sizeof(slot->chatId), "%s", chatId);
+    snprintf(slot->parseMode, sizeof(slot->parseMode), "%s", parseMode);
+    snprintf(slot->text, sizeof(slot->text), "%s", text);
+    counters.queued++;
+    return true;
+}
+
+// отправка ======================================================================================================================//
+
+BotOutbox::ChatState* BotOutbox::chat(const char* chatId, unsigned long nowMs) {
+    ChatState* oldest = &chats[0];
+    for (ChatState& known : chats) {
+        if (strcmp(known.chatId, chatId) == 0) {
+            known.lastUsedMs = nowMs;
+            return &known;
+        }
+        if (known.chatId[0] == '\0' || (oldest->chatId[0] != '\0' && known.lastUsedMs < oldest->lastUsedMs)) {
+            oldest = &known;
+        }
+    }
+    // чатов больше таблицы - место давно молчавшего; его корзина и так успела бы наполниться
+    snprintf(oldest->chatId, sizeof(oldest->chatId), "%s", chatId);
+    oldest->bucket = { BOT_CHAT_BURST, nowMs };
+    oldest->blockedUntilMs = nowMs;
+    oldest->lastUsedMs = nowMs;
+    return oldest;
+}
+
+// 0 - можно отправлять; сообщения одного чата уходят по порядку, ждущая пачку авария не держит
+// остальные
+uint32_t BotOutbox::waitMs(BotOutMessage& message, unsigned long nowMs) {
+    for (const BotOutMessage& other : slots) {
+        if (other.used && other.seq < message.seq && strcmp(other.chatId, message.chatId) == 0 && !settling(other, nowMs)) {
+            return UINT32_MAX;
+        }
+    }
+
+    ChatState* state = chat(message.chatId, nowMs);
+    refill(state->bucket.tokens, state->bucket.updatedMs, BOT_CHAT_RATE_PER_S, BOT_CHAT_BURST, nowMs);
+    refill(global.tokens, global.updatedMs, BOT_GLOBAL_RATE_PER_S, BOT_GLOBAL_BURST, nowMs);
+
+    uint32_t wait = max(token_wait_ms(state->bucket.tokens, BOT_CHAT_RATE_PER_S),
+                        token_wait_ms(global.tokens, BOT_GLOBAL_RATE_PER_S));
+    if ((long)(message.notBeforeMs - nowMs) > 0) wait = max(wait, (uint32_t)(message.notBeforeMs - nowMs));
+    if ((long)(state->blockedUntilMs - nowMs) > 0) wait = max(wait, (uint32_t)(state->blockedUntilMs - nowMs));
+    return wait;
+}
+
+/**
+ * @brief Самое старое сообщение, которое лимиты пропускают прямо сейчас
+ * @return nullptr - ничего; иначе токены уже взяты: сообщение надо отправить и отдать в complete()
+ */
+BotOutMessage* BotOutbox::ready(unsigned long nowMs) {
+    BotOutMessage* oldest = nullptr;
+    for (BotOutMessage& message : slots) {
+        if (!message.used || (oldest != nullptr && message.seq > oldest->seq)) continue;
+        if (waitMs(message, nowMs) == 0) oldest = &message;
+    }
+    if (oldest == nullptr) return nullptr;
+
+    chat(oldest->chatId, nowMs)->bucket.tokens -= 1.0f;
+    global.tokens -= 1.0f;
+    return oldest;
+}
+
+void BotOutbox::complete(BotOutMessage* message, const BotSendResult& result, unsigned long nowMs) {
+    // сервер считает запрос по приходу, а тот мог задержаться на рукопожатии: время в пути
+    // корзины не пополняет
+    ChatState* state = chat(message->chatId, nowMs);
+    state->bucket.updatedMs = nowMs;
+    global.updatedMs = nowMs;
+
+    switch (result.status) {
+        case BotSendStatus::SENT:
+            counters.sent++;
+            break;
+
+        case BotSendStatus::RATE_LIMITED:
+            // сообщение остается первым в очереди чата, чат молчит, сколько сказал сервер
+            counters.rateLimited++;
+            state->blockedUntilMs = nowMs + max((uint16_t)1, result.retryAfterS) * 1000UL;
+            return;
+
+        case BotSendStatus::FAILED:
+            counters.retried++;
+            if (++message->attempts < BOT_OUTBOX_MAX_ATTEMPTS) {
+                uint32_t backoff = BOT_OUTBOX_RETRY_MIN_MS << (message->attempts - 1);
+                message->notBeforeMs = nowMs + min(backoff, (uint32_t)BOT_OUTBOX_RETRY_MAX_MS);
+                return;
+            }
+            Serial.println("Telegram: сообщение не отправлено, попытки кончились");
+            counters.dropped++;
+            break;
+
+        case BotSendStatus::REJECTED:
+            Serial.println("Telegram: сервер отклонил сообщение");
+            counters.dropped++;
+            break;
+    }
+    message->used = false;
+    pending--;
+}
+
+// UINT32_MAX - очередь пуста
+uint32_t BotOutbox::msUntilReady(unsigned long nowMs) {
+    uint32_t wait = UINT32_MAX;
+    for (BotOutMessage& message : slots) {
+        if (message.used) wait = min(wait, waitMs(message, nowMs));
+    }
+    return wait;
+}
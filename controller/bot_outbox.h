@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bot_api.h"
+#include "bot_link.h"
+
+// Очередь исходящих сообщений бота. Обработчики команд и рассылка аварий только кладут
+// сообщение и идут дальше; отправляет задача бота, когда позволяют лимиты Telegram:
+// корзина токенов на каждый чат (BOT_CHAT_RATE_PER_S) и общая (BOT_GLOBAL_RATE_PER_S).
+// 429 - чат молчит retry_after секунд, сбой сети - повтор с удвоением паузы.
+//
+// Сводка состояния (STATUS) и авария (ALERT) в очереди одна на чат: новая заменяет еще не
+// отправленную. Авария к тому же выжидает BOT_ALERT_SETTLE_MS после последней замены -
+// пачка аварий уходит в чат одним сообщением. Так же одна на чат и правка панели (DASHBOARD):
+// до отправки важен только последний ее вид.
+
+const size_t BOT_MESSAGE_CAPACITY = 1536;           // самый длинный ответ (/perf, /settings) ~1 КБ в UTF-8
+const int BOT_OUTBOX_SLOTS = 8;
+const int BOT_OUTBOX_CHATS = 8;
+const float BOT_CHAT_RATE_PER_S = 1.0f;             // Telegram: не чаще раза в секунду в чат
+const float BOT_CHAT_BURST = 3.0f;
+const float BOT_GLOBAL_RATE_PER_S = 25.0f;          // Telegram: до 30 в секунду на бота
+const float BOT_GLOBAL_BURST = 25.0f;
+const unsigned long BOT_ALERT_SETTLE_MS = 2000;
+const int BOT_OUTBOX_MAX_ATTEMPTS = 6;
+const unsigned long BOT_OUTBOX_RETRY_MIN_MS = 1000;
+const unsigned long BOT_OUTBOX_RETRY_MAX_MS = 60000;
+
+enum class BotOutKind : uint8_t {
+    REPLY,              // ответ на команду - каждый уходит
+    STATUS,             // сводка: важна только последняя
+    ALERT,              // авария: важна только последняя
+    DASHBOARD           // панель /live: создание или правка, важна только последняя
+};
+
+struct BotOutMessage {
+    bool used;
+    BotOutKind kind;
+    uint32_t seq;                       // порядок постановки
+    uint8_t attempts;
+    unsigned long notBeforeMs;
+    int32_t editMessageId;              // не 0 - править это сообщение, а не слать новое
+    const char* replyMarkup;            // клавиатура, строка живет все время работы; nullptr - без нее
+    char chatId[BOT_CHAT_ID_LEN];
+    char parseMode[12];
+    char text[BOT_MESSAGE_CAPACITY];
+};
+
+struct BotOutboxStats {
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t coalesced;                 // заменены более новыми до отправки
+    uint32_t rateLimited;               // ответов 429
+    uint32_t retried;                   // сбоев сети
+    uint32_t dropped;                   // очередь полна, отказ сервера или попытки кончились
+};
+
+class BotOutbox {
+public:
+    // не блокирует; false - сообщение отброшено
+    bool push(BotOutKind kind, const char* chatId, const char* text, const char* parseMode, unsigned long nowMs,
+              int32_t editMessageId = 0, const char* replyMarkup = nullptr);
+
+    BotOutMessage* ready(unsigned long nowMs);          // что можно отправить сейчас, nullptr - ничего
+    void complete(BotOutMessage* message, const BotSendResult& result, unsigned long nowMs);
+    uint32_t msUntilReady(unsigned long nowMs);         // когда лимиты пропустят следующее
+    bool empty() const { return pending == 0; }
+    BotOutboxStats stats() const { return counters; }
+
+private:
+    struct TokenBucket {
+        float tokens;
+        unsigned long updatedMs;
+    };
+
+    struct ChatState {
+        char chatId[BOT_CHAT_ID_LEN];
+        TokenBucket bucket;
+        unsigned long blockedUntilMs;   // 429
+        unsigned long lastUsedMs;
+    };
+
+    ChatState* chat(const char* chatId, unsigned long nowMs);
+    uint32_t waitMs(BotOutMessage& message, unsigned long nowMs);
+
+    BotOutMessage slots[BOT_OUTBOX_SLOTS] = {};
+    ChatState chats[BOT_OUTBOX_CHATS] = {};
+    TokenBucket global = { BOT_GLOBAL_BURST, 0 };
+    uint32_t nextSeq = 0;
+    int pending = 0;
+    BotOutboxStats counters = {};
+};
@@ -1,4 +1,8 @@
 #include <OneButton.h>
+#if defined(ESP32)
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+#endif
 
 const int BUTTON_PINS[] = {13, 12, 14, 27};
 const int NUM_BUTTONS = sizeof(BUTTON_PINS) / sizeof(BUTTON_PINS[0]);
@@ -66,6 +70,16 @@ void buttons_setup() {
         buttons[i]->attachClick(clickHandlers[i]);
     }
 }
+// кнопки замыкают на землю: низкий уровень будит из light sleep
+void buttons_enable_wakeup() {
+#if defined(ESP32)
+    for (int i = 0; i < NUM_BUTTONS; i++) {
+        gpio_wakeup_enable((gpio_num_t)BUTTON_PINS[i], GPIO_INTR_LOW_LEVEL);
+    }
+    esp_sleep_enable_gpio_wakeup();
+#endif
+}
+
 void buttons_update() {
     for (int i = 0; i < NUM_BUTTONS; i++) {
         buttons[i]->tick();
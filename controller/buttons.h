@@ -2,6 +2,7 @@
 
 void buttons_setup();
 void buttons_update();
+void buttons_enable_wakeup();   // кнопки будят из light sleep
 
 bool isButtonEventPending();
 int getNextButtonEvent();
@@ -3,44 +3,203 @@
 #include "sensors.h"
 #include "menu.h"
 #include "motor_impl.h"
+#include "position_store.h"
 #include "window_controller.h"
 #include "tgbot.h"
+#include "scheduler.h"
+#include "power.h"
+#include "profiler.h"
+#include "binlog.h"
 
 WindowController windowController;
 TelegramBot telegramBot;
+
+// задачи планировщика ==========================================================================================================//
+//
+// Вместо опроса всего подряд в каждом loop() - сроки в планировщике, между ними loop() спит.
+// Датчики, бот и логика окна внутри по-прежнему держат свои интервалы и автоматы;
+// период задачи - только как часто их стоит проверять.
+
+const uint32_t MOTOR_ACTIVE_PERIOD_US = 1000;       // мотор едет: шаг регулятора и профиля
+const uint32_t POWER_PERIOD_US = 1000000;
+const uint32_t SCHEDULER_STATS_PERIOD_US = 600000000;
+
+// периоды, которые зависят от режима питания: в энергосбережении реже, между ними - light sleep
+struct JobPeriods {
+    uint32_t motorIdleUs;       // мотор стоит: проверка внешнего поворота и журнал
+    uint32_t buttonsUs;         // OneButton: антидребезг 50 мс, клик 400 мс
+    uint32_t sensorsUs;         // ответ MH-Z19B ждем до 500 мс
+    uint32_t windowUs;
+    uint32_t telegramUs;        // только очереди и снимок, сеть - в задаче бота
+};
+
+const JobPeriods JOB_PERIODS[POWER_MODE_COUNT] = {
+    { 20000, 10000, 50000, 100000, 100000 },            // NORMAL
+    { 200000, 25000, 200000, 1000000, 500000 }          // ENERGY_SAVING
+};
+
+static int motorJob = SCHEDULER_INVALID_JOB;
+static int buttonsJob = SCHEDULER_INVALID_JOB;
+static int sensorsJob = SCHEDULER_INVALID_JOB;
+static int windowJob = SCHEDULER_INVALID_JOB;
+static int telegramJob = SCHEDULER_INVALID_JOB;
+static PowerMode appliedPowerMode = PowerMode::NORMAL;
+
+static const JobPeriods& job_periods() {
+    return JOB_PERIODS[(int)power_get_mode()];
+}
+
+// режим меняет меню; периоды задач догоняют его здесь
+static void apply_power_mode() {
+    if (power_get_mode() == appliedPowerMode) return;
+    appliedPowerMode = power_get_mode();
+    const JobPeriods& periods = job_periods();
+    scheduler_set_period(buttonsJob, periods.buttonsUs);
+    scheduler_set_period(sensorsJob, periods.sensorsUs);
+    scheduler_set_period(windowJob, periods.windowUs);
+    scheduler_set_period(telegramJob, periods.telegramUs);
+    scheduler_wake(motorJob);   // свой период мотор выставит сам
+}
+
+static void motor_job() {
+    ProfileScope scope(ProfileSection::MOTOR);
+    motor_update();             // движение мотора идет по шагам, loop() не блокируется
+    position_store_update();    // журнал положения: пакетные записи во flash
+    scheduler_set_period(motorJob, is_motor_busy() ? MOTOR_ACTIVE_PERIOD_US : job_periods().motorIdleUs);
+}
+
+// задачи, которые могут дать мотору команду, будят его сразу, а не через период простоя
+static void wake_motor_if_busy() {
+    if (is_motor_busy()) {
+        scheduler_wake(motorJob);
+    }
+}
+
+static void buttons_job() {
+    ProfileScope scope(ProfileSection::BUTTONS);
+    buttons_update();
+    if (check_button_event()) {
+        bool blank = !power_display_on();
+        power_note_activity();
+        if (!blank) {           // нажатие на погасшем экране только будит его
+            processButtonPress(get_pressedButtonIndex());
+        }
+        reset_ButtonEvent();
+        apply_power_mode();
+    }
+    wake_motor_if_busy();
+}
+
+// Отправка буфера по I2C блокирует цикл на ~92 мс, а мотор в пути шагает раз в миллисекунду:
+// пока он едет, экран не обновляется, кадр догонит после остановки
+static void display_job() {
+    if (!power_display_on() || is_motor_busy()) return;
+    {
+        ProfileScope scope(ProfileSection::DISPLAY_DRAW);
+        updateDisplay();            // здесь обновляем данные для дисплея
+    }
+    ProfileScope scope(ProfileSection::DISPLAY_FLUSH);
+    display_regular_update();       // и посылаем их на дисплей
+}
+
+static void sensors_job() {
+    {
+        ProfileScope scope(ProfileSection::TEMP_SENSORS);
+        temperature_sensors_update();
+    }
+    ProfileScope scope(ProfileSection::CO2_SENSOR);
+    co2_sensor_update();
+}
+
+static void window_job() {
+    ProfileScope scope(ProfileSection::WINDOW);
+    windowController.update();
+    wake_motor_if_busy();
+}
+
+static void telegram_job() {
+    ProfileScope scope(ProfileSection::TELEGRAM);
+    telegramBot.update(windowController);
+    wake_motor_if_busy();
+}
+
+static void power_job() {
+    power_update();             // гасит экран, замедляет датчики, копит скважность по режимам
+    apply_power_mode();
+}
+
+static void stats_job() {
+    scheduler_print_stats();
+    power_print_stats();
+    profiler_print();
+    BinlogStats binlog = binlog_stats();
+    Serial.println("Binlog: " + String(binlog.written) + " records, dropped " + String(binlog.dropped));
+}
+
+// бюджеты подсистем для счетчика превышений; у задач планировщика - те же
+static void profiler_begin_budgets() {
+    profiler_begin();
+    profiler_set_budget(ProfileSection::MOTOR, 500);
+    profiler_set_budget(ProfileSection::BUTTONS, 1000);
+    profiler_set_budget(ProfileSection::WINDOW, 5000);
+    profiler_set_budget(ProfileSection::DISPLAY_DRAW, 2000);
+    profiler_set_budget(ProfileSection::DISPLAY_FLUSH, 100000);    // 1 КБ буфера по I2C на 100 кГц ~ 92 мс
+    profiler_set_budget(ProfileSection::TEMP_SENSORS, 5000);
+    profiler_set_budget(ProfileSection::CO2_SENSOR, 5000);
+    profiler_set_budget(ProfileSection::TELEGRAM, 2000);
+}
+
+static void scheduler_begin_jobs() {
+    profiler_begin_budgets();
+    power_begin();
+    scheduler_begin(power_scheduler_clock());   // сон между сроками - через режим питания
+    const JobPeriods& periods = job_periods();
+    motorJob = scheduler_every("motor", periods.motorIdleUs, motor_job, 500);
+    buttonsJob = scheduler_every("buttons", periods.buttonsUs, buttons_job, 1000);
+    scheduler_every("display", DISPLAY_UPD_PERIOD_MS * 1000, display_job);
+    sensorsJob = scheduler_every("sensors", periods.sensorsUs, sensors_job, 5000);
+    windowJob = scheduler_every("window", periods.windowUs, window_job, 5000);
+    telegramJob = scheduler_every("telegram", periods.telegramUs, telegram_job, 2000);
+    scheduler_every("power", POWER_PERIOD_US, power_job, 500);
+    scheduler_every("stats", SCHEDULER_STATS_PERIOD_US, stats_job);
+}
+
 void setup() {
     Serial.begin(115200);
+    binlog_begin();             // горячие пути пишут кадрами, текст - tools/binlog_decode
 
     delay(1000);
 
     motor_setup();
+    position_store_begin();
+    windowController.restoreHistory();
     OLED_screen_setup();
     temp_sensors_setup();
     co2_sensor_setup();
 
-    telegramBot.init();
+    telegramBot.init();         // WiFi и TLS подключает задача бота на ядре 0
 
     buttons_setup();
     menu_setup();               // обязательно после сенсоров и дисплея
 
 
-    // первоначальная нормировка положения мотора
-    performHoming();
+    // положение из журнала, если перезагрузка была чистой, иначе - нормировка по упору
+    if (!position_store_restore()) {
+        performHoming();
+    } else {
+        wait_motor_idle(0);     // пробный ход; если энкодер его не насчитал - тут же и хоуминг
+    }
     stop_motor();
+    scheduler_begin_jobs();
+
+    PositionStoreStats stats = position_store_stats();
+    HistoryStoreStats historyStats = history_store_stats();
+    Serial.println("Boot to ready: " + String(millis()) + " ms, position journal writes: " + String(stats.writesTotal) +
+                   ", history restore: " + String(historyStats.restoreMs) + " ms");
 }
 
 void loop() {
-    windowController.update();
-    updateDisplay();            // здесь обновляем данные для дисплея
-    display_regular_update();   // здесь с фиксированной частотой посылаем новые данные на дисплей
-
-    // запросы на read на датчики
-    buttons_update();
-    temperature_sensors_update();
-    co2_sensor_update();
-
-    telegramBot.update(windowController);
-    // delay(5000); // Основной цикл каждые 5 секунд
+    scheduler_loop();
 }
 
 void log_system_status(float metric) {
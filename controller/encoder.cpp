@@ -0,0 +1,257 @@
+#include "encoder.h"
+
+// read() зовут и loop(), и таймер сэмплера - отрезки направления меняем под спинлоком
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+static portMUX_TYPE encoderMux = portMUX_INITIALIZER_UNLOCKED;
+#define ENCODER_LOCK()      portENTER_CRITICAL_SAFE(&encoderMux)
+#define ENCODER_UNLOCK()    portEXIT_CRITICAL_SAFE(&encoderMux)
+#else
+#define ENCODER_LOCK()
+#define ENCODER_UNLOCK()
+#endif
+
+// общая часть ===================================================================================================================//
+
+int64_t Encoder::read() {
+    ENCODER_LOCK();
+    uint64_t edges = readEdges();
+    int64_t value = base + direction * (int64_t)(edges - segmentStartEdges);
+    ENCODER_UNLOCK();
+    return value;
+}
+
+void Encoder::write(int64_t value) {
+    ENCODER_LOCK();
+    base = value;
+    segmentStartEdges = readEdges();
+    ENCODER_UNLOCK();
+}
+
+void Encoder::setDirection(int dir) {
+    if (dir == direction) {
+        return;
+    }
+    // закрываем отрезок старым знаком, ничего не обнуляя в железе - фронты не теряются
+    ENCODER_LOCK();
+    uint64_t edges = readEdges();
+    base += direction * (int64_t)(edges - segmentStartEdges);
+    segmentStartEdges = edges;
+    direction = dir;
+    ENCODER_UNLOCK();
+}
+
+EncoderStats Encoder::getStats() {
+    EncoderStats stats;
+    ENCODER_LOCK();
+    stats.edges = readEdges();
+    ENCODER_UNLOCK();
+    stats.overflows = overflows;
+    stats.lostEdges = lostEdges;
+    return stats;
+}
+
+// модель ========================================================================================================================//
+
+void MockEncoder::inject(uint32_t edges) {
+    injected += edges;
+
+    if (hardwareLimit == 0) {
+        if (masked) {
+            // все фронты окна дают одно отложенное прерывание
+            if (edges > 0) {
+                lostEdges += edges - (edgePending ? 0 : 1);
+                edgePending = true;
+            }
+        } else {
+            counted += edges;
+        }
+        return;
+    }
+
+    hardwareCount += edges;
+    while (hardwareCount >= hardwareLimit) {
+        hardwareCount -= hardwareLimit;
+        pendingOverflows++;
+    }
+    if (!masked) {
+        serviceOverflow();
+    }
+}
+
+void MockEncoder::maskInterrupts(bool masked_) {
+    masked = masked_;
+    if (masked) {
+        return;
+    }
+    if (hardwareLimit == 0) {
+        if (edgePending) {
+            counted++;
+            edgePending = false;
+        }
+    } else {
+        serviceOverflow();
+    }
+}
+
+void MockEncoder::serviceOverflow() {
+    // у PCNT одно событие на все, что накопилось, пока прерывание ждало
+    if (pendingOverflows > 0) {
+        overflows++;
+        counted += (uint64_t)hardwareLimit;
+        pendingOverflows--;
+    }
+    if (pendingOverflows > 0) {
+        // второе переполнение до обработки первого - событие потеряно
+        lostEdges += pendingOverflows * hardwareLimit;
+        pendingOverflows = 0;
+    }
+}
+
+uint64_t MockEncoder::readEdges() {
+    if (hardwareLimit == 0) {
+        return counted;
+    }
+    // переполнение уже произошло, но прерывание еще не обработано: счетчик "откатился" -
+    // учитываем ожидающее переполнение так же, как PcntEncoder::readEdges()
+    return counted + (uint64_t)pendingOverflows * hardwareLimit + hardwareCount;
+}
+
+// ESP32 =========================================================================================================================//
+
+#if defined(ESP32)
+
+#include <Arduino.h>
+#include "driver/pulse_cnt.h"
+
+const int PCNT_HIGH_LIMIT = 32767;  // при достижении счетчик PCNT сбрасывается в 0
+
+class PcntEncoder : public Encoder {
+public:
+    PcntEncoder(int pin, uint32_t glitchFilterNs) : pin(pin), glitchFilterNs(glitchFilterNs) {}
+
+    bool begin() override {
+        pcnt_unit_config_t unitConfig = {};
+        unitConfig.low_limit = -1;
+        unitConfig.high_limit = PCNT_HIGH_LIMIT;
+        if (pcnt_new_unit(&unitConfig, &unit) != ESP_OK) {
+            return false;
+        }
+
+        pcnt_glitch_filter_config_t filterConfig = {};
+        filterConfig.max_glitch_ns = glitchFilterNs;
+        pcnt_unit_set_glitch_filter(unit, &filterConfig);
+
+        pcnt_chan_config_t chanConfig = {};
+        chanConfig.edge_gpio_num = pin;
+        chanConfig.level_gpio_num = -1;
+        if (pcnt_new_channel(unit, &chanConfig, &channel) != ESP_OK) {
+            pcnt_del_unit(unit);
+            return false;
+        }
+        // считаем только передние фронты, как attachInterrupt(..., RISING)
+        pcnt_channel_set_edge_action(channel, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD);
+
+        pcnt_unit_add_watch_point(unit, PCNT_HIGH_LIMIT);
+        pcnt_event_callbacks_t callbacks = {};
+        callbacks.on_reach = onReach;
+        pcnt_unit_register_event_callbacks(unit, &callbacks, this);
+
+        pcnt_unit_enable(unit);
+        pcnt_unit_clear_count(unit);
+        pcnt_unit_start(unit);
+        return true;
+    }
+
+    const char* name() const override { return "pcnt"; }
+
+protected:
+    uint64_t readEdges() override {
+        // переполнения и счетчик читаются не атомарно - повторяем, если между ними пришло событие
+        uint32_t wrapsBefore, wrapsAfter;
+        int raw = 0;
+        do {
+            wrapsBefore = overflows;
+            pcnt_unit_get_count(unit, &raw);
+            wrapsAfter = overflows;
+        } while (wrapsBefore != wrapsAfter);
+
+        uint64_t edges = (uint64_t)wrapsAfter * PCNT_HIGH_LIMIT + (uint32_t)raw;
+        if (edges < lastEdges) {
+            // счетчик уже сброшен, а прерывание еще не обработано (маска на этом ядре)
+            edges += PCNT_HIGH_LIMIT;
+        }
+        lastEdges = edges;
+        return edges;
+    }
+
+private:
+    static bool IRAM_ATTR onReach(pcnt_unit_handle_t, const pcnt_watch_event_data_t*, void* ctx) {
+        static_cast<PcntEncoder*>(ctx)->overflows++;
+        return false;
+    }
+
+    int pin;
+    uint32_t glitchFilterNs;
+    pcnt_unit_handle_t unit = nullptr;
+    pcnt_channel_handle_t channel = nullptr;
+    uint64_t lastEdges = 0;
+};
+
+class IsrEncoder : public Encoder {
+public:
+    explicit IsrEncoder(int pin) : pin(pin) {}
+
+    bool begin() override {
+        instance = this;
+        attachInterrupt(digitalPinToInterrupt(pin), onEdge, RISING);
+        return true;
+    }
+
+    const char* name() const override { return "isr"; }
+
+protected:
+    uint64_t readEdges() override {
+        // 32-битный счетчик атомарен на ESP32, старшие разряды достраиваем по переполнению
+        uint32_t now = edgeCount;
+        if (now < lastLow) {
+            overflows++;
+            high += 1ULL << 32;
+        }
+        lastLow = now;
+        return high + now;
+    }
+
+private:
+    static void IRAM_ATTR onEdge() {
+        instance->edgeCount++;
+    }
+
+    static IsrEncoder* instance;
+    int pin;
+    volatile uint32_t edgeCount = 0;
+    uint32_t lastLow = 0;
+    uint64_t high = 0;
+};
+
+IsrEncoder* IsrEncoder::instance = nullptr;
+
+Encoder* encoder_create_pcnt(int pin, uint32_t glitchFilterNs) {
+    return new PcntEncoder(pin, glitchFilterNs);
+}
+
+Encoder* encoder_create_isr(int pin) {
+    return new IsrEncoder(pin);
+}
+
+#else
+
+Encoder* encoder_create_pcnt(int, uint32_t) {
+    return nullptr;
+}
+
+Encoder* encoder_create_isr(int) {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+
+// Однофазный энкодер: железо только считает фронты, знак задается программно
+// направлением, которое выставили мотору (как раньше делал encoderISR()).
+
+struct EncoderStats {
+    uint64_t edges;         // всего фронтов с момента begin()
+    uint32_t overflows;     // переполнений аппаратного счетчика, учтенных в 64-битном счете
+    uint32_t lostEdges;     // фронтов, о потере которых известно
+};
+
+class Encoder {
+public:
+    virtual ~Encoder() {}
+
+    virtual bool begin() = 0;
+    virtual const char* name() const = 0;
+
+    int64_t read();                     // положение в тиках со знаком
+    void write(int64_t value);          // переустановить положение (хоуминг)
+    void setDirection(int dir);         // +1 / -1, фронты до смены считаются со старым знаком
+    int getDirection() const { return direction; }
+    EncoderStats getStats();
+
+protected:
+    virtual uint64_t readEdges() = 0;   // монотонный 64-битный счетчик фронтов
+
+    volatile uint32_t overflows = 0;
+    volatile uint32_t lostEdges = 0;
+
+private:
+    int64_t base = 0;                   // положение на начало текущего отрезка направления
+    uint64_t segmentStartEdges = 0;     // фронтов на начало отрезка
+    int direction = 0;
+};
+
+// ESP32: аппаратный счетчик импульсов PCNT с глитч-фильтром. nullptr, если собрано не под ESP32.
+Encoder* encoder_create_pcnt(int pin, uint32_t glitchFilterNs);
+
+// Запасной вариант: прерывание на каждый фронт. Фронты, пришедшие пока прерывания
+// запрещены (OneWire), теряются, и обнаружить это нельзя.
+Encoder* encoder_create_isr(int pin);
+
+// Модель для хоста и тестов. Умеет изображать оба бэкенда:
+//  - hardwareLimit > 0: аппаратный счетчик с переполнением на hardwareLimit и отложенным
+//    прерыванием переполнения (как PCNT), фронты не теряются;
+//  - hardwareLimit == 0: счет в прерывании, фронты в окне maskInterrupts() схлопываются в один.
+class MockEncoder : public Encoder {
+public:
+    explicit MockEncoder(uint32_t hardwareLimit = 0) : hardwareLimit(hardwareLimit) {}
+
+    bool begin() override { return true; }
+    const char* name() const override { return hardwareLimit ? "mock-pcnt" : "mock-isr"; }
+
+    void inject(uint32_t edges);        // на вход пришли фронты
+    void maskInterrupts(bool masked);   // окно с запрещенными прерываниями
+    uint64_t injectedEdges() const { return injected; }
+
+protected:
+    uint64_t readEdges() override;
+
+private:
+    void serviceOverflow();
+
+    uint32_t hardwareLimit;
+    uint64_t injected = 0;
+    uint64_t counted = 0;               // isr: счет в прерывании; pcnt: учтенные переполнения * limit
+    uint32_t hardwareCount = 0;         // pcnt: текущее значение аппаратного счетчика
+    uint32_t pendingOverflows = 0;      // pcnt: переполнения, прерывание которых еще не обработано
+    bool masked = false;
+    bool edgePending = false;           // isr: фронт ждет обработки после снятия маски
+};
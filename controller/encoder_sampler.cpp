@@ -0,0 +1,237 @@
+#include "encoder_sampler.h"
+#include "encoder.h"
+#include <atomic>
+#include <math.h>
+
+#if defined(ESP32)
+#include <esp_timer.h>
+#endif
+
+// кольцевой буфер ===============================================================================================================//
+
+struct EncoderSample {
+    uint32_t timeUs;
+    int32_t count;
+};
+
+const uint32_t RING_SIZE = 64;     // степень двойки; 64 мс запаса при периоде 1 мс
+
+static EncoderSample ring[RING_SIZE];
+static std::atomic<uint32_t> ringHead(0);  // пишет только таймер
+static std::atomic<uint32_t> ringTail(0);  // пишет только читатель
+static std::atomic<uint32_t> droppedSamples(0);
+static std::atomic<bool> resetRequested(false);
+static std::atomic<bool> samplingActive(false);    // мотор стоит - кольцо никто не разбирает
+
+static Encoder* sampledEncoder = nullptr;
+
+void encoder_sampler_sample(uint32_t nowUs) {
+    if (sampledEncoder == nullptr || !samplingActive.load(std::memory_order_relaxed)) return;
+
+    uint32_t head = ringHead.load(std::memory_order_relaxed);
+    uint32_t tail = ringTail.load(std::memory_order_acquire);
+    if (head - tail >= RING_SIZE) {
+        // читатель не успевает - теряем новый отсчет, старые остаются согласованными
+        droppedSamples.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring[head % RING_SIZE].timeUs = nowUs;
+    ring[head % RING_SIZE].count = (int32_t)sampledEncoder->read();
+    ringHead.store(head + 1, std::memory_order_release);
+}
+
+static uint32_t samplePeriodUs = ENCODER_SAMPLE_PERIOD_US;
+
+#if defined(ESP32)
+static esp_timer_handle_t sampleTimer = nullptr;
+
+static void sampler_timer_callback(void*) {
+    encoder_sampler_sample((uint32_t)esp_timer_get_time());
+}
+#endif
+
+// таймер создается остановленным: периодический таймер 1 кГц не дал бы чипу уснуть в light sleep
+void encoder_sampler_begin(Encoder* encoder, uint32_t periodUs) {
+    sampledEncoder = encoder;
+    samplePeriodUs = periodUs;
+
+#if defined(ESP32)
+    if (sampleTimer == nullptr) {
+        esp_timer_create_args_t args = {};
+        args.callback = sampler_timer_callback;
+        args.name = "enc_sampler";
+        esp_timer_create(&args, &sampleTimer);
+    }
+#endif
+}
+
+// на хосте отсчеты подает тест через encoder_sampler_sample(), без пуска они отбрасываются
+void encoder_sampler_set_active(bool active) {
+    if (active == samplingActive.load(std::memory_order_relaxed)) return;
+    if (active) {
+        encoder_sampler_reset();        // отсчеты до остановки к новому ходу не относятся
+    }
+    samplingActive.store(active, std::memory_order_release);
+#if defined(ESP32)
+    if (sampleTimer == nullptr) return;
+    if (active) {
+        esp_timer_start_periodic(sampleTimer, samplePeriodUs);
+    } else {
+        esp_timer_stop(sampleTimer);
+    }
+#endif
+}
+
+uint32_t encoder_sampler_dropped() {
+    return droppedSamples.load(std::memory_order_relaxed);
+}
+
+// потоковая оценка ==============================================================================================================//
+//
+// Экспоненциально взвешенный МНК по модели x(tau) = p + v*tau + a*tau^2/2.
+// Начало координат (время и счет) всегда в последнем отсчете: при новом отсчете суммы
+// сдвигаются по биному и затухают - O(1) на отсчет, без потери точности на больших счетах.
+// Время - в миллисекундах, чтобы степени tau оставались в разумном диапазоне.
+
+const double LS_TIME_CONSTANT_MS = 8.0;         // память оценки
+const float LOW_SPEED_VELOCITY = 500.0f;        // ниже - меньше одного фронта на отсчет, верим периоду фронтов
+
+static double S[5];     // sum w * tau^k
+static double B[3];     // sum w * tau^k * x
+static bool haveSample = false;
+static uint32_t lastTimeUs = 0;
+static int32_t lastCount = 0;
+
+// период фронтов: время между изменениями счета
+static uint32_t lastEdgeUs = 0;
+static uint32_t edgePeriodUs = 0;
+static int edgeSign = 0;
+
+static void estimator_reset() {
+    for (int k = 0; k < 5; k++) S[k] = 0.0;
+    for (int k = 0; k < 3; k++) B[k] = 0.0;
+    haveSample = false;
+    edgePeriodUs = 0;
+    edgeSign = 0;
+}
+
+static void estimator_add(uint32_t timeUs, int32_t count) {
+    if (!haveSample) {
+        estimator_reset();
+        haveSample = true;
+        lastTimeUs = timeUs;
+        lastCount = count;
+        lastEdgeUs = timeUs;
+        S[0] = 1.0;
+        return;
+    }
+
+    uint32_t dtUs = timeUs - lastTimeUs;
+    double d = dtUs / 1000.0;
+    double dx = (double)(count - lastCount);
+
+    // сдвиг начала: tau' = tau - d, x' = x - dx
+    double nd = -d;
+    double nd2 = nd * nd, nd3 = nd2 * nd, nd4 = nd3 * nd;
+    double s0 = S[0], s1 = S[1], s2 = S[2], s3 = S[3], s4 = S[4];
+    S[4] = s4 + 4 * nd * s3 + 6 * nd2 * s2 + 4 * nd3 * s1 + nd4 * s0;
+    S[3] = s3 + 3 * nd * s2 + 3 * nd2 * s1 + nd3 * s0;
+    S[2] = s2 + 2 * nd * s1 + nd2 * s0;
+    S[1] = s1 + nd * s0;
+
+    double b0 = B[0] - dx * s0;
+    double b1 = B[1] - dx * s1;
+    double b2 = B[2] - dx * s2;
+    B[2] = b2 + 2 * nd * b1 + nd2 * b0;
+    B[1] = b1 + nd * b0;
+    B[0] = b0;
+
+    double decay = exp(-d / LS_TIME_CONSTANT_MS);
+    for (int k = 0; k < 5; k++) S[k] *= decay;
+    for (int k = 0; k < 3; k++) B[k] *= decay;
+
+    // новый отсчет в начале координат: tau = 0, x = 0
+    S[0] += 1.0;
+
+    if (count != lastCount) {
+        long edges = labs((long)(count - lastCount));
+        edgePeriodUs = (timeUs - lastEdgeUs) / edges;
+        edgeSign = (count > lastCount) ? 1 : -1;
+        lastEdgeUs = timeUs;
+    }
+
+    lastTimeUs = timeUs;
+    lastCount = count;
+}
+
+static void estimator_solve(float& velocity, float& acceleration) {
+    velocity = 0.0f;
+    acceleration = 0.0f;
+
+    // [S0 S1 S2; S1 S2 S3; S2 S3 S4] * [p v a/2] = [B0 B1 B2]
+    double det = S[0] * (S[2] * S[4] - S[3] * S[3])
+               - S[1] * (S[1] * S[4] - S[3] * S[2])
+               + S[2] * (S[1] * S[3] - S[2] * S[2]);
+    if (fabs(det) > 1e-9) {
+        double detV = S[0] * (B[1] * S[4] - S[3] * B[2])
+                    - B[0] * (S[1] * S[4] - S[3] * S[2])
+                    + S[2] * (S[1] * B[2] - B[1] * S[2]);
+        double detA = S[0] * (S[2] * B[2] - B[1] * S[3])
+                    - S[1] * (S[1] * B[2] - B[1] * S[2])
+                    + B[0] * (S[1] * S[3] - S[2] * S[2]);
+        velocity = (float)(detV / det * 1000.0);
+        acceleration = (float)(2.0 * detA / det * 1000000.0);
+        return;
+    }
+
+    // мало отсчетов для параболы - прямая
+    double det2 = S[0] * S[2] - S[1] * S[1];
+    if (fabs(det2) > 1e-9) {
+        velocity = (float)((S[0] * B[1] - S[1] * B[0]) / det2 * 1000.0);
+    }
+}
+
+void encoder_sampler_reset() {
+    resetRequested.store(true, std::memory_order_release);
+}
+
+EncoderMotion encoder_sampler_get_motion(float stallVelocity) {
+    if (resetRequested.exchange(false, std::memory_order_acq_rel)) {
+        ringTail.store(ringHead.load(std::memory_order_acquire), std::memory_order_release);
+        estimator_reset();
+    }
+
+    // разбираем все, что накопил таймер
+    uint32_t head = ringHead.load(std::memory_order_acquire);
+    uint32_t tail = ringTail.load(std::memory_order_relaxed);
+    while (tail != head) {
+        const EncoderSample& sample = ring[tail % RING_SIZE];
+        estimator_add(sample.timeUs, sample.count);
+        tail++;
+    }
+    ringTail.store(tail, std::memory_order_release);
+
+    EncoderMotion motion;
+    estimator_solve(motion.velocity, motion.acceleration);
+    motion.timestampUs = lastTimeUs;
+    motion.sinceLastEdgeUs = haveSample ? lastTimeUs - lastEdgeUs : 0;
+
+    // на малой скорости МНК квантуется по одному фронту - берем период фронтов;
+    // долгое отсутствие фронтов ограничивает скорость сверху (парабола после остановки
+    // еще какое-то время "едет" дальше, а фронтов уже нет)
+    float bound = motion.sinceLastEdgeUs > 0 ? 1000000.0f / motion.sinceLastEdgeUs : INFINITY;
+    float speed = fabsf(motion.velocity);
+    if (edgePeriodUs > 0 && (speed < LOW_SPEED_VELOCITY || speed > bound)) {
+        uint32_t period = edgePeriodUs > motion.sinceLastEdgeUs ? edgePeriodUs : motion.sinceLastEdgeUs;
+        motion.velocity = edgeSign * 1000000.0f / period;
+    }
+
+    float confidence = 0.0f;
+    if (haveSample && stallVelocity > 0.0f) {
+        confidence = 1.0f - fabsf(motion.velocity) / stallVelocity;
+        if (confidence < 0.0f) confidence = 0.0f;
+        if (confidence > 1.0f) confidence = 1.0f;
+    }
+    motion.stallConfidence = confidence;
+    return motion;
+}
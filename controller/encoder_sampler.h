@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+class Encoder;
+
+// Сэмплер энкодера: таймер с фиксированным периодом кладет (время, счет) в кольцевой буфер
+// без блокировок (один писатель - таймер, один читатель - loop()), а потоковая оценка
+// по этим отсчетам в любой момент дает скорость, ускорение и уверенность в остановке.
+
+struct EncoderMotion {
+    float velocity;             // тики/с, со знаком счета
+    float acceleration;         // тики/с^2
+    float stallConfidence;      // 0..1: насколько уверены, что |скорость| ниже порога остановки
+    uint32_t sinceLastEdgeUs;   // сколько прошло с последнего изменения счета
+    uint32_t timestampUs;       // время последнего учтенного отсчета
+};
+
+const uint32_t ENCODER_SAMPLE_PERIOD_US = 1000;
+
+void encoder_sampler_begin(Encoder* encoder, uint32_t periodUs = ENCODER_SAMPLE_PERIOD_US);
+void encoder_sampler_set_active(bool active);           // таймер только пока мотор едет; пуск сбрасывает историю
+void encoder_sampler_sample(uint32_t nowUs);            // писатель: колбэк таймера (на хосте - тест)
+void encoder_sampler_reset();                           // после encoder->write(): старая история не годится
+
+EncoderMotion encoder_sampler_get_motion(float stallVelocity);
+uint32_t encoder_sampler_dropped();                     // отсчетов потеряно из-за переполнения кольца
@@ -0,0 +1,71 @@
+#include "hal.h"
+#include <stdio.h>
+
+// HalLog ========================================================================================================================//
+
+void HalLog::print(const char* text) {
+    if (hal->logEnabled()) hal->log(text);
+}
+
+void HalLog::print(char value) {
+    char text[2] = { value, 0 };
+    print(text);
+}
+
+void HalLog::print(int value) {
+    print((long)value);
+}
+
+void HalLog::print(unsigned int value) {
+    print((unsigned long)value);
+}
+
+void HalLog::print(long value) {
+    if (!hal->logEnabled()) return;
+    char text[24];
+    snprintf(text, sizeof(text), "%ld", value);
+    hal->log(text);
+}
+
+void HalLog::print(unsigned long value) {
+    if (!hal->logEnabled()) return;
+    char text[24];
+    snprintf(text, sizeof(text), "%lu", value);
+    hal->log(text);
+}
+
+void HalLog::print(double value, int digits) {
+    if (!hal->logEnabled()) return;
+    char text[32];
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+    hal->log(text);
+}
+
+void HalLog::println() {
+    print("\n");
+}
+
+// часы и вывод процесса на Arduino ==============================================================================================//
+// Здесь, а не в hal_esp32.cpp: binlog нужен и скетчам без датчиков; хостовые - в hal_host.cpp.
+
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+
+unsigned long hal_millis() {
+    return millis();
+}
+
+unsigned long hal_micros() {
+    return micros();
+}
+
+void hal_write(const uint8_t* data, size_t length) {
+    Serial.write(data, length);
+}
+
+void hal_print(const char* line) {
+    Serial.println(line);
+}
+
+#endif
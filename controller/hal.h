@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "motor_impl.h"
+
+// Все, что логика окна берет у железа: датчики, мотор, часы и журнал.
+//
+// WindowController ходит сюда через тонкий интерфейс WindowHal, а не в sensors.h, motor_impl.h,
+// millis() и Serial напрямую: на ESP32 - бэкенд поверх них (hal_esp32.cpp), на хосте -
+// HostWindowHal (hal_host.h) с часами симуляции и журналом в stdout, который симуляция
+// дополняет своей комнатой и мотором. Так симулируется и меряется тот же код, что прошивается,
+// а у каждого контроллера свой экземпляр - прогоны идут параллельно.
+//
+// Модулям без своего экземпляра (binlog, history_store) нужны только часы и вывод процесса -
+// hal_millis(), hal_micros(), hal_write(), hal_print(); на Arduino они в hal.cpp, на хосте - в hal_host.cpp.
+
+class WindowHal {
+public:
+    virtual ~WindowHal() {}
+
+    // датчики
+    virtual float roomTemp() = 0;
+    virtual bool roomSensorError() = 0;
+    virtual unsigned long roomTempReadTime() = 0;       // millis() последнего показания
+    virtual float outsideTemp() = 0;
+    virtual bool outsideSensorError() = 0;
+    virtual int co2() = 0;
+    virtual bool co2Error() = 0;
+    virtual unsigned long co2ReadTime() = 0;
+
+    // мотор
+    virtual int changePosition(int position) = 0;       // не блокирует, вернет принятую позицию
+    virtual int position() = 0;
+    virtual bool motorBusy() = 0;
+    virtual MotorMoveStatus motorStatus() = 0;
+
+    // часы
+    virtual unsigned long millis() = 0;
+    virtual unsigned long micros() = 0;                 // замеры длительности
+
+    // журнал: готовый текст, переводы строк - в нем самом
+    virtual void log(const char* text) = 0;
+    virtual bool logEnabled() { return true; }          // false - числа для журнала и не форматируются
+};
+
+WindowHal* window_hal_esp32();      // датчики, мотор и Serial прошивки; nullptr не на Arduino
+
+// Вывод в журнал HAL с перегрузками, как у Serial: print(float, 1), println(int)...
+// Числа форматируются на стеке, без String.
+class HalLog {
+public:
+    explicit HalLog(WindowHal* hal) : hal(hal) {}
+
+    void print(const char* text);
+    void print(char value);
+    void print(int value);
+    void print(unsigned int value);
+    void print(long value);
+    void print(unsigned long value);
+    void print(double value, int digits = 2);
+
+    void println();
+    template <typename T>
+    void println(T value) {
+        print(value);
+        println();
+    }
+    void println(double value, int digits) {
+        print(value, digits);
+        println();
+    }
+
+private:
+    WindowHal* hal;
+};
+
+// часы и вывод процесса
+unsigned long hal_millis();
+unsigned long hal_micros();
+void hal_write(const uint8_t* data, size_t length);
+void hal_print(const char* line);   // строка целиком, перевод строки добавится
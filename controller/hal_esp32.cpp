@@ -0,0 +1,44 @@
+#include "hal.h"
+
+// Бэкенд прошивки: датчики sensors.h, мотор motor_impl.h, millis() и Serial.
+// Собирается везде, где есть Arduino: на ESP32 и в тестовых скетчах с заглушками датчиков.
+
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include "sensors.h"
+
+class Esp32WindowHal : public WindowHal {
+public:
+    float roomTemp() override { return get_room_temp(); }
+    bool roomSensorError() override { return get_room_sensor_error(); }
+    unsigned long roomTempReadTime() override { return get_temp_read_time(); }
+    float outsideTemp() override { return get_outside_temp(); }
+    bool outsideSensorError() override { return get_outside_sensor_error(); }
+    int co2() override { return get_last_co2_ppm(); }
+    bool co2Error() override { return get_co2_read_error(); }
+    unsigned long co2ReadTime() override { return get_last_co2_read_time(); }
+
+    int changePosition(int position) override { return change_pos(position); }
+    int position() override { return get_current_position_index(); }
+    bool motorBusy() override { return is_motor_busy(); }
+    MotorMoveStatus motorStatus() override { return get_motor_move_status(); }
+
+    unsigned long millis() override { return ::millis(); }
+    unsigned long micros() override { return ::micros(); }
+
+    void log(const char* text) override { Serial.print(text); }
+};
+
+WindowHal* window_hal_esp32() {
+    static Esp32WindowHal hal;
+    return &hal;
+}
+
+#else
+
+WindowHal* window_hal_esp32() {
+    return nullptr;
+}
+
+#endif
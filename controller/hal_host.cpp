@@ -0,0 +1,41 @@
+#include "hal_host.h"
+
+// Хост без Arduino: сборка CMake под Linux. Скетчи, даже на хосте с заглушками, берут hal_esp32.cpp.
+
+#if !defined(ARDUINO)
+
+#include <chrono>
+#include <stdio.h>
+
+static const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+
+static unsigned long elapsed_us() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - processStart).count();
+}
+
+unsigned long HostWindowHal::micros() {
+    return elapsed_us();
+}
+
+void HostWindowHal::log(const char* text) {
+    if (verbose) fputs(text, stdout);
+}
+
+unsigned long hal_millis() {
+    return elapsed_us() / 1000;
+}
+
+unsigned long hal_micros() {
+    return elapsed_us();
+}
+
+void hal_write(const uint8_t* data, size_t length) {
+    fwrite(data, 1, length, stdout);
+}
+
+void hal_print(const char* line) {
+    puts(line);
+}
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "hal.h"
+
+// Хостовый бэкенд (Linux, g++): часы - время симуляции, которое двигает ее цикл, журнал - stdout
+// или тишина. Датчики и мотор остаются чистыми - их дает симуляция комнаты и мотора.
+// micros() - настоящие, для замеров длительности решений.
+
+class HostWindowHal : public WindowHal {
+public:
+    unsigned long millis() override { return nowMs; }
+    unsigned long micros() override;
+    void log(const char* text) override;
+    bool logEnabled() override { return verbose; }
+
+    void setTime(unsigned long ms) { nowMs = ms; }
+    void setVerbose(bool on) { verbose = on; }
+
+protected:
+    unsigned long nowMs = 0;
+    bool verbose = true;
+};
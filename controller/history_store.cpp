@@ -0,0 +1,303 @@
+#include "history_store.h"
+#include "hal.h"
+#include <stdio.h>
+#include <string.h>
+
+static HistoryStorage* storage = nullptr;
+static PositionHistory* histories = nullptr;
+static int positions = 0;
+
+static uint32_t snapshotSeq = 0;                    // последний целый снимок, 0 - снимков нет
+static unsigned long clockShift = 0;                // часы записей во flash = hal_millis() - clockShift
+static uint32_t logRecords = 0;                     // целых записей в журнале за текущим снимком
+static bool logDamaged = false;                     // в журнале оборванные или чужие записи: дописывать нельзя
+static HistoryLogRecord pending[HISTORY_STORE_DEFER_MAX];
+static int pendingCount = 0;
+static HistoryStoreStats stats = {};
+
+// FNV-1a
+static uint32_t fnv1a(const void* data, size_t length, uint32_t hash = 2166136261u) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint16_t record_checksum(const HistoryLogRecord& record) {
+    uint32_t hash = fnv1a(&record, offsetof(HistoryLogRecord, checksum));
+    return (uint16_t)(hash ^ (hash >> 16));
+}
+
+static size_t payload_size() {
+    return sizeof(PositionHistory) * positions;
+}
+
+static HistoryFile snapshot_file(uint32_t seq) {
+    return (seq % 2 == 0) ? HistoryFile::SNAPSHOT_A : HistoryFile::SNAPSHOT_B;
+}
+
+// снимок ========================================================================================================================//
+
+static bool read_header(HistoryFile file, HistorySnapshotHeader& header) {
+    if (storage->size(file) != sizeof(header) + payload_size()) return false;
+    if (!storage->read(file, 0, &header, sizeof(header))) return false;
+    return header.version == HISTORY_STORE_VERSION && header.positions == positions &&
+           header.payloadSize == payload_size();
+}
+
+// читает снимок прямо в истории; false - снимок битый, истории тогда не определены
+static bool read_snapshot(HistoryFile file, const HistorySnapshotHeader& header) {
+    if (!storage->read(file, sizeof(header), histories, payload_size())) return false;
+    uint32_t checksum = fnv1a(&header, offsetof(HistorySnapshotHeader, checksum));
+    return fnv1a(histories, payload_size(), checksum) == header.checksum;
+}
+
+/**
+ * @brief Свертка: все истории - новым снимком во второй файл, журнал - заново
+ * @details Пока снимок не записан целиком, старый снимок и журнал за ним остаются в силе.
+ * Журнал удаляется уже после: если питание пропадет между ними, его записи несут номер
+ * старого снимка и при загрузке пропускаются.
+ */
+static bool compact() {
+    pendingCount = 0;                               // неполная пачка уже в историях, войдет в снимок
+
+    HistorySnapshotHeader header = {};
+    header.version = HISTORY_STORE_VERSION;
+    header.positions = positions;
+    header.payloadSize = payload_size();
+    header.seq = snapshotSeq + 1;
+    header.savedAtMs = hal_millis();
+    uint32_t checksum = fnv1a(&header, offsetof(HistorySnapshotHeader, checksum));
+    header.checksum = fnv1a(histories, payload_size(), checksum);
+
+    HistoryFile file = snapshot_file(header.seq);
+    if (!storage->write(file, &header, sizeof(header)) || !storage->append(file, histories, payload_size())) {
+        hal_print("History store: snapshot write failed");
+        return false;
+    }
+    snapshotSeq = header.seq;
+    clockShift = 0;                                 // истории в снимке - по нынешним часам
+    logRecords = 0;
+    logDamaged = false;
+    storage->remove(HistoryFile::LOG);
+    stats.compactions++;
+    stats.bytesWritten += sizeof(header) + payload_size();
+    return true;
+}
+
+// загрузка ======================================================================================================================//
+
+/**
+ * @brief Дописывает к историям целые записи журнала за снимком seq
+ * @param haveLast lastMs уже задан (время снимка)
+ * @param lastMs время самой свежей записи
+ * @return false - в журнале есть оборванные или чужие записи, его надо свернуть
+ */
+static bool replay_log(uint32_t seq, bool haveLast, unsigned long& lastMs) {
+    const int CHUNK = 16;
+    HistoryLogRecord chunk[CHUNK];
+    size_t total = storage->size(HistoryFile::LOG) / sizeof(HistoryLogRecord);
+    bool clean = storage->size(HistoryFile::LOG) % sizeof(HistoryLogRecord) == 0;
+
+    for (size_t done = 0; done < total;) {
+        int n = (total - done < (size_t)CHUNK) ? (int)(total - done) : CHUNK;
+        if (!storage->read(HistoryFile::LOG, done * sizeof(HistoryLogRecord), chunk, n * sizeof(HistoryLogRecord))) {
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            const HistoryLogRecord& record = chunk[i];
+            if (record.checksum != record_checksum(record) || record.position >= positions) {
+                return false;                       // оборванная запись: дальше верить нечему
+            }
+            if (record.base != seq) {
+                clean = false;                      // осталась от снимка до свертки
+                continue;
+            }
+            // на хосте unsigned long шире 32 бит: время записи - от предыдущей
+            unsigned long timestamp = haveLast ? lastMs + (int32_t)(record.timestamp - (uint32_t)lastMs)
+                                               : (unsigned long)record.timestamp;
+            histories[record.position].addRecord(record.metric, timestamp);
+            if (!haveLast || (long)(timestamp - lastMs) > 0) lastMs = timestamp;
+            haveLast = true;
+            logRecords++;
+            stats.restoredRecords++;
+        }
+        done += n;
+    }
+    return clean;
+}
+
+void history_store_begin(PositionHistory* histories_, int positions_, HistoryStorage* storage_) {
+    histories = histories_;
+    positions = positions_;
+    storage = storage_;
+    if (storage == nullptr) {
+        storage = history_storage_create_littlefs();
+    }
+    if (storage == nullptr || !storage->begin()) {
+        hal_print("History store unavailable");
+        storage = nullptr;
+        return;
+    }
+
+    unsigned long start = hal_millis();
+    stats = {};
+    pendingCount = 0;
+    logRecords = 0;
+
+    // самый свежий целый снимок; если он оборван - предыдущий
+    HistorySnapshotHeader headers[2];
+    HistoryFile files[2] = { HistoryFile::SNAPSHOT_A, HistoryFile::SNAPSHOT_B };
+    bool valid[2];
+    valid[0] = read_header(files[0], headers[0]);
+    valid[1] = read_header(files[1], headers[1]);
+    int first = (valid[1] && (!valid[0] || (int32_t)(headers[1].seq - headers[0].seq) > 0)) ? 1 : 0;
+
+    int best = -1;
+    for (int i = first, tries = 0; tries < 2; i = 1 - i, tries++) {
+        if (valid[i] && read_snapshot(files[i], headers[i])) {
+            best = i;
+            break;
+        }
+    }
+
+    unsigned long lastMs = 0;
+    if (best >= 0) {
+        snapshotSeq = headers[best].seq;
+        lastMs = (unsigned long)headers[best].savedAtMs;
+    } else {
+        snapshotSeq = 0;
+        for (int i = 0; i < positions; i++) histories[i] = PositionHistory();
+    }
+
+    bool clean = replay_log(snapshotSeq, best >= 0, lastMs);
+    stats.restored = best >= 0 || stats.restoredRecords > 0;
+
+    // часы записей - как будто последняя сделана только что
+    unsigned long now = hal_millis();
+    clockShift = now - lastMs;
+    if (stats.restored) {
+        for (int i = 0; i < positions; i++) histories[i].shiftTime(clockShift);
+    }
+    // свертка - с первой пачкой, а не здесь: запись снимка дольше всей загрузки
+    logDamaged = !clean;
+
+    stats.restoreMs = hal_millis() - start;
+    char line[96];
+    snprintf(line, sizeof(line), "History store: snapshot %lu, %lu log records, %lu ms%s", (unsigned long)snapshotSeq,
+             (unsigned long)stats.restoredRecords, stats.restoreMs, clean ? "" : ", log damaged");
+    hal_print(line);
+}
+
+// запись ========================================================================================================================//
+
+void history_store_record(int position, float metric, unsigned long timestamp, bool motorBusy) {
+    if (storage == nullptr || position < 0 || position >= positions) return;
+
+    HistoryLogRecord& record = pending[pendingCount++];
+    record.base = snapshotSeq;
+    record.timestamp = timestamp - clockShift;
+    record.metric = metric;
+    record.position = position;
+    record.reserved = 0;
+    record.checksum = record_checksum(record);
+
+    if (pendingCount >= HISTORY_STORE_BATCH && (!motorBusy || pendingCount == HISTORY_STORE_DEFER_MAX)) {
+        history_store_flush();
+    }
+}
+
+void history_store_flush() {
+    if (storage == nullptr || pendingCount == 0) return;
+    // за оборванной записью дописанное при загрузке не прочтется
+    if (logDamaged || logRecords + pendingCount > HISTORY_STORE_COMPACT_RECORDS) {
+        compact();
+        return;
+    }
+
+    size_t length = pendingCount * sizeof(HistoryLogRecord);
+    if (!storage->append(HistoryFile::LOG, pending, length)) {
+        hal_print("History store: log write failed");
+        logDamaged = true;                          // хвост мог остаться оборванным
+    } else {
+        logRecords += pendingCount;
+        stats.flushes++;
+        stats.bytesWritten += length;
+    }
+    pendingCount = 0;
+}
+
+HistoryStoreStats history_store_stats() {
+    return stats;
+}
+
+// ESP32 =========================================================================================================================//
+
+#if defined(ESP32)
+
+#include <LittleFS.h>
+
+class LittleFsHistoryStorage : public HistoryStorage {
+public:
+    bool begin() override {
+        return LittleFS.begin(true);                // первый запуск - форматировать раздел
+    }
+
+    size_t size(HistoryFile file) override {
+        File f = LittleFS.open(path(file), "r");
+        if (!f) return 0;
+        size_t length = f.size();
+        f.close();
+        return length;
+    }
+
+    bool read(HistoryFile file, size_t offset, void* data, size_t length) override {
+        File f = LittleFS.open(path(file), "r");
+        if (!f) return false;
+        bool ok = f.seek(offset) && f.read(static_cast<uint8_t*>(data), length) == length;
+        f.close();
+        return ok;
+    }
+
+    bool write(HistoryFile file, const void* data, size_t length) override {
+        return put(file, "w", data, length);
+    }
+
+    bool append(HistoryFile file, const void* data, size_t length) override {
+        return put(file, "a", data, length);
+    }
+
+    bool remove(HistoryFile file) override {
+        return !LittleFS.exists(path(file)) || LittleFS.remove(path(file));
+    }
+
+private:
+    static const char* path(HistoryFile file) {
+        switch (file) {
+            case HistoryFile::SNAPSHOT_A: return "/history_a.bin";
+            case HistoryFile::SNAPSHOT_B: return "/history_b.bin";
+            default: return "/history.log";
+        }
+    }
+
+    bool put(HistoryFile file, const char* mode, const void* data, size_t length) {
+        File f = LittleFS.open(path(file), mode);
+        if (!f) return false;
+        bool ok = f.write(static_cast<const uint8_t*>(data), length) == length;
+        f.close();
+        return ok;
+    }
+};
+
+HistoryStorage* history_storage_create_littlefs() {
+    return new LittleFsHistoryStorage();
+}
+
+#else
+
+HistoryStorage* history_storage_create_littlefs() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "position_history.h"
+
+// Выученная история позиций (position_history.h) во flash: переживает перезагрузку и
+// пропадание питания, контроллер не начинает учиться с нуля.
+//
+// Снимок - все истории целиком с заголовком и контрольной суммой, два файла по очереди:
+// новый пишется поверх более старого, последний целый не трогается. Между снимками новые
+// замеры дописываются в журнал пачками по HISTORY_STORE_BATCH (раз в ~15 мин при замере в
+// минуту). Журнал дорос до HISTORY_STORE_COMPACT_RECORDS - свертка: снимок, журнал пустеет.
+// Каждая запись журнала несет номер снимка, за которым идет, и свою контрольную сумму:
+// оборванная запись и записи, оставшиеся от снимка до свертки, при загрузке пропускаются,
+// а вместо первой же пачки после такой загрузки пишется снимок. Загрузка сама ничего не
+// пишет: только читает снимок и журнал.
+//
+// Запись во flash идет в цикле управления, а свертка переписывает весь снимок - сотни
+// миллисекунд. Пока едет мотор, пачки не пишутся, а копятся до HISTORY_STORE_DEFER_MAX
+// и уходят со следующим замером после остановки.
+//
+// Часов реального времени нет, а millis() после перезагрузки снова с нуля: при загрузке вся
+// история сдвигается так, будто последний замер был только что. Время без питания в возраст
+// записей не идет.
+
+const uint16_t HISTORY_STORE_VERSION = 1;
+const int HISTORY_STORE_BATCH = 15;
+const int HISTORY_STORE_DEFER_MAX = 4 * HISTORY_STORE_BATCH;    // больше мотор не ждем, пишем на ходу
+const int HISTORY_STORE_COMPACT_RECORDS = 360;      // ~6 ч замеров; журнал до 5.8 КБ
+
+enum class HistoryFile : uint8_t {
+    SNAPSHOT_A,
+    SNAPSHOT_B,
+    LOG
+};
+
+struct HistorySnapshotHeader {
+    uint16_t version;
+    uint16_t positions;
+    uint32_t payloadSize;       // sizeof(PositionHistory) * positions - другая раскладка не читается
+    uint64_t savedAtMs;         // время снимка по часам его записей, во всю ширину unsigned long
+    uint32_t seq;               // номер снимка, у последнего - наибольший
+    uint32_t checksum;          // заголовок до этого поля и все истории
+};
+
+struct HistoryLogRecord {
+    uint32_t base;              // номер снимка, за которым идет запись
+    uint32_t timestamp;         // по часам снимка, младшие 32 бита: записи ближе 24 дней друг к другу
+    float metric;
+    uint8_t position;
+    uint8_t reserved;
+    uint16_t checksum;
+};
+
+// файлы: LittleFS на ESP32, память в тестах
+class HistoryStorage {
+public:
+    virtual ~HistoryStorage() {}
+    virtual bool begin() = 0;
+    virtual size_t size(HistoryFile file) = 0;                                  // 0 - файла нет
+    virtual bool read(HistoryFile file, size_t offset, void* data, size_t length) = 0;
+    virtual bool write(HistoryFile file, const void* data, size_t length) = 0;  // файл заново
+    virtual bool append(HistoryFile file, const void* data, size_t length) = 0;
+    virtual bool remove(HistoryFile file) = 0;
+};
+
+HistoryStorage* history_storage_create_littlefs();     // nullptr, если не ESP32
+
+struct HistoryStoreStats {
+    uint32_t restoredRecords;   // замеров из журнала при загрузке
+    unsigned long restoreMs;
+    uint32_t flushes;
+    uint32_t compactions;
+    uint32_t bytesWritten;      // с момента загрузки
+    bool restored;              // при загрузке нашелся целый снимок или журнал
+};
+
+/**
+ * @brief Подключает истории и восстанавливает их из flash
+ * @param histories истории всех позиций, живут все время работы
+ * @param storage nullptr - LittleFS
+ */
+void history_store_begin(PositionHistory* histories, int positions, HistoryStorage* storage = nullptr);
+void history_store_record(int position, float metric, unsigned long timestamp,     // после addRecord()
+                          bool motorBusy = false);                                  // true - запись во flash подождет
+void history_store_flush();             // дописать неполную пачку
+HistoryStoreStats history_store_stats();
@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <array>
 #include "OLED_screen.h"
+#include "power.h"
 // #include "metric_control.h"
 
 #define DBG_PRINT() Serial.println(String(__FILE__) + ":" + String(__LINE__) + " (" + String(__PRETTY_FUNCTION__) + ")")
@@ -310,7 +311,10 @@ void mode_selection_actions(int button_index) {
         Serial.println("Invalid button index!");
         return;
     }
+    if (button_index > MODE_ENERGY_SAVING) return;  // кнопка 3 - назад без смены режима
+
     menu_ctx.mode = (MODE)button_index;
+    power_set_mode(menu_ctx.mode == MODE_ENERGY_SAVING ? PowerMode::ENERGY_SAVING : PowerMode::NORMAL);
 }
 
 void temp_actions(int button_index) {
@@ -0,0 +1,76 @@
+#include "message_builder.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char TRUNCATION_MARK[] = "...";
+static const size_t TRUNCATION_RESERVE = sizeof(TRUNCATION_MARK);      // метка и '\0'
+
+MessageBuilder::MessageBuilder(char* buffer, size_t capacity) : buffer(buffer), capacity(capacity) {
+    clear();
+}
+
+void MessageBuilder::clear() {
+    used = 0;
+    overflow = false;
+    if (capacity > 0) buffer[0] = '\0';
+}
+
+// место под метку держим всегда, чтобы обрезка не затирала уже собранное;
+// буфер к этому моменту заполнен дальше capacity - TRUNCATION_RESERVE
+void MessageBuilder::markTruncated() {
+    if (overflow || capacity < TRUNCATION_RESERVE) {
+        overflow = true;
+        return;
+    }
+    overflow = true;
+    used = capacity - TRUNCATION_RESERVE;
+    // не рвем многобайтный символ UTF-8 пополам
+    while (used > 0 && ((unsigned char)buffer[used] & 0xC0) == 0x80) {
+        used--;
+    }
+    memcpy(buffer + used, TRUNCATION_MARK, sizeof(TRUNCATION_MARK));
+    used += sizeof(TRUNCATION_MARK) - 1;
+}
+
+MessageBuilder& MessageBuilder::add(const char* text) {
+    return add(text, strlen(text));
+}
+
+MessageBuilder& MessageBuilder::add(const char* text, size_t length) {
+    if (overflow) return *this;
+    if (capacity < TRUNCATION_RESERVE) {
+        markTruncated();
+        return *this;
+    }
+    if (used + length + TRUNCATION_RESERVE > capacity) {
+        size_t room = capacity - used - TRUNCATION_RESERVE;
+        memcpy(buffer + used, text, room + 1);      // и первый не влезший байт - по нему видна граница символа
+        markTruncated();
+        return *this;
+    }
+    memcpy(buffer + used, text, length);
+    used += length;
+    buffer[used] = '\0';
+    return *this;
+}
+
+MessageBuilder& MessageBuilder::addf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vaddf(format, args);
+    va_end(args);
+    return *this;
+}
+
+MessageBuilder& MessageBuilder::vaddf(const char* format, va_list args) {
+    if (overflow) return *this;
+    size_t room = capacity - used;
+    int written = vsnprintf(buffer + used, room, format, args);
+    if (written < 0) return *this;
+    if ((size_t)written + TRUNCATION_RESERVE > room) {
+        markTruncated();
+        return *this;
+    }
+    used += written;
+    return *this;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdarg.h>
+
+// Сборка текста сообщения в чужом буфере фиксированного размера - без кучи.
+// Длинное сообщение обрезается с "..." на конце, truncated() это покажет.
+// Постоянные куски текста - обычные const char[]: на ESP32 они и так лежат во flash.
+
+class MessageBuilder {
+public:
+    MessageBuilder(char* buffer, size_t capacity);
+
+    MessageBuilder& add(const char* text);
+    MessageBuilder& add(const char* text, size_t length);
+    MessageBuilder& addf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    MessageBuilder& vaddf(const char* format, va_list args);
+    void clear();
+
+    const char* c_str() const { return buffer; }
+    size_t length() const { return used; }
+    bool truncated() const { return overflow; }
+
+private:
+    void markTruncated();
+
+    char* buffer;
+    size_t capacity;
+    size_t used = 0;
+    bool overflow = false;
+};
@@ -0,0 +1,88 @@
+#include "metric_trend.h"
+#include <math.h>
+
+static float confidence_of(float slope, float slopeError) {
+    if (slopeError <= 0.0f) return slope != 0.0f ? 1.0f : 0.0f;
+    float t2 = (slope / slopeError) * (slope / slopeError);
+    return t2 / (t2 + TREND_CONFIDENCE_T2);
+}
+
+void MetricTrend::reset() {
+    *this = MetricTrend(timeConstant);
+}
+
+void MetricTrend::addSample(float value, unsigned long timestamp) {
+    if (!started) {
+        started = true;
+        lastMs = timestamp;
+        weight = 1.0f;
+        weightSq = 1.0f;
+        meanTime = 0.0f;
+        meanValue = value;
+        covTT = covTV = covVV = 0.0f;
+        return;
+    }
+
+    long deltaMs = (long)(timestamp - lastMs);
+    float dt = deltaMs > 0 ? deltaMs / 1000.0f : 0.0f;
+    lastMs = timestamp;
+
+    // старые отсчеты легчают, нормированные средние и ковариации от этого не меняются
+    float decay = expf(-dt / timeConstant);
+    weight = weight * decay + 1.0f;
+    weightSq = weightSq * decay * decay + 1.0f;
+    meanTime -= dt;                                 // время - от нового отсчета
+
+    float a = 1.0f / weight;
+    float dT = -meanTime;
+    float dV = value - meanValue;
+    meanTime += a * dT;
+    meanValue += a * dV;
+    covTT = (1.0f - a) * (covTT + a * dT * dT);
+    covTV = (1.0f - a) * (covTV + a * dT * dV);
+    covVV = (1.0f - a) * (covVV + a * dV * dV);
+}
+
+float MetricTrend::effectiveSamples() const {
+    return weightSq > 0.0f ? weight * weight / weightSq : 0.0f;
+}
+
+static float age_s(unsigned long currentTime, unsigned long sampleMs) {
+    long ageMs = (long)(currentTime - sampleMs);
+    return ageMs > 0 ? ageMs / 1000.0f : 0.0f;
+}
+
+bool MetricTrend::ready(unsigned long currentTime) const {
+    return started && effectiveSamples() >= TREND_MIN_SAMPLES && covTT > 0.0f &&
+           age_s(currentTime, lastMs) <= TREND_STALE_CONSTANTS * timeConstant;
+}
+
+TrendEstimate MetricTrend::estimate(unsigned long currentTime) const {
+    TrendEstimate result = { meanValue, 0.0f, 0.0f, 0.0f };
+    if (!ready(currentTime)) return result;
+
+    float samples = effectiveSamples();
+    float slope = covTV / covTT;
+    float level = meanValue - slope * meanTime;     // на момент последнего отсчета
+    float age = age_s(currentTime, lastMs);
+
+    float residual = covVV - covTV * slope;
+    if (residual < 0.0f) residual = 0.0f;
+    float variance = residual * samples / (samples - 2.0f);
+    float slopeError = sqrtf(variance / (samples * covTT));
+
+    result.level = level + slope * age;
+    result.slope = slope;
+    result.slopeError = slopeError;
+    result.confidence = confidence_of(slope, slopeError);
+    return result;
+}
+
+TrendEstimate trend_combine(const TrendEstimate& x, float a, const TrendEstimate& y, float b) {
+    TrendEstimate result;
+    result.level = a * x.level + b * y.level;
+    result.slope = a * x.slope + b * y.slope;
+    result.slopeError = sqrtf(a * a * x.slopeError * x.slopeError + b * b * y.slopeError * y.slopeError);
+    result.confidence = confidence_of(result.slope, result.slopeError);
+    return result;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Наклон метрики по потоку показаний датчика: взвешенная регрессия по времени, вес отсчета
+// exp(-возраст / timeConstant) - рекурсивный МНК с забыванием.
+//
+// Хранятся только взвешенные средние и ковариации времени и значения (как у Уэлфорда):
+// новый отсчет - O(1) и без вычитания больших сумм, время считается от последнего отсчета.
+// Кроме наклона - его стандартная ошибка по остаткам и эффективному числу отсчетов
+// (W^2 / сумма квадратов весов) и уверенность t^2 / (t^2 + TREND_CONFIDENCE_T2), t = наклон / ошибка:
+// шум дает уверенность около нуля, устойчивый рост - около единицы. Отсчеты идут неравномерно
+// (5 с, 10 с, в энергосбережении в 6 раз реже), пропуски - не беда: старое просто весит меньше.
+
+const float TREND_TIME_CONSTANT_S = 120.0f;
+const float TREND_CONFIDENCE_T2 = 9.0f;         // t = 3 - уверенность 0.5
+const float TREND_MIN_SAMPLES = 4.0f;           // меньше эффективных отсчетов - наклона нет
+const float TREND_STALE_CONSTANTS = 3.0f;       // отсчетов нет дольше 3 постоянных - тренда нет
+
+struct TrendEstimate {
+    float level;        // сглаженное значение на момент запроса
+    float slope;        // в секунду
+    float slopeError;   // стандартная ошибка наклона
+    float confidence;   // 0..1
+};
+
+class MetricTrend {
+public:
+    explicit MetricTrend(float timeConstantS = TREND_TIME_CONSTANT_S) : timeConstant(timeConstantS) {}
+
+    void addSample(float value, unsigned long timestamp);
+    TrendEstimate estimate(unsigned long currentTime) const;   // не ready() - наклон 0, уверенность 0
+    bool ready(unsigned long currentTime) const;                // отсчетов хватает, и они свежие
+    void reset();
+
+    float effectiveSamples() const;
+    unsigned long lastSampleMs() const { return lastMs; }
+
+private:
+    float timeConstant;
+    bool started = false;
+    unsigned long lastMs = 0;
+
+    float weight = 0.0f;        // сумма весов
+    float weightSq = 0.0f;      // сумма квадратов весов
+    float meanTime = 0.0f;      // с, от последнего отсчета (<= 0)
+    float meanValue = 0.0f;
+    float covTT = 0.0f;         // взвешенные (ко)вариации на единицу веса
+    float covTV = 0.0f;
+    float covVV = 0.0f;
+};
+
+// наклон суммы a * x + b * y независимых метрик
+TrendEstimate trend_combine(const TrendEstimate& x, float a, const TrendEstimate& y, float b);
@@ -0,0 +1,80 @@
+#include "motion_profile.h"
+#include <math.h>
+
+void TrapezoidProfile::plan(float distance_, float v0_, float vMax, float accel_, float decel_) {
+    distance = distance_ > 0.0f ? distance_ : 0.0f;
+    accel = accel_;
+    decel = decel_;
+    v0 = v0_ > 0.0f ? v0_ : 0.0f;
+
+    // пиковая скорость, при которой разгон + торможение укладываются ровно в путь
+    float vReach = sqrtf((2.0f * distance + v0 * v0 / accel) / (1.0f / accel + 1.0f / decel));
+    vPeak = fminf(vMax, vReach);
+
+    if (vPeak < v0) {
+        // уже едем быстрее, чем можно: сразу тормозим
+        vPeak = v0;
+    }
+
+    tAccel = (vPeak - v0) / accel;
+    dAccel = (vPeak * vPeak - v0 * v0) / (2.0f * accel);
+    tDecel = vPeak / decel;
+    float dDecel = vPeak * vPeak / (2.0f * decel);
+
+    dCruise = distance - dAccel - dDecel;
+    if (dCruise < 0.0f) dCruise = 0.0f;
+    tCruise = (vPeak > 0.0f) ? dCruise / vPeak : 0.0f;
+}
+
+void TrapezoidProfile::sample(float t, float& pos, float& vel) const {
+    if (t <= 0.0f) {
+        pos = 0.0f;
+        vel = v0;
+        return;
+    }
+    if (t < tAccel) {
+        vel = v0 + accel * t;
+        pos = v0 * t + 0.5f * accel * t * t;
+        return;
+    }
+    t -= tAccel;
+    if (t < tCruise) {
+        vel = vPeak;
+        pos = dAccel + vPeak * t;
+        return;
+    }
+    t -= tCruise;
+    if (t < tDecel) {
+        vel = vPeak - decel * t;
+        pos = dAccel + dCruise + vPeak * t - 0.5f * decel * t * t;
+        return;
+    }
+    vel = 0.0f;
+    pos = distance;
+}
+
+float TrapezoidProfile::accelAt(float t) const {
+    if (t < 0.0f) return 0.0f;
+    if (t < tAccel) return accel;
+    if (t < tAccel + tCruise) return 0.0f;
+    if (t < tAccel + tCruise + tDecel) return -decel;
+    return 0.0f;
+}
+
+float TrapezoidProfile::duration() const {
+    return tAccel + tCruise + tDecel;
+}
+
+float SpeedPI::update(float error, float dt, float feedforward) {
+    float out = feedforward + kp * error + ki * (integral + error * dt);
+
+    // anti-windup: интегрируем, только если выход не упирается в ограничение в ту же сторону
+    if ((out < outMax || error < 0.0f) && (out > outMin || error > 0.0f)) {
+        integral += error * dt;
+    }
+
+    out = feedforward + kp * error + ki * integral;
+    if (out > outMax) out = outMax;
+    if (out < outMin) out = outMin;
+    return out;
+}
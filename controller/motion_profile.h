@@ -0,0 +1,33 @@
+#pragma once
+
+// Трапецеидальный профиль скорости (разгон / крейсер / торможение) и ПИ-регулятор скорости.
+
+struct TrapezoidProfile {
+    float distance = 0.0f;      // путь, тики
+    float v0 = 0.0f;            // начальная скорость, тики/с
+    float vPeak = 0.0f;         // максимальная достигнутая скорость, тики/с
+    float accel = 1.0f;         // ускорение разгона, тики/с^2
+    float decel = 1.0f;         // ускорение торможения, тики/с^2
+
+    float tAccel = 0.0f;        // длительности фаз, с
+    float tCruise = 0.0f;
+    float tDecel = 0.0f;
+    float dAccel = 0.0f;        // путь на разгоне, тики
+    float dCruise = 0.0f;       // путь на крейсерской скорости, тики
+
+    void plan(float distance, float v0, float vMax, float accel, float decel);
+    void sample(float t, float& pos, float& vel) const;
+    float accelAt(float t) const;
+    float duration() const;
+};
+
+struct SpeedPI {
+    float kp = 0.0f;
+    float ki = 0.0f;
+    float outMin = 0.0f;
+    float outMax = 0.0f;
+    float integral = 0.0f;
+
+    void reset() { integral = 0.0f; }
+    float update(float error, float dt, float feedforward);
+};
@@ -1,5 +1,9 @@
 #include <Arduino.h>
 #include "motor_impl.h"
+#include "motion_profile.h"
+#include "encoder.h"
+#include "encoder_sampler.h"
+#include "binlog.h"
 
 #define DBG_PRINT() Serial.println(String(__PRETTY_FUNCTION__) + ":" + String(__LINE__))
 
@@ -8,11 +12,12 @@ const int MOTOR_DIR_PIN = 19;           // Пин направления -> на
 const int ENCODER_OUTPUT_PIN = 26;      // encoder pin
 
 const int PWM_FREQ = 20000;         // Частота ШИМ
-const int PWM_RESOLUTION_BITS = 8;  // Разрешение ШИМ (8 бит = 0-255)
+const int PWM_RESOLUTION_BITS = 10; // Разрешение ШИМ (10 бит = 0-1023, при 20 кГц LEDC дает максимум 11 бит)
 
-volatile long encoderCount = 0;
+const uint32_t ENCODER_GLITCH_FILTER_NS = 1000;   // импульсы короче - помехи (период фронтов на полной скорости ~200 мкс)
+
+static Encoder* encoder = nullptr;  // PCNT, при неудаче - прерывание на каждый фронт
 long lastStoppedEncoderCount = 0;
-volatile int current_motor_dir = 0; // 1 - вперед, -1 - назад
 
 bool ledcAttached = false;
 
@@ -30,45 +35,106 @@ static long initialencoderCount = 0;                        // Начальна
 
 // static float requiredRevolutions = 0.0;                     // Требуемое количество оборотов (может быть дробным)
 static int requiredDirection = 1;                           // Требуемое направление: 1 для FORWARD, -1 для BACKWARD
-static int requiredSpeed = 0;                               // Требуемая скорость (0-1023 для 10-битного PWM)
+static int requiredSpeed = 0;                               // Ограничение ШИМ для задачи (0-1023 для 10-битного PWM)
+
+// профиль скорости и регулятор ================================================
+const float PROFILE_MAX_VELOCITY   = 4500.0f;               // крейсерская скорость, тики/с
+const float PROFILE_ACCEL          = 20000.0f;              // разгон, тики/с^2
+const float PROFILE_DECEL          = 10000.0f;              // торможение, тики/с^2
+const float PROFILE_CREEP_VELOCITY = 150.0f;                // минимальная скорость доезда до цели, тики/с
+const float MOTOR_VELOCITY_PER_DUTY = 5.0f;                 // тики/с на единицу ШИМ (прямая связь регулятора)
+const float MOTOR_TIME_CONSTANT_S  = 0.06f;                 // постоянная времени разгона (прямая связь по ускорению)
+const float SPEED_KP               = 0.05f;                 // ПИ по скорости: ед. ШИМ на тик/с
+const float SPEED_KI               = 1.0f;                  // ед. ШИМ на тик
+const float POSITION_KP            = 10.0f;                 // коррекция скорости по отставанию от профиля, 1/с
+const float STOP_LOOKAHEAD_S       = 0.02f;                 // выбег после снятия ШИМ, с
+const unsigned long CONTROL_PERIOD_US     = 5000;           // период регулятора
+const unsigned long REVERSAL_DEAD_TIME_MS = 60;             // пауза без ШИМ перед сменой направления
+const unsigned long REVERSAL_MAX_WAIT_MS  = 300;            // дольше вал не ждем, даже если энкодер еще тикает
+const float MOVE_STALL_VELOCITY    = 60.0f;                 // ниже ползучей скорости - вал заклинило, тики/с
+const float MOVE_STALL_CONFIDENCE  = 0.5f;
+const unsigned long MOVE_STALL_GRACE_MS   = 100;            // после старта профиля вал еще разгоняется
+const unsigned long MOVE_STALL_CONFIRM_MS = 20;
+const int MOVE_STALL_MIN_DUTY      = 100;                   // на ползучей скорости ШИМ у мертвой зоны - это не заклинивание
+
+static TrapezoidProfile moveProfile;
+static SpeedPI speedPI = { SPEED_KP, SPEED_KI, 0.0f, (float)MOTOR_PWM_MAX };
+static unsigned long profileStartUs = 0;                    // старт профиля (после паузы реверса)
+static unsigned long lastControlUs = 0;
+static long lastControlProgress = 0;
+static float measuredVelocity = 0.0f;                       // скорость вдоль направления задачи, тики/с
+static bool moveStalled = false;                            // задача снята по заклиниванию
+static bool moveStallCandidate = false;
+static unsigned long moveStallSinceUs = 0;
+
+static int motorPwm = 0;                                    // последняя выставленная скважность
+static int motorDirPin = 0;                                 // последнее выставленное направление
+static int lastDriveDir = 0;                                // направление, в котором последний раз был ШИМ (stop_motor() пишет DIR = 0)
+static unsigned long lastDriveMs = 0;                       // когда последний раз ШИМ был > 0
+
+static bool reversalPending = false;                        // ждем остановки вала перед реверсом
+static unsigned long reversalStartUs = 0;
+static unsigned long reversalDeadlineUs = 0;                // минимальная пауза без ШИМ
+static long reversalLastCount = 0;
 
 int curr_pos_ind = 0;
 
-volatile unsigned long isrCallCount = 0;
+// асинхронное перемещение по позициям
+static int target_pos_ind = 0;                              // позиция, в которую едем (или приехали)
+static unsigned long moveStartTime = 0;                     // время постановки (или перенацеливания) задачи
+static unsigned long moveTimeout = DFLT_TIMEOUT;            // таймаут текущей задачи
+static MotorMoveStatus moveStatus = MotorMoveStatus::IDLE;
+static MotorMoveCallback moveCallback = nullptr;
 
-void IRAM_ATTR encoderISR() {
-  encoderCount += current_motor_dir;
+long get_encoder() {
+    return (long)encoder->read();
 }
 
 void updateStoppedPosition() {
-    lastStoppedEncoderCount = encoderCount;
+    lastStoppedEncoderCount = get_encoder();
 }
 
-long get_encoder() {
-    return encoderCount;
+void motor_set_encoder(Encoder* enc) {
+    encoder = enc;
+}
+
+EncoderStats get_encoder_stats() {
+    return encoder->getStats();
+}
+
+const char* get_encoder_backend() {
+    return encoder->name();
 }
 
 // Forward declaration
 
 void stop_motor();
 void set_motor_speed(int speed, int direction);
+static void homing_update();
+static void cancel_resync();
+static void backlash_drive(int direction);
+static void backlash_external(long ticks);
 
 // basic motor management =======================================================================================================//
 
 void stop_motor() {
     set_motor_speed(0, 0);
     motorMoveTaskActive = false;
-    resetEncoderVelocityCalculation();
     Serial.println("Motor STOPPED (direction preserved)");
 }
 
 void set_motor_speed(int speed, int direction) {
-    assert(speed >= 0 && speed <= 255);
+    assert(speed >= 0 && speed <= MOTOR_PWM_MAX);
     assert(direction == 0 || direction == 1);
 
     if (speed > 0) {
-        current_motor_dir = (direction == 1) ? 1 : -1;
+        encoder->setDirection((direction == 1) ? 1 : -1);
+        lastDriveMs = millis();
+        lastDriveDir = direction;
+        backlash_drive(direction);
     }
+    motorPwm = speed;
+    motorDirPin = direction;
     if (!ledcAttached) {
         if (ledcAttach(MOTOR_PWM_PIN, PWM_FREQ, PWM_RESOLUTION_BITS)) {
             ledcAttached = true;
@@ -83,7 +149,15 @@ void set_motor_speed(int speed, int direction) {
 //     Serial.print(", DIR=");
 //     Serial.print(direction ? "HIGH" : "LOW");
 //     Serial.print(", CurrentDir=");
-//     Serial.println(current_motor_dir);
+//     Serial.println(encoder->getDirection());
+}
+
+int get_motor_pwm() {
+    return motorPwm;
+}
+
+int get_motor_direction() {
+    return motorDirPin;
 }
 
 void detach_motor_pwm() {
@@ -114,8 +188,22 @@ void motor_setup() {
         Serial.println("LEDC initialization failed - using digital writes");
     }
 
-    // Подключение прерывания
-    attachInterrupt(digitalPinToInterrupt(ENCODER_OUTPUT_PIN), encoderISR, RISING);
+    // Энкодер: аппаратный счетчик, если доступен, иначе прерывание на каждый фронт
+    if (encoder == nullptr) {
+        encoder = encoder_create_pcnt(ENCODER_OUTPUT_PIN, ENCODER_GLITCH_FILTER_NS);
+        if (encoder == nullptr || !encoder->begin()) {
+            Serial.println("PCNT unavailable - falling back to encoder ISR");
+            delete encoder;
+            encoder = encoder_create_isr(ENCODER_OUTPUT_PIN);
+            encoder->begin();
+        }
+    } else {
+        encoder->begin();
+    }
+    Serial.println("Encoder backend: " + String(encoder->name()));
+
+    // скорость и ускорение вала считаем по отсчетам таймера, а не по вызовам loop()
+    encoder_sampler_begin(encoder);
 
     Serial.println("Setup complete. Starting motor test...");
     Serial.println("---");
@@ -142,18 +230,19 @@ bool checkExternalMovement(long threshold = CRIT_THRESHOLD) {
         return false;
     }
     // Проверяем разницу с последней зафиксированной позицией
-    long positionDiff = abs(encoderCount - lastStoppedEncoderCount);
+    long positionDiff = abs(get_encoder() - lastStoppedEncoderCount);
 
     if (positionDiff >= threshold) {
         Serial.print("EXTERNAL MOVEMENT DETECTED! Diff: ");
         Serial.print(positionDiff);
         Serial.print(" ticks (");
-        Serial.print(encoderCount);
+        Serial.print(get_encoder());
         Serial.print(" vs ");
         Serial.print(lastStoppedEncoderCount);
         Serial.println(")");
 
         // Обновляем эталонную позицию на текущую
+        backlash_external(positionDiff);
         updateStoppedPosition();
         return true;
     }
@@ -169,56 +258,131 @@ void setMotorMoveTask(unsigned long ticks, int direction, int speed) {
         stop_motor();
         return;
     }
-//
-//     if (checkExternalMovement) {
-//         Serial.println("External movement caught");
-//         reset_motor();
-//     }
 
-    // проверка на значения direction
+    // при перенацеливании в ту же сторону профиль стартует с текущей скорости
+    float v0 = (motorMoveTaskActive && direction == requiredDirection) ? measuredVelocity : 0.0f;
 
     // requiredRevolutions = ticks;
     requiredDirection = direction;
-    requiredSpeed = constrain(speed, 0, 1023);
+    requiredSpeed = constrain(speed, 0, MOTOR_PWM_MAX);
     targetTickCount = ticks; // (long)(requiredRevolutions * ENCODER_RESOLUTION);
-    initialencoderCount = encoderCount;
+    initialencoderCount = get_encoder();
     motorMoveTaskActive = true;
+    encoder_sampler_set_active(true);
+
+    moveProfile.plan(ticks, v0, PROFILE_MAX_VELOCITY, PROFILE_ACCEL, PROFILE_DECEL);
+    speedPI.outMax = requiredSpeed;
+    speedPI.reset();
+    measuredVelocity = v0;
+    lastControlProgress = 0;
+    moveStalled = false;
+    moveStallCandidate = false;
+
+    // реверс: сначала выдерживаем паузу без ШИМ и ждем, пока вал остановится -
+    // иначе фронты выбега энкодер посчитает уже в новом направлении
+    unsigned long nowUs = micros();
+    unsigned long sinceDrive = millis() - lastDriveMs;
+    reversalPending = (direction != lastDriveDir) && (motorPwm > 0 || sinceDrive < REVERSAL_DEAD_TIME_MS);
+    if (reversalPending) {
+        set_motor_speed(0, lastDriveDir);
+        unsigned long wait = (motorPwm > 0 || sinceDrive > REVERSAL_DEAD_TIME_MS) ? REVERSAL_DEAD_TIME_MS
+                                                                                  : REVERSAL_DEAD_TIME_MS - sinceDrive;
+        reversalStartUs = nowUs;
+        reversalDeadlineUs = nowUs + wait * 1000UL;
+        reversalLastCount = get_encoder();
+    }
+    profileStartUs = nowUs;
+    lastControlUs = nowUs;
 
-    Serial.print("Move Task: ");
-    Serial.print("dir=");
-    Serial.print(requiredDirection);
-    Serial.print(", speed=");
-    Serial.print(requiredSpeed);
-    Serial.print(", target=");
-    Serial.print(targetTickCount);
-    Serial.print(" ticks (current: ");
-    Serial.print(encoderCount);
-    Serial.println(")");
+    BINLOG_INFO(MOVE_TASK, requiredDirection, requiredSpeed, targetTickCount, get_encoder(), moveProfile.duration());
 }
 
+/**
+ * @brief Шаг регулятора задачи движения
+ *
+ * Скорость ведется по трапецеидальному профилю: опорная скорость профиля плюс
+ * поправка на отставание по положению, ШИМ - прямая связь + ПИ по скорости энкодера.
+ * Остановка - по положению с учетом выбега, поэтому цель отрабатывается с точностью до тиков.
+ */
 bool MotorExecMoveTask() {
     if (!motorMoveTaskActive) {
         return false;
     }
 
-    long currentDisplacement = encoderCount - initialencoderCount;
-    long absoluteDisplacement = abs(currentDisplacement);
+    const long dirSign = (requiredDirection == 1) ? 1 : -1;
+    long count = get_encoder();
+    long progress = (count - initialencoderCount) * dirSign;
 
     // // ДЛЯ ОТЛАДКИ - выводим реальные значения
-    // Serial.println("DEBUG: curr=" + String(encoderCount) +
+    // Serial.println("DEBUG: curr=" + String(get_encoder()) +
     //               ", init=" + String(initialencoderCount) +
-    //               ", disp=" + String(currentDisplacement) +
+    //               ", disp=" + String(progress) +
     //               ", target=" + String(targetTickCount));
 
-    if (absoluteDisplacement >= targetTickCount) {
+    if (progress + measuredVelocity * STOP_LOOKAHEAD_S >= targetTickCount) {
         stop_motor();
-        lastStoppedEncoderCount = encoderCount;
-        Serial.println("Move COMPLETED. Ticks: " + String(absoluteDisplacement));
+        lastStoppedEncoderCount = count;
+        BINLOG_INFO(MOVE_COMPLETED, progress);
         return false;
     }
 
+    unsigned long nowUs = micros();
+    if (nowUs - lastControlUs < CONTROL_PERIOD_US) {
+        return true;
+    }
+
+    if (reversalPending) {
+        // пауза перед реверсом: профиль стартует, когда энкодер перестал тикать
+        bool shaftStopped = (count == reversalLastCount);
+        reversalLastCount = count;
+        lastControlUs = nowUs;
+        if ((long)(nowUs - reversalDeadlineUs) >= 0 &&
+            (shaftStopped || nowUs - reversalStartUs >= REVERSAL_MAX_WAIT_MS * 1000UL)) {
+            reversalPending = false;
+            profileStartUs = nowUs;
+            lastControlProgress = progress;
+        }
+        return true;
+    }
+
+    float dt = (nowUs - lastControlUs) / 1000000.0f;
+    EncoderMotion motion = encoder_sampler_get_motion(MOVE_STALL_VELOCITY);
+    measuredVelocity = dirSign * motion.velocity;
+    lastControlUs = nowUs;
+    lastControlProgress = progress;
+
+    // заклинивание: ШИМ заметно выше мертвой зоны, разгон прошел, а уверенность остановки держится
+    if (nowUs - profileStartUs >= MOVE_STALL_GRACE_MS * 1000UL && motorPwm >= MOVE_STALL_MIN_DUTY &&
+        motion.stallConfidence >= MOVE_STALL_CONFIDENCE) {
+        if (!moveStallCandidate) {
+            moveStallCandidate = true;
+            moveStallSinceUs = nowUs;
+        } else if (nowUs - moveStallSinceUs >= MOVE_STALL_CONFIRM_MS * 1000UL) {
+            // задачу не снимаем: положение по энкодеру еще нужно finish_move()
+            set_motor_speed(0, requiredDirection);
+            moveStalled = true;
+            lastStoppedEncoderCount = count;
+            BINLOG_WARN(MOVE_STALLED, progress, targetTickCount);
+            return false;
+        }
+    } else {
+        moveStallCandidate = false;
+    }
+
+    float t = (nowUs - profileStartUs) / 1000000.0f;
+    float posRef, velRef;
+    moveProfile.sample(t, posRef, velRef);
+
+    float velCmd = velRef + POSITION_KP * (posRef - progress);
+    if (velCmd < PROFILE_CREEP_VELOCITY) {
+        velCmd = PROFILE_CREEP_VELOCITY;
+    }
+
+    float feedforward = (velCmd + MOTOR_TIME_CONSTANT_S * moveProfile.accelAt(t)) / MOTOR_VELOCITY_PER_DUTY;
+    float duty = speedPI.update(velCmd - measuredVelocity, dt, feedforward);
+
     // Продолжаем движение
-    set_motor_speed(requiredSpeed, requiredDirection);
+    set_motor_speed((int)(duty + 0.5f), requiredDirection);
     return true;
 }
 
@@ -235,7 +399,7 @@ bool unint_motor_move(unsigned long ticks, int direction, int speed, unsigned lo
     setMotorMoveTask(ticks, direction, speed);
 
     unsigned long startTime = millis();
-    Serial.println("motor init encoder position: " + String(encoderCount));
+    Serial.println("motor init encoder position: " + String(get_encoder()));
 
     while (MotorExecMoveTask()) {
         // Кормим WDT
@@ -245,15 +409,15 @@ bool unint_motor_move(unsigned long ticks, int direction, int speed, unsigned lo
         if (timeout_ms > 0 && (millis() - startTime) > timeout_ms) {
             Serial.println("Motor move TIMEOUT!");
             stop_motor();
-            // lastStoppedEncoderCount = encoderCount;
+            // lastStoppedEncoderCount = get_encoder();
             return false;
         }
     }
 
     stop_motor();
-    // lastStoppedEncoderCount = encoderCount;
+    // lastStoppedEncoderCount = get_encoder();
     delay(30); // небольшая стабилизация
-    return true;
+    return !moveStalled;
 }
 
 void cancelMotorMoveTask() {
@@ -261,305 +425,1126 @@ void cancelMotorMoveTask() {
     Serial.println("Motor Move Task Cancelled.");
 }
 
+// backlash and slip ============================================================================================================//
+//
+// Тяга со струбциной: после реверса вал проходит зазор вхолостую, а под нагрузкой струбцина
+// проскальзывает по штанге. Энкодер стоит на валу и не видит ни того, ни другого, поэтому
+// положение створки - это счет вала минус смещения, а сами параметры учим у упора закрытия:
+// остаток при касании - неучтенное проскальзывание, проба слабым ШИМом от упора в обе
+// стороны - зазор. Пересинхронизация дешевая (упор рядом, без быстрого подхода и отъезда)
+// и запускается, только когда оценка ошибки переваливает за порог.
+
+const float RESYNC_ERROR_TICKS = 8.0f;              // выше - пересинхронизация перед следующей задачей
+const float RESYNC_CLOSING_ERROR_TICKS = 4.0f;      // выше - пересинхронизация, раз все равно едем закрывать
+const float DRIFT_ERROR_PER_TICK = 0.0005f;         // неучтенный дрейф до первых остатков: тиков ошибки на тик хода
+const float DRIFT_ERROR_MIN = 0.0001f;
+const float DRIFT_ERROR_MAX = 0.01f;
+const float DRIFT_ERROR_MARGIN = 2.0f;              // запас к наблюдаемому остатку
+const float BACKLASH_ERROR_TICKS = 0.5f;            // ошибка компенсации выученного зазора
+const float BACKLASH_ERROR_UNCALIBRATED = 2.0f;     // пока зазор ни разу не мерили
+const float BACKLASH_LEARN_RATE = 0.5f;
+const float SLIP_LEARN_RATE = 0.7f;
+const float DRIFT_LEARN_RATE = 0.3f;
+const uint16_t BACKLASH_PROBE_LEARN = 3;            // первые пересинхронизации всегда с пробой зазора
+const uint16_t BACKLASH_PROBE_EVERY = 5;            // дальше - каждая пятая, зазор меняется медленно
+const long SLIP_LEARN_MIN_TRAVEL = 2000;            // меньше хода открытия с прошлой синхронизации - остаток не информативен
+const float SLIP_MAX = 0.02f;
+
+static MotorCalibration calibration = { { 0.0f, 0.0f }, 0.0f, DRIFT_ERROR_PER_TICK, 0 };
+static MotorSyncState syncState = { 1, 0.0f, 0.0f, 0.0f, 0 };  // после хоуминга зазор выбран закрытием
+static long accountedCount = 0;                     // ход до этого счета уже учтен в смещениях
+static bool resyncActive = false;                   // хоуминг-автомат сейчас ведет пересинхронизацию
+static bool resyncFailed = false;                   // упор не нашелся - до хоуминга сами не пробуем
+static bool stopKnown = false;                      // был хоуминг или положение из журнала - знаем, где упор
+
+MotorCalibration motor_get_calibration() {
+    return calibration;
+}
+
+void motor_set_calibration(const MotorCalibration& value) {
+    calibration = value;
+    Serial.println("Calibration: backlash " + String(calibration.backlashTicks[0], 1) + "/" +
+                   String(calibration.backlashTicks[1], 1) + " ticks, slip " +
+                   String(calibration.slipPerTick * 100.0f, 3) + "%, resyncs " + String(calibration.resyncs));
+}
+
+MotorSyncState motor_get_sync_state() {
+    return syncState;
+}
+
+/**
+ * @brief Оценка ошибки положения створки, тики
+ *
+ * Накопленный дрейф растет с ходом (скорость - по остаткам прошлых пересинхронизаций),
+ * ошибка компенсации зазора не копится: она одна и та же на каждом реверсе.
+ */
+float get_position_error_estimate() {
+    return syncState.errorEstimate + ((calibration.resyncs > 0) ? BACKLASH_ERROR_TICKS : BACKLASH_ERROR_UNCALIBRATED);
+}
+
+bool is_resyncing() {
+    return resyncActive;
+}
+
+/**
+ * @brief Смещение вала относительно створки после выборки зазора в direction
+ *
+ * Зазоры в две стороны меряются раздельно и могут не совпасть (упругость струбцины),
+ * поэтому смещение держим в [0, зазор открытия]: иначе разница копилась бы с каждым реверсом.
+ */
+static float lash_offset_after(int direction) {
+    if (direction == syncState.lashDir) {
+        return syncState.lashOffset;
+    }
+    if (direction == 0) {
+        return calibration.backlashTicks[0];
+    }
+    return max(syncState.lashOffset - calibration.backlashTicks[1], 0.0f);
+}
+
+// вал пошел в direction: зазор выбран в эту сторону
+static void backlash_drive(int direction) {
+    if (direction == syncState.lashDir) {
+        return;
+    }
+    syncState.lashOffset = lash_offset_after(direction);
+    syncState.lashDir = direction;
+}
+
+// стоящий вал провернули снаружи: одноканальный энкодер не знает, в какую сторону
+static void backlash_external(long ticks) {
+    syncState.errorEstimate += 2.0f * ticks;
+    accountedCount = get_encoder();
+}
+
+/**
+ * @brief Учитывает ход вала с прошлого вызова: проскальзывание по модели и рост оценки ошибки
+ */
+static void backlash_account() {
+    long count = get_encoder();
+    long travel = accountedCount - count;           // > 0 - открытие (открытие уменьшает счет)
+    accountedCount = count;
+
+    float slip;
+    if (travel > 0) {
+        syncState.openTravel += travel;
+        slip = max(calibration.slipPerTick, 0.0f) * travel;
+    } else {
+        slip = min(calibration.slipPerTick, 0.0f) * -travel;
+    }
+    syncState.slipOffset += slip;
+    syncState.errorEstimate += max(calibration.driftPerTick, DRIFT_ERROR_MIN) * labs(travel);
+}
+
+// доля хода вала, которую створка теряет при движении в direction
+static float slip_fraction(int direction) {
+    return (direction == 0) ? max(calibration.slipPerTick, 0.0f) : max(-calibration.slipPerTick, 0.0f);
+}
+
+// счет вала вдоль оси открытия, при котором створка встанет в windowTicks, если подъехать в direction
+static float window_to_motor(long windowTicks, int direction) {
+    return windowTicks + lash_offset_after(direction) + syncState.slipOffset;
+}
+
+// путь вала от текущего счета до windowTicks, с выборкой зазора и ожидаемым проскальзыванием
+static unsigned long motor_path_ticks(long windowTicks, int direction) {
+    float path = fabsf(window_to_motor(windowTicks, direction) + get_encoder());
+    return lroundf(path / (1.0f - slip_fraction(direction)));
+}
+
+// вал стоит на упоре закрытия с выбранным закрытием зазором, счет обнулен
+static void backlash_zero() {
+    accountedCount = 0;
+    syncState.lashDir = 1;
+    syncState.lashOffset = 0.0f;
+    syncState.slipOffset = 0.0f;
+    syncState.errorEstimate = 0.0f;
+    syncState.openTravel = 0;
+}
+
+/**
+ * @brief Остаток при касании упора при пересинхронизации: учим проскальзывание
+ * @param residual Положение створки по оценке в момент касания (на самом деле 0), тики
+ *
+ * Упор один, поэтому различима только разница проскальзываний открытия и закрытия:
+ * остаток приписываем тому направлению, в котором створка отстала.
+ */
+static void learn_slip(float residual) {
+    if (syncState.openTravel < SLIP_LEARN_MIN_TRAVEL) {
+        return;
+    }
+    calibration.slipPerTick = constrain(calibration.slipPerTick + SLIP_LEARN_RATE * residual / syncState.openTravel,
+                                        -SLIP_MAX, SLIP_MAX);
+
+    // скорость роста оценки ошибки - по тому, насколько ошиблась модель (ход туда и обратно)
+    float observed = fabsf(residual) / (2.0f * syncState.openTravel);
+    calibration.driftPerTick = constrain(calibration.driftPerTick +
+                                         DRIFT_LEARN_RATE * (DRIFT_ERROR_MARGIN * observed - calibration.driftPerTick),
+                                         DRIFT_ERROR_MIN, DRIFT_ERROR_MAX);
+}
+
+static void learn_backlash(const long measured[2]) {
+    bool first = calibration.backlashTicks[0] == 0.0f && calibration.backlashTicks[1] == 0.0f;
+    for (int direction = 0; direction < 2; direction++) {
+        if (first) {
+            calibration.backlashTicks[direction] = measured[direction];
+        } else {
+            calibration.backlashTicks[direction] += BACKLASH_LEARN_RATE * (measured[direction] - calibration.backlashTicks[direction]);
+        }
+    }
+}
+
 // discrete control =============================================================================================================//
 
+static long travelTicks = MAX_MOTOR_POS;                        // полный ход, уточняется замером при хоуминге
+static unsigned long posStepTicks = MAX_MOTOR_POS / MAX_POS;   // тиков энкодера на позицию
+
+const long POSITION_DEADBAND_TICKS = 3;             // ближе к цели не доезжаем - дрожание регулятора
+const int MAX_POSITION_CORRECTIONS = 2;             // доводок после выбега на одну задачу
+const unsigned long MOVE_SETTLE_QUIET_MS = 40;      // энкодер молчит столько - выбег закончился
+const unsigned long MOVE_SETTLE_MAX_MS = 300;
+
+static long targetTicks = 0;                        // абсолютная цель вдоль оси открытия
+static bool moveSettling = false;                   // ШИМ снят, ждем конца выбега перед проверкой остатка
+static int moveCorrections = 0;
+static unsigned long moveSettleStartMs = 0;
+static unsigned long moveSettleChangeMs = 0;
+static long moveSettleLastCount = 0;
+static int restoreCheckPhase = 0;                   // пробный ход после восстановления: 1 - туда, 2 - обратно
+
+// задача по позиции еще не закончена: едем, ждем выбега или сначала пересинхронизируемся
+static bool pos_move_active() {
+    return motorMoveTaskActive || moveSettling || resyncActive;
+}
+
 unsigned long pos2ticks(int pos) {
-    const unsigned long step = MAX_MOTOR_POS / MAX_POS;
-    return step * abs(pos - curr_pos_ind);
+    return posStepTicks * pos;
 }
 
-int dir2pos(int pos) {
-    return (pos > curr_pos_ind) ? 0 : 1;
+static long max_position_ticks() {
+    return (long)posStepTicks * (MAX_POS - 1);
 }
 
-int change_pos(int pos) {
-    if (pos == curr_pos_ind) {
-        Serial.println("pos = curr");
+/**
+ * @brief Текущее положение створки в тиках вдоль оси открытия (0 - закрыто, упор хоуминга)
+ *
+ * По счету энкодера за вычетом зазора и проскальзывания тяги: открытие (direction = 0)
+ * уменьшает счет, закрытие - увеличивает.
+ */
+long get_position_ticks() {
+    return lroundf(-get_encoder() - syncState.lashOffset - syncState.slipOffset);
+}
+
+static int ticks2nearest_pos(long ticks) {
+    long pos = (ticks + (long)posStepTicks / 2) / (long)posStepTicks;
+    return constrain(pos, 0L, (long)MAX_POS - 1);
+}
+
+static bool restore_check_next(MotorMoveStatus status);
+
+// новая задача извне перебивает пробный ход: ее конец - уже не проба
+static void drop_restore_check() {
+    if (restoreCheckPhase == 0) {
+        return;
+    }
+    restoreCheckPhase = 0;
+    Serial.println("Restore check interrupted by a new command");
+}
+
+static void finish_move(MotorMoveStatus status) {
+    moveSettling = false;
+    backlash_account();
+    if (status == MotorMoveStatus::DONE) {
+        curr_pos_ind = target_pos_ind;
+    } else {
+        // не доехали - считаем, что стоим в ближайшей позиции, цель - там, где стоим
+        targetTicks = get_position_ticks();
+        curr_pos_ind = ticks2nearest_pos(targetTicks);
+        target_pos_ind = curr_pos_ind;
+    }
+    if (motorMoveTaskActive) {
+        stop_motor();
+    }
+    lastStoppedEncoderCount = get_encoder();
+    moveStatus = status;
+
+    if (restoreCheckPhase != 0 && restore_check_next(status)) {
+        return;
+    }
+    if (moveCallback) {
+        moveCallback(status, curr_pos_ind);
+    }
+}
+
+/**
+ * @brief Ставит (или перенацеливает) задачу движения к абсолютной цели ticks
+ *
+ * Путь считается от фактического положения по энкодеру, поэтому недолет или перелет
+ * прошлой задачи исправляется следующей, а не копится до хоуминга.
+ * Паузу при смене направления выдерживает setMotorMoveTask().
+ */
+static void start_move_to_ticks(long ticks, int posIndex) {
+    backlash_account();
+    long delta = ticks - get_position_ticks();
+    int direction = (delta > 0) ? 0 : 1;
+
+    targetTicks = ticks;
+    target_pos_ind = posIndex;
+    moveSettling = false;
+    moveStartTime = millis();
+    moveTimeout = DFLT_TIMEOUT;
+
+    if (labs(delta) <= POSITION_DEADBAND_TICKS) {
+        finish_move(MotorMoveStatus::DONE);
+        return;
+    }
+
+    setMotorMoveTask(motor_path_ticks(ticks, direction), direction, DFLT_SPEED);
+    moveStatus = MotorMoveStatus::MOVING;
+}
+
+static bool resync_due(long ticks) {
+    if (resyncFailed || !stopKnown) {
+        return false;
+    }
+    float error = get_position_error_estimate();
+    return error > RESYNC_ERROR_TICKS || (ticks == 0 && error > RESYNC_CLOSING_ERROR_TICKS);
+}
+
+static void start_resync_to(long ticks, int posIndex);
+
+/**
+ * @brief Новая задача (не доводка): проверка внешнего поворота и порога ошибки
+ *
+ * Пересинхронизация вставляется только перед задачей со стоящего мотора, перенацеливание
+ * на ходу ее не запускает. Если она уже идет - новая цель просто ждет ее конца.
+ */
+static void begin_move(long ticks, int posIndex) {
+    drop_restore_check();
+    if (resyncActive) {
+        targetTicks = ticks;
+        target_pos_ind = posIndex;
+        return;
+    }
+    bool idle = !pos_move_active();
+    if (idle) {
+        checkExternalMovement();
+    }
+    moveCorrections = 0;
+    if (idle && resync_due(ticks)) {
+        start_resync_to(ticks, posIndex);
+        return;
+    }
+    start_move_to_ticks(ticks, posIndex);
+}
+
+int move_to_ticks(long ticks) {
+    if (ticks < 0 || ticks > max_position_ticks()) {
+        Serial.println("ticks out of range");
+        return -1;
+    }
+    if (is_homing()) {
+        Serial.println("homing in progress");
+        return -1;
+    }
+    if (pos_move_active() && ticks == targetTicks) {
         return 0;
     }
-    if (pos > MAX_POS) {
-        Serial.println("pos out of range");
+
+    Serial.print("move_to_ticks(): ");
+    Serial.print(get_position_ticks());
+    Serial.print(" -> ");
+    Serial.println(ticks);
+
+    // только ставим задачу, движение ведет motor_update()
+    begin_move(ticks, ticks2nearest_pos(ticks));
+    return 0;
+}
+
+int move_to_percent(float percent) {
+    if (percent < 0.0f || percent > 100.0f) {
+        Serial.println("percent out of range");
         return -1;
     }
+    return move_to_ticks(lroundf(percent * max_position_ticks() / 100.0f));
+}
 
-    // вычисляем количество тиков
-    unsigned long ticks = pos2ticks(pos);
+float get_percent_open() {
+    return 100.0f * get_position_ticks() / max_position_ticks();
+}
+
+long get_target_ticks() {
+    return targetTicks;
+}
 
-    // направление 0/1
-    int direction = dir2pos(pos);
+int change_pos(int pos) {
+    if (pos < 0 || pos >= (int)MAX_POS) {
+        Serial.println("pos out of range");
+        return -1;
+    }
+    if (is_homing()) {
+        Serial.println("homing in progress");
+        return -1;
+    }
+    long ticks = pos2ticks(pos);
+    if (pos_move_active() && ticks == targetTicks) {
+        Serial.println("pos = target");
+        return 0;
+    }
+    if (!pos_move_active() && pos == curr_pos_ind && labs(ticks - get_position_ticks()) <= POSITION_DEADBAND_TICKS) {
+        Serial.println("pos = curr");
+        return 0;
+    }
 
     Serial.print("change_pos(): curr=");
     Serial.print(curr_pos_ind);
+    if (pos_move_active()) {
+        Serial.print(" (moving to ");
+        Serial.print(target_pos_ind);
+        Serial.print(")");
+    }
     Serial.print(" -> ");
-    Serial.print(pos);
-    Serial.print(" | ticks=");
-    Serial.print(ticks);
-    Serial.print(" dir=");
-    Serial.println(direction);
+    Serial.println(pos);
 
-    // выполняем движение
-    bool ok = unint_motor_move(ticks, direction);
+    begin_move(ticks, pos);
+    return 0;
+}
 
-    if (!ok) {
-        Serial.println("Error: movement failed.");
-        return -1;
+/**
+ * @brief Ожидание конца выбега и доводка к абсолютной цели
+ *
+ * Выбег зависит от нагрузки и смазки, поэтому остаток после остановки
+ * доводится короткой задачей к той же цели (не больше MAX_POSITION_CORRECTIONS раз).
+ */
+static void settle_update() {
+    unsigned long now = millis();
+    long count = get_encoder();
+    if (count != moveSettleLastCount) {
+        moveSettleLastCount = count;
+        moveSettleChangeMs = now;
+    }
+    if (now - moveSettleChangeMs < MOVE_SETTLE_QUIET_MS && now - moveSettleStartMs < MOVE_SETTLE_MAX_MS) {
+        return;
     }
 
-    // обновляем состояние
-    curr_pos_ind = pos;
+    backlash_account();
+    long residual = targetTicks - get_position_ticks();
+    if (labs(residual) > POSITION_DEADBAND_TICKS && moveCorrections < MAX_POSITION_CORRECTIONS) {
+        moveCorrections++;
+        Serial.println("Position correction: " + String(residual) + " ticks");
+        unsigned long startTime = moveStartTime;
+        start_move_to_ticks(targetTicks, target_pos_ind);
+        moveStartTime = startTime;          // таймаут - на всю задачу вместе с доводками
+        return;
+    }
+    finish_move(MotorMoveStatus::DONE);
+}
 
-    return 0;
+static void motor_step() {
+    if (is_homing() || resyncActive) {
+        homing_update();
+        return;
+    }
+    if (moveSettling) {
+        settle_update();
+        return;
+    }
+    if (!motorMoveTaskActive) {
+        return;
+    }
+
+    if (!MotorExecMoveTask()) {
+        if (moveStalled) {
+            finish_move(MotorMoveStatus::STALLED);
+            return;
+        }
+        // ШИМ снят по прогнозу выбега - остаток проверим, когда вал встанет
+        moveSettling = true;
+        moveSettleStartMs = millis();
+        moveSettleChangeMs = moveSettleStartMs;
+        moveSettleLastCount = get_encoder();
+        return;
+    }
+
+    if (moveTimeout > 0 && (millis() - moveStartTime) > moveTimeout) {
+        Serial.println("Motor move TIMEOUT!");
+        finish_move(MotorMoveStatus::TIMEOUT);
+    }
+}
+
+void motor_update() {
+    motor_step();
+    // мотор встал - сэмплер до следующего хода не нужен, а его таймер не дает уснуть
+    if (!is_motor_busy()) {
+        encoder_sampler_set_active(false);
+    }
+}
+
+bool wait_motor_idle(unsigned long timeout_ms) {
+    unsigned long startTime = millis();
+    while (is_motor_busy()) {
+        motor_update();
+        vTaskDelay(1);
+        if (timeout_ms > 0 && (millis() - startTime) > timeout_ms) {
+            return false;
+        }
+    }
+    return moveStatus == MotorMoveStatus::DONE || moveStatus == MotorMoveStatus::IDLE;
+}
+
+void cancel_pos_move() {
+    if (!pos_move_active()) {
+        return;
+    }
+    drop_restore_check();
+    Serial.println("Position move cancelled");
+    if (resyncActive) {
+        cancel_resync();
+    }
+    finish_move(MotorMoveStatus::CANCELLED);
+}
+
+bool is_motor_busy() {
+    return pos_move_active() || is_homing();
 }
 
+MotorMoveStatus get_motor_move_status() {
+    return moveStatus;
+}
+
+void set_motor_move_callback(MotorMoveCallback callback) {
+    moveCallback = callback;
+}
 
 int get_current_position_index() {
     return curr_pos_ind;
 }
 
+int get_target_position_index() {
+    return target_pos_ind;
+}
+
 // HOMING =======================================================================================================================//
+//
+// Двухфазный хоуминг: быстро к упору, отъезд на HOMING_BACKOFF_TICKS, медленно обратно -
+// ноль берется на медленном подходе, где вал почти не вминается в упор. По запросу
+// то же самое повторяется у противоположного упора: меряем полный ход и шаг позиции,
+// после чего встаем в крайнюю позицию.
+//
+// Тот же автомат ведет пересинхронизацию: профилем к упору закрытия почти вплотную,
+// медленный подход, остаток при касании, пробы зазора в обе стороны - и дальше
+// к цели отложенной задачи.
 
-// Добавьте эти константы в начало файла после других констант
 const int HOMING_DIR = 1;                           // направлени хоуминга
-const int HOMING_SPEED = 150;                       // Скорость хоуминга (0-255)
+const int HOMING_FAST_SPEED = MOTOR_PWM_MAX;        // быстрый подход к упору (ШИМ)
+const int HOMING_SLOW_SPEED = 200;                  // медленный повторный подход (ШИМ)
+const int HOMING_BOOST_STEP = 200;                  // прибавка ШИМ, если вал не тронулся
+const long HOMING_BACKOFF_TICKS = 150;              // отъезд от упора перед медленным подходом
 const int HOMING_MIN_VELOCITY = 180;                // Минимальная скорость энкодера для остановки хоуминга
-const unsigned long HOMING_TIMEOUT_MS = 15000;      // Таймаут хоуминга 10 секунд
-const unsigned long VELOCITY_SAMPLE_PERIOD = 100;   // Период измерения скорости (мс)
-
-// Добавьте глобальные переменные для расчета скорости
-unsigned long lastEncoderSampleTime = 0;
-long lastEncoderCount = 0;
-float currentEncoderVelocity = 0.0;      // Текущая скорость энкодера в тиках/секунду
+const float HOMING_STALL_CONFIDENCE = 0.5f;         // уверенность остановки (скорость < HOMING_MIN_VELOCITY / 2)
+const unsigned long HOMING_STALL_CONFIRM_MS = 20;   // столько уверенность должна держаться
+const unsigned long HOMING_SPINUP_MS = 300;         // за это время вал обязан разогнаться
+const unsigned long HOMING_SETTLE_QUIET_MS = 20;    // после остановки энкодер молчит столько - вал встал
+const unsigned long HOMING_SETTLE_MAX_MS = 300;
+const unsigned long HOMING_TIMEOUT_MS = 15000;      // Таймаут хоуминга (на каждый упор)
+const long RESYNC_APPROACH_TICKS = 40;              // профилем до этого положения (плюс оценка ошибки), дальше медленно
+const int LASH_PROBE_DUTY = 60;                     // выше мертвой зоны вала, ниже трогания створки
+const unsigned long LASH_PROBE_QUIET_MS = 60;       // энкодер молчит столько - вал уперся в створку
+const long LASH_PROBE_MAX_TICKS = 100;              // дальше - створка поехала вместе с валом, ШИМ пробы велик
+
+enum class HomingState {
+    IDLE,
+    FAST_APPROACH,
+    FAST_SETTLE,
+    BACKOFF,
+    BACKOFF_SETTLE,
+    SLOW_APPROACH,
+    SLOW_SETTLE,
+    RETURNING,          // после замера хода - в крайнюю позицию
+    RESYNC_MOVE,        // пересинхронизация: профилем почти до упора закрытия
+    LASH_PROBE,         // слабый ШИМ от упора: вал проходит зазор и встает, створку не сдвинув
+    LASH_PAUSE          // пауза реверса между пробами
+};
+
+static HomingState homingState = HomingState::IDLE;
+static int homingResult = 0;
+static int homingSide = HOMING_DIR;                 // к какому упору едем сейчас
+static bool homingMeasureTravel = false;
+static unsigned long homingStartMs = 0;
+static unsigned long homingSideStartMs = 0;         // таймаут считаем на каждый упор
+static unsigned long homingDurationMs = 0;
+static unsigned long homingPhaseMs = 0;             // начало текущей фазы
+static unsigned long homingPrintMs = 0;
+static unsigned long stallSinceMs = 0;
+static bool stallCandidate = false;
+static int homingSpeed = 0;
+static bool homingSpunUp = false;
+static long homingStartCount = 0;
+static long settleLastCount = 0;
+static unsigned long settleLastChangeMs = 0;
+static int probeDir = 0;
+static long probeStartCount = 0;
+static long lashMeasured[2] = { 0, 0 };
+static unsigned long resyncDurationMs = 0;
 
-// ===================================================================
-// Функция calculateEncoderVelocity - расчет скорости энкодера
-// ===================================================================
 /**
- * @brief Рассчитывает текущую скорость энкодера
+ * @brief Текущая скорость энкодера по сэмплеру
  * @return Скорость в тиках/секунду
  */
 float calculateEncoderVelocity() {
-    unsigned long currentTime = millis();
+    return encoder_sampler_get_motion(HOMING_MIN_VELOCITY).velocity;
+}
 
-    if (lastEncoderSampleTime == 0) {
-        // Первый вызов
-        lastEncoderSampleTime = currentTime;
-        return HOMING_MIN_VELOCITY + 1;
-    }
+/**
+ * @brief Сбрасывает историю оценки скорости (после перезаписи счета энкодера)
+ */
+void resetEncoderVelocityCalculation() {
+    encoder_sampler_reset();
+}
 
-    // Вычисляем дельту времени
-    unsigned long deltaTime = currentTime - lastEncoderSampleTime;
+bool is_homing() {
+    return homingState != HomingState::IDLE && !resyncActive;
+}
 
-    if (deltaTime < VELOCITY_SAMPLE_PERIOD) {
-        // Не прошло достаточно времени для измерения
-        return currentEncoderVelocity;
-    }
+int get_homing_result() {
+    return homingResult;
+}
 
-    // Вычисляем дельту тиков
-    long deltaTicks = encoderCount - lastEncoderCount;
+unsigned long get_homing_duration_ms() {
+    return homingDurationMs;
+}
+
+long get_travel_ticks() {
+    return travelTicks;
+}
 
-    // Рассчитываем скорость (тиков/секунду)
-    currentEncoderVelocity = (deltaTicks * 1000.0) / deltaTime;
+static void finish_homing(int result) {
+    if (motorMoveTaskActive) {
+        stop_motor();
+    }
+    set_motor_speed(0, homingSide);
+    homingState = HomingState::IDLE;
+    lastStoppedEncoderCount = get_encoder();
+
+    if (resyncActive) {
+        // упор не нашелся: ошибку не сбрасываем, задачу снимаем
+        resyncActive = false;
+        resyncFailed = true;
+        Serial.println("RESYNC FAILED - code " + String(result));
+        finish_move(MotorMoveStatus::TIMEOUT);
+        return;
+    }
+    homingResult = result;
+    homingDurationMs = millis() - homingStartMs;
 
-    // Обновляем значения для следующего расчета
-    lastEncoderSampleTime = currentTime;
-    lastEncoderCount = encoderCount;
+    if (result == 0) {
+        Serial.println("=== HOMING PROCEDURE COMPLETED SUCCESSFULLY ===");
+        Serial.println("Homing time: " + String(homingDurationMs) + " ms");
+        Serial.println("Current position: " + String(curr_pos_ind));
+        Serial.println("Encoder value: " + String(get_encoder()));
+    } else {
+        Serial.println("HOMING FAILED - code " + String(result));
+    }
+}
 
-    return currentEncoderVelocity;
+static void begin_approach(HomingState state, int speed, unsigned long now) {
+    homingState = state;
+    homingPhaseMs = now;
+    homingPrintMs = now;
+    homingSpeed = speed;
+    homingSpunUp = false;
+    stallCandidate = false;
+    homingStartCount = get_encoder();
+    encoder_sampler_set_active(true);
+    set_motor_speed(speed, homingSide);
 }
 
-// ===================================================================
-// Функция resetEncoderVelocityCalculation - сброс расчета скорости
-// ===================================================================
-/**
- * @brief Сбрасывает расчет скорости энкодера
- */
-void resetEncoderVelocityCalculation() {
-    lastEncoderSampleTime = 0;
-    lastEncoderCount = encoderCount;
-    currentEncoderVelocity = 0.0;
+static void begin_settle(HomingState state, unsigned long now) {
+    set_motor_speed(0, homingSide);
+    if (state != HomingState::BACKOFF_SETTLE) {
+        // без ШИМ вал у упора может только отойти от него (уплотнитель отжимает) -
+        // считаем эти фронты в обратную сторону, иначе ход растет на двойную отдачу
+        encoder->setDirection((homingSide == 1) ? -1 : 1);
+    }
+    homingState = state;
+    homingPhaseMs = now;
+    settleLastCount = get_encoder();
+    settleLastChangeMs = now;
 }
 
-// ===================================================================
-// Функция performHoming - выполнение процедуры хоуминга
-// ===================================================================
 /**
- * @brief Выполняет процедуру хоуминга мотора
- * @return true - хоуминг успешен, false - таймаут или ошибка
+ * @brief Запускает хоуминг, дальше его ведет motor_update()
+ * @param measureTravel true - после нуля доехать до противоположного упора и измерить полный ход
  *
- * Алгоритм:
- * 1. Двигает мотор в указанном направлении с HOMING_SPEED
- * 2. Постоянно отслеживает скорость энкодера
- * 3. Когда скорость падает ниже HOMING_MIN_VELOCITY, останавливаем мотор
- * 4. Сбрасывает encoderCount в 0
- * 5. Имеет таймаут HOMING_TIMEOUT_MS
+ * Скорость и уверенность остановки берем из сэмплера энкодера: разгон подтверждается по факту,
+ * упор - когда уверенность держится HOMING_STALL_CONFIRM_MS. Счет энкодера обнуляется
+ * после медленного подхода к упору закрытия, когда вал остановился.
  */
-int performHoming() {
+void start_homing(bool measureTravel) {
     Serial.println("=== STARTING HOMING PROCEDURE ===");
     Serial.print("Direction: ");
     Serial.println(HOMING_DIR == 1 ? "FORWARD" : "BACKWARD");
-    Serial.println("Moving until encoder velocity drops below " + String(HOMING_MIN_VELOCITY) + " ticks/sec");
+    Serial.println("Fast approach, back off " + String(HOMING_BACKOFF_TICKS) + " ticks, slow approach" +
+                   (measureTravel ? ", then measure travel" : ""));
 
+    drop_restore_check();
+    cancel_pos_move();
     cancelMotorMoveTask();
-    resetEncoderVelocityCalculation();
 
-    unsigned long startTime = millis();
-    unsigned long lastPrintTime = 0;
-    unsigned long motorStartTime = millis();
+    unsigned long now = millis();
+    resyncActive = false;
+    homingResult = 0;
+    homingStartMs = now;
+    homingSideStartMs = now;
+    homingSide = HOMING_DIR;
+    homingMeasureTravel = measureTravel;
+    begin_approach(HomingState::FAST_APPROACH, HOMING_FAST_SPEED, now);
+}
 
-    // Запускаем мотор
-    Serial.println("Starting motor...");
-    set_motor_speed(HOMING_SPEED, HOMING_DIR);
+/**
+ * @brief Шаг подхода к упору
+ * @return 0 - едем, 1 - уперлись, <0 - ошибка
+ */
+static int approach_step(const EncoderMotion& motion, unsigned long now) {
+    if (!homingSpunUp) {
+        if (fabs(motion.velocity) >= HOMING_MIN_VELOCITY) {
+            BINLOG_INFO(HOMING_RUNNING, now - homingPhaseMs);
+            homingPhaseMs = now;
+            homingSpunUp = true;
+            return 0;
+        }
+        if (now - homingPhaseMs < HOMING_SPINUP_MS) {
+            return 0;
+        }
+        if (get_encoder() != homingStartCount) {
+            // вал тронулся, но сразу уперся - стоим у упора
+            Serial.println("Motor stalled during spin-up - already at the stop");
+            return 1;
+        }
+        if (homingSpeed < MOTOR_PWM_MAX) {
+            Serial.println("ERROR: Motor not moving. Trying with higher speed...");
+            homingSpeed = min(homingSpeed + HOMING_BOOST_STEP, MOTOR_PWM_MAX);
+            set_motor_speed(homingSpeed, homingSide);
+            homingPhaseMs = now;
+            return 0;
+        }
+        if (resyncActive) {
+            // мотор только что ехал - значит, створка уже на упоре
+            Serial.println("No motion towards the stop - already there");
+            return 1;
+        }
+        if (homingState == HomingState::FAST_APPROACH) {
+            // у жесткого упора вал не дает ни одного фронта - отъезд покажет, живой ли мотор
+            Serial.println("No motion towards the stop - backing off to check");
+            return 1;
+        }
+        Serial.println("FATAL: Motor still not moving. Aborting homing.");
+        return -2;
+    }
 
-    // Даем мотору больше времени на разгон в закрепленной конструкции
-    Serial.println("Waiting for motor to start...");
-    delay(2000); // Увеличиваем до 1 секунды для разгона
+    if (now - homingPrintMs > 500) {
+        BINLOG_INFO(HOMING_PROGRESS, motion.velocity, get_encoder(), (now - homingStartMs) / 1000.0f);
+        homingPrintMs = now;
+    }
 
-    bool homingSuccessful = false;
-    bool timeoutReached = false;
+    if (motion.stallConfidence < HOMING_STALL_CONFIDENCE) {
+        stallCandidate = false;
+        return 0;
+    }
+    if (!stallCandidate) {
+        stallCandidate = true;
+        stallSinceMs = now;
+        return 0;
+    }
+    if (now - stallSinceMs >= HOMING_STALL_CONFIRM_MS) {
+        BINLOG_INFO(HOMING_END_STOP, motion.velocity);
+        return 1;
+    }
+    return 0;
+}
 
-    // Счетчик для пропуска первых измерений скорости
-    int measurementsToSkip = 3; // Пропустить первые 3 измерения
-    int measurementCount = 0;
+static bool settle_step(unsigned long now) {
+    long count = get_encoder();
+    if (count != settleLastCount) {
+        settleLastCount = count;
+        settleLastChangeMs = now;
+    }
+    return now - settleLastChangeMs >= HOMING_SETTLE_QUIET_MS || now - homingPhaseMs >= HOMING_SETTLE_MAX_MS;
+}
 
-    Serial.println("Beginning velocity monitoring...");
+static void finish_resync(bool probed, unsigned long now);
+
+static void begin_probe(int direction, unsigned long now) {
+    homingState = HomingState::LASH_PROBE;
+    homingPhaseMs = now;
+    probeDir = direction;
+    probeStartCount = get_encoder();
+    settleLastCount = probeStartCount;
+    settleLastChangeMs = now;
+    encoder_sampler_set_active(true);
+    set_motor_speed(LASH_PROBE_DUTY, direction);
+}
 
-    while (!homingSuccessful && !timeoutReached) {
-        if (millis() - startTime > HOMING_TIMEOUT_MS) {
-            Serial.println("HOMING TIMEOUT after " + String(HOMING_TIMEOUT_MS) + "ms");
-            timeoutReached = true;
-            break;
-        }
+/**
+ * @brief Запускает пересинхронизацию, после нее - задача к ticks
+ *
+ * Профилем до RESYNC_APPROACH_TICKS (с запасом на оценку ошибки), медленный подход,
+ * касание упора закрытия и пробы зазора. Полный хоуминг с отъездом не нужен: где упор,
+ * известно с точностью до оценки ошибки.
+ */
+static void start_resync_to(long ticks, int posIndex) {
+    Serial.println("=== RESYNC: position error estimate " + String(get_position_error_estimate(), 1) + " ticks ===");
+
+    unsigned long now = millis();
+    resyncActive = true;
+    targetTicks = ticks;
+    target_pos_ind = posIndex;
+    moveSettling = false;
+    moveStatus = MotorMoveStatus::MOVING;
+    homingStartMs = now;
+    homingSideStartMs = now;
+    homingSide = HOMING_DIR;
+    homingMeasureTravel = false;
+
+    backlash_account();
+    long approach = RESYNC_APPROACH_TICKS + lroundf(get_position_error_estimate());
+    if (get_position_ticks() <= approach) {
+        begin_approach(HomingState::SLOW_APPROACH, HOMING_SLOW_SPEED, now);
+        return;
+    }
+    homingState = HomingState::RESYNC_MOVE;
+    setMotorMoveTask(motor_path_ticks(approach, HOMING_DIR), HOMING_DIR, DFLT_SPEED);
+}
 
-        float velocity = calculateEncoderVelocity();
+void start_resync() {
+    if (is_motor_busy()) {
+        Serial.println("motor busy");
+        return;
+    }
+    start_resync_to(targetTicks, target_pos_ind);
+}
 
-        // Пропускаем первые несколько измерений
-        measurementCount++;
-        if (measurementCount <= measurementsToSkip) {
-            if (millis() - lastPrintTime > 500) {
-                Serial.println("Skipping initial measurement " + String(measurementCount) +
-                               "/" + String(measurementsToSkip) + "...");
-                lastPrintTime = millis();
-            }
-            vTaskDelay(100); // Даем больше времени между измерениями
-            continue;
-        }
+static void cancel_resync() {
+    cancelMotorMoveTask();
+    set_motor_speed(0, lastDriveDir);
+    homingState = HomingState::IDLE;
+    resyncActive = false;
+}
 
-        // Выводим информацию о скорости
-        if (millis() - lastPrintTime > 500) {
-            Serial.print("Homing... Velocity: ");
-            Serial.print(velocity);
-            Serial.print(" ticks/sec, Encoder: ");
-            Serial.print(encoderCount);
-            Serial.print(", Time: ");
-            Serial.print((millis() - startTime) / 1000.0, 1);
-            Serial.println("s");
-            lastPrintTime = millis();
-        }
+// пересинхронизация: створка на упоре закрытия, остаток оценки - неучтенное проскальзывание
+static void on_resync_contact(unsigned long now) {
+    backlash_account();
+    float residual = -get_encoder() - syncState.lashOffset - syncState.slipOffset;
+    Serial.println("Resync contact: residual " + String(residual, 1) + " ticks after " +
+                   String(syncState.openTravel) + " ticks of opening");
+    learn_slip(residual);
 
-        // Если скорость все еще 0 после ожидания разгона, проверяем мотор
-        if (measurementCount > measurementsToSkip + 5 && fabs(velocity) < 10) {
-            Serial.println("WARNING: Motor may not be moving. Checking...");
+    encoder->write(0);
+    resetEncoderVelocityCalculation();
+    lastStoppedEncoderCount = 0;
+    initialencoderCount = 0;
+    backlash_zero();
+    curr_pos_ind = 0;
 
-            // Даем мотору немного больше времени
-            delay(500);
-            velocity = calculateEncoderVelocity();
+    if (calibration.resyncs < BACKLASH_PROBE_LEARN || calibration.resyncs % BACKLASH_PROBE_EVERY == 0) {
+        begin_probe(1 - HOMING_DIR, now);
+    } else {
+        finish_resync(false, now);
+    }
+}
 
-            if (fabs(velocity) < 10) {
-                Serial.println("ERROR: Motor not moving. Trying with higher speed...");
+/**
+ * @brief Шаг пробы зазора
+ *
+ * Створка стоит на упоре, ШИМ пробы ее не трогает: вал проходит зазор и встает.
+ * От упора - зазор при реверсе в открытие, обратно к створке - в закрытие.
+ */
+static void probe_update(unsigned long now) {
+    long count = get_encoder();
+    if (count != settleLastCount) {
+        settleLastCount = count;
+        settleLastChangeMs = now;
+    }
+    long travel = labs(count - probeStartCount);
 
-                // Пробуем увеличить скорость
-                set_motor_speed(HOMING_SPEED + 50, HOMING_DIR);
-                delay(1000);
-                velocity = calculateEncoderVelocity();
+    if (travel > LASH_PROBE_MAX_TICKS) {
+        // створка поехала вместе с валом: зазор не измерить, но счет по-прежнему верен
+        set_motor_speed(0, probeDir);
+        Serial.println("Backlash probe: no pickup within " + String(LASH_PROBE_MAX_TICKS) + " ticks");
+        finish_resync(false, now);
+        return;
+    }
+    if (now - settleLastChangeMs < LASH_PROBE_QUIET_MS) {
+        return;
+    }
 
-                if (fabs(velocity) < 10) {
-                    Serial.println("FATAL: Motor still not moving. Aborting homing.");
-                    stop_motor();
-                    return -2;
-                }
-            }
-        }
+    set_motor_speed(0, probeDir);
+    lashMeasured[probeDir] = travel;
+    homingState = HomingState::LASH_PAUSE;
+    homingPhaseMs = now;
+}
+
+static void finish_resync(bool probed, unsigned long now) {
+    if (probed) {
+        learn_backlash(lashMeasured);
+        // вал вернулся к створке на упоре: зазор выбран закрытием, счет - около нуля
+        accountedCount = get_encoder();
+        syncState.lashDir = 1;
+        syncState.lashOffset = 0.0f;
+        syncState.errorEstimate = 0.0f;
+    }
+    calibration.resyncs++;
+    lastStoppedEncoderCount = get_encoder();
+    homingState = HomingState::IDLE;
+    resyncActive = false;
+    resyncDurationMs = now - homingStartMs;
+
+    Serial.println("Resync done in " + String(resyncDurationMs) + " ms: backlash " +
+                   String(calibration.backlashTicks[0], 1) + "/" + String(calibration.backlashTicks[1], 1) +
+                   (probed ? " ticks (measured " + String(lashMeasured[0]) + "/" + String(lashMeasured[1]) + ")" : String(" ticks")) +
+                   ", slip " + String(calibration.slipPerTick * 100.0f, 3) + "%");
+
+    // отложенная задача
+    start_move_to_ticks(targetTicks, target_pos_ind);
+}
 
-        // Проверяем скорость (учитываем как положительные, так и отрицательные скорости)
-        float absVelocity = fabs(velocity);
+unsigned long get_resync_duration_ms() {
+    return resyncDurationMs;
+}
 
-        if (absVelocity < HOMING_MIN_VELOCITY && absVelocity > 0) {
-            // Скорость низкая, но не нулевая - возможное достижение упора
+// вал стоит на упоре после медленного подхода
+static void on_stop_reached(unsigned long now) {
+    if (resyncActive) {
+        on_resync_contact(now);
+        return;
+    }
+    if (homingSide == HOMING_DIR) {
+        // Сбрасываем счетчик энкодера в 0
+        encoder->write(0);
+        resetEncoderVelocityCalculation();
+        lastStoppedEncoderCount = 0;
+        initialencoderCount = 0;
+        backlash_zero();
+        resyncFailed = false;
+        stopKnown = true;
+
+        // Обновляем текущую позицию
+        curr_pos_ind = 0;
+        target_pos_ind = 0;
+        targetTicks = 0;
+        Serial.println("Encoder counter RESET to 0");
+
+        if (!homingMeasureTravel) {
+            finish_homing(0);
+            return;
+        }
+        homingSide = 1 - HOMING_DIR;
+        homingSideStartMs = now;
+        begin_approach(HomingState::FAST_APPROACH, HOMING_FAST_SPEED, now);
+        return;
+    }
 
-            // Ждем немного для подтверждения
-            delay(200);
-            velocity = calculateEncoderVelocity();
-            absVelocity = fabs(velocity);
+    backlash_account();
+    long travel = get_position_ticks();            // зазор выбран открытием - вычитается
+    travelTicks = travel;
+    posStepTicks = travel / MAX_POS;
+    Serial.println("Measured travel: " + String(travel) + " ticks, " + String(posStepTicks) + " ticks per position");
 
-            if (absVelocity < HOMING_MIN_VELOCITY && absVelocity > 0) {
-                // Скорость действительно низкая и не нулевая - достигли упора
-                Serial.println("HOMING COMPLETE - Encoder velocity dropped to " + String(velocity) + " ticks/sec");
+    // от упора открытия - в крайнюю позицию
+    homingSide = HOMING_DIR;
+    homingState = HomingState::RETURNING;
+    setMotorMoveTask(motor_path_ticks(max_position_ticks(), HOMING_DIR), HOMING_DIR, DFLT_SPEED);
+}
 
-                // Продолжаем двигаться еще немного, чтобы убедиться в упоре
-                delay(300);
+static void homing_update() {
+    unsigned long now = millis();
+    if (now - homingSideStartMs > HOMING_TIMEOUT_MS) {
+        Serial.println("HOMING TIMEOUT after " + String(HOMING_TIMEOUT_MS) + "ms");
+        finish_homing(-1);
+        return;
+    }
 
-                // Проверяем еще раз
-                velocity = calculateEncoderVelocity();
-                absVelocity = fabs(velocity);
+    EncoderMotion motion = encoder_sampler_get_motion(HOMING_MIN_VELOCITY);
+    int result;
+
+    switch (homingState) {
+        case HomingState::FAST_APPROACH:
+        case HomingState::SLOW_APPROACH:
+            result = approach_step(motion, now);
+            if (result < 0) {
+                finish_homing(result);
+            } else if (result > 0) {
+                begin_settle(homingState == HomingState::FAST_APPROACH ? HomingState::FAST_SETTLE
+                                                                       : HomingState::SLOW_SETTLE, now);
+            }
+            break;
 
-                if (absVelocity < HOMING_MIN_VELOCITY) {
-                    stop_motor();
-                    delay(300); // Ждем полной остановки
+        case HomingState::FAST_SETTLE:
+            if (settle_step(now)) {
+                homingState = HomingState::BACKOFF;
+                setMotorMoveTask(HOMING_BACKOFF_TICKS, 1 - homingSide, DFLT_SPEED);
+            }
+            break;
 
-                    // Сбрасываем счетчик энкодера в 0
-                    encoderCount = 0;
-                    lastStoppedEncoderCount = 0;
-                    initialencoderCount = 0;
+        case HomingState::BACKOFF:
+            if (!MotorExecMoveTask()) {
+                bool stalled = moveStalled;
+                stop_motor();
+                if (stalled) {
+                    bool moved = get_encoder() != initialencoderCount;
+                    Serial.println(moved ? "FATAL: Cannot back off the end stop" : "FATAL: Motor not moving. Aborting homing.");
+                    finish_homing(moved ? -3 : -2);
+                    break;
+                }
+                begin_settle(HomingState::BACKOFF_SETTLE, now);
+            }
+            break;
 
-                    // Обновляем текущую позицию
-                    curr_pos_ind = 0;
+        case HomingState::BACKOFF_SETTLE:
+            if (settle_step(now)) {
+                begin_approach(HomingState::SLOW_APPROACH, HOMING_SLOW_SPEED, now);
+            }
+            break;
 
-                    Serial.println("Encoder counter RESET to 0");
-                    homingSuccessful = true;
-//
-//                     // Делаем небольшой отъезд от упора
-//                     Serial.println("Moving away from homing position...");
-//                     int oppositeDirection = HOMING_DIR == 1 ? 0 : 1;
-//                     set_motor_speed(HOMING_SPEED / 2, oppositeDirection);
-//                     delay(400);
-//                     stop_motor();
-//                     delay(200);
+        case HomingState::SLOW_SETTLE:
+            if (settle_step(now)) {
+                on_stop_reached(now);
+            }
+            break;
+
+        case HomingState::RESYNC_MOVE:
+            if (!MotorExecMoveTask()) {
+                bool stalled = moveStalled;
+                stop_motor();
+                if (stalled) {
+                    // упор ближе, чем думали
+                    begin_settle(HomingState::SLOW_SETTLE, now);
+                } else {
+                    begin_approach(HomingState::SLOW_APPROACH, HOMING_SLOW_SPEED, now);
                 }
             }
-        }
+            break;
 
-        // Короткая задержка для стабильности
-        vTaskDelay(50); // Увеличиваем задержку
-    }
+        case HomingState::LASH_PROBE:
+            probe_update(now);
+            break;
 
-    // Останавливаем мотор на всякий случай
-    stop_motor();
+        case HomingState::LASH_PAUSE:
+            if (now - homingPhaseMs >= REVERSAL_DEAD_TIME_MS) {
+                if (probeDir != HOMING_DIR) {
+                    begin_probe(HOMING_DIR, now);
+                } else {
+                    finish_resync(true, now);
+                }
+            }
+            break;
 
-    // Сбрасываем расчет скорости
-    resetEncoderVelocityCalculation();
+        case HomingState::RETURNING:
+            if (!MotorExecMoveTask()) {
+                curr_pos_ind = MAX_POS - 1;
+                target_pos_ind = curr_pos_ind;
+                targetTicks = get_position_ticks();
+                finish_homing(0);
+            }
+            break;
 
-    if (timeoutReached) {
-        Serial.println("HOMING FAILED - Timeout reached");
-        return -1;
+        default:
+            break;
     }
+}
 
-    if (homingSuccessful) {
-        Serial.println("=== HOMING PROCEDURE COMPLETED SUCCESSFULLY ===");
-        Serial.println("Current position: " + String(curr_pos_ind));
-        Serial.println("Encoder value: " + String(encoderCount));
-        return 0;
+/**
+ * @brief Выполняет процедуру хоуминга мотора (блокирующая обертка над start_homing())
+ * @return 0 - успех, -1 - таймаут, -2 - мотор не вращается, -3 - не отъехать от упора
+ */
+int performHoming(bool measureTravel) {
+    start_homing(measureTravel);
+    while (is_homing()) {
+        motor_update();
+        vTaskDelay(1);
     }
-
-    Serial.println("HOMING FAILED - Unknown error");
-    return -4;
+    return homingResult;
 }
 
-// Testing ======================================================================================================================//
+// restore ======================================================================================================================//
+
+const long RESTORE_JOG_TICKS = 40;                  // пробный ход после восстановления, туда и обратно
+
+static long restoreCheckStartCount = 0;
+static long restoreCheckHomeTicks = 0;
 
-void motor_test() {
-    unint_motor_move(300, 1, 200);
-    delay(2000);
-    unint_motor_move(300, 0, 200);
-    delay(2000);
+/**
+ * @brief Конец очередного пробного хода: следующий ход или хоуминг, если проба не прошла
+ * @return true - запущено новое движение, конец этой задачи наружу не сообщаем
+ */
+static bool restore_check_next(MotorMoveStatus status) {
+    long counted = labs(get_encoder() - restoreCheckStartCount);
+    if (status != MotorMoveStatus::DONE || counted < RESTORE_JOG_TICKS / 2) {
+        Serial.println("Restore check failed: jog counted " + String(counted) + " of " + String(RESTORE_JOG_TICKS) +
+                       " ticks, homing");
+        restoreCheckPhase = 0;
+        stopKnown = false;
+        start_homing();
+        return true;
+    }
+    if (restoreCheckPhase == 1) {
+        restoreCheckPhase = 2;
+        restoreCheckStartCount = get_encoder();
+        start_move_to_ticks(restoreCheckHomeTicks, curr_pos_ind);
+        return true;
+    }
+    restoreCheckPhase = 0;
+    Serial.println("Restore check passed: position " + String(curr_pos_ind));
+    return false;
 }
 
+/**
+ * @brief Восстанавливает положение, сохраненное до перезагрузки, вместо хоуминга
+ * @return false - запись неправдоподобна (счет энкодера не сходится с позицией, ход вне пределов)
+ *
+ * Контрольная сумма записи уже гарантирует, что счет и позиция согласованы, но не знает, что
+ * было без питания. Поэтому после восстановления запускается пробный ход на RESTORE_JOG_TICKS
+ * к середине хода и обратно (ведет motor_update(), мотор занят, пока он идет): мертвый энкодер
+ * ничего не насчитает, а створку, которую руками дожали до упора, упор остановит. Проба не
+ * прошла - сам запускается хоуминг.
+ */
+bool motor_restore_position(int posIndex, long encoderCount, long travel, const MotorSyncState& sync) {
+    if (posIndex < 0 || posIndex >= (int)MAX_POS ||
+        travel < (long)MAX_MOTOR_POS / 2 || travel > (long)MAX_MOTOR_POS * 2) {
+        Serial.println("Restore rejected: pos " + String(posIndex) + ", travel " + String(travel));
+        return false;
+    }
+    long step = travel / MAX_POS;
+    long expected = -step * posIndex - lroundf(sync.lashOffset + sync.slipOffset);  // открытие уменьшает счет энкодера
+    if (labs(encoderCount - expected) > step / 2) {
+        Serial.println("Restore rejected: encoder " + String(encoderCount) + " vs expected " + String(expected));
+        return false;
+    }
+
+    cancel_pos_move();
+    encoder->write(encoderCount);
+    if (get_encoder() != encoderCount) {
+        Serial.println("Restore rejected: encoder backend did not accept the count");
+        return false;
+    }
+    resetEncoderVelocityCalculation();
+    lastStoppedEncoderCount = encoderCount;
+    initialencoderCount = encoderCount;
+    travelTicks = travel;
+    posStepTicks = step;
+    syncState = sync;
+    accountedCount = encoderCount;
+    stopKnown = true;
+    curr_pos_ind = posIndex;
+    target_pos_ind = curr_pos_ind;
+    targetTicks = get_position_ticks();
+    Serial.println("Position restored: " + String(curr_pos_ind) + ", encoder " + String(encoderCount));
+
+    long towardMiddle = (posIndex < (int)MAX_POS / 2) ? RESTORE_JOG_TICKS : -RESTORE_JOG_TICKS;
+    restoreCheckHomeTicks = targetTicks;
+    restoreCheckStartCount = get_encoder();
+    restoreCheckPhase = 1;
+    moveCorrections = 0;
+    start_move_to_ticks(targetTicks + towardMiddle, posIndex);
+    return true;
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include "encoder.h"
+
 const unsigned long DFLT_TIMEOUT = 20000;
-const int DFLT_SPEED = 150;
+const int MOTOR_PWM_MAX = 1023;         // 10-битный ШИМ
+const int DFLT_SPEED = MOTOR_PWM_MAX;   // ограничение ШИМ для задачи, скорость задает профиль
 
 void motor_setup();
 
@@ -9,15 +12,85 @@ void motor_setup();
 void stop_motor();
 
 long get_encoder();
+void motor_set_encoder(Encoder* enc);  // до motor_setup(): свой бэкенд энкодера (хост, тесты)
+EncoderStats get_encoder_stats();
+const char* get_encoder_backend();
+int get_motor_pwm();
+int get_motor_direction();
 
 void setMotorMoveTask(unsigned long ticks, int direction, int speed);
 bool MotorExecMoveTask();
 bool unint_motor_move(unsigned long ticks, int direction, int speed = DFLT_SPEED, unsigned long timeout_ms = DFLT_TIMEOUT);
 
-int change_pos(int pos);
+// асинхронное перемещение по позициям =========================================================================================//
+
+enum class MotorMoveStatus {
+    IDLE,       // задач еще не было
+    MOVING,     // мотор едет к target
+    DONE,       // приехали в target
+    TIMEOUT,    // не доехали за отведенное время
+    CANCELLED,  // задача снята (хоуминг и т.п.)
+    STALLED     // вал заклинило посреди хода
+
+};
+
+typedef void (*MotorMoveCallback)(MotorMoveStatus status, int pos);
+
+int move_to_ticks(long ticks);          // абсолютная цель вдоль оси открытия (0 - закрыто), не блокирует
+int move_to_percent(float percent);     // 0 - закрыто, 100 - крайняя позиция
+int change_pos(int pos);                // одна из MAX_POS позиций -> move_to_ticks()
+void motor_update();                    // продвигает задачу (и хоуминг), вызывать в каждом loop()
+bool wait_motor_idle(unsigned long timeout_ms = DFLT_TIMEOUT);
+void cancel_pos_move();
+
+bool is_motor_busy();                   // едем к позиции или идет хоуминг
+MotorMoveStatus get_motor_move_status();
+void set_motor_move_callback(MotorMoveCallback callback);
+
 int get_current_position_index();
+int get_target_position_index();
+long get_position_ticks();              // фактическое положение по энкодеру
+long get_target_ticks();
+float get_percent_open();
 
 void motor_test();
 
+float calculateEncoderVelocity();
 void resetEncoderVelocityCalculation();
-int performHoming();
+void start_homing(bool measureTravel = false);  // не блокирует, ведет motor_update()
+bool is_homing();
+int get_homing_result();                // результат последнего хоуминга, как у performHoming()
+unsigned long get_homing_duration_ms();
+long get_travel_ticks();                // полный ход, тики (MAX_MOTOR_POS, пока не измерен)
+int performHoming(bool measureTravel = false);  // блокирующий хоуминг: 0 - успех, <0 - ошибка
+
+// зазор и проскальзывание тяги ================================================================================================//
+
+// Выученные параметры тяги со струбциной
+struct MotorCalibration {
+    float backlashTicks[2];     // холостой ход вала после реверса: [0] - в открытие, [1] - в закрытие
+    float slipPerTick;          // отставание створки на тик хода открытия (< 0 - на тик хода закрытия)
+    float driftPerTick;         // рост оценки ошибки на тик хода - по остаткам пересинхронизаций
+    uint16_t resyncs;           // сколько раз обучались у упора
+};
+
+// Текущее расхождение вала и створки (створка = вал - lashOffset - slipOffset)
+struct MotorSyncState {
+    int32_t lashDir;            // в какую сторону выбран зазор
+    float lashOffset;           // тики вдоль оси открытия
+    float slipOffset;
+    float errorEstimate;        // накопленный с прошлой синхронизации дрейф, тики
+    int32_t openTravel;         // ход открытия с прошлой синхронизации, тики (для обучения проскальзывания)
+};
+
+MotorCalibration motor_get_calibration();
+void motor_set_calibration(const MotorCalibration& calibration);   // из журнала
+MotorSyncState motor_get_sync_state();
+float get_position_error_estimate();    // тики; выше порога - пересинхронизация у упора
+bool is_resyncing();                    // частичная пересинхронизация у упора закрытия (в is_homing() не входит)
+void start_resync();                    // не блокирует; задача по позиции продолжится после нее
+unsigned long get_resync_duration_ms();
+
+bool motor_restore_position(int posIndex, long encoderCount, long travelTicks,
+                            const MotorSyncState& sync);    // положение из журнала, false - не сходится;
+                                                            // дальше пробный ход, не прошел - хоуминг
@@ -0,0 +1,229 @@
+#include "position_history.h"
+#include <math.h>
+
+// exp((t - origin) / 1 ч); t бывает и раньше опоры (старые записи), и позже
+static float origin_weight(unsigned long timestamp, unsigned long origin) {
+    return expf((float)(long)(timestamp - origin) / POSITION_HISTORY_DECAY_MS);
+}
+
+static uint16_t quantize(float value, float step) {
+    float steps = value / step + 0.5f;
+    if (steps <= 0.0f) return 0;
+    if (steps >= 65535.0f) return 65535;
+    return (uint16_t)steps;
+}
+
+static float metric_of(const HistoryEntry& entry) {
+    return entry.metric * POSITION_HISTORY_METRIC_STEP;
+}
+
+static float weight_of(const HistoryEntry& entry) {
+    return entry.weight * POSITION_HISTORY_WEIGHT_STEP;
+}
+
+static int tier_offset(int tier) {
+    int offset = 0;
+    for (int t = 0; t < tier; t++) offset += POSITION_HISTORY_TIER_SIZE[t];
+    return offset;
+}
+
+// время записи яруса в единицах яруса после предыдущей; округляется от уже округленного
+// времени предыдущей, так что ошибка не копится
+static unsigned long tier_time(const HistoryTier& tier, int tierIndex, unsigned long timeMs, uint16_t& gap) {
+    if (tier.count == 0) {
+        gap = 0;
+        return timeMs;
+    }
+    unsigned long unit = POSITION_HISTORY_TIER_UNIT_MS[tierIndex];
+    long delta = (long)(timeMs - tier.newestMs);
+    unsigned long steps = (delta > 0) ? ((unsigned long)delta + unit / 2) / unit : 0;
+    gap = (steps > 65535UL) ? 65535 : (uint16_t)steps;
+    return tier.newestMs + gap * unit;
+}
+
+// ярусы =========================================================================================================================//
+
+HistoryEntry& PositionHistory::at(int tier, int i) {
+    return entries[tier_offset(tier) + (tiers[tier].head + i) % POSITION_HISTORY_TIER_SIZE[tier]];
+}
+
+const HistoryEntry& PositionHistory::at(int tier, int i) const {
+    return entries[tier_offset(tier) + (tiers[tier].head + i) % POSITION_HISTORY_TIER_SIZE[tier]];
+}
+
+void PositionHistory::append(int tier, unsigned long timeMs, float metric, float weight) {
+    HistoryTier& state = tiers[tier];
+    uint16_t gap;
+    unsigned long quantizedMs = tier_time(state, tier, timeMs, gap);
+
+    HistoryEntry& entry = entries[tier_offset(tier) + (state.head + state.count) % POSITION_HISTORY_TIER_SIZE[tier]];
+    entry.metric = quantize(metric, POSITION_HISTORY_METRIC_STEP);
+    entry.weight = quantize(weight, POSITION_HISTORY_WEIGHT_STEP);
+    entry.gap = gap;
+
+    if (state.count == 0) state.oldestMs = quantizedMs;
+    state.newestMs = quantizedMs;
+    state.count++;
+    count++;
+}
+
+// только из хранилища, суммы весов - забота вызывающего
+void PositionHistory::evictOldest(int tier) {
+    HistoryTier& state = tiers[tier];
+    state.head = (state.head + 1) % POSITION_HISTORY_TIER_SIZE[tier];
+    state.count--;
+    count--;
+    if (state.count > 0) state.oldestMs += at(tier, 0).gap * POSITION_HISTORY_TIER_UNIT_MS[tier];
+}
+
+/**
+ * @brief Сливает n самых старых записей яруса в одну запись следующего
+ * @details Время корзины - время самой свежей из слитых, округленное до единицы следующего
+ * яруса, вес и метрика - относительно него. Суммы весов меняются только на ошибку округления.
+ */
+void PositionHistory::mergeOldest(int tier, int n) {
+    const int MAX_MERGE = 10;
+    HistoryTier& state = tiers[tier];
+    if (n > state.count) n = state.count;
+    if (n > MAX_MERGE) n = MAX_MERGE;
+    if (n <= 0) return;
+
+    unsigned long times[MAX_MERGE];
+    unsigned long timeMs = state.oldestMs;
+    for (int i = 0; i < n; i++) {
+        if (i > 0) timeMs += at(tier, i).gap * POSITION_HISTORY_TIER_UNIT_MS[tier];
+        times[i] = timeMs;
+    }
+
+    makeRoom(tier + 1);
+    uint16_t gap;
+    unsigned long bucketMs = tier_time(tiers[tier + 1], tier + 1, times[n - 1], gap);
+
+    float weight = 0.0f;
+    float metricSum = 0.0f;
+    for (int i = 0; i < n; i++) {
+        float w = weight_of(at(tier, i)) * origin_weight(times[i], bucketMs);
+        weight += w;
+        metricSum += metric_of(at(tier, i)) * w;
+    }
+    float metric = (weight > 0.0f) ? metricSum / weight : 0.0f;
+
+    for (int i = 0; i < n; i++) evictOldest(tier);
+    append(tier + 1, bucketMs, metric, weight);
+
+    // поправка сумм на округление веса и метрики корзины
+    const HistoryEntry& bucket = at(tier + 1, tiers[tier + 1].count - 1);
+    float scale = origin_weight(bucketMs, decayOrigin);
+    decayedWeight += (weight_of(bucket) - weight) * scale;
+    decayedMetric += (weight_of(bucket) * metric_of(bucket) - metricSum) * scale;
+}
+
+// место под новую запись яруса: слить старые в следующий, с последнего - вытеснить
+void PositionHistory::makeRoom(int tier) {
+    if (tiers[tier].count < POSITION_HISTORY_TIER_SIZE[tier]) return;
+
+    if (tier == POSITION_HISTORY_TIERS - 1) {
+        const HistoryEntry& oldest = at(tier, 0);
+        float weight = weight_of(oldest) * origin_weight(tiers[tier].oldestMs, decayOrigin);
+        decayedWeight -= weight;
+        decayedMetric -= metric_of(oldest) * weight;
+        evictOldest(tier);
+        return;
+    }
+    mergeOldest(tier, POSITION_HISTORY_TIER_MERGE[tier]);
+}
+
+// постановка ====================================================================================================================//
+
+void PositionHistory::addRecord(float metric, unsigned long timestamp) {
+    // забыть то, у чего вес уже ниже точности float
+    for (int tier = POSITION_HISTORY_TIERS - 1; tier >= 0; tier--) {
+        while (tiers[tier].count > 0 && (long)(timestamp - tiers[tier].oldestMs) > (long)POSITION_HISTORY_FORGET_MS) {
+            const HistoryEntry& oldest = at(tier, 0);
+            float weight = weight_of(oldest) * origin_weight(tiers[tier].oldestMs, decayOrigin);
+            decayedWeight -= weight;
+            decayedMetric -= metric_of(oldest) * weight;
+            evictOldest(tier);
+        }
+    }
+    if (count == 0) {
+        decayOrigin = timestamp;
+        decayedWeight = 0.0f;
+        decayedMetric = 0.0f;
+    }
+
+    // перерыв длиннее, чем влезает в запись первого яруса: окно было в других позициях,
+    // прежний заход целиком уходит в корзины
+    HistoryTier& fine = tiers[0];
+    if (fine.count > 0 && (long)(timestamp - fine.newestMs) > (long)(65535UL * POSITION_HISTORY_TIER_UNIT_MS[0])) {
+        while (fine.count > 0) mergeOldest(0, POSITION_HISTORY_TIER_MERGE[0]);
+    }
+
+    makeRoom(0);
+    append(0, timestamp, metric, 1.0f);
+
+    const HistoryEntry& added = at(0, fine.count - 1);
+    if ((long)(fine.newestMs - decayOrigin) > (long)POSITION_HISTORY_RENORM_MS) {
+        renormalize(fine.newestMs);
+        return;
+    }
+    float weight = weight_of(added) * origin_weight(fine.newestMs, decayOrigin);
+    decayedWeight += weight;
+    decayedMetric += metric_of(added) * weight;
+}
+
+// пересчет сумм относительно новой опоры: раз в POSITION_HISTORY_RENORM_MS, в среднем O(1)
+void PositionHistory::renormalize(unsigned long origin) {
+    decayOrigin = origin;
+    decayedWeight = 0.0f;
+    decayedMetric = 0.0f;
+    for (int tier = 0; tier < POSITION_HISTORY_TIERS; tier++) {
+        unsigned long timeMs = tiers[tier].oldestMs;
+        for (int i = 0; i < tiers[tier].count; i++) {
+            const HistoryEntry& entry = at(tier, i);
+            if (i > 0) timeMs += entry.gap * POSITION_HISTORY_TIER_UNIT_MS[tier];
+            float weight = weight_of(entry) * origin_weight(timeMs, origin);
+            decayedWeight += weight;
+            decayedMetric += metric_of(entry) * weight;
+        }
+    }
+}
+
+// запросы =======================================================================================================================//
+
+float PositionHistory::getWeightedMetric(unsigned long currentTime) const {
+    if (count == 0) return -1.0f;
+    // общий множитель в отношении сокращается, он нужен только для порога веса
+    return (getTotalWeight(currentTime) >= POSITION_HISTORY_MIN_WEIGHT) ? (decayedMetric / decayedWeight) : -1.0f;
+}
+
+float PositionHistory::getTotalWeight(unsigned long currentTime) const {
+    if (count == 0) return 0.0f;
+    return decayedWeight / origin_weight(currentTime, decayOrigin);
+}
+
+bool PositionHistory::latest(MetricRecord& last, MetricRecord& prev) const {
+    const HistoryTier& fine = tiers[0];
+    if (fine.count < 2) return false;
+
+    const HistoryEntry& newest = at(0, fine.count - 1);
+    last = { metric_of(newest), fine.newestMs };
+    prev = { metric_of(at(0, fine.count - 2)), fine.newestMs - newest.gap * POSITION_HISTORY_TIER_UNIT_MS[0] };
+    return true;
+}
+
+unsigned long PositionHistory::oldestMs() const {
+    for (int tier = POSITION_HISTORY_TIERS - 1; tier >= 0; tier--) {
+        if (tiers[tier].count > 0) return tiers[tier].oldestMs;
+    }
+    return 0;
+}
+
+void PositionHistory::shiftTime(unsigned long deltaMs) {
+    // в записях только расстояния, абсолютны лишь границы ярусов и опора
+    for (HistoryTier& tier : tiers) {
+        tier.oldestMs += deltaMs;
+        tier.newestMs += deltaMs;
+    }
+    decayOrigin += deltaMs;
+}
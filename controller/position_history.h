@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+
+// История метрики для одной позиции окна и средняя метрика с весом exp(-возраст в часах).
+//
+// Хранение в три яруса разного разрешения. Свежие замеры лежат как есть; когда ярус полон,
+// самые старые его записи сливаются в одну запись следующего, более грубого яруса: 10 замеров
+// (~10 мин) - в корзину, 6 корзин (~1 ч) - в корзину последнего яруса. Вытесняется только
+// старое с последнего яруса или то, что старше POSITION_HISTORY_FORGET_MS, - у него вес уже
+// ниже точности float. Запись - 6 байт: метрика с шагом 0.01, вес корзины с шагом 1/1000 и
+// расстояние до предыдущей записи яруса в единицах яруса (секунды или минуты; округление с
+// учетом уже накопленной ошибки, она не копится). Вес корзины считается относительно ее
+// собственного времени: exp((t_i - t_корзины) / 1 ч) по слитым замерам, так что слияние не
+// меняет ни сумм весов, ни средней метрики, кроме округления.
+//
+// Суммы весов ведутся нарастающим итогом относительно опорного момента decayOrigin:
+// запись с меткой t входит в них с весом w * exp((t - decayOrigin) / 1 ч), к запросу в момент
+// now остается домножить на общий множитель exp(-(now - decayOrigin) / 1 ч). Так addRecord() и
+// оба запроса - O(1) в среднем и по одной экспоненте. Вытесненная запись вычитается. Когда
+// свежие записи уходят от опоры дальше POSITION_HISTORY_RENORM_MS (веса растут как e^8),
+// опора переносится на последнюю запись, а суммы пересчитываются заново - заодно сбрасывается
+// накопленная вычитаниями ошибка.
+
+const int POSITION_HISTORY_TIERS = 3;
+const int POSITION_HISTORY_TIER_SIZE[POSITION_HISTORY_TIERS] = { 48, 48, 96 };      // 48 мин + 8 ч + 4 сут
+const int POSITION_HISTORY_TIER_MERGE[POSITION_HISTORY_TIERS] = { 10, 6, 0 };       // сколько записей идут в одну следующего яруса
+const unsigned long POSITION_HISTORY_TIER_UNIT_MS[POSITION_HISTORY_TIERS] = { 1000UL, 60000UL, 60000UL };
+const int POSITION_HISTORY_ENTRIES = 48 + 48 + 96;
+const unsigned long POSITION_HISTORY_DECAY_MS = 3600000UL;      // вес падает в e раз за час
+const unsigned long POSITION_HISTORY_RENORM_MS = 8UL * 3600000UL;
+const unsigned long POSITION_HISTORY_FORGET_MS = 5UL * 24UL * 3600000UL;   // e^-120 - ноль во float
+constexpr float POSITION_HISTORY_MIN_WEIGHT = 0.1f;
+constexpr float POSITION_HISTORY_METRIC_STEP = 0.01f;   // метрика 0..655.35
+constexpr float POSITION_HISTORY_WEIGHT_STEP = 0.001f;  // вес корзины до 65.5
+
+struct MetricRecord {
+    float metric;
+    unsigned long timestamp;
+};
+
+struct HistoryEntry {
+    uint16_t metric;                    // в POSITION_HISTORY_METRIC_STEP
+    uint16_t weight;                    // в POSITION_HISTORY_WEIGHT_STEP, у замера - 1
+    uint16_t gap;                       // от предыдущей записи яруса, в единицах яруса
+};
+
+struct HistoryTier {
+    uint8_t head;                       // индекс самой старой записи внутри яруса
+    uint8_t count;
+    unsigned long oldestMs;             // время самой старой и самой свежей записей
+    unsigned long newestMs;
+};
+
+struct PositionHistory {
+    HistoryEntry entries[POSITION_HISTORY_ENTRIES];
+    HistoryTier tiers[POSITION_HISTORY_TIERS] = {};
+    int count = 0;                      // записей во всех ярусах
+
+    float decayedWeight = 0.0f;         // сумма w * exp((t - decayOrigin) / 1 ч)
+    float decayedMetric = 0.0f;         // то же, умноженное на метрику
+    unsigned long decayOrigin = 0;
+
+    void addRecord(float metric, unsigned long timestamp);
+    float getWeightedMetric(unsigned long currentTime) const;   // -1 - мало данных
+    float getTotalWeight(unsigned long currentTime) const;
+
+    bool latest(MetricRecord& last, MetricRecord& prev) const;  // два последних замера, если оба еще не слиты
+    unsigned long oldestMs() const;     // время самой старой записи, count > 0
+    void shiftTime(unsigned long deltaMs);  // на другие часы: millis() после перезагрузки
+
+private:
+    HistoryEntry& at(int tier, int i);  // i-я от старой запись яруса
+    const HistoryEntry& at(int tier, int i) const;
+    void append(int tier, unsigned long timeMs, float metric, float weight);
+    void evictOldest(int tier);
+    void mergeOldest(int tier, int n);
+    void makeRoom(int tier);
+    void renormalize(unsigned long origin);
+};
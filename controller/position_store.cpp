@@ -0,0 +1,216 @@
+#include <Arduino.h>
+#include "position_store.h"
+#include "motor_impl.h"
+#include <stddef.h>
+
+const uint16_t POSITION_RECORD_VERSION = 2;          // 2 - зазор и проскальзывание тяги
+
+static PositionStorage* storage = nullptr;
+static PositionRecord lastRecord = {};              // последняя записанная (или прочитанная) запись
+static int lastSlot = -1;
+static bool haveRecord = false;
+static uint32_t writesSinceBoot = 0;
+static unsigned long idleSinceMs = 0;
+static bool wasBusy = false;
+
+const long POSITION_STORE_DRIFT_TICKS = 5;          // стоящий вал сдвинули - переписываем запись
+
+static uint32_t record_checksum(const PositionRecord& record) {
+    // FNV-1a по всем полям, кроме самой суммы
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(PositionRecord, checksum); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool record_valid(const PositionRecord& record) {
+    return record.version == POSITION_RECORD_VERSION && record.checksum == record_checksum(record);
+}
+
+// память =======================================================================================================================//
+
+bool MemoryPositionStorage::load(int slot, PositionRecord& record) {
+    if (!used[slot]) return false;
+    record = slots[slot];
+    return true;
+}
+
+bool MemoryPositionStorage::save(int slot, const PositionRecord& record) {
+    slots[slot] = record;
+    used[slot] = true;
+    return true;
+}
+
+void MemoryPositionStorage::corrupt(int slot) {
+    slots[slot].encoderCount ^= 0x5a5a;
+}
+
+// журнал =======================================================================================================================//
+
+static void write_record(bool clean) {
+    PositionRecord record = {};
+    record.version = POSITION_RECORD_VERSION;
+    record.clean = clean ? 1 : 0;
+    record.seq = haveRecord ? lastRecord.seq + 1 : 1;
+    record.posIndex = get_current_position_index();
+    record.encoderCount = get_encoder();
+    record.travelTicks = get_travel_ticks();
+    record.calibration = motor_get_calibration();
+    record.sync = motor_get_sync_state();
+    record.writes = (haveRecord ? lastRecord.writes : 0) + 1;
+    record.checksum = record_checksum(record);
+
+    int slot = (lastSlot + 1) % POSITION_STORE_SLOTS;
+    if (!storage->save(slot, record)) {
+        Serial.println("Position store: write failed");
+        return;
+    }
+    lastRecord = record;
+    lastSlot = slot;
+    haveRecord = true;
+    writesSinceBoot++;
+}
+
+// запись не описывает стоящий мотор: грязная или положение с тех пор изменилось
+// (блокирующий хоуминг, внешний поворот створки)
+static bool record_stale() {
+    if (!haveRecord || !lastRecord.clean) {
+        return true;
+    }
+    return lastRecord.posIndex != get_current_position_index() ||
+           lastRecord.travelTicks != get_travel_ticks() ||
+           lastRecord.calibration.resyncs != motor_get_calibration().resyncs ||
+           labs(lastRecord.encoderCount - get_encoder()) > POSITION_STORE_DRIFT_TICKS;
+}
+
+void position_store_begin(PositionStorage* storage_) {
+    storage = storage_;
+    if (storage == nullptr) {
+        storage = position_storage_create_nvs();
+    }
+    if (storage == nullptr || !storage->begin()) {
+        Serial.println("Position store unavailable");
+        storage = nullptr;
+        return;
+    }
+
+    // самая свежая целая запись
+    haveRecord = false;
+    lastSlot = -1;
+    writesSinceBoot = 0;
+    for (int slot = 0; slot < POSITION_STORE_SLOTS; slot++) {
+        PositionRecord record;
+        if (!storage->load(slot, record) || !record_valid(record)) {
+            continue;
+        }
+        if (!haveRecord || (int32_t)(record.seq - lastRecord.seq) > 0) {
+            lastRecord = record;
+            lastSlot = slot;
+            haveRecord = true;
+        }
+    }
+    wasBusy = false;
+    idleSinceMs = millis();
+}
+
+/**
+ * @brief Восстанавливает положение из журнала после перезагрузки
+ * @return true - запись чистая и счет энкодера сходится с позицией; дальше мотор занят пробным
+ *         ходом, и только если энкодер его не насчитает, сам запустится хоуминг
+ *
+ * Грязная запись значит, что питание пропало посреди движения - положению верить нельзя.
+ */
+bool position_store_restore() {
+    if (storage == nullptr || !haveRecord) {
+        Serial.println("Position store: no saved position");
+        return false;
+    }
+    Serial.println("Position store: seq " + String(lastRecord.seq) + ", pos " + String(lastRecord.posIndex) +
+                   ", encoder " + String(lastRecord.encoderCount) + (lastRecord.clean ? ", clean" : ", DIRTY"));
+    // выученная тяга не зависит от того, где створка: берем и из грязной записи
+    motor_set_calibration(lastRecord.calibration);
+    if (!lastRecord.clean) {
+        return false;
+    }
+
+    if (!motor_restore_position(lastRecord.posIndex, lastRecord.encoderCount, lastRecord.travelTicks, lastRecord.sync)) {
+        Serial.println("Position store: encoder sanity check failed");
+        // дальше будет хоуминг: если питание пропадет посреди него, старой записи верить нельзя
+        write_record(false);
+        return false;
+    }
+    return true;
+}
+
+void position_store_update() {
+    if (storage == nullptr) {
+        return;
+    }
+
+    bool busy = is_motor_busy();
+    if (busy) {
+        // первая задача серии - помечаем журнал грязным, пока едем - больше не пишем
+        if (!haveRecord || lastRecord.clean) {
+            write_record(false);
+        }
+    } else if (wasBusy) {
+        idleSinceMs = millis();
+    } else if (millis() - idleSinceMs >= POSITION_STORE_COMMIT_DELAY_MS && record_stale()) {
+        // серия движений закончилась - одна чистая запись на всю серию
+        write_record(true);
+    }
+    wasBusy = busy;
+}
+
+PositionStoreStats position_store_stats() {
+    PositionStoreStats stats;
+    stats.writesSinceBoot = writesSinceBoot;
+    stats.writesTotal = haveRecord ? lastRecord.writes : 0;
+    unsigned long uptime = millis();
+    stats.writesPerDay = uptime > 0 ? writesSinceBoot * 86400000.0f / uptime : 0.0f;
+    return stats;
+}
+
+// ESP32 =========================================================================================================================//
+
+#if defined(ESP32)
+
+#include <Preferences.h>
+
+class NvsPositionStorage : public PositionStorage {
+public:
+    bool begin() override {
+        return prefs.begin("window_pos", false);
+    }
+
+    bool load(int slot, PositionRecord& record) override {
+        return prefs.getBytes(key(slot), &record, sizeof(record)) == sizeof(record);
+    }
+
+    bool save(int slot, const PositionRecord& record) override {
+        return prefs.putBytes(key(slot), &record, sizeof(record)) == sizeof(record);
+    }
+
+private:
+    const char* key(int slot) {
+        snprintf(keyBuf, sizeof(keyBuf), "pos%d", slot);
+        return keyBuf;
+    }
+
+    Preferences prefs;
+    char keyBuf[8];
+};
+
+PositionStorage* position_storage_create_nvs() {
+    return new NvsPositionStorage();
+}
+
+#else
+
+PositionStorage* position_storage_create_nvs() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include "motor_impl.h"
+
+// Журнал положения створки во flash: позиция, счет энкодера, измеренный ход и флаг
+// "движение завершено". Чистая перезагрузка восстанавливает положение без хоуминга.
+// Заодно хранит выученные зазор и проскальзывание тяги - они нужны и после хоуминга.
+//
+// Записи идут по кругу в POSITION_STORE_SLOTS слотах с растущим номером: последняя
+// целая запись никогда не перезаписывается, а износ делится между слотами. Коммиты
+// пакетные: "грязная" запись - один раз при начале серии движений, "чистая" - когда
+// мотор простоял POSITION_STORE_COMMIT_DELAY_MS.
+
+struct PositionRecord {
+    uint16_t version;
+    uint16_t clean;             // 1 - мотор стоял, положение достоверно
+    uint32_t seq;               // номер записи, у последней - наибольший
+    int32_t posIndex;
+    int32_t encoderCount;
+    int32_t travelTicks;
+    MotorCalibration calibration;
+    MotorSyncState sync;        // смещения вала относительно створки на момент записи
+    uint32_t writes;            // всего записей за жизнь устройства
+    uint32_t checksum;
+};
+
+const int POSITION_STORE_SLOTS = 4;
+const unsigned long POSITION_STORE_COMMIT_DELAY_MS = 5000;
+
+// хранилище слотов: NVS на ESP32, память в тестах
+class PositionStorage {
+public:
+    virtual ~PositionStorage() {}
+    virtual bool begin() = 0;
+    virtual bool load(int slot, PositionRecord& record) = 0;
+    virtual bool save(int slot, const PositionRecord& record) = 0;
+};
+
+PositionStorage* position_storage_create_nvs();     // nullptr, если не ESP32
+
+// хранилище в RAM: переживает "перезагрузку" модуля, но не процесса
+class MemoryPositionStorage : public PositionStorage {
+public:
+    bool begin() override { return true; }
+    bool load(int slot, PositionRecord& record) override;
+    bool save(int slot, const PositionRecord& record) override;
+    void corrupt(int slot);                         // испорченная запись (питание пропало посреди записи)
+
+private:
+    PositionRecord slots[POSITION_STORE_SLOTS] = {};
+    bool used[POSITION_STORE_SLOTS] = {};
+};
+
+struct PositionStoreStats {
+    uint32_t writesSinceBoot;
+    uint32_t writesTotal;
+    float writesPerDay;         // по темпу с момента загрузки
+};
+
+void position_store_begin(PositionStorage* storage = nullptr);
+bool position_store_restore();                      // true - положение восстановлено, хоуминг не нужен
+void position_store_update();                       // вызывать в каждом loop()
+PositionStoreStats position_store_stats();
@@ -0,0 +1,370 @@
+#include <Arduino.h>
+#include "power.h"
+#include "motor_impl.h"
+#include "sensors.h"
+#include "OLED_screen.h"
+#include "buttons.h"
+#include "bot_link.h"
+#include <atomic>
+
+#if defined(ESP32)
+#include <esp_pm.h>
+#include <esp_idf_version.h>
+#endif
+
+// оценка тока ===================================================================================================================//
+//
+// Типовые значения для ESP32-WROOM при 240 МГц по даташиту; датчики и драйвер мотора не входят.
+// Радио добавляется, пока чип не в light sleep: без энергосбережения приемник слушает
+// постоянно, в modem sleep просыпается к маякам точки доступа.
+// Это модель, а не замер: при подключенном WiFi автоматический light sleep прерывается
+// на каждый DTIM-маяк и на TLS-соединение бота, и реальный ток выше оценки - мерить амперметром.
+
+const float CURRENT_BUSY_MA = 50.0f;            // ядро считает
+const float CURRENT_IDLE_MA = 25.0f;            // ядро ждет в vTaskDelay
+const float CURRENT_LIGHT_SLEEP_MA = 0.8f;
+const float CURRENT_RADIO_MA[POWER_MODE_COUNT] = {
+    75.0f,                                      // WIFI_PS_MIN_MODEM по умолчанию в Arduino, но бот опрашивает каждую секунду
+    6.0f                                        // WIFI_PS_MAX_MODEM, опрос раз в BOT_SAVING_UPDATE_INTERVAL
+};
+const float CURRENT_DISPLAY_MA = 12.0f;         // SSD1306, типичное заполнение экрана
+
+// часы и сон ====================================================================================================================//
+
+// как в планировщике: vTaskDelay отдает ядро, меньше тика - yield()
+class PlatformPowerClock : public SchedulerClock {
+public:
+    uint32_t nowUs() override { return (uint32_t)micros(); }
+    void sleepUs(uint32_t us) override {
+#if defined(ESP32)
+        TickType_t ticks = pdMS_TO_TICKS(us / 1000);
+        if (ticks > 0) {
+            vTaskDelay(ticks);
+        } else {
+            yield();
+        }
+#else
+        delay(us / 1000);
+#endif
+    }
+};
+
+static PlatformPowerClock platformClock;
+static SchedulerClock* baseClock = &platformClock;
+static std::atomic<uint8_t> powerMode((uint8_t)PowerMode::NORMAL);
+static bool lightSleepMeasured = false;     // без замера сна ток - оценка сверху, как без сна
+
+// Сон не принудительный: esp_light_sleep_start() не сохраняет WiFi-соединение и остановил бы
+// оба ядра посреди запроса бота. В энергосбережении включается автоматический light sleep
+// (esp_pm_configure), и чип засыпает сам, когда все задачи ждут, а никто не держит блокировку
+// питания. Бот держит свою на время работы с сетью (bot_link_set_network_busy()), управление -
+// пока едет мотор: энкодер в light sleep не считает. WiFi при этом остается подключенным
+// в modem sleep и просыпается к маякам точки доступа. Таймер сэмплера энкодера (1 кГц) тоже
+// работает только в ходе мотора, иначе будил бы чип каждую миллисекунду.
+//
+// Нужны CONFIG_PM_ENABLE и CONFIG_FREERTOS_USE_TICKLESS_IDLE; без них остается только modem sleep.
+
+#if defined(ESP32)
+
+static esp_pm_lock_handle_t motorLock = nullptr;
+static bool motorLockHeld = false;
+
+static void configure_light_sleep(bool enable) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t config = {};
+#else
+    esp_pm_config_esp32_t config = {};
+#endif
+    config.max_freq_mhz = 240;
+    config.min_freq_mhz = enable ? 80 : 240;    // ниже 80 МГц упала бы APB: ШИМ мотора и UART
+    config.light_sleep_enable = enable;
+    esp_err_t err = esp_pm_configure(&config);
+    if (enable && err != ESP_OK) {
+        Serial.println("Power: automatic light sleep unavailable (" + String(esp_err_to_name(err)) + "), modem sleep only");
+    }
+}
+
+// мотор запускают только задачи этого же цикла: блокировка берется раньше, чем он уснет
+static void hold_motor_lock(bool hold) {
+    if (motorLock == nullptr || hold == motorLockHeld) return;
+    if (hold) {
+        esp_pm_lock_acquire(motorLock);
+    } else {
+        esp_pm_lock_release(motorLock);
+    }
+    motorLockHeld = hold;
+}
+
+// Время сна - по факту: планировщик питания сообщает, сколько чип проспал. Без
+// CONFIG_PM_LIGHT_SLEEP_CALLBACKS узнать это неоткуда, и сон не считается вовсе -
+// ждать срока, пока сон разрешен, еще не значит спать: будят таймеры, прерывания и маяки WiFi.
+#if defined(CONFIG_PM_LIGHT_SLEEP_CALLBACKS)
+static portMUX_TYPE sleepMux = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t sleptUs = 0;
+
+static esp_err_t IRAM_ATTR on_light_sleep_exit(int64_t sleepTimeUs, void*) {
+    portENTER_CRITICAL_SAFE(&sleepMux);
+    sleptUs += sleepTimeUs;
+    portEXIT_CRITICAL_SAFE(&sleepMux);
+    return ESP_OK;
+}
+#endif
+
+static bool measure_light_sleep() {
+#if defined(CONFIG_PM_LIGHT_SLEEP_CALLBACKS)
+    static bool registered = false;
+    if (!registered) {
+        esp_pm_sleep_cbs_register_config_t callbacks = {};
+        callbacks.exit_cb = on_light_sleep_exit;
+        registered = esp_pm_light_sleep_register_cbs(&callbacks) == ESP_OK;
+    }
+    return registered;
+#else
+    return false;
+#endif
+}
+
+static uint64_t light_sleep_total_us() {
+#if defined(CONFIG_PM_LIGHT_SLEEP_CALLBACKS)
+    portENTER_CRITICAL(&sleepMux);
+    uint64_t total = sleptUs;
+    portEXIT_CRITICAL(&sleepMux);
+    return total;
+#else
+    return 0;
+#endif
+}
+
+#else
+
+// на хосте сон - это сон базовых часов, пока light sleep был бы разрешен
+static uint64_t hostSleptUs = 0;
+
+static bool light_sleep_allowed(uint32_t us) {
+    return power_saving() && us >= POWER_LIGHT_SLEEP_MIN_US && !is_motor_busy() && !bot_link_network_busy();
+}
+
+static bool measure_light_sleep() {
+    return true;
+}
+
+static uint64_t light_sleep_total_us() {
+    return hostSleptUs;
+}
+
+#endif
+
+class PowerSchedulerClock : public SchedulerClock {
+public:
+    uint32_t nowUs() override { return baseClock->nowUs(); }
+    void sleepUs(uint32_t us) override {
+#if defined(ESP32)
+        hold_motor_lock(is_motor_busy());
+        baseClock->sleepUs(us);
+#else
+        bool asleep = light_sleep_allowed(us);
+        uint32_t start = baseClock->nowUs();
+        baseClock->sleepUs(us);
+        if (asleep) {
+            hostSleptUs += baseClock->nowUs() - start;
+        }
+#endif
+    }
+};
+
+static PowerSchedulerClock powerClock;
+
+// состояние =====================================================================================================================//
+
+const unsigned long STABLE_SAMPLE_MS = 10000;
+const int STABLE_SAMPLES = POWER_STABLE_WINDOW_MS / STABLE_SAMPLE_MS;
+
+static bool displayOn = true;
+static unsigned long lastActivityMs = 0;
+
+static float tempSamples[STABLE_SAMPLES];
+static int co2Samples[STABLE_SAMPLES];
+static int stableCount = 0;
+static int stableHead = 0;
+static unsigned long lastStableSampleMs = 0;
+static bool sensorsStable = false;
+
+static PowerModeStats modeStats[POWER_MODE_COUNT];
+static uint32_t lastAccountUs = 0;
+static uint64_t lastBusyUs = 0;
+static uint64_t lastLightSleepUs = 0;
+
+static void set_display(bool on) {
+    if (on == displayOn) return;
+    displayOn = on;
+    OLED_screen_set_power(on);
+}
+
+// время с прошлого учета - в статистику текущего режима
+static void account() {
+    uint32_t now = baseClock->nowUs();
+    uint32_t elapsed = now - lastAccountUs;
+    uint64_t busy = scheduler_busy_us();
+    uint64_t slept = light_sleep_total_us();
+    PowerModeStats& stats = modeStats[powerMode.load()];
+    stats.elapsedUs += elapsed;
+    stats.busyUs += busy - lastBusyUs;
+    stats.lightSleepUs += slept - lastLightSleepUs;
+    if (displayOn) stats.displayOnUs += elapsed;
+    lastAccountUs = now;
+    lastBusyUs = busy;
+    lastLightSleepUs = slept;
+}
+
+// показания за окно POWER_STABLE_WINDOW_MS не выходят из полосы - датчики можно опрашивать реже
+static void sample_sensors() {
+    if (stableCount > 0 && millis() - lastStableSampleMs < STABLE_SAMPLE_MS) return;
+    lastStableSampleMs = millis();
+
+    tempSamples[stableHead] = get_room_temp();
+    co2Samples[stableHead] = get_last_co2_ppm();
+    stableHead = (stableHead + 1) % STABLE_SAMPLES;
+    if (stableCount < STABLE_SAMPLES) stableCount++;
+
+    bool stable = stableCount == STABLE_SAMPLES && !get_room_sensor_error() && !get_co2_read_error();
+    if (stable) {
+        float tMin = tempSamples[0], tMax = tempSamples[0];
+        int cMin = co2Samples[0], cMax = co2Samples[0];
+        for (int i = 1; i < STABLE_SAMPLES; i++) {
+            tMin = min(tMin, tempSamples[i]);
+            tMax = max(tMax, tempSamples[i]);
+            cMin = min(cMin, co2Samples[i]);
+            cMax = max(cMax, co2Samples[i]);
+        }
+        stable = tMax - tMin <= POWER_STABLE_TEMP_C && cMax - cMin <= POWER_STABLE_CO2_PPM;
+    }
+    sensorsStable = stable;
+}
+
+// API ===========================================================================================================================//
+
+void power_begin(SchedulerClock* base) {
+    baseClock = (base != nullptr) ? base : &platformClock;
+
+    powerMode.store((uint8_t)PowerMode::NORMAL);
+    displayOn = true;
+    lastActivityMs = millis();
+    stableCount = 0;
+    stableHead = 0;
+    sensorsStable = false;
+    for (int i = 0; i < POWER_MODE_COUNT; i++) {
+        modeStats[i] = PowerModeStats();
+    }
+#if !defined(ESP32)
+    hostSleptUs = 0;
+#endif
+    lastAccountUs = baseClock->nowUs();
+    lastBusyUs = 0;
+    lastLightSleepUs = light_sleep_total_us();
+
+#if defined(ESP32)
+    if (motorLock == nullptr) {
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "motor", &motorLock);
+    }
+    configure_light_sleep(false);
+#endif
+    lightSleepMeasured = measure_light_sleep();
+    buttons_enable_wakeup();
+}
+
+SchedulerClock* power_scheduler_clock() {
+    return &powerClock;
+}
+
+void power_set_mode(PowerMode mode) {
+    if (mode == power_get_mode()) return;
+    account();
+    powerMode.store((uint8_t)mode);
+    Serial.println(mode == PowerMode::ENERGY_SAVING ? "Power: energy saving" : "Power: normal");
+#if defined(ESP32)
+    configure_light_sleep(mode == PowerMode::ENERGY_SAVING);
+#endif
+
+    lastActivityMs = millis();
+    if (mode == PowerMode::NORMAL) {
+        set_display(true);
+        sensors_set_slow_polling(false);
+    }
+}
+
+PowerMode power_get_mode() {
+    return (PowerMode)powerMode.load();
+}
+
+bool power_saving() {
+    return power_get_mode() == PowerMode::ENERGY_SAVING;
+}
+
+void power_note_activity() {
+    lastActivityMs = millis();
+    set_display(true);
+}
+
+bool power_display_on() {
+    return displayOn;
+}
+
+bool power_sensors_stable() {
+    return sensorsStable;
+}
+
+void power_update() {
+    account();
+    sample_sensors();
+
+    if (!power_saving()) return;
+
+    if (displayOn && millis() - lastActivityMs > POWER_DISPLAY_TIMEOUT_MS) {
+        set_display(false);
+    }
+    sensors_set_slow_polling(sensorsStable);
+}
+
+PowerModeStats power_mode_stats(PowerMode mode) {
+    account();
+    PowerModeStats stats = modeStats[(int)mode];
+    stats.lightSleepMeasured = lightSleepMeasured;
+    if (stats.elapsedUs == 0) return stats;
+
+    float elapsed = (float)stats.elapsedUs;
+    stats.dutyCycle = stats.busyUs / elapsed;
+    stats.lightSleepFraction = stats.lightSleepUs / elapsed;
+    float idle = max(0.0f, 1.0f - stats.dutyCycle - stats.lightSleepFraction);
+    float awake = 1.0f - stats.lightSleepFraction;
+    stats.estimatedCurrentMa = stats.dutyCycle * CURRENT_BUSY_MA + idle * CURRENT_IDLE_MA +
+                               stats.lightSleepFraction * CURRENT_LIGHT_SLEEP_MA +
+                               awake * CURRENT_RADIO_MA[(int)mode] +
+                               stats.displayOnUs / elapsed * CURRENT_DISPLAY_MA;
+    return stats;
+}
+
+void power_print_stats() {
+    const char* names[POWER_MODE_COUNT] = { "normal", "energy saving" };
+    for (int i = 0; i < POWER_MODE_COUNT; i++) {
+        PowerModeStats stats = power_mode_stats((PowerMode)i);
+        if (stats.elapsedUs == 0) continue;
+        Serial.print("Power ");
+        Serial.print(names[i]);
+        Serial.print(": ");
+        Serial.print(stats.elapsedUs / 1000000.0f, 0);
+        Serial.print(" s, duty ");
+        Serial.print(stats.dutyCycle * 100.0f, 2);
+        if (stats.lightSleepMeasured) {
+            Serial.print("%, light sleep ");
+            Serial.print(stats.lightSleepFraction * 100.0f, 1);
+            Serial.print("%");
+        } else {
+            Serial.print("%, light sleep not measured");
+        }
+        Serial.print(", display on ");
+        Serial.print(stats.displayOnUs * 100.0f / stats.elapsedUs, 1);
+        Serial.print(stats.lightSleepMeasured ? "%, ~" : "%, <=");
+        Serial.print(stats.estimatedCurrentMa, 1);
+        Serial.println(" mA");
+    }
+}
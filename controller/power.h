@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include "scheduler.h"
+
+// Режим энергосбережения ("3: energy-saving" в меню):
+// - WiFi в modem sleep, бот опрашивает сервер реже
+// - экран гаснет после простоя кнопок, любая кнопка его будит (первое нажатие только будит)
+// - датчики опрашиваются реже, пока показания стабильны
+// - автоматический light sleep (esp_pm): чип засыпает сам, пока все задачи ждут; мотор
+//   и сеть бота держат блокировки питания, WiFi остается подключенным; будят таймер и кнопки
+// Часы планировщика оборачиваются: занятость считается здесь же, время light sleep сообщает
+// планировщик питания (CONFIG_PM_LIGHT_SLEEP_CALLBACKS); по ним - скважность и оценка тока
+// для каждого режима. Без замера сна ток оценивается сверху, как будто чип не спал.
+
+enum class PowerMode : uint8_t {
+    NORMAL,
+    ENERGY_SAVING
+};
+
+const int POWER_MODE_COUNT = 2;
+
+const unsigned long POWER_DISPLAY_TIMEOUT_MS = 60000;      // экран гаснет после простоя кнопок
+const uint32_t POWER_LIGHT_SLEEP_MIN_US = 5000;            // короче - просыпание дороже сна
+const unsigned long POWER_STABLE_WINDOW_MS = 120000;       // показания стабильны, если за это время
+const float POWER_STABLE_TEMP_C = 0.3f;                    // температура в комнате гуляет не больше
+const int POWER_STABLE_CO2_PPM = 50;                       // и CO2 - не больше
+
+struct PowerModeStats {
+    uint64_t elapsedUs;
+    uint64_t busyUs;            // задачи планировщика
+    uint64_t lightSleepUs;
+    uint64_t displayOnUs;
+    float dutyCycle;            // доля времени в задачах
+    float lightSleepFraction;
+    float estimatedCurrentMa;   // без замера сна - оценка сверху
+    bool lightSleepMeasured;    // время сна известно, а не нули вместо него
+};
+
+void power_begin(SchedulerClock* base = nullptr);   // nullptr - часы платформы
+SchedulerClock* power_scheduler_clock();            // для scheduler_begin()
+
+void power_set_mode(PowerMode mode);
+PowerMode power_get_mode();                         // можно читать из задачи бота
+bool power_saving();
+
+void power_note_activity();                         // кнопка: будит экран
+bool power_display_on();
+bool power_sensors_stable();
+
+void power_update();                                // задача планировщика, раз в секунду
+PowerModeStats power_mode_stats(PowerMode mode);
+void power_print_stats();
@@ -0,0 +1,153 @@
+#include "profiler.h"
+
+const char* const SECTION_NAMES[PROFILE_SECTION_COUNT] = {
+    "motor", "buttons", "window", "display draw", "display flush", "temp sensors", "co2 sensor", "telegram"
+};
+
+const int OVERHEAD_CALIBRATION_RUNS = 1024;     // часы микросекундные, scope - доли микросекунды
+
+struct SectionProfile {
+    uint32_t buckets[PROFILER_BUCKETS];
+    uint32_t count;
+    uint32_t overruns;
+    uint32_t budgetUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+};
+
+static SectionProfile sections[PROFILE_SECTION_COUNT];
+static uint32_t overheadNs = 0;
+
+// лог-шкала: 0..3 мкс - по корзине на значение, дальше октава [2^k, 2^(k+1)) делится на 4
+static int bucket_of(uint32_t us) {
+    if (us < (uint32_t)PROFILER_SUB_BUCKETS) return (int)us;
+    int octave = 31 - __builtin_clz(us);
+    int sub = (us >> (octave - 2)) & (PROFILER_SUB_BUCKETS - 1);
+    int bucket = PROFILER_SUB_BUCKETS * (octave - 1) + sub;
+    return min(bucket, PROFILER_BUCKETS - 1);
+}
+
+uint32_t profiler_bucket_upper_us(int bucket) {
+    if (bucket < PROFILER_SUB_BUCKETS) return bucket;
+    int octave = bucket / PROFILER_SUB_BUCKETS + 1;
+    int sub = bucket % PROFILER_SUB_BUCKETS;
+    uint32_t width = 1UL << (octave - 2);
+    return ((PROFILER_SUB_BUCKETS + sub) << (octave - 2)) + width - 1;
+}
+
+// квантиль - верхняя граница корзины, в которую он попал, но не больше максимума
+static uint32_t quantile_us(const SectionProfile& profile, float q) {
+    if (profile.count == 0) return 0;
+    uint32_t rank = (uint32_t)(q * (profile.count - 1)) + 1;
+    uint32_t seen = 0;
+    for (int i = 0; i < PROFILER_BUCKETS; i++) {
+        seen += profile.buckets[i];
+        if (seen >= rank) return min(profiler_bucket_upper_us(i), profile.maxUs);
+    }
+    return profile.maxUs;
+}
+
+void profiler_begin() {
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        sections[i].budgetUs = 0;
+    }
+    profiler_reset();
+
+    // цена пустого ProfileScope: чтение часов дважды и запись в гистограмму
+    uint32_t start = profiler_now_us();
+    for (int i = 0; i < OVERHEAD_CALIBRATION_RUNS; i++) {
+        ProfileScope scope(ProfileSection::MOTOR);
+    }
+    overheadNs = (profiler_now_us() - start) * 1000UL / OVERHEAD_CALIBRATION_RUNS;
+    profiler_reset();
+}
+
+void profiler_set_budget(ProfileSection section, uint32_t budgetUs) {
+    sections[(int)section].budgetUs = budgetUs;
+}
+
+void profiler_record(ProfileSection section, uint32_t us) {
+    SectionProfile& profile = sections[(int)section];
+    profile.buckets[bucket_of(us)]++;
+    profile.count++;
+    profile.sumUs += us;
+    if (us > profile.maxUs) profile.maxUs = us;
+    if (profile.budgetUs > 0 && us > profile.budgetUs) profile.overruns++;
+}
+
+void profiler_reset() {
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        SectionProfile& profile = sections[i];
+        memset(profile.buckets, 0, sizeof(profile.buckets));
+        profile.count = 0;
+        profile.overruns = 0;
+        profile.maxUs = 0;
+        profile.sumUs = 0;
+    }
+}
+
+ProfileSummary profiler_summary(ProfileSection section) {
+    const SectionProfile& profile = sections[(int)section];
+    ProfileSummary summary;
+    summary.name = SECTION_NAMES[(int)section];
+    summary.count = profile.count;
+    summary.overruns = profile.overruns;
+    summary.budgetUs = profile.budgetUs;
+    summary.p50Us = quantile_us(profile, 0.50f);
+    summary.p99Us = quantile_us(profile, 0.99f);
+    summary.maxUs = profile.maxUs;
+    summary.meanUs = (profile.count > 0) ? (float)profile.sumUs / profile.count : 0.0f;
+    return summary;
+}
+
+uint32_t profiler_bucket_count(ProfileSection section, int bucket) {
+    return sections[(int)section].buckets[bucket];
+}
+
+uint32_t profiler_overhead_ns() {
+    return overheadNs;
+}
+
+static void summary_line(MessageBuilder& out, const ProfileSummary& summary) {
+    out.addf("%s: n=%lu p50=%lu p99=%lu max=%lu us", summary.name, (unsigned long)summary.count,
+             (unsigned long)summary.p50Us, (unsigned long)summary.p99Us, (unsigned long)summary.maxUs);
+    if (summary.budgetUs > 0) {
+        out.addf(", over %lu us: %lu", (unsigned long)summary.budgetUs, (unsigned long)summary.overruns);
+    }
+}
+
+void profiler_print() {
+    char buffer[PROFILER_PRINT_LINE];
+    Serial.println("=== Loop profile ===");
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        ProfileSummary summary = profiler_summary((ProfileSection)i);
+        if (summary.count == 0) continue;
+        MessageBuilder line(buffer, sizeof(buffer));
+        summary_line(line, summary);
+        Serial.println(line.c_str());
+
+        // гистограмма: "<=верхняя граница:число" по непустым корзинам
+        line.clear();
+        line.add("  ");
+        for (int b = 0; b < PROFILER_BUCKETS; b++) {
+            uint32_t n = sections[i].buckets[b];
+            if (n == 0) continue;
+            line.addf("<=%lu:%lu ", (unsigned long)profiler_bucket_upper_us(b), (unsigned long)n);
+        }
+        Serial.println(line.c_str());
+    }
+    Serial.print("Profiler overhead: ");
+    Serial.print(overheadNs);
+    Serial.println(" ns per scope");
+}
+
+void profiler_report(MessageBuilder& message) {
+    message.add("=== Loop profile ===\n");
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        ProfileSummary summary = profiler_summary((ProfileSection)i);
+        if (summary.count == 0) continue;
+        summary_line(message, summary);
+        message.add("\n");
+    }
+    message.addf("Overhead: %lu ns per scope", (unsigned long)overheadNs);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "message_builder.h"
+
+#if defined(ESP32)
+#include <esp_timer.h>
+#endif
+
+// Профилировщик цикла управления: сколько времени уходит на каждую подсистему.
+// ProfileScope в начале блока читает часы в микросекундах, в деструкторе кладет длительность
+// в гистограмму своей подсистемы: лог-шкала, PROFILER_SUB_BUCKETS корзин на октаву,
+// погрешность квантилей - не больше ширины корзины (25%). Память фиксирована, запись -
+// несколько инструкций без блокировок, поэтому профилировщик включен всегда.
+// Пишет только задача управления; отчет может читать и задача бота без блокировок -
+// в худшем случае сводка разойдется с гистограммой на одно измерение.
+
+enum class ProfileSection : uint8_t {
+    MOTOR,
+    BUTTONS,
+    WINDOW,             // WindowController::update()
+    DISPLAY_DRAW,       // updateDisplay()
+    DISPLAY_FLUSH,      // display_regular_update(), I2C
+    TEMP_SENSORS,
+    CO2_SENSOR,
+    TELEGRAM,           // TelegramBot::update(), сторона управления
+    COUNT
+};
+
+const int PROFILE_SECTION_COUNT = (int)ProfileSection::COUNT;
+
+const int PROFILER_SUB_BUCKETS = 4;                 // корзин на октаву
+const int PROFILER_OCTAVES = 24;                    // до 2^24 мкс ~ 16 с, дольше - в последнюю
+const int PROFILER_BUCKETS = PROFILER_SUB_BUCKETS * PROFILER_OCTAVES;
+const size_t PROFILER_PRINT_LINE = 512;             // строка гистограммы в profiler_print(), на стеке
+
+// Не счетчик тактов: в энергосбережении частоту CPU меняет планировщик питания (80..240 МГц),
+// в том числе посреди блока, и такты в микросекунды уже не пересчитать
+#if defined(ESP32)
+inline uint32_t profiler_now_us() { return (uint32_t)esp_timer_get_time(); }
+#else
+inline uint32_t profiler_now_us() { return (uint32_t)micros(); }
+#endif
+
+struct ProfileSummary {
+    const char* name;
+    uint32_t count;
+    uint32_t overruns;          // дольше бюджета
+    uint32_t budgetUs;          // 0 - без бюджета
+    uint32_t p50Us;
+    uint32_t p99Us;
+    uint32_t maxUs;
+    float meanUs;
+};
+
+void profiler_begin();
+void profiler_set_budget(ProfileSection section, uint32_t budgetUs);
+void profiler_record(ProfileSection section, uint32_t us);
+void profiler_reset();
+
+ProfileSummary profiler_summary(ProfileSection section);
+uint32_t profiler_bucket_count(ProfileSection section, int bucket);
+uint32_t profiler_bucket_upper_us(int bucket);      // верхняя граница корзины
+uint32_t profiler_overhead_ns();                    // цена одного ProfileScope, меряется в profiler_begin()
+
+void profiler_print();                              // сводка и непустые корзины в Serial
+void profiler_report(MessageBuilder& message);      // сводка для /perf
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileSection section) : section(section), start(profiler_now_us()) {}
+    ~ProfileScope() { profiler_record(section, profiler_now_us() - start); }
+
+private:
+    ProfileSection section;
+    uint32_t start;
+};
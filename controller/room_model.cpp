@@ -0,0 +1,148 @@
+#include "room_model.h"
+#include <string.h>
+
+// RLS ===========================================================================================================================//
+
+void RlsEstimator::reset() {
+    memset(theta, 0, sizeof(theta));
+    memset(P, 0, sizeof(P));
+    for (int i = 0; i < ROOM_MODEL_PARAMS; i++) P[i][i] = ROOM_MODEL_INITIAL_VARIANCE;
+    samples = 0;
+}
+
+float RlsEstimator::predict(const float x[ROOM_MODEL_PARAMS]) const {
+    float y = 0.0f;
+    for (int i = 0; i < ROOM_MODEL_PARAMS; i++) y += theta[i] * x[i];
+    return y;
+}
+
+void RlsEstimator::update(const float x[ROOM_MODEL_PARAMS], float y) {
+    float Px[ROOM_MODEL_PARAMS];
+    float denominator = ROOM_MODEL_FORGETTING;
+    for (int i = 0; i < ROOM_MODEL_PARAMS; i++) {
+        Px[i] = 0.0f;
+        for (int j = 0; j < ROOM_MODEL_PARAMS; j++) Px[i] += P[i][j] * x[j];
+        denominator += x[i] * Px[i];
+    }
+
+    float error = y - predict(x);
+    for (int i = 0; i < ROOM_MODEL_PARAMS; i++) {
+        theta[i] += Px[i] / denominator * error;
+    }
+    // P = (P - Px Px^T / denominator) / lambda; P симметрична, так что x^T P = Px^T
+    float trace = 0.0f;
+    for (int i = 0; i < ROOM_MODEL_PARAMS; i++) {
+        for (int j = 0; j < ROOM_MODEL_PARAMS; j++) {
+            P[i][j] = (P[i][j] - Px[i] * Px[j] / denominator) / ROOM_MODEL_FORGETTING;
+        }
+        trace += P[i][i];
+    }
+    // окно долго стоит - забывание раздувает P по невозбужденным направлениям; держим в рамках
+    float maxTrace = ROOM_MODEL_PARAMS * ROOM_MODEL_INITIAL_VARIANCE;
+    if (trace > maxTrace) {
+        float scale = maxTrace / trace;
+        for (int i = 0; i < ROOM_MODEL_PARAMS; i++) {
+            for (int j = 0; j < ROOM_MODEL_PARAMS; j++) P[i][j] *= scale;
+        }
+    }
+    samples++;
+}
+
+// модель ========================================================================================================================//
+
+void RoomModel::reset() {
+    temperatureRls.reset();
+    co2Rls.reset();
+    haveAnchor = false;
+    anchorPosition = 0;
+    anchorMs = 0;
+    anchor = {};
+}
+
+void RoomModel::interrupt() {
+    haveAnchor = false;
+}
+
+void RoomModel::observe(const RoomState& state, int position, int positions, unsigned long timestamp) {
+    if (!haveAnchor || position != anchorPosition) {
+        haveAnchor = true;
+        anchor = state;
+        anchorPosition = position;
+        anchorMs = timestamp;
+        return;
+    }
+    if (timestamp - anchorMs < ROOM_MODEL_SAMPLE_MS) return;
+
+    float minutes = (timestamp - anchorMs) / 60000.0f;
+    float opening = positions > 1 ? position / (float)(positions - 1) : 0.0f;
+
+    // регрессоры - по середине интервала
+    float temperature = (anchor.temperature + state.temperature) * 0.5f;
+    float outside = (anchor.outsideTemp + state.outsideTemp) * 0.5f;
+    float exchange = (outside - temperature) / 10.0f;
+    float xT[ROOM_MODEL_PARAMS] = { 1.0f, exchange, opening * exchange };
+    temperatureRls.update(xT, (state.temperature - anchor.temperature) / minutes);
+
+    float co2 = (anchor.co2 + state.co2) * 0.5f;
+    float ventilation = (ROOM_MODEL_OUTDOOR_CO2 - co2) / 100.0f;
+    float xC[ROOM_MODEL_PARAMS] = { 1.0f, ventilation, opening * ventilation };
+    co2Rls.update(xC, (state.co2 - anchor.co2) / minutes);
+
+    anchor = state;
+    anchorMs = timestamp;
+}
+
+static float window_variance(const RlsEstimator& rls) {
+    return rls.P[2][2] / ROOM_MODEL_INITIAL_VARIANCE;
+}
+
+bool RoomModel::ready() const {
+    return temperatureRls.samples >= (unsigned long)ROOM_MODEL_MIN_SAMPLES &&
+           co2Rls.samples >= (unsigned long)ROOM_MODEL_MIN_SAMPLES &&
+           window_variance(temperatureRls) <= ROOM_MODEL_MAX_WINDOW_VARIANCE &&
+           window_variance(co2Rls) <= ROOM_MODEL_MAX_WINDOW_VARIANCE;
+}
+
+// скорость обмена за минуту: не отрицательная и не больше половины разницы за шаг
+static float exchange_rate(float leak, float window, float opening, float scale) {
+    float rate = (leak > 0.0f ? leak : 0.0f) + (window > 0.0f ? window : 0.0f) * opening;
+    rate /= scale;
+    return rate < 0.5f ? rate : 0.5f;
+}
+
+void RoomModel::evaluate(const RoomState& state, int positions, int horizonMin,
+                         RoomMetricFunction metric, const void* context, float* costs) const {
+    if (positions > ROOM_MODEL_MAX_POSITIONS) positions = ROOM_MODEL_MAX_POSITIONS;
+    if (horizonMin > ROOM_MODEL_MAX_HORIZON) horizonMin = ROOM_MODEL_MAX_HORIZON;
+    if (horizonMin < 1) horizonMin = 1;
+
+    const float* a = temperatureRls.theta;
+    const float* b = co2Rls.theta;
+    for (int position = 0; position < positions; position++) {
+        float opening = positions > 1 ? position / (float)(positions - 1) : 0.0f;
+        float rateT = exchange_rate(a[1], a[2], opening, 10.0f);
+        float rateC = exchange_rate(b[1], b[2], opening, 100.0f);
+
+        float temperature = state.temperature;
+        float co2 = state.co2;
+        float sum = 0.0f;
+        for (int minute = 0; minute < horizonMin; minute++) {
+            temperature += a[0] + rateT * (state.outsideTemp - temperature);
+            co2 += b[0] + rateC * (ROOM_MODEL_OUTDOOR_CO2 - co2);
+            if (co2 < ROOM_MODEL_OUTDOOR_CO2) co2 = ROOM_MODEL_OUTDOOR_CO2;
+            sum += metric(context, temperature, co2);
+        }
+        costs[position] = sum / horizonMin;
+    }
+}
+
+RoomModelStats RoomModel::stats() const {
+    RoomModelStats result;
+    result.samples = temperatureRls.samples;
+    memcpy(result.temperatureParams, temperatureRls.theta, sizeof(result.temperatureParams));
+    memcpy(result.co2Params, co2Rls.theta, sizeof(result.co2Params));
+    float vt = window_variance(temperatureRls);
+    float vc = window_variance(co2Rls);
+    result.windowVariance = vt > vc ? vt : vc;
+    return result;
+}
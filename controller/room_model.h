@@ -0,0 +1,90 @@
+#pragma once
+
+// Модель комнаты для режима PREDICTIVE: температура и CO2 - звенья первого порядка, обмен с
+// улицей растет с открытием окна. Параметры подбираются на ходу рекурсивным МНК с забыванием
+// по показаниям RecentData.
+//
+//   dT/dt = a0 + a1 * (Tout - T) / 10 + a2 * p * (Tout - T) / 10          °C/мин
+//   dC/dt = b0 + b1 * (Cout - C) / 100 + b2 * p * (Cout - C) / 100       ppm/мин
+//
+// p - открытие 0..1 (позиция / 9), a0 и b0 - отопление, солнце и люди, a1 и b1 - щели и
+// стены, a2 и b2 - окно. Производная - по разности за ROOM_MODEL_SAMPLE_MS, пока окно стоит:
+// шаг DS18B20 0.25 °C за минуту дал бы шума больше самого сигнала. Окно не двигалось - вклад
+// окна не определен (дисперсия a2/b2 велика), и модель не готова: решения тогда за AUTO,
+// а его шаги как раз и дают модели разные позиции.
+//
+// Прогноз - ROOM_MODEL_MAX_HORIZON шагов по минуте для каждой из позиций, без экспонент:
+// 10 позиций x 30 шагов - заведомо доли миллисекунды на ESP32.
+
+const int ROOM_MODEL_PARAMS = 3;
+const int ROOM_MODEL_MAX_POSITIONS = 10;
+const int ROOM_MODEL_MAX_HORIZON = 30;                  // шагов по минуте
+const unsigned long ROOM_MODEL_SAMPLE_MS = 5UL * 60000UL;
+const float ROOM_MODEL_FORGETTING = 0.995f;             // память ~200 отсчетов, ~17 ч
+const float ROOM_MODEL_INITIAL_VARIANCE = 100.0f;
+const float ROOM_MODEL_OUTDOOR_CO2 = 420.0f;
+const int ROOM_MODEL_MIN_SAMPLES = 12;                  // ~1 ч
+const float ROOM_MODEL_MAX_WINDOW_VARIANCE = 0.01f;     // доля начальной: окно двигалось достаточно
+
+// Рекурсивный МНК с забыванием на ROOM_MODEL_PARAMS параметров
+struct RlsEstimator {
+    float theta[ROOM_MODEL_PARAMS];
+    float P[ROOM_MODEL_PARAMS][ROOM_MODEL_PARAMS];      // ковариация оценки
+    unsigned long samples;
+
+    void reset();
+    void update(const float x[ROOM_MODEL_PARAMS], float y);
+    float predict(const float x[ROOM_MODEL_PARAMS]) const;
+};
+
+struct RoomState {
+    float temperature;
+    float outsideTemp;
+    float co2;
+};
+
+struct RoomModelStats {
+    unsigned long samples;
+    float temperatureParams[ROOM_MODEL_PARAMS];
+    float co2Params[ROOM_MODEL_PARAMS];
+    float windowVariance;               // большая из дисперсий a2, b2 (в долях начальной)
+};
+
+// цена прогноза - как WindowController::calculateTotalMetric()
+typedef float (*RoomMetricFunction)(const void* context, float temperature, float co2);
+
+class RoomModel {
+public:
+    RoomModel() { reset(); }
+
+    void reset();
+
+    /**
+     * @brief Показания в момент timestamp при позиции position
+     * @details Отсчет для МНК - раз в ROOM_MODEL_SAMPLE_MS, пока позиция та же; сдвиг окна
+     * начинает интервал заново.
+     */
+    void observe(const RoomState& state, int position, int positions, unsigned long timestamp);
+    void interrupt();                   // окно поехало или датчик отказал: интервал заново
+
+    bool ready() const;
+
+    /**
+     * @brief Средняя по горизонту метрика для каждой позиции, если окно поставить туда сейчас
+     * @param horizonMin до ROOM_MODEL_MAX_HORIZON
+     * @param costs на positions значений
+     */
+    void evaluate(const RoomState& state, int positions, int horizonMin,
+                  RoomMetricFunction metric, const void* context, float* costs) const;
+
+    RoomModelStats stats() const;
+
+private:
+    RlsEstimator temperatureRls;
+    RlsEstimator co2Rls;
+
+    bool haveAnchor;
+    RoomState anchor;
+    int anchorPosition;
+    unsigned long anchorMs;
+};
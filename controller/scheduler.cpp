@@ -0,0 +1,291 @@
+#include "scheduler.h"
+#include <Arduino.h>
+
+// часы платформы ================================================================================================================//
+
+// до следующего срока меньше тика FreeRTOS - не спим, следующий проход loop() придет раньше
+class PlatformSchedulerClock : public SchedulerClock {
+public:
+    uint32_t nowUs() override { return (uint32_t)micros(); }
+    void sleepUs(uint32_t us) override {
+#if defined(ESP32)
+        TickType_t ticks = pdMS_TO_TICKS(us / 1000);
+        if (ticks > 0) {
+            vTaskDelay(ticks);
+        } else {
+            yield();
+        }
+#else
+        delay(us / 1000);
+#endif
+    }
+};
+
+static PlatformSchedulerClock platformClock;
+static SchedulerClock* schedClock = &platformClock;
+
+// задачи и куча сроков ==========================================================================================================//
+
+const uint32_t MAX_SLEEP_US = 1000000;      // задач нет - все равно просыпаемся раз в секунду
+
+struct SchedulerJob {
+    const char* name;
+    SchedulerJobFn fn;
+    uint32_t periodUs;
+    uint32_t budgetUs;
+    uint32_t deadlineUs;
+    uint32_t lastStartUs;
+    bool used;
+    int heapIndex;              // -1 - не в куче (выполняется или снята)
+    SchedulerJobStats stats;
+    double latencySumUs;
+};
+
+static SchedulerJob jobs[SCHEDULER_MAX_JOBS];
+static int heap[SCHEDULER_MAX_JOBS];
+static int heapSize = 0;
+static uint64_t busyUs = 0;
+
+// a раньше b с учетом переполнения счета
+static bool earlier(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+static void heap_swap(int i, int j) {
+    int t = heap[i];
+    heap[i] = heap[j];
+    heap[j] = t;
+    jobs[heap[i]].heapIndex = i;
+    jobs[heap[j]].heapIndex = j;
+}
+
+static void sift_up(int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!earlier(jobs[heap[i]].deadlineUs, jobs[heap[parent]].deadlineUs)) break;
+        heap_swap(i, parent);
+        i = parent;
+    }
+}
+
+static void sift_down(int i) {
+    while (true) {
+        int first = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < heapSize && earlier(jobs[heap[left]].deadlineUs, jobs[heap[first]].deadlineUs)) first = left;
+        if (right < heapSize && earlier(jobs[heap[right]].deadlineUs, jobs[heap[first]].deadlineUs)) first = right;
+        if (first == i) break;
+        heap_swap(i, first);
+        i = first;
+    }
+}
+
+static void heap_push(int job) {
+    heap[heapSize] = job;
+    jobs[job].heapIndex = heapSize;
+    heapSize++;
+    sift_up(heapSize - 1);
+}
+
+static void heap_remove(int job) {
+    int i = jobs[job].heapIndex;
+    if (i < 0) return;
+    heapSize--;
+    if (i != heapSize) {
+        heap_swap(i, heapSize);
+        sift_down(i);
+        sift_up(i);
+    }
+    jobs[job].heapIndex = -1;
+}
+
+static void reschedule(int job, uint32_t deadlineUs) {
+    heap_remove(job);
+    jobs[job].deadlineUs = deadlineUs;
+    heap_push(job);
+}
+
+static bool valid_job(int job) {
+    return job >= 0 && job < SCHEDULER_MAX_JOBS && jobs[job].used;
+}
+
+static int add_job(const char* name, uint32_t periodUs, uint32_t delayUs, SchedulerJobFn fn, uint32_t budgetUs) {
+    for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+        if (jobs[i].used) continue;
+
+        SchedulerJob& job = jobs[i];
+        job = SchedulerJob();
+        job.name = name;
+        job.fn = fn;
+        job.periodUs = periodUs;
+        job.budgetUs = budgetUs;
+        job.used = true;
+        job.heapIndex = -1;
+        job.lastStartUs = schedClock->nowUs();
+        job.stats.name = name;
+        job.stats.periodUs = periodUs;
+        reschedule(i, job.lastStartUs + delayUs);
+        return i;
+    }
+    Serial.print("Scheduler: no free slot for ");
+    Serial.println(name);
+    return SCHEDULER_INVALID_JOB;
+}
+
+// API ===========================================================================================================================//
+
+void scheduler_begin(SchedulerClock* schedulerClock) {
+    schedClock = (schedulerClock != nullptr) ? schedulerClock : &platformClock;
+    for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+        jobs[i] = SchedulerJob();
+        jobs[i].heapIndex = -1;
+    }
+    heapSize = 0;
+    busyUs = 0;
+}
+
+int scheduler_every(const char* name, uint32_t periodUs, SchedulerJobFn fn, uint32_t budgetUs) {
+    if (periodUs == 0) return SCHEDULER_INVALID_JOB;
+    return add_job(name, periodUs, 0, fn, budgetUs);
+}
+
+int scheduler_after(const char* name, uint32_t delayUs, SchedulerJobFn fn, uint32_t budgetUs) {
+    return add_job(name, 0, delayUs, fn, budgetUs);
+}
+
+void scheduler_set_period(int job, uint32_t periodUs) {
+    if (!valid_job(job) || periodUs == 0 || jobs[job].periodUs == periodUs) return;
+    jobs[job].periodUs = periodUs;
+    jobs[job].stats.periodUs = periodUs;
+    // изнутри самой задачи срок пересчитает scheduler_run_pending()
+    if (jobs[job].heapIndex >= 0) {
+        uint32_t now = schedClock->nowUs();
+        uint32_t next = jobs[job].lastStartUs + periodUs;
+        reschedule(job, earlier(next, now) ? now : next);   // по новому периоду уже пора - без пропусков
+    }
+}
+
+void scheduler_wake(int job) {
+    if (!valid_job(job) || jobs[job].heapIndex < 0) return;
+    uint32_t now = schedClock->nowUs();
+    if (earlier(now, jobs[job].deadlineUs)) {
+        reschedule(job, now);
+    }
+}
+
+void scheduler_cancel(int job) {
+    if (!valid_job(job)) return;
+    heap_remove(job);
+    jobs[job].used = false;
+}
+
+/**
+ * @brief Выполнить задачи, у которых подошел срок, по порядку сроков
+ * @return Сколько мкс до следующего срока (0 - есть просроченные)
+ *
+ * Периодическая задача получает следующий срок от прошлого срока, а не от конца
+ * выполнения - период не уплывает. Если она опоздала больше чем на период, пропущенные
+ * запуски не догоняются: считаем их в skipped и встаем на ближайший будущий срок.
+ * За один проход каждая задача выполняется не больше раза, чтобы перегрузка не заперла loop().
+ */
+uint32_t scheduler_run_pending() {
+    for (int budget = heapSize; budget > 0 && heapSize > 0; budget--) {
+        uint32_t now = schedClock->nowUs();
+        int id = heap[0];
+        SchedulerJob& job = jobs[id];
+        if (earlier(now, job.deadlineUs)) break;
+
+        heap_remove(id);
+        uint32_t deadline = job.deadlineUs;
+        uint32_t lateness = now - deadline;
+        job.lastStartUs = now;
+
+        job.fn();
+
+        uint32_t end = schedClock->nowUs();
+        uint32_t runUs = end - now;
+        busyUs += runUs;
+
+        SchedulerJobStats& stats = job.stats;
+        stats.runs++;
+        stats.lastRunUs = runUs;
+        if (runUs > stats.maxRunUs) stats.maxRunUs = runUs;
+        if (lateness > stats.maxLatenessUs) stats.maxLatenessUs = lateness;
+        job.latencySumUs += lateness;
+        stats.meanLatenessUs = job.latencySumUs / stats.runs;
+        if (job.budgetUs > 0 && runUs > job.budgetUs) stats.overruns++;
+
+        if (!job.used || job.heapIndex >= 0) {
+            continue;       // задача сняла себя или переставила срок сама
+        }
+        if (job.periodUs == 0) {
+            job.used = false;
+            continue;
+        }
+        uint32_t next = deadline + job.periodUs;
+        if (!earlier(end, next)) {
+            uint32_t missed = (end - deadline) / job.periodUs;
+            stats.skipped += missed;
+            next = deadline + (missed + 1) * job.periodUs;
+        }
+        reschedule(id, next);
+    }
+
+    if (heapSize == 0) return MAX_SLEEP_US;
+    uint32_t now = schedClock->nowUs();
+    uint32_t deadline = jobs[heap[0]].deadlineUs;
+    if (!earlier(now, deadline)) return 0;
+    return min(deadline - now, MAX_SLEEP_US);
+}
+
+void scheduler_loop() {
+    uint32_t wait = scheduler_run_pending();
+    if (wait > 0) {
+        schedClock->sleepUs(wait);
+    }
+}
+
+bool scheduler_job_stats(int job, SchedulerJobStats& stats) {
+    if (!valid_job(job)) return false;
+    stats = jobs[job].stats;
+    return true;
+}
+
+void scheduler_reset_stats() {
+    for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+        if (!jobs[i].used) continue;
+        jobs[i].stats = SchedulerJobStats();
+        jobs[i].stats.name = jobs[i].name;
+        jobs[i].stats.periodUs = jobs[i].periodUs;
+        jobs[i].latencySumUs = 0;
+    }
+    busyUs = 0;
+}
+
+uint64_t scheduler_busy_us() {
+    return busyUs;
+}
+
+void scheduler_print_stats() {
+    Serial.println("=== SCHEDULER ===");
+    for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+        if (!jobs[i].used) continue;
+        const SchedulerJobStats& stats = jobs[i].stats;
+        Serial.print(stats.name);
+        Serial.print(": period ");
+        Serial.print(stats.periodUs);
+        Serial.print(" us, runs ");
+        Serial.print(stats.runs);
+        Serial.print(", late mean ");
+        Serial.print(stats.meanLatenessUs, 0);
+        Serial.print("/max ");
+        Serial.print(stats.maxLatenessUs);
+        Serial.print(" us, run max ");
+        Serial.print(stats.maxRunUs);
+        Serial.print(" us, skipped ");
+        Serial.print(stats.skipped);
+        Serial.print(", overruns ");
+        Serial.println(stats.overruns);
+    }
+}
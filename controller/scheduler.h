@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+
+// Кооперативный планировщик для loop(): подсистемы регистрируют периодические и разовые
+// задачи, loop() выполняет те, у которых подошел срок, и спит до ближайшего следующего.
+// Сроки - в min-куче по времени, на каждую задачу копится статистика опоздания и
+// переполнения бюджета. Все время - в микросекундах по часам SchedulerClock, счет
+// с переполнением (сравнение через знаковую разность), поэтому задержки - не больше 35 минут.
+
+// часы планировщика: micros() и сон FreeRTOS на ESP32, виртуальное время в тестах
+class SchedulerClock {
+public:
+    virtual ~SchedulerClock() {}
+    virtual uint32_t nowUs() = 0;
+    virtual void sleepUs(uint32_t us) = 0;
+};
+
+// виртуальные часы: сон просто сдвигает время, задачи сами тратят его через advance()
+class VirtualSchedulerClock : public SchedulerClock {
+public:
+    explicit VirtualSchedulerClock(uint32_t startUs = 0) : timeUs(startUs) {}
+    uint32_t nowUs() override { return timeUs; }
+    void sleepUs(uint32_t us) override { timeUs += us; sleptUs += us; }
+    void advance(uint32_t us) { timeUs += us; }
+    uint64_t sleptTotalUs() const { return sleptUs; }
+
+private:
+    uint32_t timeUs;
+    uint64_t sleptUs = 0;
+};
+
+typedef void (*SchedulerJobFn)();
+
+const int SCHEDULER_MAX_JOBS = 16;
+const int SCHEDULER_INVALID_JOB = -1;
+
+struct SchedulerJobStats {
+    const char* name;
+    uint32_t periodUs;          // 0 - разовая
+    uint32_t runs;
+    uint32_t skipped;           // пропущено периодов: задача опоздала больше чем на период
+    uint32_t overruns;          // выполнение дольше бюджета
+    uint32_t maxLatenessUs;     // насколько позже срока начали выполнять
+    float meanLatenessUs;
+    uint32_t maxRunUs;
+    uint32_t lastRunUs;
+};
+
+void scheduler_begin(SchedulerClock* clock = nullptr);     // nullptr - часы платформы
+
+// budgetUs = 0 - бюджет не проверяется; первый запуск периодической задачи - сразу
+int scheduler_every(const char* name, uint32_t periodUs, SchedulerJobFn fn, uint32_t budgetUs = 0);
+int scheduler_after(const char* name, uint32_t delayUs, SchedulerJobFn fn, uint32_t budgetUs = 0);
+void scheduler_set_period(int job, uint32_t periodUs);     // новый срок - от прошлого запуска
+void scheduler_wake(int job);                              // выполнить при ближайшем проходе
+void scheduler_cancel(int job);
+
+uint32_t scheduler_run_pending();                          // выполнить просроченные; до следующего срока, мкс
+void scheduler_loop();                                     // тело loop(): выполнить и уснуть до следующего срока
+
+bool scheduler_job_stats(int job, SchedulerJobStats& stats);
+void scheduler_reset_stats();
+uint64_t scheduler_busy_us();                              // сколько времени заняли задачи с scheduler_begin()
+void scheduler_print_stats();
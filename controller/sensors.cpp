@@ -4,6 +4,7 @@
 #include <assert.h>
 #include "OLED_screen.h"
 #include "sensors.h"
+#include "binlog.h"
 
 // #define DBG_PRINT() Serial.println(String(__PRETTY_FUNCTION__) + ":" + String(__LINE__))
 #define DBG_PRINT()
@@ -17,6 +18,8 @@ const int TEMP_READ_DELAY = 1000;   // задержка перед чтение
 
 const int RESOLUTION_BITS = 10;     // устанавливаем точность измерения в битах (12 максимум)
 
+static int pollingFactor = 1;       // SENSORS_SLOW_POLLING_FACTOR в энергосбережении при стабильных показаниях
+
 
 
 
@@ -46,6 +49,8 @@ TempSensor temp_sensors[SENSORS_COUNT] = {
     { .pin = 23,  .sensor = nullptr, .last_tempC = 0.0, .error = false }
 };
 
+unsigned long last_temp_read_time = 0;  // время последнего опроса датчиков температуры
+
 const unsigned long ROOM_SENSOR_INDEX = 0;
 const unsigned long OUTSIDE_SENSOR_INDEX = 1;
 
@@ -93,8 +98,7 @@ void temp_request() {
 void temp_sensors_read() {
     for (int i = 0; i < SENSORS_COUNT; i++) {
         float temp = temp_sensors[i].sensor->getTempCByIndex(0);
-        String msg = String(i) + ":" + String(temp);
-        Serial.println(msg);
+        BINLOG_INFO(TEMP_READING, i, temp);
 
         if (temp == DEVICE_DISCONNECTED_C) {
             temp_sensors[i].last_tempC = NAN;
@@ -105,6 +109,8 @@ void temp_sensors_read() {
         }
     }
 
+    last_temp_read_time = millis();
+
     // upd_avg_temp();
 }
 
@@ -153,7 +159,7 @@ void temperature_sensors_update() {
             break;
 
         case STATE_WAITING_FOR_REQUEST:
-            if (now - lastTempAction >= TEMP_INTERVAL) {
+            if (now - lastTempAction >= (unsigned long)TEMP_INTERVAL * pollingFactor) {
                 temp_request();
                 lastTempAction = now;
                 temp_state = STATE_WAITING_FOR_READ;
@@ -176,6 +182,10 @@ float get_sensor_recent_temp(int sensor_ind) {
     return temp_sensors[sensor_ind].last_tempC;
 }
 
+unsigned long get_temp_read_time() {
+    return last_temp_read_time;
+}
+
 bool get_room_sensor_error() {
     return get_sensor_error(ROOM_SENSOR_INDEX);
 }
@@ -262,7 +272,7 @@ void co2_sensor_update() {
     static unsigned long readStartTime = 0;
     static bool waiting_for_response = false;
 
-    if (!waiting_for_response && (now - lastRequest >= REQUEST_INTERVAL)) {
+    if (!waiting_for_response && (now - lastRequest >= REQUEST_INTERVAL * pollingFactor)) {
         co2_level_request();
         lastRequest = now;
         readStartTime = now;
@@ -286,6 +296,10 @@ int get_last_co2_ppm() {
     return last_co2_ppm;
 }
 
+void sensors_set_slow_polling(bool slow) {
+    pollingFactor = slow ? SENSORS_SLOW_POLLING_FACTOR : 1;
+}
+
 int get_optimal_co2_ppm() {
     return co2_optimal;
 }
@@ -2,6 +2,8 @@
 
 const int SENSORS_COUNT = 3;    // общее количество датчиков температуры
 
+const int SENSORS_SLOW_POLLING_FACTOR = 6;  // во столько раз реже опрос, пока показания стабильны
+
 void temp_sensors_setup();
 void temperature_sensors_update();
 
@@ -9,6 +11,7 @@ float get_room_temp();
 float get_outside_temp();
 
 float get_sensor_recent_temp(int sensor_ind);
+unsigned long get_temp_read_time();           // millis() последнего опроса, для тренда
 
 bool get_room_sensor_error();
 bool get_outside_sensor_error();
@@ -20,4 +23,7 @@ void co2_sensor_update();
 
 int get_last_co2_ppm();
 bool get_co2_read_error();
+unsigned long get_last_co2_read_time();       // millis() последнего удачного чтения
 int get_optimal_co2_ppm();
+
+void sensors_set_slow_polling(bool slow);     // режим энергосбережения
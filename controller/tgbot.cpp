@@ -1,21 +1,18 @@
 #include "tgbot.h"
+#include "position_store.h"
+#include "profiler.h"
+#include <string.h>
+#include <math.h>
 
-WiFiClientSecure client;
+#if !defined(ESP32)
+#include <thread>
+#endif
 
-void TelegramBot::init() {
-    // Подключение к WiFi (данные теперь из tgbotconfig.h)
-    WiFi.begin(ssid, password);  // ssid и password из tgbotconfig.h
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(1000);
-        Serial.println("Подключаемся к WiFi...");
-    }
-    Serial.println("Подключено к WiFi");
-
-    // Настройка SSL для Telegram
-    client.setCACert(TELEGRAM_CERTIFICATE_ROOT);
+// задача бота ===================================================================================================================//
 
-    // Создание объекта бота (BOT_TOKEN из tgbotconfig.h)
-    bot = new UniversalTelegramBot(BOT_TOKEN, client);
+void TelegramBot::init(BotTransport* botTransport, bool startTask) {
+    transport = (botTransport != nullptr) ? botTransport : bot_transport_create_telegram();
+    bot_link_begin();
 
     // Выводим информацию о белом списке
     Serial.println("Белый список пользователей:");
@@ -23,11 +20,128 @@ void TelegramBot::init() {
         Serial.println("  - " + user_id);
     }
 
+    if (transport == nullptr) {
+        Serial.println("Telegram бот: нет сети, задача не запущена");
+        return;
+    }
+
+    if (!startTask) {
+        bot_link_set_network_busy(true);
+        transport->connect();
+        bot_link_set_network_busy(false);
+        return;
+    }
+
+    // подключение к WiFi и TLS - уже в задаче, setup() и loop() их не ждут
+    running = true;
+    taskFinished = false;
+#if defined(ESP32)
+    xTaskCreatePinnedToCore(taskEntry, "tgbot", BOT_TASK_STACK, this, BOT_TASK_PRIORITY, nullptr, BOT_TASK_CORE);
+#else
+    std::thread(taskEntry, this).detach();
+#endif
     Serial.println("Telegram бот инициализирован");
 }
 
-// Остальные функции остаются без изменений...
-bool TelegramBot::isUserAllowed(String user_id) {
+void TelegramBot::stop() {
+    running = false;
+    while (!taskFinished) {
+        delay(10);
+    }
+}
+
+void TelegramBot::taskEntry(void* arg) {
+    TelegramBot* self = static_cast<TelegramBot*>(arg);
+    bot_link_set_network_busy(true);
+    self->transport->connect();
+    bot_link_set_network_busy(false);
+    while (self->running) {
+        self->pollOnce(self->updateInterval(), self->longPollSeconds());
+    }
+    self->taskFinished = true;
+#if defined(ESP32)
+    vTaskDelete(nullptr);
+#endif
+}
+
+unsigned long TelegramBot::updateInterval() const {
+    return powerSave ? SAVING_UPDATE_INTERVAL : UPDATE_INTERVAL;
+}
+
+// long poll держит флаг сети поднятым все время ожидания, а с ним и light sleep под запретом -
+// в энергосбережении опрос короткий, раз в SAVING_UPDATE_INTERVAL, по тому же соединению
+uint16_t TelegramBot::longPollSeconds() const {
+    return powerSave ? 0 : BOT_LONG_POLL_S;
+}
+
+// режим питания переключает управление, радио - здесь, в задаче сети
+void TelegramBot::syncPowerMode() {
+    bool saving = power_saving();
+    if (saving == powerSave) return;
+    powerSave = saving;
+    transport->setPowerSave(saving);
+}
+
+/**
+ * @brief Один проход задачи бота
+ * @param replyWaitMs Сколько ждать ответов управления до следующего опроса сервера
+ * @param longPollS Сколько сервер может держать getUpdates, 0 - короткий опрос раз в updateInterval()
+ *
+ * Ответы на команды отправляются, как только управление их выложило и лимиты Telegram
+ * пропускают. Пока ответа ждем или в outbox что-то лежит, сервер опрашивается коротко,
+ * иначе - long poll. Все, что блокирует на сети, - только здесь; на это время поднят флаг
+ * bot_link_set_network_busy() с блокировкой питания, и чип не уходит в light sleep.
+ */
+void TelegramBot::pollOnce(uint32_t replyWaitMs, uint16_t longPollS) {
+    bot_link_snapshot(status);
+    syncPowerMode();
+    unsigned long interval = updateInterval();
+
+    bot_link_set_network_busy(true);
+    BotReply reply;
+    while (bot_link_take_reply(reply, 0)) {
+        handleReply(reply);
+    }
+    updateDashboards();
+
+    if (status.emergency != EmergencyType::NONE) {
+        if (!broadcastDone || millis() - lastBroadcast > BROADCAST_INTERVAL) {
+            lastBroadcast = millis();
+            sendStatusToAll(broadcastDone);
+            broadcastDone = true;
+        }
+    }
+    flushOutbox();
+
+    if (awaitingReplies > 0 && millis() - lastCommandMs > BOT_REPLY_TIMEOUT_MS) {
+        Serial.println("Telegram: управление не ответило на команду");
+        awaitingReplies = 0;
+    }
+
+    bool longPoll = longPollS > 0 && awaitingReplies == 0 && outbox.empty();
+    if (longPoll || millis() - lastUpdateTime > interval) {
+        handleMessages(longPoll ? longPollS : 0);
+        lastUpdateTime = millis();
+        flushOutbox();
+    }
+    bot_link_set_network_busy(false);
+
+    // после long poll без новых команд ждать нечего - сразу следующий
+    if (replyWaitMs > 0 && (awaitingReplies > 0 || longPollS == 0 || !outbox.empty())) {
+        unsigned long sincePoll = millis() - lastUpdateTime;
+        uint32_t wait = (sincePoll < interval) ? min((uint32_t)(interval - sincePoll), replyWaitMs) : 1;
+        wait = max((uint32_t)1, min(wait, outbox.msUntilReady(millis())));
+        if (bot_link_take_reply(reply, wait)) {
+            bot_link_set_network_busy(true);
+            handleReply(reply);
+            flushOutbox();
+            bot_link_set_network_busy(false);
+        }
+    }
+}
+
+// белый список и отправка ====================================================================================================//
+bool TelegramBot::isUserAllowed(const String& user_id) {
     for (const String& allowed_id : allowedUsers) {
         if (allowed_id == user_id) {
             return true;
@@ -45,460 +159,913 @@ void TelegramBot::addAllowedUser(String user_id) {
     Serial.println("Добавлен пользователь в белый список: " + user_id);
 }
 
-void TelegramBot::sendNotAllowedMessage(String chat_id) {
-    String message = "🚫 **Доступ запрещен**\n\n";
-    message += "Ваш ID: `" + chat_id + "`\n";
-    message += "Обратитесь к администратору для получения доступа.";
-    bot->sendMessage(chat_id, message, "Markdown");
-
-    Serial.println("Попытка доступа от неавторизованного пользователя: " + chat_id);
+// ответы собираются в messageBuffer задачи бота: одно сообщение за раз, куча не нужна
+MessageBuilder TelegramBot::newMessage() {
+    return MessageBuilder(messageBuffer, sizeof(messageBuffer));
 }
 
-void TelegramBot::sendStatusToAll(WindowController& windowController) {
-    for (const String& user_id : allowedUsers) {
-        // Защита от пустых ID
-        if (user_id.length() == 0) continue;
-
-        Serial.println("Отправка статуса пользователю: " + user_id);
-
+void TelegramBot::sendMessage(const char* chat_id, const char* text, const char* parseMode, BotOutKind kind) {
+    if (!outbox.push(kind, chat_id, text, parseMode, millis())) {
+        Serial.println("Telegram: очередь отправки полна, сообщение отброшено");
+    }
+}
 
-        String message = " EMERGENCY!!! \n";
-        bot->sendMessage(user_id, message, "Markdown");
-        sendStatusLog(user_id, windowController);
+void TelegramBot::sendMessage(const char* chat_id, const MessageBuilder& message, const char* parseMode, BotOutKind kind) {
+    if (message.truncated()) {
+        Serial.println("Telegram: сообщение обрезано по BOT_MESSAGE_CAPACITY");
+    }
+    sendMessage(chat_id, message.c_str(), parseMode, kind);
+}
 
-        // ⚠️ Обязательная задержка между отправками!
-        // Telegram разрешает ~30 сообщений/сек на бота, но лучше — 1 сообщение/сек на чат
-        delay(1000); // 1 секунда
+// все, что лимиты пропускают сейчас; остальное - на следующем проходе
+void TelegramBot::flushOutbox() {
+    BotOutMessage* message;
+    while ((message = outbox.ready(millis())) != nullptr) {
+        BotSendResult result = (message->editMessageId != 0)
+            ? transport->edit(message->chatId, message->editMessageId, message->text, message->parseMode, message->replyMarkup)
+            : transport->send(message->chatId, message->text, message->parseMode, message->replyMarkup);
+        if (message->kind == BotOutKind::DASHBOARD) dashboardSent(*message, result);
+        outbox.complete(message, result, millis());
     }
 }
 
-void TelegramBot::update(WindowController& windowController) {
+void TelegramBot::sendNotAllowedMessage(const char* chat_id) {
+    MessageBuilder message = newMessage();
+    message.add("🚫 **Доступ запрещен**\n\n");
+    message.addf("Ваш ID: `%s`\n", chat_id);
+    message.add("Обратитесь к администратору для получения доступа.");
+    sendMessage(chat_id, message, "Markdown");
 
-    static unsigned last_broadcast = -120 * 1000;
-    if (windowController.getLastEmergency() != EmergencyType::NONE) {
+    Serial.print("Попытка доступа от неавторизованного пользователя: ");
+    Serial.println(chat_id);
+}
 
-        if (millis() - last_broadcast > 120 * 1000) {
-            last_broadcast = millis();
-            sendStatusToAll(windowController);
-        }
-    }
+// repeat - напоминание о той же аварии: чатам с панелью оно не нужно, авария видна на ней
+void TelegramBot::sendStatusToAll(bool repeat) {
+    for (const String& user_id : allowedUsers) {
+        // Защита от пустых ID
+        if (user_id.length() == 0) continue;
+        if (repeat && findDashboard(user_id.c_str()) != nullptr) continue;
 
-    if (millis() - lastUpdateTime > UPDATE_INTERVAL) {
-        handleMessages(windowController);
-        lastUpdateTime = millis();
+        Serial.print("Отправка статуса пользователю: ");
+        Serial.println(user_id);
+
+        // одно сообщение в чат; паузы между чатами выдерживает outbox
+        sendStatusLog(user_id.c_str(), BotOutKind::ALERT);
     }
 }
 
-void TelegramBot::handleMessages(WindowController& windowController) {
-    int numNewMessages = bot->getUpdates(bot->last_message_received + 1);
+static const char WELCOME_TEXT[] =
+    "**Бот управления окнами**\n\n"
+    "Доступные команды:\n"
+    "`/status` - текущие показания\n"
+    "`/settings` - настройки параметров\n"
+    "`/mode` - управление режимом работы\n"
+    "`/window` - управление положением окна\n"
+    "`/live` - панель, которая обновляется сама\n"
+    "`/perf` - время подсистем цикла управления\n";
+
+void TelegramBot::handleMessages(uint16_t waitS) {
+    BotMessage messages[BOT_MAX_MESSAGES_PER_POLL];
+    int numNewMessages = transport->poll(messages, BOT_MAX_MESSAGES_PER_POLL, waitS);
 
     while (numNewMessages) {
         Serial.println("Получено сообщение Telegram");
 
         for (int i = 0; i < numNewMessages; i++) {
-            String chat_id = String(bot->messages[i].chat_id);
-            String text = bot->messages[i].text;
-
-            if (text == "/start") {
-                String welcome = "**Бот управления окнами**\n\n";
-                welcome += "Доступные команды:\n";
-                welcome += "`/status` - текущие показания\n";
-                welcome += "`/settings` - настройки параметров\n";
-                welcome += "`/mode` - управление режимом работы\n";
-                welcome += "`/window` - управление положением окна\n";
-                bot->sendMessage(chat_id, welcome, "Markdown");
-            }
-            else if (text == "/status") {
-                sendStatusLog(chat_id, windowController);
-            }
-            else if (text == "/settings") {
-                showSettingsMenu(chat_id, windowController);
-            }
-            else if (text == "/mode") {
-                showModeMenu(chat_id, windowController);
-            }
-            else if (text == "/window") {
-                showWindowMenu(chat_id, windowController);
-            }
-            else if (text == "/mode_auto") {
-                setMode(chat_id, WindowMode::AUTO, windowController);
-            }
-            else if (text == "/mode_manual") {
-                setMode(chat_id, WindowMode::MANUAL, windowController);
-            }
-            else if (text == "/homing") {
-                handleHoming(chat_id, windowController);
-            }
-            else if (text.startsWith("/set_position ")) {
-                handleSetPosition(chat_id, text, windowController);
-            }
-            else if (text.startsWith("/set_")) {
-                handleParameterSetting(chat_id, text, windowController);
-            }
-            else {
-                bot->sendMessage(chat_id, "Неизвестная команда. Используйте /start", "");
+            const char* chat_id = messages[i].chatId.c_str();
+            bool button = messages[i].callbackId.length() > 0;
+            if (button) {
+                transport->answerCallback(messages[i].callbackId.c_str());
             }
+            handleCommand(chat_id, messages[i].text, button);
         }
-        numNewMessages = bot->getUpdates(bot->last_message_received + 1);
+        // остаток забираем сразу: на команды, выложенные выше, ответ придет скоро
+        numNewMessages = transport->poll(messages, BOT_MAX_MESSAGES_PER_POLL, 0);
     }
 }
 
-void TelegramBot::showModeMenu(String chat_id, WindowController& windowController) {
-    WindowConfig config = windowController.getConfig();
+// quiet - команда с кнопки панели
+void TelegramBot::handleCommand(const char* chat_id, const String& text, bool quiet) {
+    if (text == "/start") {
+        sendMessage(chat_id, WELCOME_TEXT, "Markdown");
+    }
+    else if (status.seq == 0) {
+        sendMessage(chat_id, "Система запускается, повторите команду через несколько секунд", "");
+    }
+    else if (text == "/status") {
+        sendStatusLog(chat_id);
+    }
+    else if (text == "/perf") {
+        MessageBuilder message = newMessage();
+        profiler_report(message);
+        sendMessage(chat_id, message, "");
+    }
+    else if (text == "/settings") {
+        showSettingsMenu(chat_id);
+    }
+    else if (text == "/mode") {
+        showModeMenu(chat_id);
+    }
+    else if (text == "/window") {
+        showWindowMenu(chat_id);
+    }
+    else if (text == "/live") {
+        startDashboard(chat_id);
+    }
+    else if (text == "/live_off") {
+        stopDashboard(chat_id);
+    }
+    else if (text == "/mode_auto") {
+        BotCommand command = {};
+        command.type = BotCommandType::SET_MODE;
+        command.mode = WindowMode::AUTO;
+        postCommand(chat_id, command, quiet);
+    }
+    else if (text == "/mode_manual") {
+        BotCommand command = {};
+        command.type = BotCommandType::SET_MODE;
+        command.mode = WindowMode::MANUAL;
+        postCommand(chat_id, command, quiet);
+    }
+    else if (text == "/mode_predictive") {
+        BotCommand command = {};
+        command.type = BotCommandType::SET_MODE;
+        command.mode = WindowMode::PREDICTIVE;
+        postCommand(chat_id, command, quiet);
+    }
+    else if (text == "/homing") {
+        handleHoming(chat_id);
+    }
+    else if (strncmp(text.c_str(), "/set_position ", 14) == 0) {
+        handleSetPosition(chat_id, text.c_str(), quiet);
+    }
+    else if (strncmp(text.c_str(), "/set_", 5) == 0) {
+        handleParameterSetting(chat_id, text.c_str());
+    }
+    else {
+        sendMessage(chat_id, "Неизвестная команда. Используйте /start", "");
+    }
+}
+
+// команда управлению: ответ придет через очередь ответов
+void TelegramBot::postCommand(const char* chat_id, BotCommand& command, bool quiet) {
+    strncpy(command.chatId, chat_id, BOT_CHAT_ID_LEN - 1);
+    command.chatId[BOT_CHAT_ID_LEN - 1] = '\0';
+    command.quiet = quiet;
+    if (!bot_link_post_command(command)) {
+        sendMessage(chat_id, "❌ Система занята, повторите команду позже", "");
+        return;
+    }
+    awaitingReplies++;
+    lastCommandMs = millis();
+}
 
-    String message = "🎛️ **УПРАВЛЕНИЕ РЕЖИМОМ РАБОТЫ**\n\n";
-    message += "Текущий режим: ";
+static const char MODE_MENU_AUTO[] =
+    "🔘 **AUTO (автоматический)**\n\n"
+    "В этом режиме система автоматически управляет окнами на основе:\n"
+    "• Температуры в помещении\n"
+    "• Уровня CO2\n"
+    "• Разницы температур внутри/снаружи\n"
+    "\n⚠️ Ручное управление отключено\n";
+
+static const char MODE_MENU_MANUAL[] =
+    "✋ **MANUAL (ручной)**\n\n"
+    "В этом режиме окна управляются только вручную.\n"
+    "Автоматические корректировки отключены.\n"
+    "\n**Ручное управление позицией:**\n"
+    "Используйте `/set_position N` где N от 0 до 9\n"
+    "• 0 - полностью закрыто\n"
+    "• 9 - полностью открыто\n";
+
+static const char MODE_MENU_PREDICTIVE[] =
+    "🔮 **PREDICTIVE (по модели комнаты)**\n\n"
+    "Система сама учит, как быстро комната остывает и проветривается\n"
+    "при каждом открытии окна, и ставит окно туда, где метрика\n"
+    "в ближайшие минуты будет лучшей с учетом цены хода.\n"
+    "Пока модель не обучена, решения принимаются как в AUTO.\n";
+
+static const char MODE_MENU_CHOICES[] =
+    "\n**Выберите режим:**\n"
+    "`/mode_auto` - переключить в автоматический режим\n"
+    "`/mode_predictive` - переключить в режим по модели комнаты\n"
+    "`/mode_manual` - переключить в ручной режим\n";
+
+void TelegramBot::showModeMenu(const char* chat_id) {
+    const WindowConfig& config = status.config;
+
+    MessageBuilder message = newMessage();
+    message.add("🎛️ **УПРАВЛЕНИЕ РЕЖИМОМ РАБОТЫ**\n\n");
+    message.add("Текущий режим: ");
 
     switch (config.currentMode) {
         case WindowMode::AUTO:
-            message += "🔘 **AUTO (автоматический)**\n\n";
-            message += "В этом режиме система автоматически управляет окнами на основе:\n";
-            message += "• Температуры в помещении\n";
-            message += "• Уровня CO2\n";
-            message += "• Разницы температур внутри/снаружи\n";
-            message += "\n⚠️ Ручное управление отключено\n";
+            message.add(MODE_MENU_AUTO);
             break;
         case WindowMode::MANUAL:
-            message += "✋ **MANUAL (ручной)**\n\n";
-            message += "В этом режиме окна управляются только вручную.\n";
-            message += "Автоматические корректировки отключены.\n";
-            message += "\n**Ручное управление позицией:**\n";
-            message += "Используйте `/set_position N` где N от 0 до 9\n";
-            message += "• 0 - полностью закрыто\n";
-            message += "• 9 - полностью открыто\n";
+            message.add(MODE_MENU_MANUAL);
+            break;
+        case WindowMode::PREDICTIVE:
+            message.add(MODE_MENU_PREDICTIVE);
             break;
 
         case WindowMode::EMERGENCY:
-            message += " EMERGENCY!!!\n ";
-            message += " Check status to see the reason\n";
+            message.add(" EMERGENCY!!!\n ");
+            message.add(" Check status to see the reason\n");
 
         default:
-            message += "❓ **UNKNOWN**\n\n";
+            message.add("❓ **UNKNOWN**\n\n");
             break;
     }
 
-    message += "\n**Выберите режим:**\n";
-    message += "`/mode_auto` - переключить в автоматический режим\n";
-    message += "`/mode_manual` - переключить в ручной режим\n";
+    message.add(MODE_MENU_CHOICES);
 
-    bot->sendMessage(chat_id, message, "Markdown");
+    sendMessage(chat_id, message, "Markdown");
 }
 
-void TelegramBot::handleSetPosition(String chat_id, String command, WindowController& windowController) {
-    WindowConfig config = windowController.getConfig();
-
-    // Проверяем, что находимся в ручном режиме
-    if (config.currentMode != WindowMode::MANUAL) {
-        String error = "❌ **Ошибка: неверный режим**\n\n";
-        error += "Команда `/set_position` доступна только в **ручном режиме**.\n";
-        error += "Текущий режим: ";
-
-        switch (config.currentMode) {
-            case WindowMode::AUTO:
-                error += "AUTO (автоматический)";
-                break;
-            case WindowMode::MANUAL:
-                error += "MANUAL (ручной)"; // Не должно случиться, но на всякий случай
-                break;
-            default:
-                error += "UNKNOWN";
-                break;
-        }
-
-        error += "\n\nИспользуйте `/mode_manual` для переключения в ручной режим.";
-        bot->sendMessage(chat_id, error, "Markdown");
-        return;
-    }
-
+void TelegramBot::handleSetPosition(const char* chat_id, const char* command, bool quiet) {
     // Парсим позицию
-    String posStr = command.substring(14); // "/set_position " = 14 символов
-    posStr.trim();
+    const char* posStr = command + 14; // "/set_position " = 14 символов
+    while (*posStr == ' ') posStr++;
 
-    if (posStr.length() == 0) {
-        bot->sendMessage(chat_id, "❌ **Ошибка: укажите позицию**\n\nИспользуйте: `/set_position N` где N от 0 до 9", "Markdown");
+    if (*posStr == '\0') {
+        sendMessage(chat_id, "❌ **Ошибка: укажите позицию**\n\nИспользуйте: `/set_position N` где N от 0 до 9", "Markdown");
         return;
     }
 
-    int position = posStr.toInt();
+    int position = atoi(posStr);
 
     // Проверяем диапазон
     if (position < 0 || position > 9) {
-        bot->sendMessage(chat_id, "❌ **Ошибка: недопустимая позиция**\n\nПозиция должна быть от 0 до 9.", "Markdown");
+        sendMessage(chat_id, "❌ **Ошибка: недопустимая позиция**\n\nПозиция должна быть от 0 до 9.", "Markdown");
         return;
     }
 
-    // Устанавливаем позицию
-    int success = windowController.setManualPosition(position);
-
-    if (success >= 0) {
-        String response = "✅ **Позиция окна изменена**\n\n";
-        response += "Установлена позиция: **" + String(position) + "/9**\n";
-
-        if (position == 0) {
-            response += "Окно полностью закрыто.";
-        } else if (position == 9) {
-            response += "Окно полностью открыто.";
-        } else {
-            response += "Окно открыто на " + String(position) + "/9.";
-        }
-
-        bot->sendMessage(chat_id, response, "Markdown");
-
-        // Логируем
-        Serial.print("Установлена ручная позиция окна: ");
-        Serial.println(position);
-    } else {
-        bot->sendMessage(chat_id, "❌ **Ошибка при установке позиции**\n\nНе удалось установить позицию окна.", "Markdown");
-    }
+    // режим проверит управление - снимок мог устареть
+    BotCommand request = {};
+    request.type = BotCommandType::SET_POSITION;
+    request.position = position;
+    postCommand(chat_id, request, quiet);
 }
 
+static const char WINDOW_MENU_MANUAL[] =
+    "`/set_position N` - установить позицию (N от 0 до 9)\n"
+    "  0 - полностью закрыто\n"
+    "  9 - полностью открыто\n\n";
 
-void TelegramBot::showWindowMenu(String chat_id, WindowController& windowController) {
-    WindowConfig config = windowController.getConfig();
-    RecentData data = windowController.getRecentData();
-
-    String message = "🏠 **УПРАВЛЕНИЕ ОКНОМ**\n\n";
+static const char WINDOW_MENU_NOT_MANUAL[] =
+    "⚠️ Ручное управление доступно только в режиме MANUAL\n"
+    "Используйте `/mode_manual` для переключения\n\n";
 
-    message += "**Текущее состояние:**\n";
-    message += "• Позиция: " + String(data.windowPosition) + "/9\n";
-    message += "• Режим: ";
+static const char WINDOW_MENU_HOMING[] =
+    "`/homing` - выполнить процедуру калибровки (хоуминг)\n"
+    "• Сбрасывает счетчик энкодера\n"
+    "• Устанавливает нулевую позицию\n"
+    "• ⚠️ Требует свободного хода мотора\n\n"
+    "**Предупреждение:** Хоуминг может занять до 10 секунд.";
 
-    switch (config.currentMode) {
+static const char* mode_name(WindowMode mode) {
+    switch (mode) {
         case WindowMode::AUTO:
-            message += "AUTO (автоматический)";
-            break;
+            return "AUTO (автоматический)";
         case WindowMode::MANUAL:
-            message += "MANUAL (ручной)";
-            break;
+            return "MANUAL (ручной)";
+        case WindowMode::PREDICTIVE:
+            return "PREDICTIVE (по модели комнаты)";
         default:
-            message += "UNKNOWN";
-            break;
+            return "UNKNOWN";
     }
+}
 
-    message += "\n\n**Доступные команды:**\n";
+void TelegramBot::showWindowMenu(const char* chat_id) {
+    const WindowConfig& config = status.config;
+    const RecentData& data = status.data;
 
-    if (config.currentMode == WindowMode::MANUAL) {
-        message += "`/set_position N` - установить позицию (N от 0 до 9)\n";
-        message += "  0 - полностью закрыто\n";
-        message += "  9 - полностью открыто\n\n";
-    } else {
-        message += "⚠️ Ручное управление доступно только в режиме MANUAL\n";
-        message += "Используйте `/mode_manual` для переключения\n\n";
-    }
+    MessageBuilder message = newMessage();
+    message.add("🏠 **УПРАВЛЕНИЕ ОКНОМ**\n\n");
 
-    message += "`/homing` - выполнить процедуру калибровки (хоуминг)\n";
-    message += "• Сбрасывает счетчик энкодера\n";
-    message += "• Устанавливает нулевую позицию\n";
-    message += "• ⚠️ Требует свободного хода мотора\n\n";
+    message.add("**Текущее состояние:**\n");
+    message.addf("• Позиция: %d/9\n", data.windowPosition);
+    message.addf("• Режим: %s", mode_name(config.currentMode));
 
-    message += "**Предупреждение:** Хоуминг может занять до 10 секунд.";
+    message.add("\n\n**Доступные команды:**\n");
+    message.add(config.currentMode == WindowMode::MANUAL ? WINDOW_MENU_MANUAL : WINDOW_MENU_NOT_MANUAL);
+    message.add(WINDOW_MENU_HOMING);
 
-    bot->sendMessage(chat_id, message, "Markdown");
+    sendMessage(chat_id, message, "Markdown");
 }
 
-void TelegramBot::handleHoming(String chat_id, WindowController& windowController) {
+void TelegramBot::handleHoming(const char* chat_id) {
     Serial.println("Получена команда /homing");
 
-    String message = "🔄 **НАЧАЛО ПРОЦЕДУРЫ КАЛИБРОВКИ**\n\n";
-    message += "Выполняется хоуминг мотора...\n";
-    message += "Пожалуйста, подождите (до 10 секунд).";
-    bot->sendMessage(chat_id, message, "");
+    sendMessage(chat_id, "🔄 **НАЧАЛО ПРОЦЕДУРЫ КАЛИБРОВКИ**\n\n"
+                         "Выполняется хоуминг мотора...\n"
+                         "Пожалуйста, подождите (обычно 1-2 секунды).", "");
 
-    // Выполняем хоуминг
-    int result = performHoming();
+    // хоуминг ведет управление, результат придет ответом по его окончании
+    BotCommand command = {};
+    command.type = BotCommandType::HOMING;
+    postCommand(chat_id, command);
+}
 
-    String resultMessage = "";
+void TelegramBot::sendStatusLog(const char* chat_id, BotOutKind kind) {
+    const RecentData& data = status.data;
+    MessageBuilder message = newMessage();
+    if (kind == BotOutKind::ALERT) {
+        message.add(" EMERGENCY!!! \n");
+    }
+    message.add("=== System Status ===\n");
+    message.addf("Temperature: %.1f°C\n", data.temperature);
+    message.addf("Outside: %.1f°C\n", data.outsideTemp);
+    message.addf("CO2: %d ppm\n", data.co2);
+    message.addf("Window: %d/9\n", data.windowPosition);
+    message.addf("Total Metric: %.1f", data.totalMetric);
 
-    if (result >= 0) {
-        resultMessage = "✅ **КАЛИБРОВКА УСПЕШНО ЗАВЕРШЕНА**\n\n";
-        resultMessage += "Код выполнения: " + String(result) + "\n";
-        resultMessage += "Счетчик энкодера сброшен в 0\n";
-        resultMessage += "Нулевая позиция установлена";
+    // Добавляем информацию о режиме
+    message.addf("\nMode: %s", mode_name(status.config.currentMode));
 
-        Serial.println("Хоуминг успешно завершен с кодом: " + String(result));
-    } else {
-        resultMessage = "❌ **ОШИБКА КАЛИБРОВКИ**\n\n";
-        resultMessage += "Код ошибки: " + String(result) + "\n";
+    const PositionStoreStats& journal = status.journal;
+    message.addf("\nFlash writes: %.1f/day (total %lu)", journal.writesPerDay, (unsigned long)journal.writesTotal);
 
-        // Детализируем ошибку по коду
-        switch (result) {
-            case -1:
-                resultMessage += "• Таймаут выполнения (10 секунд)\n";
-                resultMessage += "• Мотор не достиг упора\n";
-                break;
-            case -2:
-                resultMessage += "• Мотор не начал движение\n";
-                resultMessage += "• Проверьте питание и соединения\n";
-                break;
-            case -3:
-                resultMessage += "• Ошибка энкодера\n";
-                resultMessage += "• Проверьте датчик положения\n";
-                break;
-            default:
-                resultMessage += "• Неизвестная ошибка\n";
-                break;
-        }
+    const MotorCalibration& drive = status.calibration;
+    message.addf("\nBacklash: %.1f/%.1f ticks, slip %.2f%%", drive.backlashTicks[0], drive.backlashTicks[1],
+                 drive.slipPerTick * 100.0f);
+    message.addf("\nPosition error: ~%.1f ticks (resyncs %lu)", status.positionErrorTicks, (unsigned long)drive.resyncs);
 
-        resultMessage += "\nПроверьте:\n";
-        resultMessage += "1. Свободный ход мотора\n";
-        resultMessage += "2. Соединение энкодера\n";
-        resultMessage += "3. Наличие упора для хоуминга";
+    message.addf("\nPower: %s, duty %.1f%%, %s%.0f mA",
+                 status.powerMode == PowerMode::ENERGY_SAVING ? "energy saving" : "normal",
+                 status.power.dutyCycle * 100.0f, status.power.lightSleepMeasured ? "~" : "<=",
+                 status.power.estimatedCurrentMa);
 
-        Serial.println("Хоуминг завершился с ошибкой: " + String(result));
+    sendMessage(chat_id, message, "", kind);
+}
+
+// панель /live ==================================================================================================================//
+
+static const char DASHBOARD_KEYBOARD[] =
+    "{\"inline_keyboard\":["
+    "[{\"text\":\"AUTO\",\"callback_data\":\"/mode_auto\"},{\"text\":\"PREDICTIVE\",\"callback_data\":\"/mode_predictive\"},"
+    "{\"text\":\"MANUAL\",\"callback_data\":\"/mode_manual\"}],"
+    "[{\"text\":\"0\",\"callback_data\":\"/set_position 0\"},{\"text\":\"1\",\"callback_data\":\"/set_position 1\"},"
+    "{\"text\":\"2\",\"callback_data\":\"/set_position 2\"},{\"text\":\"3\",\"callback_data\":\"/set_position 3\"},"
+    "{\"text\":\"4\",\"callback_data\":\"/set_position 4\"}],"
+    "[{\"text\":\"5\",\"callback_data\":\"/set_position 5\"},{\"text\":\"6\",\"callback_data\":\"/set_position 6\"},"
+    "{\"text\":\"7\",\"callback_data\":\"/set_position 7\"},{\"text\":\"8\",\"callback_data\":\"/set_position 8\"},"
+    "{\"text\":\"9\",\"callback_data\":\"/set_position 9\"}],"
+    "[{\"text\":\"Отключить панель\",\"callback_data\":\"/live_off\"}]]}";
+
+static const char* emergency_name(EmergencyType emergency) {
+    switch (emergency) {
+        case EmergencyType::CO2_CRITICAL:
+            return "критический CO2";
+        case EmergencyType::TEMP_CRITICAL_HELP:
+        case EmergencyType::TEMP_CRITICAL_HARM:
+            return "критическая температура";
+        case EmergencyType::SENSOR_FAILURE:
+            return "отказ датчиков";
+        default:
+            return "";
     }
+}
 
-    // Обновляем статус окна после хоуминга
-    RecentData data = windowController.getRecentData();
-    resultMessage += "\n\n**Текущая позиция:** " + String(data.windowPosition) + "/9";
+static DashboardView dashboard_view(const BotStatusSnapshot& snapshot) {
+    const RecentData& data = snapshot.data;
+    DashboardView view;
+    view.temperature = data.temperature;
+    view.outsideTemp = data.outsideTemp;
+    view.co2 = data.co2;
+    view.windowPosition = data.windowPosition;
+    view.mode = snapshot.config.currentMode;
+    view.emergency = snapshot.emergency;
+    view.sensorError = data.tempSensorError || data.outsideSensorError || data.co2SensorError;
+    return view;
+}
 
-    bot->sendMessage(chat_id, resultMessage, "");
+// заметно ли изменились показания с прошлой правки; дрожание датчиков панель не трогает
+static bool view_changed(const DashboardView& shown, const DashboardView& view) {
+    return fabsf(view.temperature - shown.temperature) >= BOT_DASHBOARD_TEMP_STEP ||
+           fabsf(view.outsideTemp - shown.outsideTemp) >= BOT_DASHBOARD_TEMP_STEP ||
+           abs(view.co2 - shown.co2) >= BOT_DASHBOARD_CO2_STEP ||
+           view.windowPosition != shown.windowPosition ||
+           view.mode != shown.mode ||
+           view.emergency != shown.emergency ||
+           view.sensorError != shown.sensorError;
 }
 
-void TelegramBot::sendStatusLog(String chat_id, WindowController& controller) {
-    RecentData data = controller.getRecentData();
-    String message = "=== System Status ===\n";
-    message += "Temperature: " + String(data.temperature, 1) + "°C\n";
-    message += "Outside: " + String(data.outsideTemp, 1) + "°C\n";
-    message += "CO2: " + String(data.co2) + " ppm\n";
-    message += "Window: " + String(data.windowPosition) + "/9\n";
-    message += "Total Metric: " + String(data.totalMetric, 1);
+Dashboard* TelegramBot::findDashboard(const char* chat_id) {
+    for (Dashboard& dashboard : dashboards) {
+        if (dashboard.chatId[0] != '\0' && strcmp(dashboard.chatId, chat_id) == 0) return &dashboard;
+    }
+    return nullptr;
+}
 
-    // Добавляем информацию о режиме
-    message += "\nMode: ";
-    switch (controller.getConfig().currentMode) {
-        case WindowMode::AUTO:
-            message += "AUTO (автоматический)";
-            break;
-        case WindowMode::MANUAL:
-            message += "MANUAL (ручной)";
-            break;
-        default:
-            message += "UNKNOWN";
-            break;
+void TelegramBot::renderDashboard(MessageBuilder& message, const DashboardView& view) {
+    message.add("📊 Панель\n\n");
+    message.addf("Комната: %.1f°C, снаружи %.1f°C\n", view.temperature, view.outsideTemp);
+    message.addf("CO2: %d ppm\n", view.co2);
+    message.addf("Окно: %d/9\n", view.windowPosition);
+    message.addf("Режим: %s\n", mode_name(view.mode));
+    if (view.sensorError) {
+        message.add("⚠️ Ошибка датчика\n");
+    }
+    if (view.emergency != EmergencyType::NONE) {
+        message.addf("🚨 АВАРИЯ: %s\n", emergency_name(view.emergency));
     }
+    message.add("\nОбновляется сама. Позиция окна - только в MANUAL.");
+}
 
-    bot->sendMessage(chat_id, message, "");
+// новое сообщение панели; его id придет с ответом сервера, до тех пор панель не правится
+void TelegramBot::startDashboard(const char* chat_id) {
+    Dashboard* dashboard = findDashboard(chat_id);
+    for (int i = 0; dashboard == nullptr && i < BOT_DASHBOARD_CHATS; i++) {
+        if (dashboards[i].chatId[0] == '\0') dashboard = &dashboards[i];
+    }
+    if (dashboard == nullptr) {
+        sendMessage(chat_id, "❌ Все панели заняты, попросите кого-нибудь отключить свою: /live_off", "");
+        return;
+    }
+
+    snprintf(dashboard->chatId, sizeof(dashboard->chatId), "%s", chat_id);
+    dashboard->messageId = 0;
+    dashboard->shown = dashboard_view(status);
+    dashboard->editedMs = millis();
+
+    MessageBuilder message = newMessage();
+    renderDashboard(message, dashboard->shown);
+    if (!outbox.push(BotOutKind::DASHBOARD, chat_id, message.c_str(), "", millis(), 0, DASHBOARD_KEYBOARD)) {
+        Serial.println("Telegram: очередь отправки полна, панель не создана");
+        dashboard->chatId[0] = '\0';
+    }
 }
 
-void TelegramBot::showSettingsMenu(String chat_id, WindowController& windowController) {
-    WindowConfig config = windowController.getConfig();
+void TelegramBot::stopDashboard(const char* chat_id) {
+    Dashboard* dashboard = findDashboard(chat_id);
+    if (dashboard == nullptr) {
+        sendMessage(chat_id, "Панель не включена. /live - включить", "");
+        return;
+    }
+    // сообщение остается в чате, но без кнопок
+    if (dashboard->messageId != 0) {
+        outbox.push(BotOutKind::DASHBOARD, chat_id, "📊 Панель отключена. /live - включить снова", "", millis(),
+                    dashboard->messageId);
+    }
+    *dashboard = {};
+}
 
-    String message = "⚙️ **НАСТРОЙКИ ПАРАМЕТРОВ**\n\n";
-    message += "**Текущие значения:**\n";
-    message += "Температура:\n";
-    message += "  - Идеальная: " + String(config.tempIdeal) + "°C\n";
-    message += "  - Критический макс: " + String(config.tempCriticalHigh) + "°C\n";
-    message += "  - Критический мин: " + String(config.tempCriticalLow) + "°C\n\n";
+// проход задачи бота: правим панели, где показания заметно изменились
+void TelegramBot::updateDashboards() {
+    if (status.seq == 0) return;
+    DashboardView view = dashboard_view(status);
+    for (Dashboard& dashboard : dashboards) {
+        if (dashboard.chatId[0] == '\0' || dashboard.messageId == 0) continue;
+        if (!view_changed(dashboard.shown, view) || millis() - dashboard.editedMs < BOT_DASHBOARD_MIN_EDIT_MS) continue;
+
+        MessageBuilder message = newMessage();
+        renderDashboard(message, view);
+        if (outbox.push(BotOutKind::DASHBOARD, dashboard.chatId, message.c_str(), "", millis(), dashboard.messageId,
+                        DASHBOARD_KEYBOARD)) {
+            dashboard.shown = view;
+            dashboard.editedMs = millis();
+        }
+    }
+}
 
-    message += "CO2:\n";
-    message += "  - Идеальный: " + String(config.co2Ideal) + " ppm\n";
-    message += "  - Критический: " + String(config.co2CriticalHigh) + " ppm\n\n";
+// ответ сервера на создание или правку панели
+void TelegramBot::dashboardSent(const BotOutMessage& message, const BotSendResult& result) {
+    Dashboard* dashboard = findDashboard(message.chatId);
+    if (dashboard == nullptr || message.editMessageId != dashboard->messageId) return;
+
+    if (result.status == BotSendStatus::SENT && message.editMessageId == 0) {
+        dashboard->messageId = result.messageId;
+    } else if (result.status == BotSendStatus::REJECTED) {
+        // сообщение панели удалили из чата - подписка кончилась
+        Serial.print("Telegram: панель недоступна, отключена для ");
+        Serial.println(message.chatId);
+        *dashboard = {};
+    }
+}
 
-    message += "Режим работы: ";
-    switch (config.currentMode) {
-        case WindowMode::AUTO:
-            message += "AUTO (автоматический)";
-            break;
-        case WindowMode::MANUAL:
-            message += "MANUAL (ручной)";
-            break;
-        default:
-            message += "UNKNOWN";
-            break;
+static const char SETTINGS_MENU_COMMANDS[] =
+    "**Команды для изменения:**\n"
+    "`/set_temp_ideal 23.5` - идеальная температура\n"
+    "`/set_temp_high 35` - макс температура\n"
+    "`/set_temp_low 10` - мин температура\n"
+    "`/set_co2_ideal 800` - идеальный CO2\n"
+    "`/set_co2_high 2500` - критический CO2\n"
+    "`/mode` - управление режимом работы\n";
+
+void TelegramBot::showSettingsMenu(const char* chat_id) {
+    const WindowConfig& config = status.config;
+
+    MessageBuilder message = newMessage();
+    message.add("⚙️ **НАСТРОЙКИ ПАРАМЕТРОВ**\n\n");
+    message.add("**Текущие значения:**\n");
+    message.add("Температура:\n");
+    message.addf("  - Идеальная: %.2f°C\n", config.tempIdeal);
+    message.addf("  - Критический макс: %.2f°C\n", config.tempCriticalHigh);
+    message.addf("  - Критический мин: %.2f°C\n\n", config.tempCriticalLow);
+
+    message.add("CO2:\n");
+    message.addf("  - Идеальный: %d ppm\n", config.co2Ideal);
+    message.addf("  - Критический: %d ppm\n\n", config.co2CriticalHigh);
+
+    message.addf("Режим работы: %s\n\n", mode_name(config.currentMode));
+
+    message.add(SETTINGS_MENU_COMMANDS);
+
+    sendMessage(chat_id, message, "Markdown");
+}
+
+void TelegramBot::handleParameterSetting(const char* chat_id, const char* command) {
+    BotCommand request = {};
+    request.type = BotCommandType::SET_PARAM;
+
+    if (strncmp(command, "/set_temp_ideal ", 16) == 0) {
+        request.param = BotParam::TEMP_IDEAL;
+        request.value = atof(command + 16);
+    }
+    else if (strncmp(command, "/set_temp_high ", 15) == 0) {
+        request.param = BotParam::TEMP_HIGH;
+        request.value = atof(command + 15);
+    }
+    else if (strncmp(command, "/set_temp_low ", 14) == 0) {
+        request.param = BotParam::TEMP_LOW;
+        request.value = atof(command + 14);
     }
-    message += "\n\n";
+    else if (strncmp(command, "/set_co2_ideal ", 15) == 0) {
+        request.param = BotParam::CO2_IDEAL;
+        request.value = atoi(command + 15);
+    }
+    else if (strncmp(command, "/set_co2_high ", 14) == 0) {
+        request.param = BotParam::CO2_HIGH;
+        request.value = atoi(command + 14);
+    }
+    else if (strncmp(command, "/set_mode ", 10) == 0) {
+        const char* modeStr = command + 10;
 
-    message += "**Команды для изменения:**\n";
-    message += "`/set_temp_ideal 23.5` - идеальная температура\n";
-    message += "`/set_temp_high 35` - макс температура\n";
-    message += "`/set_temp_low 10` - мин температура\n";
-    message += "`/set_co2_ideal 800` - идеальный CO2\n";
-    message += "`/set_co2_high 2500` - критический CO2\n";
-    message += "`/mode` - управление режимом работы\n";
+        request.type = BotCommandType::SET_MODE;
+        if (strcasecmp(modeStr, "auto") == 0) {
+            request.mode = WindowMode::AUTO;
+        }
+        else if (strcasecmp(modeStr, "manual") == 0) {
+            request.mode = WindowMode::MANUAL;
+        }
+        else if (strcasecmp(modeStr, "predictive") == 0) {
+            request.mode = WindowMode::PREDICTIVE;
+        }
+        else {
+            sendMessage(chat_id, "❌ Неизвестный режим. Используйте 'auto', 'predictive' или 'manual'", "");
+            return;
+        }
+    }
+    else {
+        sendMessage(chat_id, "❌ Неизвестная команда. Используйте /settings для списка команд", "");
+        return;
+    }
 
-    bot->sendMessage(chat_id, message, "Markdown");
+    postCommand(chat_id, request);
 }
 
-void TelegramBot::setMode(String chat_id, WindowMode mode, WindowController& windowController) {
-    WindowConfig config = windowController.getConfig();
-    config.currentMode = mode;
-    windowController.setConfig(config);
+// ответ управления на команду - в сообщение пользователю
+void TelegramBot::handleReply(const BotReply& reply) {
+    if (awaitingReplies > 0) awaitingReplies--;
+    const char* chat_id = reply.command.chatId;
+    MessageBuilder message = newMessage();
+
+    // нажали кнопку панели: результат покажет сама панель, и показать его надо сразу
+    if (reply.command.quiet) {
+        Dashboard* dashboard = findDashboard(chat_id);
+        if (dashboard != nullptr) dashboard->editedMs = millis() - BOT_DASHBOARD_MIN_EDIT_MS;
+        bool done = reply.command.type == BotCommandType::SET_MODE ||
+                    (reply.command.type == BotCommandType::SET_POSITION && reply.result >= 0);
+        if (done) return;
+    }
 
-    String message = "✅ **Режим работы изменен**\n\n";
+    switch (reply.command.type) {
+        case BotCommandType::SET_MODE:
+            message.add("✅ **Режим работы изменен**\n\n");
+            switch (reply.mode) {
+                case WindowMode::AUTO:
+                    message.add("Установлен режим: **AUTO (автоматический)**\n");
+                    message.add("Система будет автоматически управлять окнами.");
+                    break;
+                case WindowMode::MANUAL:
+                    message.add("Установлен режим: **MANUAL (ручной)**\n");
+                    message.add("Автоматическое управление отключено.");
+                    break;
+                case WindowMode::PREDICTIVE:
+                    message.add("Установлен режим: **PREDICTIVE (по модели комнаты)**\n");
+                    message.add("Позицию выбирает прогноз по выученной модели комнаты.");
+                    break;
+                default:
+                    message.add("Установлен неизвестный режим.");
+                    break;
+            }
+            sendMessage(chat_id, message, "Markdown");
+            break;
 
-    switch (mode) {
-        case WindowMode::AUTO:
-            message += "Установлен режим: **AUTO (автоматический)**\n";
-            message += "Система будет автоматически управлять окнами.";
+        case BotCommandType::SET_PARAM:
+            switch (reply.command.param) {
+                case BotParam::TEMP_IDEAL:
+                    message.addf("✅ Идеальная температура: %.2f°C", reply.value);
+                    break;
+                case BotParam::TEMP_HIGH:
+                    message.addf("✅ Макс температура: %.2f°C", reply.value);
+                    break;
+                case BotParam::TEMP_LOW:
+                    message.addf("✅ Мин температура: %.2f°C", reply.value);
+                    break;
+                case BotParam::CO2_IDEAL:
+                    message.addf("✅ Идеальный CO2: %d ppm", (int)reply.value);
+                    break;
+                case BotParam::CO2_HIGH:
+                    message.addf("✅ Критический CO2: %d ppm", (int)reply.value);
+                    break;
+            }
+            sendMessage(chat_id, message, "");
             break;
-        case WindowMode::MANUAL:
-            message += "Установлен режим: **MANUAL (ручной)**\n";
-            message += "Автоматическое управление отключено.";
+
+        case BotCommandType::SET_POSITION: {
+            int position = reply.command.position;
+            if (reply.result == BOT_RESULT_WRONG_MODE) {
+                message.add("❌ **Ошибка: неверный режим**\n\n");
+                message.add("Команда `/set_position` доступна только в **ручном режиме**.\n");
+                message.addf("Текущий режим: %s", mode_name(reply.mode));
+                message.add("\n\nИспользуйте `/mode_manual` для переключения в ручной режим.");
+                sendMessage(chat_id, message, "Markdown");
+            } else if (reply.result >= 0) {
+                message.add("✅ **Окно перемещается**\n\n");
+                message.addf("Целевая позиция: **%d/9**\n", position);
+
+                if (position == 0) {
+                    message.add("Окно полностью закрыто.");
+                } else if (position == 9) {
+                    message.add("Окно полностью открыто.");
+                } else {
+                    message.addf("Окно открыто на %d/9.", position);
+                }
+                sendMessage(chat_id, message, "Markdown");
+            } else {
+                sendMessage(chat_id, "❌ **Ошибка при установке позиции**\n\nНе удалось установить позицию окна.", "Markdown");
+            }
             break;
-        default:
-            message += "Установлен неизвестный режим.";
+        }
+
+        case BotCommandType::HOMING:
+            if (reply.result >= 0) {
+                message.add("✅ **КАЛИБРОВКА УСПЕШНО ЗАВЕРШЕНА**\n\n");
+                message.addf("Код выполнения: %d\n", reply.result);
+                message.add("Счетчик энкодера сброшен в 0\n");
+                message.addf("Время калибровки: %lu мс\n", reply.durationMs);
+                message.add("Нулевая позиция установлена");
+            } else {
+                message.add("❌ **ОШИБКА КАЛИБРОВКИ**\n\n");
+                message.addf("Код ошибки: %d\n", reply.result);
+
+                // Детализируем ошибку по коду
+                switch (reply.result) {
+                    case -1:
+                        message.add("• Таймаут выполнения (15 секунд)\n");
+                        message.add("• Мотор не достиг упора\n");
+                        break;
+                    case -2:
+                        message.add("• Мотор не начал движение\n");
+                        message.add("• Проверьте питание и соединения\n");
+                        break;
+                    case -3:
+                        message.add("• Мотор не смог отъехать от упора\n");
+                        message.add("• Проверьте створку и датчик положения\n");
+                        break;
+                    default:
+                        message.add("• Неизвестная ошибка\n");
+                        break;
+                }
+
+                message.add("\nПроверьте:\n");
+                message.add("1. Свободный ход мотора\n");
+                message.add("2. Соединение энкодера\n");
+                message.add("3. Наличие упора для хоуминга");
+            }
+
+            // статус окна после хоуминга
+            message.addf("\n\n**Текущая позиция:** %d/9", reply.windowPosition);
+            sendMessage(chat_id, message, "");
             break;
     }
+}
 
-    bot->sendMessage(chat_id, message, "Markdown");
+// сторона управления ============================================================================================================//
 
-    // Логируем изменение
-    Serial.print("Режим изменен на: ");
-    switch (mode) {
-        case WindowMode::AUTO:
-            Serial.println("AUTO");
+/**
+ * @brief Шаг бота на стороне управления: команды из очереди, конец хоуминга, новый снимок
+ *
+ * Ничего не ждет: очереди опрашиваются без таймаута, хоуминг только запускается,
+ * а ответ о нем уходит, когда motor_update() его закончит.
+ */
+void TelegramBot::update(WindowController& windowController) {
+    BotCommand command;
+    while (bot_link_take_command(command)) {
+        executeCommand(command, windowController);
+    }
+
+    if (homingChatId[0] != '\0' && !is_homing()) {
+        BotReply reply = {};
+        reply.command.type = BotCommandType::HOMING;
+        memcpy(reply.command.chatId, homingChatId, BOT_CHAT_ID_LEN);
+        reply.result = get_homing_result();
+        reply.durationMs = get_homing_duration_ms();
+        reply.windowPosition = windowController.getRecentData().windowPosition;
+        bot_link_post_reply(reply);
+        homingChatId[0] = '\0';
+
+        if (reply.result >= 0) {
+            Serial.println("Хоуминг успешно завершен с кодом: " + String(reply.result));
+        } else {
+            Serial.println("Хоуминг завершился с ошибкой: " + String(reply.result));
+        }
+    }
+
+    publishStatus(windowController);
+}
+
+void TelegramBot::executeCommand(const BotCommand& command, WindowController& windowController) {
+    WindowConfig config = windowController.getConfig();
+    BotReply reply = {};
+    reply.command = command;
+    reply.result = BOT_RESULT_OK;
+
+    switch (command.type) {
+        case BotCommandType::SET_MODE:
+            config.currentMode = command.mode;
+            windowController.setConfig(config);
+
+            // Логируем изменение
+            Serial.print("Режим изменен на: ");
+            Serial.println(mode_name(command.mode));
             break;
-        case WindowMode::MANUAL:
-            Serial.println("MANUAL");
+
+        case BotCommandType::SET_PARAM:
+            switch (command.param) {
+                case BotParam::TEMP_IDEAL:
+                    config.tempIdeal = command.value;
+                    break;
+                case BotParam::TEMP_HIGH:
+                    config.tempCriticalHigh = command.value;
+                    break;
+                case BotParam::TEMP_LOW:
+                    config.tempCriticalLow = command.value;
+                    break;
+                case BotParam::CO2_IDEAL:
+                    config.co2Ideal = (int)command.value;
+                    break;
+                case BotParam::CO2_HIGH:
+                    config.co2CriticalHigh = (int)command.value;
+                    break;
+            }
+            windowController.setConfig(config);
+            reply.value = command.value;
+            break;
+
+        case BotCommandType::SET_POSITION:
+            // Проверяем, что находимся в ручном режиме
+            if (config.currentMode != WindowMode::MANUAL) {
+                reply.result = BOT_RESULT_WRONG_MODE;
+                break;
+            }
+            reply.result = windowController.setManualPosition(command.position);
+            if (reply.result >= 0) {
+                // Логируем
+                Serial.print("Установлена ручная позиция окна: ");
+                Serial.println(command.position);
+            }
             break;
+
+        case BotCommandType::HOMING:
+            // ответ - по окончании, из update()
+            start_homing();
+            memcpy(homingChatId, command.chatId, BOT_CHAT_ID_LEN);
+            return;
     }
+
+    reply.mode = windowController.getConfig().currentMode;
+    bot_link_post_reply(reply);
 }
 
-void TelegramBot::handleParameterSetting(String chat_id, String command, WindowController& windowController) {
-    WindowConfig config = windowController.getConfig();
-    String response = "";
+void TelegramBot::publishStatus(WindowController& windowController) {
+    BotStatusSnapshot snapshot;
+    snapshot.data = windowController.getRecentData();
+    snapshot.config = windowController.getConfig();
+    snapshot.emergency = windowController.getLastEmergency();
+    snapshot.journal = position_store_stats();
+    snapshot.calibration = motor_get_calibration();
+    snapshot.positionErrorTicks = get_position_error_estimate();
+    snapshot.motorBusy = is_motor_busy();
+    snapshot.powerMode = power_get_mode();
+    snapshot.power = power_mode_stats(snapshot.powerMode);
+    bot_link_publish(snapshot);
+}
+
+// ESP32 =========================================================================================================================//
+
+#if defined(ESP32)
+
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <TelegramCertificate.h>             // корневой сертификат api.telegram.org из UniversalTelegramBot
 
-    if (command.startsWith("/set_temp_ideal ")) {
-        config.tempIdeal = command.substring(16).toFloat();
-        response = "✅ Идеальная температура: " + String(config.tempIdeal) + "°C";
+// TLS до api.telegram.org. Возобновление сессии WiFiClientSecure не дает (рукопожатие
+// целиком внутри connect()), поэтому экономим иначе: соединение держится, пока его не
+// закроет сервер или сеть, и полное рукопожатие случается только тогда.
+class TlsBotSocket : public BotSocket {
+public:
+    TlsBotSocket() {
+        client.setCACert(TELEGRAM_CERTIFICATE_ROOT);
     }
-    else if (command.startsWith("/set_temp_high ")) {
-        config.tempCriticalHigh = command.substring(15).toFloat();
-        response = "✅ Макс температура: " + String(config.tempCriticalHigh) + "°C";
+
+    bool open(const char* host, uint16_t port) override {
+        return client.connect(host, port) == 1;
     }
-    else if (command.startsWith("/set_temp_low ")) {
-        config.tempCriticalLow = command.substring(14).toFloat();
-        response = "✅ Мин температура: " + String(config.tempCriticalLow) + "°C";
+
+    bool connected() override {
+        return client.connected();
     }
-    else if (command.startsWith("/set_co2_ideal ")) {
-        config.co2Ideal = command.substring(15).toInt();
-        response = "✅ Идеальный CO2: " + String(config.co2Ideal) + " ppm";
+
+    void close() override {
+        client.stop();
     }
-    else if (command.startsWith("/set_co2_high ")) {
-        config.co2CriticalHigh = command.substring(14).toInt();
-        response = "✅ Критический CO2: " + String(config.co2CriticalHigh) + " ppm";
+
+    bool write(const char* data, size_t length) override {
+        return client.write((const uint8_t*)data, length) == length;
     }
-    else if (command.startsWith("/set_mode ")) {
-        String modeStr = command.substring(10);
-        modeStr.toLowerCase();
 
-        if (modeStr == "auto") {
-            config.currentMode = WindowMode::AUTO;
-            response = "✅ Режим изменен на: AUTO (автоматический)";
+    int read(char* buffer, size_t size, uint32_t timeoutMs) override {
+        unsigned long start = millis();
+        while (client.available() == 0) {
+            if (!client.connected()) return -1;
+            if (millis() - start >= timeoutMs) return 0;
+            delay(10);
         }
-        else if (modeStr == "manual") {
-            config.currentMode = WindowMode::MANUAL;
-            response = "✅ Режим изменен на: MANUAL (ручной)";
+        return client.read((uint8_t*)buffer, size);
+    }
+
+private:
+    WiFiClientSecure client;
+};
+
+class TelegramTransport : public BotTransport {
+public:
+    TelegramTransport() : api(socket, BOT_TOKEN) {}
+
+    bool connect() override {
+        // Подключение к WiFi (данные теперь из tgbotconfig.h)
+        WiFi.begin(ssid, password);  // ssid и password из tgbotconfig.h
+        while (WiFi.status() != WL_CONNECTED) {
+            delay(1000);
+            Serial.println("Подключаемся к WiFi...");
         }
-        else {
-            response = "❌ Неизвестный режим. Используйте 'auto' или 'manual'";
+        Serial.println("Подключено к WiFi");
+        return true;
+    }
+
+    int poll(BotMessage* messages, int maxMessages, uint16_t waitS) override {
+        if (WiFi.status() != WL_CONNECTED) {        // точка доступа пропала или перезагрузилась
+            socket.close();
+            WiFi.reconnect();
+            return 0;
         }
+        return api.getUpdates(messages, maxMessages, waitS);
     }
-    else {
-        response = "❌ Неизвестная команда. Используйте /settings для списка команд";
+
+    BotSendResult send(const char* chatId, const char* text, const char* parseMode, const char* replyMarkup) override {
+        return api.sendMessage(chatId, text, parseMode, replyMarkup);
+    }
+
+    BotSendResult edit(const char* chatId, int32_t messageId, const char* text, const char* parseMode,
+                       const char* replyMarkup) override {
+        return api.editMessageText(chatId, messageId, text, parseMode, replyMarkup);
     }
 
-    windowController.setConfig(config);
+    void answerCallback(const char* callbackId) override {
+        api.answerCallbackQuery(callbackId);
+    }
 
-    bot->sendMessage(chat_id, response, "");
+    void setPowerSave(bool on) override {
+        WiFi.setSleep(on ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+    }
+
+private:
+    TlsBotSocket socket;
+    BotApiClient api;
+};
+
+BotTransport* bot_transport_create_telegram() {
+    return new TelegramTransport();
 }
+
+#else
+
+BotTransport* bot_transport_create_telegram() {
+    return nullptr;
+}
+
+#endif
@@ -3,39 +3,142 @@
 #include "window_controller.h"
 #include "tgbotconfig.h"
 #include "motor_impl.h"
+#include "bot_link.h"
+#include "message_builder.h"
+#include "bot_api.h"
+#include "bot_outbox.h"
 
-#include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <UniversalTelegramBot.h>
-#include <ArduinoJson.h>
 #include <vector>
 
+// Телеграм-бот в своей задаче на ядре 0: вся сеть (WiFi, TLS, getUpdates, sendMessage) там,
+// управление видит бота только через bot_link - очередь команд, очередь ответов и снимок
+// состояния. update() на стороне управления никогда не ждет сеть.
+//
+// Ответы собираются в messageBuffer задачи бота (MessageBuilder), а не в String: разбор
+// команды и сборка ответа кучу не трогают, и за сутки работы она не дробится.
+//
+// Сообщения ждем long polling по постоянному соединению (bot_api.h): сервер отвечает, как
+// только пришла команда. Пока управление не ответило на команду, опрос короткий - ответ
+// уходит сразу, а не после следующего long poll.
+//
+// Отправка не ждет сеть и лимиты Telegram: сообщения ложатся в outbox (bot_outbox.h), а
+// проход задачи отправляет то, что лимиты уже пропускают. Рассылка аварии - одно сообщение
+// в чат, повторная до отправки заменяет прежнюю.
+//
+// /live - панель: одно сообщение с показаниями и кнопками режима и позиции, которое бот
+// правит на месте (editMessageText), когда показания заметно изменились, но не чаще
+// BOT_DASHBOARD_MIN_EDIT_MS. Подписанному чату /status и повторы аварии больше не нужны.
+
+// сеть бота: Bot API на ESP32, подставной сервер в тестах
+class BotTransport {
+public:
+    virtual ~BotTransport() {}
+    virtual bool connect() = 0;                                         // может блокировать
+    virtual int poll(BotMessage* messages, int maxMessages, uint16_t waitS) = 0;   // waitS > 0 - long poll
+    virtual BotSendResult send(const char* chatId, const char* text, const char* parseMode, const char* replyMarkup) = 0;
+    virtual BotSendResult edit(const char* chatId, int32_t messageId, const char* text, const char* parseMode,
+                               const char* replyMarkup) = 0;
+    virtual void answerCallback(const char* callbackId) = 0;            // снять часики с нажатой кнопки
+    virtual void setPowerSave(bool on) {}                               // modem sleep в энергосбережении
+};
+
+BotTransport* bot_transport_create_telegram();      // WiFi + BotApiClient, nullptr не на ESP32
+
+const int BOT_TASK_CORE = 0;
+const uint32_t BOT_TASK_STACK = 12288;              // TLS в mbedtls требует глубокого стека
+const int BOT_TASK_PRIORITY = 1;
+const int BOT_MAX_MESSAGES_PER_POLL = 8;
+const uint16_t BOT_LONG_POLL_S = 20;               // столько же может ждать рассылка об аварии
+const unsigned long BOT_REPLY_TIMEOUT_MS = 30000;   // хоуминг - до 15 с
+const int BOT_DASHBOARD_CHATS = 4;
+const unsigned long BOT_DASHBOARD_MIN_EDIT_MS = 10000;
+const float BOT_DASHBOARD_TEMP_STEP = 0.2f;         // меньшие изменения - шум датчика, панель не трогаем
+const int BOT_DASHBOARD_CO2_STEP = 50;
+
+// что показано на панели: с этим сравнивается новый снимок
+struct DashboardView {
+    float temperature;
+    float outsideTemp;
+    int co2;
+    int windowPosition;
+    WindowMode mode;
+    EmergencyType emergency;
+    bool sensorError;
+};
+
+struct Dashboard {
+    char chatId[BOT_CHAT_ID_LEN];       // пусто - место свободно
+    int32_t messageId;                  // 0 - сообщение панели еще создается
+    DashboardView shown;
+    unsigned long editedMs;
+};
+
 class TelegramBot {
 private:
-    UniversalTelegramBot* bot;
+    BotTransport* transport = nullptr;
+    volatile bool running = false;
+    volatile bool taskFinished = true;
     unsigned long lastUpdateTime = 0;
     const unsigned long UPDATE_INTERVAL = 1000;
+    const unsigned long SAVING_UPDATE_INTERVAL = 5000;  // в энергосбережении радио больше спит
+    bool powerSave = false;
+    int awaitingReplies = 0;                        // команды, на которые управление еще не ответило
+    unsigned long lastCommandMs = 0;
+    unsigned long lastBroadcast = 0;
+    bool broadcastDone = false;
+    const unsigned long BROADCAST_INTERVAL = 120 * 1000;
+
+    BotStatusSnapshot status = {};                  // последний снимок, виден только задаче бота
+    char homingChatId[BOT_CHAT_ID_LEN] = "";        // сторона управления: кто ждет конца хоуминга
+    char messageBuffer[BOT_MESSAGE_CAPACITY];       // сборка ответов, только задача бота
+    BotOutbox outbox;                               // неотправленные сообщения, только задача бота
+    Dashboard dashboards[BOT_DASHBOARD_CHATS] = {};
 
     std::vector<String> allowedUsers = ::allowedUsers;  // Используем глобальный список
 
-    bool isUserAllowed(String user_id);
-    void sendNotAllowedMessage(String chat_id);
-    void sendStatusToAll(WindowController& windowController);
-    void sendStatusLog(String chat_id, WindowController& windowController);
+    // задача бота
+    static void taskEntry(void* arg);
+    unsigned long updateInterval() const;
+    void syncPowerMode();
+    bool isUserAllowed(const String& user_id);
+    MessageBuilder newMessage();
+    void sendMessage(const char* chat_id, const char* text, const char* parseMode, BotOutKind kind = BotOutKind::REPLY);
+    void sendMessage(const char* chat_id, const MessageBuilder& message, const char* parseMode,
+                     BotOutKind kind = BotOutKind::REPLY);
+    void flushOutbox();
+    void sendNotAllowedMessage(const char* chat_id);
+    void sendStatusToAll(bool repeat);
+    void sendStatusLog(const char* chat_id, BotOutKind kind = BotOutKind::STATUS);
+
+    void showSettingsMenu(const char* chat_id);
+    void showModeMenu(const char* chat_id);
+    void showWindowMenu(const char* chat_id);
 
-    void showSettingsMenu(String chat_id, WindowController& windowController);
-    void showModeMenu(String chat_id, WindowController& windowController);
-    void showWindowMenu(String chat_id, WindowController& windowController);
+    Dashboard* findDashboard(const char* chat_id);
+    void startDashboard(const char* chat_id);
+    void stopDashboard(const char* chat_id);
+    void renderDashboard(MessageBuilder& message, const DashboardView& view);
+    void updateDashboards();
+    void dashboardSent(const BotOutMessage& message, const BotSendResult& result);
 
-    void setMode(String chat_id, WindowMode mode, WindowController& windowController);
+    void postCommand(const char* chat_id, BotCommand& command, bool quiet = false);
+    uint16_t longPollSeconds() const;
+    void handleMessages(uint16_t waitS);
+    void handleCommand(const char* chat_id, const String& text, bool quiet);
+    void handleParameterSetting(const char* chat_id, const char* command);
+    void handleSetPosition(const char* chat_id, const char* command, bool quiet = false);
+    void handleHoming(const char* chat_id);
+    void handleReply(const BotReply& reply);
 
-    void handleMessages(WindowController& windowController);
-    void handleParameterSetting(String chat_id, String command, WindowController& windowController);
-    void handleSetPosition(String chat_id, String command, WindowController& windowController);
-    void handleHoming(String chat_id, WindowController& windowController);
+    // сторона управления
+    void executeCommand(const BotCommand& command, WindowController& windowController);
+    void publishStatus(WindowController& windowController);
 
 public:
-    void init();
-    void update(WindowController& windowController);
+    // nullptr - Bot API; startTask = false - без задачи, pollOnce() зовет сам владелец (как раньше из loop())
+    void init(BotTransport* botTransport = nullptr, bool startTask = true);
+    void stop();                                        // для тестов: задача завершается после текущего прохода
+    void pollOnce(uint32_t replyWaitMs = 0, uint16_t longPollS = 0);   // один проход задачи бота
+    void update(WindowController& windowController);    // сторона управления: не блокирует
     void addAllowedUser(String user_id); // Опционально, для runtime добавления
 };
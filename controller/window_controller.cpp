@@ -1,22 +1,37 @@
 #include "window_controller.h"
-#include "sensors.h"
+#include "binlog.h"
 #include <cmath>
-#include <Arduino.h>
+#include <stdlib.h>
+#include <algorithm>
 
 const unsigned long DECISION_INTERVAL = 60 * 1000;
 
+// вместо constrain() из Arduino: тот - макрос, и без Arduino его нет
+template <typename T>
+static T clamp_value(T value, T low, T high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
 float mapFloat(float x, float in_min, float in_max, float out_min, float out_max) {
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
 
+// экземпляр не обязательно глобальный (симуляции, перебор настроек): без мусора в полях
+WindowController::WindowController(WindowHal* hal)
+    : hal(hal != nullptr ? hal : window_hal_esp32()), console(this->hal), lastEmergency(EmergencyType::NONE), recentData() {
+}
+
 void WindowController::setMode(WindowMode newMode) {
     if (config.currentMode == newMode) return;
 
-    Serial.print("Changing mode from ");
-    Serial.print(static_cast<int>(config.currentMode));
-    Serial.print(" to ");
-    Serial.println(static_cast<int>(newMode));
+    console.print("Changing mode from ");
+    console.print(static_cast<int>(config.currentMode));
+    console.print(" to ");
+    console.println(static_cast<int>(newMode));
 
+    if (newMode == WindowMode::EMERGENCY) {
+        modeBeforeEmergency = config.currentMode;
+    }
     config.currentMode = newMode;
 
     // Сброс состояния при смене режима
@@ -29,43 +44,43 @@ void WindowController::setMode(WindowMode newMode) {
 
 int WindowController::setManualPosition(int position) {
     if (config.currentMode != WindowMode::MANUAL) {
-        Serial.println("Warning: Setting manual position while not in MANUAL mode");
+        console.println("Warning: Setting manual position while not in MANUAL mode");
     }
-    position = constrain(position, 0, POSITION_LEVELS - 1);
-    Serial.print("MANUAL: Setting position to ");
-    Serial.println(position);
-    return change_pos(position);
+    position = clamp_value(position, 0, POSITION_LEVELS - 1);
+    console.print("MANUAL: Setting position to ");
+    console.println(position);
+    return hal->changePosition(position);
 }
 
 float WindowController::getCurrentPosition() const {
-    return get_current_position_index() / (float)POSITION_LEVELS;
+    return hal->position() / (float)POSITION_LEVELS;
 }
 void WindowController::updateRecentData() {
-    unsigned long currentTime = millis();
+    unsigned long currentTime = hal->millis();
 
     // Обновляем комнатную температуру
-    recentData.tempSensorError = get_room_sensor_error();
+    recentData.tempSensorError = hal->roomSensorError();
     if (!recentData.tempSensorError) {
-        recentData.temperature = get_room_temp();
+        recentData.temperature = hal->roomTemp();
     } else {
         recentData.temperature = NAN;
-        Serial.println("WARNING: Room temperature sensor error");
+        console.println("WARNING: Room temperature sensor error");
     }
 
     // Обновляем наружную температуру
-    recentData.outsideTemp = get_outside_temp();
-    recentData.outsideSensorError = get_outside_sensor_error();
+    recentData.outsideTemp = hal->outsideTemp();
+    recentData.outsideSensorError = hal->outsideSensorError();
     if (recentData.outsideSensorError) {
-        Serial.println("WARNING: Outside temperature sensor error");
+        console.println("WARNING: Outside temperature sensor error");
     }
 
     // Обновляем CO2
-    recentData.co2SensorError = get_co2_read_error();
+    recentData.co2SensorError = hal->co2Error();
     if (!recentData.co2SensorError) {
-        recentData.co2 = get_last_co2_ppm();
+        recentData.co2 = hal->co2();
     } else {
         recentData.co2 = -1;
-        Serial.println("WARNING: CO2 sensor error");
+        console.println("WARNING: CO2 sensor error");
     }
 
     // Рассчитываем метрики
@@ -74,26 +89,33 @@ void WindowController::updateRecentData() {
     recentData.totalMetric = calculateTotalMetric();
 
     // Позиция окна
-    recentData.windowPosition = get_current_position_index();
+    recentData.windowPosition = hal->position();
     recentData.timestamp = currentTime;
 
     // Логируем обновление (для отладки)
     // static unsigned long lastLogTime = 0;
     // if (currentTime - lastLogTime > 5000) { // Логируем каждые 5 секунд
-    //     Serial.print("RecentData updated: Room=");
-    //     Serial.print(recentData.temperature, 1);
-    //     Serial.print("°C, Outside=");
-    //     Serial.print(recentData.outsideTemp, 1);
-    //     Serial.print("°C, CO2=");
-    //     Serial.print(recentData.co2);
-    //     Serial.print("ppm, Window=");
-    //     Serial.print(recentData.windowPosition);
-    //     Serial.print(", TotalMetric=");
-    //     Serial.println(recentData.totalMetric, 2);
+    //     console.print("RecentData updated: Room=");
+    //     console.print(recentData.temperature, 1);
+    //     console.print("°C, Outside=");
+    //     console.print(recentData.outsideTemp, 1);
+    //     console.print("°C, CO2=");
+    //     console.print(recentData.co2);
+    //     console.print("ppm, Window=");
+    //     console.print(recentData.windowPosition);
+    //     console.print(", TotalMetric=");
+    //     console.println(recentData.totalMetric, 2);
     //     lastLogTime = currentTime;
     // }
 }
 
+// выученное - и в память, и в журнал flash: после перезагрузки история та же, что была;
+// пока мотор едет, flash не трогаем - запись и свертка держали бы цикл управления
+void WindowController::recordHistory(int position, float metric, unsigned long timestamp) {
+    positionHistories[position].addRecord(metric, timestamp);
+    history_store_record(position, metric, timestamp, hal->motorBusy());
+}
+
 // Обновляем collectData чтобы использовать updateRecentData
 void WindowController::collectData(unsigned long currentTime) {
     updateRecentData(); // Сначала обновляем данные
@@ -101,33 +123,70 @@ void WindowController::collectData(unsigned long currentTime) {
     int positionIndex = recentData.windowPosition; // Используем уже рассчитанное
     float currentMetric = recentData.totalMetric;  // Используем уже рассчитанное
 
-    positionHistories[positionIndex].addRecord(currentMetric, currentTime);
+    recordHistory(positionIndex, currentMetric, currentTime);
+
+    // модель комнаты учится только на окне, которое стоит, и на исправных датчиках
+    if (hal->motorBusy() || recentData.tempSensorError || recentData.outsideSensorError || recentData.co2SensorError) {
+        roomModel.interrupt();
+    } else {
+        RoomState room = { recentData.temperature, recentData.outsideTemp, (float)recentData.co2 };
+        roomModel.observe(room, positionIndex, POSITION_LEVELS, currentTime);
+    }
 
-    Serial.print("Data collected: pos=");
-    Serial.print(positionIndex);
-    Serial.print(", metric=");
-    Serial.print(currentMetric, 2);
-    Serial.print(", time=");
-    Serial.println(currentTime);
+    BINLOG_INFO(DATA_COLLECTED, positionIndex, currentMetric, currentTime);
+}
+
+// новое показание датчика - сразу в тренд; сбой датчика в тренд не идет
+void WindowController::sampleTrend() {
+    unsigned long tempTime = hal->roomTempReadTime();
+    if (tempTime != lastTempSampleTime) {
+        lastTempSampleTime = tempTime;
+        if (!hal->roomSensorError()) {
+            temperatureTrend.addSample(temperatureMetricOf(hal->roomTemp()), tempTime);
+        }
+    }
+
+    unsigned long co2Time = hal->co2ReadTime();
+    if (co2Time != lastCo2SampleTime) {
+        lastCo2SampleTime = co2Time;
+        co2Trend.addSample(co2MetricOf(hal->co2()), co2Time);
+    }
+}
+
+void WindowController::restoreHistory(HistoryStorage* storage) {
+    history_store_begin(positionHistories, POSITION_LEVELS, storage);
 }
 
 // metrics ======================================================================================================================//
 float WindowController::calculateTemperatureMetric() {
     if (recentData.tempSensorError) return config.tempErrorFallback;
-
-    float temp_metric = abs(recentData.temperature - config.tempIdeal) * config.tempWeightMultiplier;
-    temp_metric = constrain(temp_metric, 0.0f, 100.0f);
-    return temp_metric;
+    return temperatureMetricOf(recentData.temperature);
 }
 
 float WindowController::calculateCO2Metric() {
     if (recentData.co2SensorError) return config.co2ErrorFallback;
+    return co2MetricOf(recentData.co2);
+}
+
+float WindowController::temperatureMetricOf(float temperature) const {
+    float temp_metric = fabsf(temperature - config.tempIdeal) * config.tempWeightMultiplier;
+    temp_metric = clamp_value(temp_metric, 0.0f, 100.0f);
+    return temp_metric;
+}
 
+// метрика прогноза модели комнаты - как calculateTotalMetric()
+float WindowController::roomMetric(const void* context, float temperature, float co2) {
+    const WindowController* controller = static_cast<const WindowController*>(context);
+    return controller->temperatureMetricOf(temperature) * controller->config.tempWeight +
+           controller->co2MetricOf((int)co2) * controller->config.co2Weight;
+}
+
+float WindowController::co2MetricOf(int co2) const {
     float co2_metric = 0.0f;
-    if (recentData.co2 > config.co2Ideal) {
-        co2_metric = (recentData.co2 - config.co2Ideal) / config.co2WeightDivisor;
+    if (co2 > config.co2Ideal) {
+        co2_metric = (co2 - config.co2Ideal) / config.co2WeightDivisor;
     }
-    co2_metric = constrain(co2_metric, 0.0f, 100.0f);
+    co2_metric = clamp_value(co2_metric, 0.0f, 100.0f);
     return co2_metric;
 }
 
@@ -137,45 +196,36 @@ float WindowController::calculateTotalMetric() {
     return (tempMetric * config.tempWeight) + (co2Metric * config.co2Weight);
 }
 
-// обновление данных ==============================================================================================================//
-
-// Реализация PositionHistory методов
-void WindowController::PositionHistory::addRecord(float metric, unsigned long timestamp) {
-    records[head] = {metric, timestamp};
-    head = (head + 1) % HISTORY_SIZE;
-    if (count < HISTORY_SIZE) count++;
-}
-
-float WindowController::PositionHistory::getWeightedMetric(unsigned long currentTime) const {
-    if (count == 0) return -1.0f;
-
-    float sumMetric = 0.0f;
-    float sumWeight = 0.0f;
-
-    for (int i = 0; i < count; i++) {
-        float ageHours = (currentTime - records[i].timestamp) / 3600000.0f;
-        float weight = exp(-ageHours);
-
-        sumMetric += records[i].metric * weight;
-        sumWeight += weight;
-    }
+// логика управления ============================================================================================================//
 
-    return (sumWeight >= MIN_WEIGHT_THRESHOLD) ? (sumMetric / sumWeight) : -1.0f;
-}
+void WindowController::pollMotorStatus() {
+    MotorMoveStatus status = hal->motorStatus();
+    if (status == lastMotorStatus) return;
+    lastMotorStatus = status;
 
-float WindowController::PositionHistory::getTotalWeight(unsigned long currentTime) const {
-    float totalWeight = 0.0f;
-    for (int i = 0; i < count; i++) {
-        float ageHours = (currentTime - records[i].timestamp) / 3600000.0f;
-        totalWeight += exp(-ageHours);
+    switch (status) {
+        case MotorMoveStatus::DONE:
+            console.print("Window reached position ");
+            console.println(hal->position());
+            break;
+        case MotorMoveStatus::TIMEOUT:
+            console.print("WARNING: Window move timed out, stopped near position ");
+            console.println(hal->position());
+            break;
+        case MotorMoveStatus::STALLED:
+            console.print("WARNING: Window jammed, stopped near position ");
+            console.println(hal->position());
+            break;
+        default:
+            break;
     }
-    return totalWeight;
 }
 
-// логика управления ============================================================================================================//
-
 void WindowController::update() {
-    unsigned long currentTime = millis();
+    unsigned long currentTime = hal->millis();
+
+    pollMotorStatus();
+    sampleTrend();
 
     // 1. Проверка экстренных условий (каждые 10 секунд)
     if (currentTime - lastEmergencyCheckTime >= emergencyConfig.emergencyCheckInterval) {
@@ -187,9 +237,11 @@ void WindowController::update() {
         else if (config.currentMode == WindowMode::EMERGENCY) {
             // Проверяем, можно ли выйти из экстренного режима
             if (shouldExitEmergencyMode(currentTime)) {
-                setMode(WindowMode::AUTO);
-                change_pos(5);
-                Serial.println("Exiting emergency mode, returning to AUTO");
+                WindowMode mode = modeBeforeEmergency == WindowMode::PREDICTIVE ? WindowMode::PREDICTIVE : WindowMode::AUTO;
+                setMode(mode);
+                hal->changePosition(5);
+                console.println(mode == WindowMode::PREDICTIVE ? "Exiting emergency mode, returning to PREDICTIVE"
+                                                              : "Exiting emergency mode, returning to AUTO");
             }
         }
 
@@ -208,15 +260,24 @@ void WindowController::update() {
 
     // Если в экстренном режиме - пропускаем обычную логику
 
+    // Пока окно едет, решение откладываем - метрика еще не отражает новую позицию
+    if (hal->motorBusy()) {
+        return;
+    }
+
     if (currentTime - lastDecisionTime >= DECISION_INTERVAL) {
         float currentMetric = calculateTotalMetric();
-        float metricTrend = calculateMetricTrend(currentTime);
-        float predictedMetric = currentMetric + metricTrend * config.predictionTime;
-
-        Serial.print("Metrics: curr=");
-        Serial.print(currentMetric, 2);
-        Serial.print(", pred=");
-        Serial.print(predictedMetric, 2);
+        // от сглаженной метрики: шаг датчика температуры 0.25 °C - это 1.25 метрики;
+        // неуверенный наклон (шум) к прогнозу почти ничего не добавляет
+        TrendEstimate trend = calculateMetricTrend(currentTime);
+        float predictedMetric = trend.level + trend.slope * trend.confidence * config.predictionTime;
+
+        console.print("Metrics: curr=");
+        console.print(currentMetric, 2);
+        console.print(", pred=");
+        console.print(predictedMetric, 2);
+        console.print(", conf=");
+        console.print(trend.confidence, 2);
 
         switch(config.currentMode) {
             case WindowMode::AUTO:
@@ -228,8 +289,11 @@ void WindowController::update() {
             case WindowMode::SHORT_TERM:
                 makeDecisionShortTerm(currentMetric);
                 break;
+            case WindowMode::PREDICTIVE:
+                makeDecisionPredictive(currentTime, currentMetric, predictedMetric);
+                break;
             case WindowMode::MANUAL:
-                Serial.println(" - MANUAL mode");
+                console.println(" - MANUAL mode");
                 break;
             default:
                 break;
@@ -250,8 +314,8 @@ bool WindowController::shouldExitEmergencyMode(unsigned long currentTime) {
     }
 
     if ( (lastEmergency == EmergencyType::TEMP_CRITICAL_HELP) || (lastEmergency == EmergencyType::TEMP_CRITICAL_HARM) ) {
-        if (!get_room_sensor_error()) {
-            float roomTemp = get_room_temp();
+        if (!hal->roomSensorError()) {
+            float roomTemp = hal->roomTemp();
             if (roomTemp <= emergencyConfig.tempCriticalHigh &&
                 roomTemp >= emergencyConfig.tempCriticalLow) {
                 return true;
@@ -268,13 +332,27 @@ bool WindowController::need2Improve(float metric) {
 }
 
 void WindowController::make_decision_auto_ST(unsigned long currentTime, float currentMetric, float predictedMetric) {
-    // Определяем необходимость улучшения
-    if (!need2Improve(currentMetric)) {
-        Serial.println("Good metric (" + String(currentMetric) + "), no actions needed");
-        return;
-    } else if (!need2Improve(predictedMetric)) {
-        Serial.println("Good trend (" + String(currentMetric) + "->" + String(predictedMetric) + "), metric will stabilize soon");
+    // Определяем необходимость улучшения: решает прогноз - уверенный рост к порогу
+    // стоит встретить заранее, уверенный спад выше порога - переждать
+    if (!need2Improve(predictedMetric)) {
+        if (!need2Improve(currentMetric)) {
+            console.print("Good metric (");
+            console.print(currentMetric);
+            console.println("), no actions needed");
+        } else {
+            console.print("Good trend (");
+            console.print(currentMetric);
+            console.print("->");
+            console.print(predictedMetric);
+            console.println("), metric will stabilize soon");
+        }
         return;
+    } else if (!need2Improve(currentMetric)) {
+        console.print("Bad trend (");
+        console.print(currentMetric);
+        console.print("->");
+        console.print(predictedMetric);
+        console.println("), acting ahead");
     }
 
     // Обновляем данные (все переменные уже в recentData)
@@ -301,25 +379,25 @@ void WindowController::make_decision_auto_ST(unsigned long currentTime, float cu
 
         if (recentData.temperature > config.tempIdeal && tempDiff < 0) {
             // Жарко в комнате, холодно снаружи - открытие охладит
-            openBenefit += abs(roomToIdeal) * 2.0f;
-            closeBenefit -= abs(roomToIdeal) * 1.0f;
+            openBenefit += fabsf(roomToIdeal) * 2.0f;
+            closeBenefit -= fabsf(roomToIdeal) * 1.0f;
         }
         else if (recentData.temperature < config.tempIdeal && tempDiff > 0) {
             // Холодно в комнате, тепло снаружи - открытие нагреет
-            openBenefit += abs(roomToIdeal) * 2.0f;
-            closeBenefit -= abs(roomToIdeal) * 1.0f;
+            openBenefit += fabsf(roomToIdeal) * 2.0f;
+            closeBenefit -= fabsf(roomToIdeal) * 1.0f;
         }
         else {
             // Открытие ухудшит температурные условия
-            openBenefit -= abs(roomToIdeal) * 1.0f;
-            closeBenefit += abs(roomToIdeal) * 2.0f;
+            openBenefit -= fabsf(roomToIdeal) * 1.0f;
+            closeBenefit += fabsf(roomToIdeal) * 2.0f;
         }
     }
 
-    Serial.print("  Direction analysis: openBenefit=");
-    Serial.print(openBenefit, 2);
-    Serial.print(", closeBenefit=");
-    Serial.print(closeBenefit, 2);
+    console.print("  Direction analysis: openBenefit=");
+    console.print(openBenefit, 2);
+    console.print(", closeBenefit=");
+    console.print(closeBenefit, 2);
 
     // 2. Определяем направление движения
     const float MIN_BENEFIT_THRESHOLD = 3.0f;
@@ -327,30 +405,30 @@ void WindowController::make_decision_auto_ST(unsigned long currentTime, float cu
 
     if (openBenefit - closeBenefit > MIN_BENEFIT_THRESHOLD) {
         direction = 1;
-        Serial.println(" - DECISION: OPEN");
+        console.println(" - DECISION: OPEN");
     }
     else if (closeBenefit - openBenefit > MIN_BENEFIT_THRESHOLD) {
         direction = -1;
-        Serial.println(" - DECISION: CLOSE");
+        console.println(" - DECISION: CLOSE");
     }
     else {
-        Serial.println(" - DECISION: HOLD");
+        console.println(" - DECISION: HOLD");
         return;
     }
 
     // 3. Выполняем движение на одну позицию
     int newPosition = currentPosition + direction;
-    newPosition = constrain(newPosition, 0, POSITION_LEVELS - 1);
+    newPosition = clamp_value(newPosition, 0, POSITION_LEVELS - 1);
 
     if (newPosition != currentPosition) {
-        Serial.print("  Moving from ");
-        Serial.print(currentPosition);
-        Serial.print(" to ");
-        Serial.println(newPosition);
-        change_pos(newPosition);
+        console.print("  Moving from ");
+        console.print(currentPosition);
+        console.print(" to ");
+        console.println(newPosition);
+        hal->changePosition(newPosition);
 
         // Записываем в историю для будущего анализа
-        positionHistories[newPosition].addRecord(currentMetric, currentTime);
+        recordHistory(newPosition, currentMetric, currentTime);
     }
 }
 
@@ -359,86 +437,132 @@ void WindowController::makeDecisionAuto(unsigned long currentTime, float current
         (predictedMetric < config.metricTarget - config.metricMargin)) {
         takeActionAuto(currentTime, currentMetric, predictedMetric);
     } else {
-        Serial.println(" - AUTO: No action needed");
+        console.println(" - AUTO: No action needed");
     }
 }
 
 void WindowController::makeDecisionBinary(float currentMetric) {
-    int currentPosition = get_current_position_index();
+    int currentPosition = hal->position();
 
     if ((currentMetric > config.binaryOpenThreshold && currentPosition != POSITION_LEVELS - 1) ||
         (currentMetric < config.binaryCloseThreshold && currentPosition != 0)) {
         takeActionBinary(currentMetric);
     } else {
-        Serial.println(" - BINARY: No action needed");
+        console.println(" - BINARY: No action needed");
     }
 }
 
 void WindowController::makeDecisionShortTerm(float currentMetric) {
     if (shortTermMetrics.size() < 2) {
-        Serial.println(" - SHORT_TERM: Not enough data");
+        console.println(" - SHORT_TERM: Not enough data");
         return;
     }
 
     float oldestMetric = shortTermMetrics.front();
     float metricChange = currentMetric - oldestMetric;
 
-    if (abs(metricChange) > config.shortTermSensitivity) {
+    if (fabsf(metricChange) > config.shortTermSensitivity) {
         takeActionShortTerm(currentMetric);
     } else {
-        Serial.println(" - SHORT_TERM: No significant change");
+        console.println(" - SHORT_TERM: No significant change");
     }
 }
 
-void WindowController::takeActionAuto(unsigned long currentTime, float currentMetric, float predictedMetric) {
-    bool needToImprove = predictedMetric > config.metricTarget + config.metricMargin;
+/**
+ * @brief Позиция с наименьшей прогнозной метрикой на горизонте плюс цена хода до нее
+ * @details Пока модель комнаты не готова (мало отсчетов, окно не двигалось, нет датчиков) -
+ * шаг как в AUTO.
+ */
+void WindowController::makeDecisionPredictive(unsigned long currentTime, float currentMetric, float predictedMetric) {
+    updateRecentData();
+    if (!roomModel.ready() || recentData.tempSensorError || recentData.outsideSensorError || recentData.co2SensorError) {
+        console.print(" - PREDICTIVE: model not ready, AUTO: ");
+        make_decision_auto_ST(currentTime, currentMetric, predictedMetric);
+        return;
+    }
+
+    RoomState room = { recentData.temperature, recentData.outsideTemp, (float)recentData.co2 };
+    float costs[POSITION_LEVELS];
+    unsigned long start = hal->micros();
+    roomModel.evaluate(room, POSITION_LEVELS, config.predictiveHorizon, roomMetric, this, costs);
 
+    int currentPosition = recentData.windowPosition;
+    int bestPosition = currentPosition;
+    float bestCost = costs[currentPosition];
+    for (int i = 0; i < POSITION_LEVELS; i++) {
+        float cost = costs[i] + config.predictiveMoveCost * abs(i - currentPosition);
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestPosition = i;
+        }
+    }
+    unsigned long elapsed = hal->micros() - start;
+    if (elapsed > predictiveWorstUs) predictiveWorstUs = elapsed;
+
+    console.print(" - PREDICTIVE: ");
+    console.print(costs[currentPosition], 2);
+    console.print(" here, ");
+    console.print(costs[bestPosition], 2);
+    console.print(" at ");
+    console.print(bestPosition);
+    console.print(" (");
+    console.print(elapsed);
+    console.println(" us)");
+
+    if (bestPosition != currentPosition) {
+        hal->changePosition(bestPosition);
+    }
+}
+
+void WindowController::takeActionAuto(unsigned long currentTime, float currentMetric, float predictedMetric) {
+//     bool needToImprove = predictedMetric > config.metricTarget + config.metricMargin;
+//
 //     // Используем новую short-term логику вместо исторической
 //     int bestPosition = find_best_pos_ST(needToImprove, currentMetric, predictedMetric);
-//     int currentPosition = get_current_position_index();
+//     int currentPosition = hal->position();
 //
 //     if (bestPosition != -1 && bestPosition != currentPosition) {
-//         Serial.print("AUTO: Moving to position ");
-//         Serial.println(bestPosition);
-//         change_pos(bestPosition);
+//         console.print("AUTO: Moving to position ");
+//         console.println(bestPosition);
+//         hal->changePosition(bestPosition);
 //
 //         // Записываем решение в историю для будущего обучения
 //         positionHistories[bestPosition].addRecord(currentMetric, currentTime);
 //     } else {
-//         Serial.println("AUTO: No better position found");
+//         console.println("AUTO: No better position found");
 //     }
 }
 
 void WindowController::takeActionBinary(float currentMetric) {
-    int currentPosition = get_current_position_index();
+    int currentPosition = hal->position();
 
     if (currentMetric > config.binaryOpenThreshold && currentPosition != POSITION_LEVELS - 1) {
-        Serial.println("BINARY: Opening fully");
-        change_pos(POSITION_LEVELS - 1);
+        console.println("BINARY: Opening fully");
+        hal->changePosition(POSITION_LEVELS - 1);
     }
     else if (currentMetric < config.binaryCloseThreshold && currentPosition != 0) {
-        Serial.println("BINARY: Closing fully");
-        change_pos(0);
+        console.println("BINARY: Closing fully");
+        hal->changePosition(0);
     }
 }
 
 void WindowController::takeActionShortTerm(float currentMetric) {
     float oldestMetric = shortTermMetrics.front();
     float metricChange = currentMetric - oldestMetric;
-    int currentPosition = get_current_position_index();
+    int currentPosition = hal->position();
     int newPosition = currentPosition;
 
     if (metricChange > 0) {
-        newPosition = min(currentPosition + 1, POSITION_LEVELS - 1);
-        Serial.print("SHORT_TERM: Opening to ");
-        Serial.println(newPosition);
+        newPosition = std::min(currentPosition + 1, POSITION_LEVELS - 1);
+        console.print("SHORT_TERM: Opening to ");
+        console.println(newPosition);
     } else {
-        newPosition = max(currentPosition - 1, 0);
-        Serial.print("SHORT_TERM: Closing to ");
-        Serial.println(newPosition);
+        newPosition = std::max(currentPosition - 1, 0);
+        console.print("SHORT_TERM: Closing to ");
+        console.println(newPosition);
     }
 
-    change_pos(newPosition);
+    hal->changePosition(newPosition);
 }
 
 // поиск наилучшей позиции ======================================================================================================//
@@ -449,9 +573,9 @@ int WindowController::findBestPosition(unsigned long currentTime, bool needToImp
     float bestMetric = needToImprove ? 1000.0f : -1000.0f;
 
     // Получаем текущие данные
-    float insideTemp = get_room_temp();
-    float outsideTemp = get_outside_temp();
-    bool outsideSensorError = get_outside_sensor_error();
+    float insideTemp = hal->roomTemp();
+    float outsideTemp = hal->outsideTemp();
+    bool outsideSensorError = hal->outsideSensorError();
 
     // Определяем температурный тренд
     float tempDiff = outsideTemp - insideTemp;
@@ -469,7 +593,7 @@ int WindowController::findBestPosition(unsigned long currentTime, bool needToImp
     }
 
     // Получаем текущий CO2
-    int currentCO2 = get_last_co2_ppm();
+    int currentCO2 = hal->co2();
     bool co2High = currentCO2 > config.co2Ideal;
 
     for (int i = 0; i < POSITION_LEVELS; i++) {
@@ -500,23 +624,12 @@ int WindowController::findBestPosition(unsigned long currentTime, bool needToImp
                 adjustedMetric -= co2Bonus;
             }
 
-            Serial.print("  Pos ");
-            Serial.print(i);
-            Serial.print(": base_metric=");
-            Serial.print(weightedMetric, 2);
-            Serial.print(", adjusted_metric=");
-            Serial.print(adjustedMetric, 2);
-            Serial.print(", weight=");
-            Serial.print(totalWeight, 2);
-
             bool isBetter = needToImprove ? (adjustedMetric < bestMetric) : (adjustedMetric > bestMetric);
+            BINLOG_DEBUG(POSITION_CANDIDATE, i, weightedMetric, adjustedMetric, totalWeight, isBetter);
 
             if (isBetter) {
                 bestMetric = adjustedMetric;
                 bestPosition = i;
-                Serial.println(" - NEW BEST");
-            } else {
-                Serial.println();
             }
         }
     }
@@ -524,85 +637,83 @@ int WindowController::findBestPosition(unsigned long currentTime, bool needToImp
     return bestPosition;
 }
 
-float WindowController::calculateMetricTrend(unsigned long currentTime) const {
-    int currentPosIndex = get_current_position_index();
-    const PositionHistory& history = positionHistories[currentPosIndex];
-
-    if (history.count < 3) return 0.0f;
-
-    int lastIndex = (history.head - 1 + HISTORY_SIZE) % HISTORY_SIZE;
-    int prevIndex = (history.head - 2 + HISTORY_SIZE) % HISTORY_SIZE;
-
-    float lastMetric = history.records[lastIndex].metric;
-    float prevMetric = history.records[prevIndex].metric;
-    unsigned long lastTime = history.records[lastIndex].timestamp;
-    unsigned long prevTime = history.records[prevIndex].timestamp;
-
-    if (lastTime == prevTime) return 0.0f;
-
-    return (lastMetric - prevMetric) / ((lastTime - prevTime) / 1000.0f);
+/**
+ * @brief Тренд общей метрики: сумма трендов температуры и CO2 с весами метрики
+ * @details Составляющая без свежих показаний (сбой датчика, начало работы) идет без наклона,
+ * уровнем - текущее значение.
+ */
+TrendEstimate WindowController::calculateMetricTrend(unsigned long currentTime) const {
+    TrendEstimate temp = { recentData.temperatureMetric, 0.0f, 0.0f, 0.0f };
+    if (!recentData.tempSensorError && temperatureTrend.ready(currentTime)) {
+        temp = temperatureTrend.estimate(currentTime);
+    }
+    TrendEstimate co2 = { recentData.co2Metric, 0.0f, 0.0f, 0.0f };
+    if (!recentData.co2SensorError && co2Trend.ready(currentTime)) {
+        co2 = co2Trend.estimate(currentTime);
+    }
+    return trend_combine(temp, config.tempWeight, co2, config.co2Weight);
 }
 
 // emergencies ==================================================================================================================//
 
 EmergencyType WindowController::checkEmergencyConditions() {
     // 1. ПРИОРИТЕТ: Критический CO2
-    if (!get_co2_read_error()) {
-        int co2 = get_last_co2_ppm();
+    if (!hal->co2Error()) {
+        int co2 = hal->co2();
         if (co2 >= emergencyConfig.co2CriticalHigh) {
-            Serial.print("EMERGENCY: Critical CO2 level: ");
-            Serial.print(co2);
-            Serial.println("ppm");
+            console.print("EMERGENCY: Critical CO2 level: ");
+            console.print(co2);
+            console.println("ppm");
             return EmergencyType::CO2_CRITICAL;
         }
     }
 
     // 2. Критическая температура в комнате
-    if (!get_room_sensor_error()) {
-        float roomTemp = get_room_temp();
-        float outsideTemp = get_outside_temp();
-        bool outsideSensorOk = !get_outside_sensor_error();
+    if (!hal->roomSensorError()) {
+        float roomTemp = hal->roomTemp();
+        float outsideTemp = hal->outsideTemp();
+        bool outsideSensorOk = !hal->outsideSensorError();
 
         if (roomTemp >= emergencyConfig.tempCriticalHigh) {
             if (outsideSensorOk && outsideTemp < roomTemp) {
-                Serial.print("EMERGENCY: Critical high temperature - opening will help: ");
-                Serial.print(roomTemp, 1);
-                Serial.print("°C, outside ");
-                Serial.print(outsideTemp, 1);
-                Serial.println("°C");
+                console.print("EMERGENCY: Critical high temperature - opening will help: ");
+                console.print(roomTemp, 1);
+                console.print("°C, outside ");
+                console.print(outsideTemp, 1);
+                console.println("°C");
                 return EmergencyType::TEMP_CRITICAL_HELP;
             } else {
-                Serial.print("EMERGENCY: Critical high temperature - opening will harm: ");
-                Serial.print(roomTemp, 1);
-                Serial.print("°C, outside ");
-                Serial.print(outsideTemp, 1);
-                Serial.println("°C");
+                console.print("EMERGENCY: Critical high temperature - opening will harm: ");
+                console.print(roomTemp, 1);
+                console.print("°C, outside ");
+                console.print(outsideTemp, 1);
+                console.println("°C");
                 return EmergencyType::TEMP_CRITICAL_HARM;
             }
         }
 
         if (roomTemp <= emergencyConfig.tempCriticalLow) {
             if (outsideSensorOk && outsideTemp > roomTemp) {
-                Serial.print("EMERGENCY: Critical low temperature - opening will help: ");
-                Serial.print(roomTemp, 1);
-                Serial.print("°C, outside ");
-                Serial.print(outsideTemp, 1);
-                Serial.println("°C");
+                console.print("EMERGENCY: Critical low temperature - opening will help: ");
+                console.print(roomTemp, 1);
+                console.print("°C, outside ");
+                console.print(outsideTemp, 1);
+                console.println("°C");
                 return EmergencyType::TEMP_CRITICAL_HELP;
             } else {
-                Serial.print("EMERGENCY: Critical low temperature - opening will harm: ");
-                Serial.print(roomTemp, 1);
-                Serial.print("°C, outside ");
-                Serial.print(outsideTemp, 1);
-                Serial.println("°C");
+                console.print("EMERGENCY: Critical low temperature - opening will harm: ");
+                console.print(roomTemp, 1);
+                console.print("°C, outside ");
+                console.print(outsideTemp, 1);
+                console.println("°C");
                 return EmergencyType::TEMP_CRITICAL_HARM;
             }
         }
     }
 
     // 3. Отказ датчиков
-    if (get_room_sensor_error() && get_co2_read_error()) {
-        Serial.println("EMERGENCY: All sensors failed!");
+    if (hal->roomSensorError() && hal->co2Error()) {
+        console.println("EMERGENCY: All sensors failed!");
         return EmergencyType::SENSOR_FAILURE;
     }
 
@@ -610,7 +721,7 @@ EmergencyType WindowController::checkEmergencyConditions() {
 }
 
 void WindowController::handleEmergency(EmergencyType emergencyType) {
-    emergencyStartTime = millis();
+    emergencyStartTime = hal->millis();
 
     switch(emergencyType) {
         case EmergencyType::CO2_CRITICAL:
@@ -632,34 +743,34 @@ void WindowController::handleEmergency(EmergencyType emergencyType) {
 
 void WindowController::handleCo2Emergency() {
     // Для CO2 - всегда полное открытие
-    Serial.println("CO2 EMERGENCY: Full opening for ventilation");
-    change_pos(POSITION_LEVELS - 1);
+    console.println("CO2 EMERGENCY: Full opening for ventilation");
+    hal->changePosition(POSITION_LEVELS - 1);
     setMode(WindowMode::EMERGENCY);
 }
 
 void WindowController::handleTempEmergency(bool willHelp) {
     if (willHelp) {
         // Открытие поможет - полное открытие
-        Serial.println("TEMP EMERGENCY: Full opening to normalize temperature");
-        change_pos(POSITION_LEVELS - 1);
+        console.println("TEMP EMERGENCY: Full opening to normalize temperature");
+        hal->changePosition(POSITION_LEVELS - 1);
     } else {
         // Открытие навредит - полное закрытие
-        Serial.println("TEMP EMERGENCY: Full closing to preserve temperature");
-        change_pos(0);
+        console.println("TEMP EMERGENCY: Full closing to preserve temperature");
+        hal->changePosition(0);
     }
     setMode(WindowMode::EMERGENCY);
 }
 
 void WindowController::handleSensorFailure() {
     // При отказе датчиков - консервативная стратегия: оставляем как есть
-    Serial.println("SENSOR FAILURE: Maintaining current position");
+    console.println("SENSOR FAILURE: Maintaining current position");
     // Не меняем позицию, но переводим в ручной режим для безопасности
     setMode(WindowMode::MANUAL);
 }
 
 void WindowController::emergencyFullOpen() {
-    Serial.println("EMERGENCY: Moving to fully open position");
+    console.println("EMERGENCY: Moving to fully open position");
 
-    change_pos(POSITION_LEVELS - 1);
-    Serial.println("EMERGENCY: Window fully opened");
+    hal->changePosition(POSITION_LEVELS - 1);
+    console.println("EMERGENCY: Window fully opened");
 }
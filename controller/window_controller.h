@@ -2,8 +2,11 @@
 
 #include <deque>
 
-#include "sensors.h"
-#include "motor_impl.h"
+#include "hal.h"
+#include "position_history.h"
+#include "history_store.h"
+#include "metric_trend.h"
+#include "room_model.h"
 
 enum class EmergencyType {
     NONE,
@@ -18,6 +21,7 @@ enum class WindowMode {
     AUTO,
     BINARY,
     SHORT_TERM,
+    PREDICTIVE,         // модель комнаты и перебор позиций (room_model.h)
     EMERGENCY
 };
 
@@ -71,10 +75,17 @@ struct WindowConfig {
     // Параметры для SHORT_TERM режима
     unsigned short shortTermHistorySize = 6; // 1 минута при 10-секундном интервале
     float shortTermSensitivity = 2.0f;
+
+    // Параметры для PREDICTIVE режима
+    unsigned short predictiveHorizon = 15;  // минут прогноза, до ROOM_MODEL_MAX_HORIZON
+    float predictiveMoveCost = 1.0f;        // метрики за каждую позицию хода
 };
 
 class WindowController {
 private:
+    WindowHal* hal;             // датчики, мотор, часы и журнал
+    HalLog console;
+
     EmergencyType lastEmergency;
 
     RecentData recentData;
@@ -83,38 +94,38 @@ private:
     std::deque<float> shortTermMetrics;
 
     static const int POSITION_LEVELS = 10;
-    static const int HISTORY_SIZE = 180;
     static const unsigned long DECISION_INTERVAL = 60 * 1000;
     static const unsigned long DATA_COLLECTION_INTERVAL = 60 * 1000;
-    static constexpr float MIN_WEIGHT_THRESHOLD = 0.1f;
-
-    struct MetricRecord {
-        float metric;
-        unsigned long timestamp;
-    };
-
-    struct PositionHistory {
-        MetricRecord records[HISTORY_SIZE];
-        int head = 0;
-        int count = 0;
-
-        void addRecord(float metric, unsigned long timestamp);
-        float getWeightedMetric(unsigned long currentTime) const;
-        float getTotalWeight(unsigned long currentTime) const;
-    };
+    static constexpr float MIN_WEIGHT_THRESHOLD = POSITION_HISTORY_MIN_WEIGHT;
 
     PositionHistory positionHistories[POSITION_LEVELS];
     unsigned long lastDataCollectionTime = 0;
+
+    // тренд для прогноза - по каждому показанию датчиков, а не по минутным замерам истории
+    MetricTrend temperatureTrend;
+    MetricTrend co2Trend;
+    unsigned long lastTempSampleTime = 0;
+    unsigned long lastCo2SampleTime = 0;
+
+    RoomModel roomModel;
+    unsigned long predictiveWorstUs = 0;    // самый долгий перебор позиций
+    WindowMode modeBeforeEmergency = WindowMode::AUTO;
     unsigned long lastDecisionTime = 0;
 
+    MotorMoveStatus lastMotorStatus = MotorMoveStatus::IDLE;
+
     // Private methods
+    void pollMotorStatus();
+    void recordHistory(int position, float metric, unsigned long timestamp);
     void collectData(unsigned long currentTime);
+    void sampleTrend();
     bool need2Improve(float metric);
 
     void make_decision_auto_ST(unsigned long currentTime, float currentMetric, float predictedMetric);
     void makeDecisionAuto(unsigned long currentTime, float currentMetric, float predictedMetric);
     void makeDecisionBinary(float currentMetric);
     void makeDecisionShortTerm(float currentMetric);
+    void makeDecisionPredictive(unsigned long currentTime, float currentMetric, float predictedMetric);
     void handleManualMode();
 
     void takeActionAuto(unsigned long currentTime, float currentMetric, float predictedMetric);
@@ -122,10 +133,13 @@ private:
     void takeActionShortTerm(float currentMetric);
 
     int findBestPosition(unsigned long currentTime, bool needToImprove) const;
-    float calculateMetricTrend(unsigned long currentTime) const;
+    TrendEstimate calculateMetricTrend(unsigned long currentTime) const;
     float calculateTotalMetric();
     float calculateTemperatureMetric();
     float calculateCO2Metric();
+    float temperatureMetricOf(float temperature) const;
+    float co2MetricOf(int co2) const;
+    static float roomMetric(const void* context, float temperature, float co2);
 
     // emergencies ==============================================================================================================//
 
@@ -155,7 +169,8 @@ public:
     void setMode(WindowMode newMode);
     int setManualPosition(int position);
     void updateRecentData();
-    WindowController() = default;
+    void restoreHistory(HistoryStorage* storage = nullptr);    // выученное до перезагрузки, из flash
+    explicit WindowController(WindowHal* hal = nullptr);     // nullptr - бэкенд прошивки, window_hal_esp32()
     void update();
     float getCurrentPosition() const;
 
@@ -167,4 +182,8 @@ public:
     const WindowConfig& getConfig() const {
         return config;
     }
+
+    RoomModelStats getRoomModelStats() const { return roomModel.stats(); }
+    bool isRoomModelReady() const { return roomModel.ready(); }
+    unsigned long getPredictiveWorstUs() const { return predictiveWorstUs; }
 };
@@ -0,0 +1,121 @@
+#include "closed_loop.h"
+#include "room_sim.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+// Контроллер прошивки в замкнутом контуре с комнатой room_sim.h: окно, которое он выбрал, меняет
+// то, что датчики покажут дальше. Тот же window_controller.cpp, что на ESP32, - через SimWindowHal.
+// 1) физика: открытое окно снижает CO2 и выстуживает комнату, батарея это компенсирует;
+//    шаг 1 с и шаг 1 мин дают одно и то же
+// 2) месяц зимы в режимах AUTO и PREDICTIVE: комфорт, CO2 сверх co2Ideal, ходы мотора - по
+//    истинным температуре и CO2, а не по показаниям; симуляция не медленнее 10000x реального времени
+//
+// Сборка - CMake на хосте (цель algotest), код возврата - число проваленных проверок.
+// Прогон месяца - run_closed_loop() из closed_loop.h, тот же, что у перебора настроек tools/sweep.
+
+const unsigned long SECOND_MS = 1000UL;
+const unsigned long MINUTE_MS = 60000UL;
+const unsigned long HOUR_MS = 3600000UL;
+const unsigned long DAY_MS = 24UL * HOUR_MS;
+const int MONTH_DAYS = 30;
+const float MIN_SPEEDUP = 10000.0f;
+
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    printf("%s%s\n", ok ? "PASS: " : "FAIL: ", what);
+    if (!ok) failures++;
+}
+
+// открытое окно ================================================================================================================//
+
+struct FixedRun {
+    float meanTemp;
+    float meanCo2;
+    float heaterKwh;
+};
+
+// окно стоит на месте двое суток, считаются вторые
+FixedRun run_fixed(int position, unsigned long stepMs) {
+    RoomSimConfig config(OutdoorProfile::WINTER, 1);
+    config.stepMs = stepMs;
+    RoomSim room(config);
+    room.setOpening(position);
+
+    room.advance(DAY_MS);
+    double energyBefore = room.state().heaterEnergy;
+    double tempSum = 0.0;
+    double co2Sum = 0.0;
+    int samples = 0;
+    for (unsigned long t = DAY_MS + MINUTE_MS; t <= 2 * DAY_MS; t += MINUTE_MS) {
+        room.advance(t);
+        tempSum += room.state().airTemp;
+        co2Sum += room.state().co2;
+        samples++;
+    }
+    FixedRun result;
+    result.meanTemp = tempSum / samples;
+    result.meanCo2 = co2Sum / samples;
+    result.heaterKwh = (room.state().heaterEnergy - energyBefore) / 3.6e6;
+    return result;
+}
+
+void check_physics() {
+    printf("--- Fixed window, winter, day 2 ---\n");
+    const int POSITIONS[] = { 0, 3, 6, 9 };
+    FixedRun runs[4];
+    bool co2Falls = true;
+    bool heaterWorks = true;
+    bool notWarmer = true;
+    for (int i = 0; i < 4; i++) {
+        runs[i] = run_fixed(POSITIONS[i], SECOND_MS);
+        printf("Position %d: T %.2f C, CO2 %.0f ppm, heater %.1f kWh\n",
+               POSITIONS[i], runs[i].meanTemp, runs[i].meanCo2, runs[i].heaterKwh);
+        if (i == 0) continue;
+        if (runs[i].meanCo2 >= runs[i - 1].meanCo2) co2Falls = false;
+        if (runs[i].heaterKwh < runs[i - 1].heaterKwh) heaterWorks = false;     // батарея может упереться в мощность
+        if (runs[i].meanTemp > runs[i - 1].meanTemp + 0.01f) notWarmer = false;
+    }
+    report(co2Falls, "wider opening gives less CO2");
+    report(heaterWorks && notWarmer && runs[3].heaterKwh > runs[0].heaterKwh,
+           "wider opening costs heat and never warms the room in winter");
+
+    FixedRun coarse = run_fixed(5, MINUTE_MS);
+    FixedRun fine = run_fixed(5, SECOND_MS);
+    printf("Step 1 min vs 1 s: T %.3f C, CO2 %.1f ppm\n", coarse.meanTemp - fine.meanTemp, coarse.meanCo2 - fine.meanCo2);
+    report(fabsf(coarse.meanTemp - fine.meanTemp) < 0.1f && fabsf(coarse.meanCo2 - fine.meanCo2) < 0.02f * fine.meanCo2,
+           "physics step does not change the result");
+}
+
+// месяц в замкнутом контуре =====================================================================================================//
+
+void run_month(WindowMode mode, const char* name) {
+    printf("--- Month of winter, %s ---\n", name);
+    const unsigned long durationMs = MONTH_DAYS * DAY_MS;
+
+    clock_t begin = clock();
+    ClosedLoopScore score = run_closed_loop(RoomSimConfig(OutdoorProfile::WINTER, 1), WindowConfig(), mode, durationMs);
+    float wallS = (float)(clock() - begin) / CLOCKS_PER_SEC;
+    float speedup = durationMs / 1000.0f / (wallS > 1e-6f ? wallS : 1e-6f);
+
+    printf("Comfort: %.1f%%, mean metric %.2f, CO2 over ideal %.0f ppm*h\n",
+           score.comfortPercent(), score.meanMetric(), score.co2PpmHours);
+    printf("Motor: %lu moves, %.0f positions, heater %.0f kWh\n", score.moves, score.travel, score.heaterKwh);
+    printf("Simulated %d days in %.2f s: %.0fx real time\n", MONTH_DAYS, wallS, speedup);
+
+    report(score.minutes == durationMs / MINUTE_MS, "whole month simulated");
+    report(score.moves > 0, "controller moves the window");
+    report(speedup >= MIN_SPEEDUP, "simulation runs at least 10000x real time");
+}
+
+int main() {
+    printf("=== Closed-loop Window Controller Simulation ===\n");
+
+    check_physics();
+    run_month(WindowMode::AUTO, "AUTO");
+    run_month(WindowMode::PREDICTIVE, "PREDICTIVE");
+
+    printf("=== TEST COMPLETED, failures: %d ===\n", failures);
+    return failures;
+}
@@ -0,0 +1,43 @@
+#include "closed_loop.h"
+#include "sim_hal.h"
+#include <math.h>
+
+static const unsigned long SECOND_MS = 1000UL;
+static const unsigned long MINUTE_MS = 60000UL;
+
+static float clamp_metric(float value) {
+    return value < 0.0f ? 0.0f : (value > 100.0f ? 100.0f : value);
+}
+
+ClosedLoopScore run_closed_loop(const RoomSimConfig& room, const WindowConfig& config, WindowMode mode,
+                                unsigned long durationMs, const WindowConfig& yardstick) {
+    SimWindowHal hal(room);
+    hal.setVerbose(false);
+
+    WindowController* controller = new WindowController(&hal);     // история позиций - не для стека
+    controller->setConfig(config);
+    controller->setMode(mode);
+
+    ClosedLoopScore score;
+    for (unsigned long t = SECOND_MS; t <= durationMs; t += SECOND_MS) {
+        hal.advance(t);
+        controller->update();
+
+        if (t % MINUTE_MS != 0) continue;
+        const RoomSimState& state = hal.room.state();
+        float tempMetric = clamp_metric(fabsf(state.airTemp - yardstick.tempIdeal) * yardstick.tempWeightMultiplier);
+        float co2Excess = state.co2 > yardstick.co2Ideal ? state.co2 - yardstick.co2Ideal : 0.0f;
+        float co2Metric = clamp_metric(co2Excess / yardstick.co2WeightDivisor);
+        float metric = tempMetric * yardstick.tempWeight + co2Metric * yardstick.co2Weight;
+        score.minutes++;
+        if (metric <= yardstick.metricTarget + yardstick.metricMargin) score.comfortMinutes++;
+        score.metricSum += metric;
+        score.co2PpmHours += co2Excess / 60.0;
+    }
+    delete controller;
+
+    score.moves = hal.motor.moves();
+    score.travel = hal.motor.travel();
+    score.heaterKwh = hal.room.state().heaterEnergy / 3.6e6;
+    return score;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../../controller/window_controller.h"
+#include "room_sim.h"
+
+// Прогон контроллера прошивки в замкнутом контуре с комнатой: update(), мотор и комната -
+// каждую секунду времени симуляции. Оценка - по истинным температуре и CO2 комнаты, а не по
+// показаниям, и по мерке yardstick, а не по конфигу прогона: иначе конфиг с большим metricMargin
+// "выигрывал" бы, просто расширив себе полосу комфорта.
+
+struct ClosedLoopScore {
+    unsigned long minutes = 0;
+    unsigned long comfortMinutes = 0;       // метрика мерки не выше metricTarget + metricMargin
+    double metricSum = 0.0;                 // метрика мерки, по минутам
+    double co2PpmHours = 0.0;               // CO2 сверх co2Ideal мерки
+    unsigned long moves = 0;                // ходов мотора
+    float travel = 0.0f;                    // позиций проехано
+    double heaterKwh = 0.0;
+
+    float comfortPercent() const { return minutes ? 100.0f * comfortMinutes / minutes : 0.0f; }
+    float meanMetric() const { return minutes ? metricSum / minutes : 0.0f; }
+};
+
+ClosedLoopScore run_closed_loop(const RoomSimConfig& room, const WindowConfig& config, WindowMode mode,
+                                unsigned long durationMs, const WindowConfig& yardstick = WindowConfig());
@@ -1,16 +1,32 @@
 #pragma once
 
-// Имитация функций управления мотором
-void change_pos(int pos);
-int get_current_position_index();
+#include "../../controller/motor_impl.h"
 
-// Функции для симуляции
-void motor_simulation_setup();
-void motor_simulation_update(unsigned long current_time);
-int get_target_position();
-int get_current_position();
-bool is_motor_moving();
-float get_position_progress(); // 0.0 - 1.0
+// Мотор окна для симуляции: едет к позиции с постоянной скоростью, как настоящий - 2 с на позицию.
+// Состояние - в экземпляре, прогоны независимы.
 
-// Конфигурация симуляции
-void set_motor_simulation_speed(float moves_per_second); // Скорость изменения позиции
+class MotorSim {
+public:
+    explicit MotorSim(float positionsPerSecond = 0.5f) : speed(positionsPerSecond) {}
+
+    int change(int position);               // как change_pos(): не блокирует, вернет принятую позицию
+    void update(unsigned long nowMs);       // продвигает мотор ко времени nowMs
+
+    int position() const;                   // ближайшая позиция, как get_current_position_index()
+    float exactPosition() const { return exact; }   // окно в пути - дробная позиция
+    int target() const { return targetPosition; }
+    bool busy() const { return moving; }
+    MotorMoveStatus status() const;
+
+    unsigned long moves() const { return moveCount; }       // команд на новую позицию
+    float travel() const { return travelled; }              // позиций проехано
+
+private:
+    float speed;
+    float exact = 0.0f;
+    int targetPosition = 0;
+    bool moving = false;
+    unsigned long lastUpdateMs = 0;
+    unsigned long moveCount = 0;
+    float travelled = 0.0f;
+};
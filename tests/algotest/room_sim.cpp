@@ -0,0 +1,197 @@
+#include "room_sim.h"
+#include <math.h>
+
+const float AIR_HEAT_CAPACITY = 1200.0f;    // Дж/(м3 К), rho * c воздуха
+const float OUTDOOR_CO2 = 420.0f;           // ppm
+const float WEATHER_TIME_CONSTANT_S = 2.0f * 86400.0f;
+const unsigned long WEATHER_STEP_MS = 60000;
+const float SLEEP_CO2_SHARE = 0.7f;
+const float SLEEP_HEAT_SHARE = 0.8f;
+const float TWO_PI_F = 6.2831853f;
+
+struct ProfileParams {
+    float meanTemp;             // °C, среднее за сутки
+    float dailySwing;           // °C, амплитуда суточного хода, максимум в 15 ч
+    float weatherSigma;         // °C, разброс погоды от суток к суткам
+    float windMean;             // м/с
+    float sunShare;             // доля ясного солнца, зимой низкое и короткое
+    float dayLength;            // ч
+    bool heating;
+};
+
+static const ProfileParams PROFILES[] = {
+    { -3.0f, 3.0f, 3.0f, 3.5f, 0.3f,  8.0f, true  },    // WINTER
+    { 10.0f, 5.0f, 3.0f, 3.0f, 0.7f, 12.0f, true  },    // SPRING
+    { 20.0f, 6.0f, 2.0f, 2.0f, 1.0f, 16.0f, false },    // SUMMER
+    { 28.0f, 7.0f, 1.0f, 1.0f, 1.0f, 16.0f, false },    // HEATWAVE
+};
+
+static const ProfileParams& profile_of(OutdoorProfile profile) {
+    return PROFILES[(int)profile];
+}
+
+// случайные числа ===============================================================================================================//
+
+// у погоды с расписанием и у датчиков свои потоки: частота опроса не меняет погоду
+static float uniform(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return ((state >> 8) + 0.5f) / 16777216.0f;
+}
+
+static float gauss(uint32_t& state) {
+    return sqrtf(-2.0f * logf(uniform(state))) * cosf(TWO_PI_F * uniform(state));
+}
+
+// RoomSim =======================================================================================================================//
+
+void RoomSim::reset(const RoomSimConfig& config) {
+    cfg = config;
+    if (cfg.stepMs == 0) cfg.stepMs = 1000;
+    nowMs = 0;
+    lastTempReadMs = 0;
+    lastCo2ReadMs = 0;
+    lastWeatherMs = 0;
+    worldNoise = cfg.seed * 2654435761u + 1;
+    sensorNoise = cfg.seed * 40503u + 7;
+    weatherOffset = profile_of(cfg.profile).weatherSigma * gauss(worldNoise);
+    windOffset = 0.0f;
+    scheduleDay = -1;
+
+    room = {};
+    room.outsideTemp = outsideTempAt(0) + weatherOffset;
+    room.wind = profile_of(cfg.profile).windMean;
+    room.airTemp = profile_of(cfg.profile).heating ? cfg.heaterSetpoint : room.outsideTemp + 3.0f;
+    room.massTemp = room.airTemp;
+    room.co2 = 600.0f;
+    updateOccupancy();
+    readSensors();
+}
+
+void RoomSim::setOpening(float position) {
+    room.opening = position < 0.0f ? 0.0f : (position > 9.0f ? 9.0f : position);
+}
+
+void RoomSim::advance(unsigned long untilMs) {
+    while ((long)(untilMs - nowMs) > 0) {
+        unsigned long stepMs = untilMs - nowMs < cfg.stepMs ? untilMs - nowMs : cfg.stepMs;
+        nowMs += stepMs;
+        if (nowMs - lastWeatherMs >= WEATHER_STEP_MS) updateWeather();
+        updateOccupancy();
+        step(stepMs / 1000.0f);
+        readSensors();
+    }
+}
+
+float RoomSim::hourOf(unsigned long timeMs) {
+    return (timeMs % 86400000UL) / 3600000.0f;
+}
+
+float RoomSim::outsideTempAt(unsigned long timeMs) const {
+    const ProfileParams& p = profile_of(cfg.profile);
+    return p.meanTemp + p.dailySwing * cosf((hourOf(timeMs) - 15.0f) / 24.0f * TWO_PI_F);
+}
+
+// улица и люди ==================================================================================================================//
+
+void RoomSim::updateWeather() {
+    // Орнштейн-Уленбек раз в минуту: разброс держится около weatherSigma
+    const ProfileParams& p = profile_of(cfg.profile);
+    float dt = (nowMs - lastWeatherMs) / 1000.0f;
+    lastWeatherMs = nowMs;
+    float keep = expf(-dt / WEATHER_TIME_CONSTANT_S);
+    float spread = sqrtf(1.0f - keep * keep);
+    weatherOffset = weatherOffset * keep + p.weatherSigma * spread * gauss(worldNoise);
+    windOffset = windOffset * keep + 0.5f * p.windMean * spread * gauss(worldNoise);
+    room.wind = p.windMean + windOffset > 0.0f ? p.windMean + windOffset : 0.0f;
+}
+
+void RoomSim::planDay(long day) {
+    scheduleDay = day;
+    bool weekend = day % 7 >= 5;
+    wakeHour = (weekend ? 8.5f : 7.0f) + 0.5f * (uniform(worldNoise) - 0.5f);
+    leaveHour = weekend ? 24.0f : 8.5f + 0.5f * uniform(worldNoise);
+    returnHour = weekend ? 24.0f : 17.5f + 1.5f * uniform(worldNoise);
+    sleepHour = 23.0f + uniform(worldNoise) - 0.5f;
+}
+
+void RoomSim::updateOccupancy() {
+    long day = nowMs / 86400000UL;
+    if (day != scheduleDay) planDay(day);
+
+    float h = hourOf(nowMs);
+    room.sleeping = h < wakeHour || h >= sleepHour;
+    bool away = h >= leaveHour && h < returnHour;
+    room.people = away ? 0 : cfg.occupants;
+}
+
+// физика ========================================================================================================================//
+
+// dx/dt = rate * (target - x) на шаге dt при постоянных rate и target
+static float relax(float x, float target, float rate, float dt) {
+    return target + (x - target) * expf(-rate * dt);
+}
+
+void RoomSim::step(float dtS) {
+    const ProfileParams& p = profile_of(cfg.profile);
+    float h = hourOf(nowMs);
+    room.outsideTemp = outsideTempAt(nowMs) + weatherOffset;
+
+    // воздух: щели плюс окно
+    float area = cfg.windowArea * room.opening / 9.0f;
+    float dT = fabsf(room.airTemp - room.outsideTemp);
+    float windowFlow = 0.5f * area * sqrtf(0.001f * room.wind * room.wind + 0.0035f * cfg.windowHeight * dT + 0.01f);
+    room.airflow = cfg.infiltrationAch * cfg.volume / 3600.0f + windowFlow;
+
+    // притоки тепла
+    float sunHours = p.dayLength;
+    float sinceSunrise = h - (12.0f - sunHours / 2.0f);
+    float sun = (sinceSunrise > 0.0f && sinceSunrise < sunHours) ? cfg.solarGain * p.sunShare * sinf(sinceSunrise / sunHours * 3.1415927f) : 0.0f;
+    float people = room.people * cfg.personHeat * (room.sleeping ? SLEEP_HEAT_SHARE : 1.0f);
+
+    // батарея: в пропорциональной зоне термостата мощность линейна по Ta и входит в уравнение
+    // воздуха, иначе постоянна на шаге - так минутный шаг не раскачивает термостат
+    float heater = 0.0f;
+    float heaterGain = 0.0f;
+    if (p.heating) {
+        float demand = (cfg.heaterSetpoint - room.airTemp) / cfg.heaterBand + 0.5f;
+        if (demand >= 1.0f) {
+            heater = cfg.heaterPower;
+        } else if (demand > 0.0f) {
+            heaterGain = cfg.heaterPower / cfg.heaterBand;
+            heater = heaterGain * (cfg.heaterSetpoint + 0.5f * cfg.heaterBand);
+        }
+    }
+
+    // воздух и стены: каждый узел точно, при замороженном соседе
+    float ventilation = AIR_HEAT_CAPACITY * room.airflow;
+    float airLoss = ventilation + cfg.glazingUA + cfg.massCoupling + heaterGain;
+    float airTarget = ((ventilation + cfg.glazingUA) * room.outsideTemp + cfg.massCoupling * room.massTemp +
+                       heater + people + sun * cfg.solarToAir) / airLoss;
+    float massLoss = cfg.massCoupling + cfg.wallUA;
+    float massTarget = (cfg.massCoupling * room.airTemp + cfg.wallUA * room.outsideTemp + sun * (1.0f - cfg.solarToAir)) / massLoss;
+    float previousAir = room.airTemp;
+    room.airTemp = relax(room.airTemp, airTarget, airLoss / cfg.airCapacity, dtS);
+    room.massTemp = relax(room.massTemp, massTarget, massLoss / cfg.massCapacity, dtS);
+
+    room.heaterPower = heater - heaterGain * 0.5f * (previousAir + room.airTemp);
+    room.heaterEnergy += room.heaterPower * dtS;
+
+    // CO2: генерация в м3/с, в ppm - на объем
+    float generation = room.people * cfg.personCo2 * (room.sleeping ? SLEEP_CO2_SHARE : 1.0f);
+    float co2Target = OUTDOOR_CO2 + generation / room.airflow * 1e6f;
+    room.co2 = relax(room.co2, co2Target, room.airflow / cfg.volume, dtS);
+}
+
+void RoomSim::readSensors() {
+    if (nowMs == 0 || nowMs - lastTempReadMs >= cfg.tempReadMs) {
+        lastTempReadMs = nowMs;
+        sensors.tempTime = nowMs;
+        sensors.roomTemp = roundf((room.airTemp + cfg.tempNoise * gauss(sensorNoise)) / cfg.tempStep) * cfg.tempStep;
+        sensors.outsideTemp = roundf((room.outsideTemp + cfg.tempNoise * gauss(sensorNoise)) / cfg.tempStep) * cfg.tempStep;
+    }
+    if (nowMs == 0 || nowMs - lastCo2ReadMs >= cfg.co2ReadMs) {
+        lastCo2ReadMs = nowMs;
+        sensors.co2Time = nowMs;
+        sensors.co2 = (int)roundf(room.co2 + cfg.co2Noise * gauss(sensorNoise));
+    }
+}
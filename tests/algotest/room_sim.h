@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdint.h>
+
+// Физика комнаты для замкнутого контура: позиция окна меняет то, что контроллер увидит дальше.
+//
+// Два тепловых узла - воздух с мебелью и стены - и CO2 в объеме комнаты:
+//   Ca dTa/dt = rho c Q (To - Ta) + K (Tm - Ta) + UAg (To - Ta) + батарея + люди + солнце * fa
+//   Cm dTm/dt = K (Ta - Tm) + UAw (To - Tm) + солнце * (1 - fa)
+//   V dC/dt  = G * люди + Q (Cout - C)
+// Q - воздух через щели плюс окно: открытие пропорционально позиции, поток по de Gids и Phaff,
+// Q = A/2 * sqrt(0.001 v^2 + 0.0035 H |dT| + 0.01) - ветер, тяга от разницы температур и
+// турбулентность. Батарея - с термостатом по воздуху, только в отопительный сезон.
+//
+// Каждое уравнение на шаге линейно по своей переменной при замороженных остальных и решается
+// точно (экспонента), так что шаг ограничен только точностью: от 1 с до минуты.
+// Улица - суточная синусоида профиля плюс погода (случайное блуждание с возвратом за ~2 суток),
+// люди - по расписанию будней и выходных со сдвигами по дням. Датчики - с шумом, шагом
+// DS18B20 в 10 бит и интервалами опроса, как в sensors.cpp.
+// Состояние - в экземпляре RoomSim, без глобальных переменных: прогоны независимы.
+
+enum class OutdoorProfile {
+    WINTER,
+    SPRING,
+    SUMMER,
+    HEATWAVE
+};
+
+struct RoomSimConfig {
+    OutdoorProfile profile = OutdoorProfile::WINTER;
+    uint32_t seed = 1;
+    unsigned long stepMs = 1000;            // шаг физики
+
+    // комната
+    float volume = 40.0f;                   // м3
+    float windowArea = 0.25f;               // м2 проема при позиции 9
+    float windowHeight = 1.2f;              // м
+    float infiltrationAch = 0.3f;           // воздухообменов в час при закрытом окне
+    float glazingUA = 10.0f;                // Вт/К, стекло - сразу к воздуху
+    float wallUA = 20.0f;                   // Вт/К, стены - через их теплоемкость
+    float airCapacity = 250e3f;             // Дж/К, воздух и мебель
+    float massCapacity = 8e6f;              // Дж/К, стены и перекрытия
+    float massCoupling = 300.0f;            // Вт/К между воздухом и стенами
+    float heaterPower = 1500.0f;            // Вт
+    float heaterSetpoint = 21.0f;           // °C, термостат радиатора
+    float heaterBand = 1.0f;                // К, пропорциональная зона термостата
+    float solarGain = 600.0f;               // Вт в ясный полдень
+    float solarToAir = 0.3f;                // доля солнца сразу в воздух
+
+    // люди
+    int occupants = 2;
+    float personHeat = 80.0f;               // Вт
+    float personCo2 = 5.2e-6f;              // м3/с CO2, бодрствует; во сне 0.7 от этого
+
+    // датчики
+    float tempNoise = 0.05f;                // °C, СКО
+    float tempStep = 0.25f;                 // 10 бит DS18B20
+    float co2Noise = 10.0f;                 // ppm, СКО
+    unsigned long tempReadMs = 5000;
+    unsigned long co2ReadMs = 10000;
+
+    RoomSimConfig(OutdoorProfile profile = OutdoorProfile::WINTER, uint32_t seed = 1) : profile(profile), seed(seed) {}
+};
+
+struct RoomSimState {
+    float airTemp;              // °C, истинная
+    float massTemp;
+    float co2;                  // ppm
+    float outsideTemp;
+    float wind;                 // м/с
+    float opening;              // позиция окна 0..9, дробная - мотор в пути
+    int people;
+    bool sleeping;
+    float airflow;              // м3/с, щели и окно
+    float heaterPower;          // Вт сейчас
+    double heaterEnergy;        // Дж с начала прогона
+};
+
+struct SensorReadings {
+    float roomTemp;
+    float outsideTemp;
+    int co2;
+    unsigned long tempTime;     // время последнего опроса, как get_temp_read_time()
+    unsigned long co2Time;
+};
+
+class RoomSim {
+public:
+    explicit RoomSim(const RoomSimConfig& config = RoomSimConfig()) { reset(config); }
+
+    void reset(const RoomSimConfig& config);
+    void setOpening(float position);            // фактическая позиция окна, 0..9
+    void advance(unsigned long untilMs);        // шагами config.stepMs до untilMs
+
+    unsigned long now() const { return nowMs; }
+    const RoomSimState& state() const { return room; }
+    const SensorReadings& readings() const { return sensors; }
+    const RoomSimConfig& config() const { return cfg; }
+
+    float outsideTempAt(unsigned long timeMs) const;   // без погоды - профиль
+    static float hourOf(unsigned long timeMs);          // прогон начинается в полночь понедельника
+
+private:
+    RoomSimConfig cfg;
+    RoomSimState room;
+    SensorReadings sensors;
+    unsigned long nowMs;
+    unsigned long lastTempReadMs;
+    unsigned long lastCo2ReadMs;
+    unsigned long lastWeatherMs;
+
+    float weatherOffset;        // °C к профилю
+    float windOffset;
+    uint32_t worldNoise;        // погода и расписание
+    uint32_t sensorNoise;
+
+    // расписание текущих суток, сдвиги от сида
+    long scheduleDay;
+    float wakeHour;
+    float leaveHour;
+    float returnHour;
+    float sleepHour;
+
+    void planDay(long day);
+    void updateWeather();
+    void updateOccupancy();
+    void step(float dtS);
+    void readSensors();
+};
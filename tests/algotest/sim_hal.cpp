@@ -0,0 +1,8 @@
+#include "sim_hal.h"
+
+void SimWindowHal::advance(unsigned long untilMs) {
+    motor.update(untilMs);
+    room.setOpening(motor.exactPosition());
+    room.advance(untilMs);
+    setTime(untilMs);
+}
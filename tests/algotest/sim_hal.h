@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../controller/hal_host.h"
+#include "room_sim.h"
+#include "motor_sim.h"
+
+// Хостовый HAL замкнутого контура: датчики - показания RoomSim, мотор - MotorSim,
+// часы - время симуляции. advance() двигает мотор и комнату, фактическая позиция окна
+// уходит в комнату, так что решение контроллера меняет то, что он прочитает дальше.
+
+class SimWindowHal : public HostWindowHal {
+public:
+    explicit SimWindowHal(const RoomSimConfig& config = RoomSimConfig()) : room(config) {}
+
+    void advance(unsigned long untilMs);
+
+    float roomTemp() override { return room.readings().roomTemp; }
+    bool roomSensorError() override { return false; }
+    unsigned long roomTempReadTime() override { return room.readings().tempTime; }
+    float outsideTemp() override { return room.readings().outsideTemp; }
+    bool outsideSensorError() override { return false; }
+    int co2() override { return room.readings().co2; }
+    bool co2Error() override { return false; }
+    unsigned long co2ReadTime() override { return room.readings().co2Time; }
+
+    int changePosition(int position) override { return motor.change(position); }
+    int position() override { return motor.position(); }
+    bool motorBusy() override { return motor.busy(); }
+    MotorMoveStatus motorStatus() override { return motor.status(); }
+
+    RoomSim room;
+    MotorSim motor;
+};
@@ -0,0 +1,175 @@
+#include "../../controller/motor_impl.h"
+#include "../../controller/encoder.h"
+#include "../../controller/position_store.h"
+#include "../motortest/encoder_sim.h"
+
+// Зазор и проскальзывание тяги на модели привода: вал и створка связаны через зазор,
+// струбцина проскальзывает при открытии, упор закрытия стоит у створки.
+// 1) случайные перемещения после хоуминга: пересинхронизации сами выучивают зазор и
+//    проскальзывание, ошибка положения СТВОРКИ после обучения ограничена
+// 2) пересинхронизаций немного, в среднем каждая дешевле полного хоуминга из тех же положений
+// 3) выученное переживает перезагрузку через журнал
+
+const int MOVES = 1000;
+const float TRUE_BACKLASH_TICKS = 24.0f;
+const float TRUE_SLIP_OPEN = 0.004f;
+const float BACKLASH_ERROR_BUDGET_TICKS = 2.0f;
+const float SLIP_ERROR_BUDGET = 0.3f;                   // доля от истинного
+const long WINDOW_ERROR_BUDGET_TICKS = 10;
+const int LEARNING_RESYNCS = 2;                         // после стольких ошибку уже сравниваем с бюджетом
+const int HOMING_RUNS = 10;
+const unsigned long SETTLE_MS = 300;
+
+MockEncoder encoder(32767);
+MemoryPositionStorage storage;
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+void step_ms(unsigned long ms) {
+    encoder_simulation_update(micros());
+    motor_update();
+    position_store_update();
+    delay(ms);
+}
+
+void run_while_busy() {
+    while (is_motor_busy()) {
+        step_ms(1);
+    }
+    for (unsigned long i = 0; i < SETTLE_MS; i++) {
+        step_ms(1);
+    }
+}
+
+long window_error() {
+    return -get_simulated_window_ticks() - get_target_ticks();
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Backlash and slip test ===");
+    randomSeed(99);
+
+    MotorPlantConfig plant;
+    plant.hasEndStop = true;
+    plant.endStopTicks = 0;
+    plant.backlashTicks = TRUE_BACKLASH_TICKS;
+    plant.slipOpen = TRUE_SLIP_OPEN;
+    plant.loadDeadbandDuty = 30;
+    motor_set_encoder(&encoder);
+    motor_setup();
+    encoder_simulation_setup(plant, &encoder);
+    position_store_begin(&storage);
+
+    start_homing();
+    run_while_busy();
+    report(get_homing_result() == 0, "homing");
+
+    // 1) случайные перемещения
+    long maxErrorLearning = 0;
+    long maxErrorLearned = 0;
+    unsigned long resyncTotalMs = 0;
+    unsigned long resyncWorstMs = 0;
+    uint16_t resyncs = motor_get_calibration().resyncs;
+    for (int move = 0; move < MOVES; move++) {
+        if (random(0, 10) < 6) {
+            change_pos(random(0, 10));
+        } else {
+            move_to_percent(random(0, 1001) / 10.0f);
+        }
+        run_while_busy();
+
+        MotorCalibration calibration = motor_get_calibration();
+        if (calibration.resyncs != resyncs) {
+            resyncs = calibration.resyncs;
+            resyncTotalMs += get_resync_duration_ms();
+            if (get_resync_duration_ms() > resyncWorstMs) resyncWorstMs = get_resync_duration_ms();
+        }
+        long error = labs(window_error());
+        if (resyncs < LEARNING_RESYNCS) {
+            if (error > maxErrorLearning) maxErrorLearning = error;
+        } else if (error > maxErrorLearned) {
+            maxErrorLearned = error;
+        }
+    }
+
+    MotorCalibration learned = motor_get_calibration();
+    Serial.print("Learned backlash ");
+    Serial.print(learned.backlashTicks[0], 1);
+    Serial.print("/");
+    Serial.print(learned.backlashTicks[1], 1);
+    Serial.print(" ticks (true ");
+    Serial.print(TRUE_BACKLASH_TICKS, 1);
+    Serial.print("), slip ");
+    Serial.print(learned.slipPerTick * 100.0f, 3);
+    Serial.print("% (true ");
+    Serial.print(TRUE_SLIP_OPEN * 100.0f, 3);
+    Serial.println("%)");
+    Serial.print("Window error: ");
+    Serial.print(maxErrorLearning);
+    Serial.print(" ticks while learning, ");
+    Serial.print(maxErrorLearned);
+    Serial.println(" ticks after");
+    Serial.print("Resyncs: ");
+    Serial.print(learned.resyncs);
+    Serial.print(" in ");
+    Serial.print(MOVES);
+    Serial.print(" moves, mean ");
+    Serial.print(learned.resyncs > 0 ? resyncTotalMs / learned.resyncs : 0);
+    Serial.print(" ms, worst ");
+    Serial.print(resyncWorstMs);
+    Serial.println(" ms");
+
+    report(fabsf(learned.backlashTicks[0] - TRUE_BACKLASH_TICKS) <= BACKLASH_ERROR_BUDGET_TICKS &&
+           fabsf(learned.backlashTicks[1] - TRUE_BACKLASH_TICKS) <= BACKLASH_ERROR_BUDGET_TICKS, "backlash learned");
+    report(fabsf(learned.slipPerTick - TRUE_SLIP_OPEN) <= SLIP_ERROR_BUDGET * TRUE_SLIP_OPEN, "slip learned");
+    report(maxErrorLearned <= WINDOW_ERROR_BUDGET_TICKS, "window error bounded after learning");
+    report(learned.resyncs >= LEARNING_RESYNCS && learned.resyncs <= MOVES / 10, "resyncs are occasional");
+
+    // 2) для сравнения - полный хоуминг из случайных положений
+    unsigned long homingTotalMs = 0;
+    for (int run = 0; run < HOMING_RUNS; run++) {
+        change_pos(random(0, 10));
+        run_while_busy();
+        start_homing();
+        run_while_busy();
+        homingTotalMs += get_homing_duration_ms();
+    }
+    unsigned long resyncMeanMs = learned.resyncs > 0 ? resyncTotalMs / learned.resyncs : 0;
+    Serial.print("Full homing: mean ");
+    Serial.print(homingTotalMs / HOMING_RUNS);
+    Serial.println(" ms");
+    report(resyncMeanMs <= homingTotalMs / HOMING_RUNS, "resync cheaper than full homing");
+
+    // 3) перезагрузка: выученное - из журнала
+    change_pos(4);
+    run_while_busy();
+    for (unsigned long t = 0; t < POSITION_STORE_COMMIT_DELAY_MS + 1000; t += 100) {
+        step_ms(100);
+    }
+    encoder.write(0);
+    MotorCalibration blank = {};
+    motor_set_calibration(blank);
+    position_store_begin(&storage);
+    bool restored = position_store_restore();
+    run_while_busy();                               // пробный ход после восстановления
+    MotorCalibration reloaded = motor_get_calibration();
+    report(restored && reloaded.resyncs == learned.resyncs &&
+           reloaded.backlashTicks[0] == learned.backlashTicks[0] &&
+           reloaded.slipPerTick == learned.slipPerTick, "calibration persisted");
+    change_pos(7);
+    run_while_busy();
+    report(labs(window_error()) <= WINDOW_ERROR_BUDGET_TICKS, "window position right after reboot");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
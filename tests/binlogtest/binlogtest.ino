@@ -0,0 +1,199 @@
+#include "../../controller/binlog.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Двоичный журнал: запись в кольцо, кадры, декодер и цена записи.
+// 1) запись в кольцо и обратно в текст - как раньше печатал Serial.print
+// 2) кадры вперемешку с текстом: декодер отдает текст байт в байт и все записи; битый кадр пропускается
+// 3) кольцо полно - новые записи отбрасываются и считаются, старые не портятся
+// 4) уровень ниже BINLOG_LEVEL вырезан вместе с аргументами
+// 5) несколько писателей одновременно с читателем: ни потерь без учета, ни рваных записей
+// 6) цена записи
+
+const int PRODUCERS = 4;
+const uint32_t WRITES_PER_PRODUCER = 20000;
+const int COST_RUNS = 10000;
+const float COST_BUDGET_US = 5.0f;
+
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+void drain_all() {
+    BinlogRecord record;
+    while (binlog_take(record)) {
+    }
+}
+
+bool same_record(const BinlogRecord& a, const BinlogRecord& b) {
+    if (a.timestampUs != b.timestampUs || a.event != b.event || a.level != b.level || a.argCount != b.argCount) return false;
+    return memcmp(a.args, b.args, a.argCount * sizeof(uint32_t)) == 0;
+}
+
+bool text_is(const BinlogRecord& record, const char* expected) {
+    char line[160];
+    binlog_format_record(record, line, sizeof(line));
+    const char* text = strchr(line, ' ') + 3;       // без "[время] I "
+    if (strcmp(text, expected) == 0) return true;
+    Serial.print("  got: ");
+    Serial.println(line);
+    return false;
+}
+
+int sideEffects = 0;
+int side_effect() {
+    sideEffects++;
+    return 1;
+}
+
+// писатель: аргументы связаны между собой, рваная запись это покажет
+void producer(int id) {
+    for (uint32_t i = 0; i < WRITES_PER_PRODUCER; i++) {
+        BINLOG_INFO(MOVE_STALLED, id, i * 3 + id);
+        if (i % 16 == 0) std::this_thread::yield();     // на одном ядре иначе читатель не успевает
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Binary log test ===");
+    binlog_begin(BinlogOutput::BINARY, false);
+
+    // 1) текст
+    BINLOG_INFO(MOVE_TASK, 1, 255, 1200L, -35L, 1.5f);
+    BINLOG_INFO(DATA_COLLECTED, 4, 12.345f, 86400000UL);
+    BINLOG_WARN(MOVE_STALLED, 17L, 40L);
+    BinlogRecord move, data, stalled, none;
+    bool taken = binlog_take(move) && binlog_take(data) && binlog_take(stalled) && !binlog_take(none);
+    report(taken && text_is(move, "Move Task: dir=1, speed=255, target=1200 ticks (current: -35), profile=1.50s") &&
+           text_is(data, "Data collected: pos=4, metric=12.35, time=86400000") &&
+           text_is(stalled, "Move STALLED at 17 of 40 ticks") && stalled.level == BINLOG_LEVEL_WARN,
+           "records read back as the old Serial text");
+
+    // 2) поток: текст, кадр, текст, битый кадр, кадр
+    std::vector<uint8_t> stream;
+    const char* textA = "Motor STOPPED (direction preserved)\r\n";
+    const char* textB = "Датчики: ok\r\n";
+    uint8_t frame[BINLOG_FRAME_MAX];
+    stream.insert(stream.end(), textA, textA + strlen(textA));
+    size_t len = binlog_frame_encode(move, frame);
+    stream.insert(stream.end(), frame, frame + len);
+    stream.insert(stream.end(), textB, textB + strlen(textB));
+    len = binlog_frame_encode(data, frame);
+    frame[5] ^= 0x40;
+    stream.insert(stream.end(), frame, frame + len);
+    len = binlog_frame_encode(stalled, frame);
+    stream.insert(stream.end(), frame, frame + len);
+
+    BinlogFrameParser parser;
+    std::string text;
+    std::vector<BinlogRecord> records;
+    int bad = 0;
+    for (uint8_t byte : stream) {
+        switch (parser.feed(byte)) {
+            case BinlogFrameParser::TEXT: text += (char)byte; break;
+            case BinlogFrameParser::RECORD: records.push_back(parser.record()); break;
+            case BinlogFrameParser::BAD_FRAME: bad++; break;
+            case BinlogFrameParser::PENDING: break;
+        }
+    }
+    report(text == std::string(textA) + textB, "text around frames passes through unchanged");
+    report(records.size() == 2 && bad == 1 && same_record(records[0], move) &&
+           same_record(records[1], stalled), "frames decode exactly, a corrupted one is skipped");
+    report(len <= 3 + BINLOG_FRAME_HEADER + 4 * 2 + 1 && len < strlen("Move STALLED at 17 of 40 ticks\r\n"),
+           "a frame is shorter than its text");
+
+    // 3) переполнение
+    BinlogStats before = binlog_stats();
+    for (int i = 0; i < BINLOG_RING_RECORDS + 50; i++) {
+        BINLOG_INFO(MOVE_COMPLETED, i);
+    }
+    BinlogStats after = binlog_stats();
+    int kept = 0;
+    bool ordered = true;
+    BinlogRecord record;
+    while (binlog_take(record)) {
+        ordered &= record.args[0] == (uint32_t)kept;
+        kept++;
+    }
+    report(kept == BINLOG_RING_RECORDS && after.dropped - before.dropped == 50 && ordered,
+           "full ring drops new records and counts them");
+
+    // 4) уровни
+    BINLOG_DEBUG(MOVE_COMPLETED, side_effect());
+    BINLOG_ERROR(MOVE_COMPLETED, side_effect());
+    int logged = 0;
+    while (binlog_take(record)) {
+        logged++;
+    }
+    report(sideEffects == 1 && logged == 1, "levels below BINLOG_LEVEL are compiled out with their arguments");
+
+    // 5) несколько писателей и читатель
+    before = binlog_stats();
+    std::atomic<bool> producing(true);
+    uint32_t consumed = 0;
+    uint32_t lastSeen[PRODUCERS];
+    bool intact = true;
+    for (int i = 0; i < PRODUCERS; i++) {
+        lastSeen[i] = UINT32_MAX;
+    }
+    std::thread consumer([&]() {
+        BinlogRecord r;
+        while (true) {
+            bool done = !producing.load();        // до take: после него новых записей уже не будет
+            if (!binlog_take(r)) {
+                if (done) break;
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t id = r.args[0];
+            uint32_t seq = (r.args[1] - id) / 3;
+            intact &= id < (uint32_t)PRODUCERS && r.args[1] == seq * 3 + id && r.argCount == 2 &&
+                      (lastSeen[id] == UINT32_MAX || seq > lastSeen[id]);
+            if (id < (uint32_t)PRODUCERS) lastSeen[id] = seq;
+            consumed++;
+        }
+    });
+    std::vector<std::thread> producers;
+    for (int i = 0; i < PRODUCERS; i++) {
+        producers.emplace_back(producer, i);
+    }
+    for (std::thread& t : producers) {
+        t.join();
+    }
+    producing.store(false);
+    consumer.join();
+    after = binlog_stats();
+    uint32_t accounted = consumed + (after.dropped - before.dropped);
+    Serial.print("Concurrent: consumed ");
+    Serial.print(consumed);
+    Serial.print(", dropped ");
+    Serial.println(after.dropped - before.dropped);
+    report(intact, "concurrent records arrive whole and in per-writer order");
+    report(accounted == PRODUCERS * WRITES_PER_PRODUCER, "every concurrent record is consumed or counted as dropped");
+
+    // 6) цена записи
+    drain_all();
+    unsigned long start = micros();
+    for (int i = 0; i < COST_RUNS; i++) {
+        BINLOG_INFO(MOVE_TASK, 1, 255, 1200L, -35L, 1.5f);
+        if (i % 64 == 63) drain_all();
+    }
+    float costUs = (micros() - start) / (float)COST_RUNS;
+    Serial.print("Cost per event: ");
+    Serial.print(costUs, 2);
+    Serial.println(" us");
+    report(costUs <= COST_BUDGET_US, "hot-path logging costs a few microseconds");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
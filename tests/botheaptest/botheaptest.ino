@@ -0,0 +1,235 @@
+#include "../../controller/motor_impl.h"
+#include "../../controller/encoder.h"
+#include "../../controller/window_controller.h"
+#include "../../controller/tgbot.h"
+#include "../motortest/encoder_sim.h"
+#include "heap_model.h"
+#include <string.h>
+
+// Сутки команд из чата против подставного Bot API, куча - под замером.
+// Подставной сервер держит запрос и ответ в String: ответ живет до следующего запроса и
+// перемежается с выделениями бота. Все, что бот делает между вызовами сети (разбор
+// команды, сборка ответа), - "окно сборки", в нем куча трогаться не должна.
+// 1) в окне сборки ни одного выделения (на ESP32 - свободная куча до и после окна совпадает)
+// 2) минимум свободной кучи и самый большой свободный блок за сутки - в отчет
+// 3) на каждую команду ушел ответ, очереди не переполнялись
+//
+// На хосте сутки идут по виртуальным часам за секунды, на плате - по-настоящему.
+
+const char* ssid = "";
+const char* password = "";
+const char* BOT_TOKEN = "";
+std::vector<String> allowedUsers = { "1001" };
+
+const unsigned long SOAK_MS = 24UL * 3600UL * 1000UL;
+const unsigned long MESSAGE_EVERY_MS = 20000;
+const unsigned long SAMPLE_EVERY_MS = 60000;
+const unsigned long IDLE_STEP_MS = 50;              // мотор стоит - шаг цикла крупнее
+const int INBOX_LEN = 4;
+
+const char* SCRIPT[] = {
+    "/start",
+    "/status",
+    "/settings",
+    "/mode",
+    "/window",
+    "/perf",
+    "/mode_manual",
+    "/set_position 6",
+    "/set_temp_ideal 23.5",
+    "/set_co2_high 2400",
+    "/set_position 2",
+    "/set_mode auto",
+    "/set_position 4",
+    "/homing",
+    "/set_temp_ideal 22",
+    "/unknown",
+    "/mode_auto",
+};
+const int SCRIPT_LEN = sizeof(SCRIPT) / sizeof(SCRIPT[0]);
+
+// окно сборки: от возврата из сети до следующего обращения к ней
+bool inComposition = false;
+uint32_t compositionAllocations = 0;
+long compositionFreeDrift = 0;
+HeapStats compositionStart;
+
+void composition_begin() {
+    compositionStart = heap_stats();
+    inComposition = true;
+}
+
+void composition_end() {
+    if (!inComposition) return;
+    inComposition = false;
+    HeapStats now = heap_stats();
+    compositionAllocations += now.allocations - compositionStart.allocations;
+    compositionFreeDrift += (long)compositionStart.freeBytes - (long)now.freeBytes;
+}
+
+// подставной Bot API: тексты запросов и ответов - String, как в библиотеке
+class StandInBotApi : public BotTransport {
+public:
+    bool connect() override {
+        return true;
+    }
+
+    int poll(BotMessage* messages, int maxMessages, uint16_t waitS) override {
+        composition_end();
+        int count = 0;
+        lastResponse = "{\"ok\":true,\"result\":[";
+        while (count < maxMessages && pending > 0) {
+            const char* text = inbox[head];
+            head = (head + 1) % INBOX_LEN;
+            pending--;
+            lastResponse += String("{\"update_id\":") + String(++updateId) + ",\"message\":{\"chat\":{\"id\":1001},\"text\":\"" +
+                            text + "\"}}";
+            messages[count].chatId = "1001";
+            messages[count].text = text;
+            count++;
+        }
+        lastResponse += "]}";
+        composition_begin();
+        return count;
+    }
+
+    BotSendResult send(const char* chatId, const char* text, const char* parseMode, const char* replyMarkup) override {
+        composition_end();
+        String request = String("{\"chat_id\":\"") + chatId + "\",\"text\":\"" + text + "\",\"parse_mode\":\"" + parseMode + "\"}";
+        lastResponse = String("{\"ok\":true,\"result\":{\"message_id\":") + String(++messageId) + "}}";
+        sent++;
+        if (strstr(text, "System Status") != nullptr) statusReplies++;
+        if (strstr(text, "КАЛИБРОВКА") != nullptr) homingReplies++;
+        composition_begin();
+        return { request.length() > 0 ? BotSendStatus::SENT : BotSendStatus::FAILED, 0, (int32_t)messageId };
+    }
+
+    BotSendResult edit(const char* chatId, int32_t messageId, const char* text, const char* parseMode,
+                       const char* replyMarkup) override {
+        return send(chatId, text, parseMode, replyMarkup);
+    }
+
+    void answerCallback(const char* callbackId) override {
+    }
+
+    void push(const char* text) {
+        if (pending == INBOX_LEN) return;
+        inbox[(head + pending) % INBOX_LEN] = text;
+        pending++;
+    }
+
+    uint32_t sent = 0;
+    uint32_t statusReplies = 0;
+    uint32_t homingReplies = 0;
+
+private:
+    const char* inbox[INBOX_LEN];
+    int head = 0;
+    int pending = 0;
+    uint32_t updateId = 0;
+    uint32_t messageId = 0;
+    String lastResponse;
+};
+
+MockEncoder encoder(32767);
+WindowController windowController;
+StandInBotApi botApi;
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+void print_heap(const char* label, size_t bytes) {
+    Serial.print(label);
+    Serial.print(bytes);
+    Serial.println(" bytes");
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Telegram heap soak ===");
+
+    MotorPlantConfig plant;
+    plant.hasEndStop = true;
+    plant.endStopTicks = 0;
+    motor_set_encoder(&encoder);
+    motor_setup();
+    encoder_simulation_setup(plant, &encoder);
+
+    // бот без задачи: один поток, замеры кучи не перемешиваются с чужими выделениями
+    TelegramBot bot;
+    bot.init(&botApi, false);
+
+    HeapStats start = heap_stats();
+    size_t minLargestBlock = start.largestFreeBlock;
+    uint32_t commands = 0;
+    unsigned long begin = millis();
+    unsigned long nextMessageMs = begin;
+    unsigned long nextSampleMs = begin;
+
+    while (millis() - begin < SOAK_MS) {
+        if (millis() >= nextMessageMs) {
+            botApi.push(SCRIPT[commands % SCRIPT_LEN]);
+            commands++;
+            nextMessageMs += MESSAGE_EVERY_MS;
+        }
+
+        encoder_simulation_update(micros());
+        motor_update();
+        windowController.update();
+        bot.update(windowController);
+
+        composition_begin();
+        bot.pollOnce();
+        composition_end();
+
+        if (millis() >= nextSampleMs) {
+            HeapStats sample = heap_stats();
+            if (sample.largestFreeBlock < minLargestBlock) minLargestBlock = sample.largestFreeBlock;
+            nextSampleMs += SAMPLE_EVERY_MS;
+        }
+        delay(is_motor_busy() ? 1 : IDLE_STEP_MS);
+    }
+
+    // последняя команда могла не дождаться ответа
+    for (int i = 0; i < 200; i++) {
+        encoder_simulation_update(micros());
+        motor_update();
+        bot.update(windowController);
+        bot.pollOnce();
+        delay(IDLE_STEP_MS);
+    }
+
+    HeapStats end = heap_stats();
+    Serial.print("Commands: ");
+    Serial.print(commands);
+    Serial.print(", replies: ");
+    Serial.println(botApi.sent);
+    print_heap("Free heap at start: ", start.freeBytes);
+    print_heap("Minimum free heap: ", end.minFreeBytes);
+    print_heap("Largest free block at start: ", start.largestFreeBlock);
+    print_heap("Largest free block, worst: ", minLargestBlock);
+    print_heap("Largest free block at end: ", end.largestFreeBlock);
+    Serial.print("Allocations while composing: ");
+    Serial.println(compositionAllocations);
+
+    if (heap_counts_allocations()) {
+        report(compositionAllocations == 0, "composing replies makes no heap allocation");
+    } else {
+        report(compositionFreeDrift == 0, "composing replies leaves the heap as it was");
+    }
+    report(botApi.sent >= commands && botApi.statusReplies >= commands / SCRIPT_LEN &&
+           botApi.homingReplies >= commands / SCRIPT_LEN, "every command answered");
+    BotLinkStats link = bot_link_stats();
+    report(link.commandsDropped == 0 && link.repliesDropped == 0, "no queue overflow");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
@@ -0,0 +1 @@
+#include "../../controller/hal_esp32.cpp"
@@ -0,0 +1,126 @@
+#include "heap_model.h"
+
+#if defined(ESP32)
+
+#include <esp_heap_caps.h>
+
+HeapStats heap_stats() {
+    HeapStats stats;
+    stats.freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    stats.minFreeBytes = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    stats.largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    stats.allocations = 0;
+    return stats;
+}
+
+bool heap_counts_allocations() {
+    return false;
+}
+
+#else
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+// блоки идут подряд: заголовок, затем данные; свободные соседи сливаются при обходе
+struct BlockHeader {
+    size_t size;                    // вместе с заголовком
+    size_t used;
+};
+
+const size_t HEAP_ALIGN = 16;
+const size_t HEADER_SIZE = (sizeof(BlockHeader) + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
+
+alignas(HEAP_ALIGN) static unsigned char arena[HEAP_MODEL_BYTES];
+static bool ready = false;
+static size_t freeBytes = 0;
+static size_t minFreeBytes = 0;
+static uint32_t allocations = 0;
+
+static BlockHeader* block_at(size_t offset) {
+    return reinterpret_cast<BlockHeader*>(arena + offset);
+}
+
+static void heap_init() {
+    BlockHeader* first = block_at(0);
+    first->size = HEAP_MODEL_BYTES;
+    first->used = 0;
+    freeBytes = minFreeBytes = HEAP_MODEL_BYTES;
+    ready = true;
+}
+
+// свободный блок забирает всех свободных соседей справа
+static void merge_free(BlockHeader* block, size_t offset) {
+    while (offset + block->size < HEAP_MODEL_BYTES) {
+        BlockHeader* next = block_at(offset + block->size);
+        if (next->used) break;
+        block->size += next->size;
+    }
+}
+
+static void* heap_alloc(size_t size) {
+    if (!ready) heap_init();
+    size_t need = HEADER_SIZE + ((size + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1));
+
+    for (size_t offset = 0; offset < HEAP_MODEL_BYTES; offset += block_at(offset)->size) {
+        BlockHeader* block = block_at(offset);
+        if (block->used) continue;
+        merge_free(block, offset);
+        if (block->size < need) continue;
+
+        if (block->size - need >= HEADER_SIZE + HEAP_ALIGN) {
+            BlockHeader* rest = block_at(offset + need);
+            rest->size = block->size - need;
+            rest->used = 0;
+            block->size = need;
+        }
+        block->used = 1;
+        freeBytes -= block->size;
+        if (freeBytes < minFreeBytes) minFreeBytes = freeBytes;
+        allocations++;
+        return arena + offset + HEADER_SIZE;
+    }
+
+    fprintf(stderr, "heap model: out of memory (%zu bytes)\n", size);
+    abort();
+}
+
+static void heap_free(void* pointer) {
+    if (pointer == nullptr) return;
+    BlockHeader* block = reinterpret_cast<BlockHeader*>(static_cast<unsigned char*>(pointer) - HEADER_SIZE);
+    block->used = 0;
+    freeBytes += block->size;
+}
+
+HeapStats heap_stats() {
+    if (!ready) heap_init();
+    HeapStats stats;
+    stats.freeBytes = freeBytes;
+    stats.minFreeBytes = minFreeBytes;
+    stats.largestFreeBlock = 0;
+    for (size_t offset = 0; offset < HEAP_MODEL_BYTES; offset += block_at(offset)->size) {
+        BlockHeader* block = block_at(offset);
+        if (block->used) continue;
+        merge_free(block, offset);
+        size_t payload = block->size - HEADER_SIZE;
+        if (payload > stats.largestFreeBlock) stats.largestFreeBlock = payload;
+    }
+    stats.allocations = allocations;
+    return stats;
+}
+
+bool heap_counts_allocations() {
+    return true;
+}
+
+void* operator new(size_t size) { return heap_alloc(size); }
+void* operator new[](size_t size) { return heap_alloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return heap_alloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return heap_alloc(size); }
+void operator delete(void* pointer) noexcept { heap_free(pointer); }
+void operator delete[](void* pointer) noexcept { heap_free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { heap_free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { heap_free(pointer); }
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Куча для замеров: на ESP32 - настоящая (heap_caps), на хосте - модель first-fit на
+// HEAP_MODEL_BYTES с заголовком у каждого блока, как в куче ESP-IDF: через нее идут все
+// new/delete теста, поэтому минимум свободного и самый большой свободный блок считаются
+// так же, как на плате, а не по системному malloc.
+
+const size_t HEAP_MODEL_BYTES = 128 * 1024;         // свободная DRAM после WiFi и TLS - того же порядка
+
+struct HeapStats {
+    size_t freeBytes;
+    size_t minFreeBytes;            // минимум за все время
+    size_t largestFreeBlock;
+    uint32_t allocations;           // только на хосте: на ESP32 счетчика нет, всегда 0
+};
+
+HeapStats heap_stats();
+bool heap_counts_allocations();
@@ -0,0 +1 @@
+#include "../../controller/room_model.cpp"
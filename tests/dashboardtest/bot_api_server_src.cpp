@@ -0,0 +1 @@
+#include "../longpolltest/bot_api_server.cpp"
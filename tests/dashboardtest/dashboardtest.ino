@@ -0,0 +1,208 @@
+#include "../../controller/motor_impl.h"
+#include "../../controller/encoder.h"
+#include "../../controller/window_controller.h"
+#include "../../controller/tgbot.h"
+#include "../../controller/bot_api.h"
+#include "../motortest/encoder_sim.h"
+#include "../longpolltest/bot_api_server.h"
+#include <algorithm>
+
+// Панель /live против подставного сервера Bot API (bot_api_server.h). Комната медленно
+// теплеет, на 20-й минуте CO2 на пять минут выше критического (sensor_stub.cpp).
+// 1) как раньше: пользователь следит за комнатой через /status с той же свежестью, что
+//    дает панель (раз в BOT_DASHBOARD_MIN_EDIT_MS), режим и позицию меняет командами
+// 2) /live: одно сообщение правится на месте, режим и позиция - кнопками
+// Считаются сообщения в чат (sendMessage + editMessageText), исходящие вызовы (все, кроме
+// getUpdates: его long poll одинаков в обеих фазах) и записи в TLS.
+//
+// Время на хосте виртуальное: час идет за секунды.
+
+const char* ssid = "";
+const char* password = "";
+const char* BOT_TOKEN = "123:TEST";
+std::vector<String> allowedUsers = { "1001" };
+
+extern unsigned long room_start_ms;
+
+const unsigned long PHASE_MS = 3600UL * 1000UL;
+const unsigned long LOOP_STEP_MS = 10;
+const unsigned long FIRST_COMMAND_MS = 30000;
+
+struct Step {
+    unsigned long atMs;
+    const char* text;
+};
+
+// что пользователь делает руками в обеих фазах
+const Step CONTROLS[] = {
+    { 40UL * 60 * 1000, "/mode_manual" },
+    { 41UL * 60 * 1000, "/set_position 3" },
+    { 45UL * 60 * 1000, "/mode_auto" },
+};
+const int CONTROLS_LEN = sizeof(CONTROLS) / sizeof(CONTROLS[0]);
+
+class StandInTransport : public BotTransport {
+public:
+    explicit StandInTransport(StandInHttpsServer& server) : api(server, BOT_TOKEN) {}
+
+    bool connect() override {
+        return true;
+    }
+
+    int poll(BotMessage* messages, int maxMessages, uint16_t waitS) override {
+        return api.getUpdates(messages, maxMessages, waitS);
+    }
+
+    BotSendResult send(const char* chatId, const char* text, const char* parseMode, const char* replyMarkup) override {
+        return api.sendMessage(chatId, text, parseMode, replyMarkup);
+    }
+
+    BotSendResult edit(const char* chatId, int32_t messageId, const char* text, const char* parseMode,
+                       const char* replyMarkup) override {
+        return api.editMessageText(chatId, messageId, text, parseMode, replyMarkup);
+    }
+
+    void answerCallback(const char* callbackId) override {
+        api.answerCallbackQuery(callbackId);
+    }
+
+    BotApiClient api;
+};
+
+// тест ==========================================================================================================================//
+
+MockEncoder encoder(32767);
+WindowController windowController;
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+void arrive(StandInHttpsServer& server, unsigned long atMs, const char* text, bool button) {
+    Arrival arrival = { atMs, text, 0, button };
+    server.arrivals.push_back(arrival);
+}
+
+struct PhaseResult {
+    int messages;           // sendMessage + editMessageText в чат
+    int edits;
+    int calls;              // запросы, кроме getUpdates
+    int requests;
+    int writes;             // записи в TLS, всего
+    int callWrites;         // записи в TLS исходящих вызовов
+    int alerts;
+};
+
+PhaseResult run_phase(StandInHttpsServer& server, bool dashboard) {
+    StandInTransport transport(server);
+    TelegramBot bot;
+    bot.init(&transport, false);
+
+    unsigned long start = millis();
+    room_start_ms = start;
+    if (dashboard) {
+        arrive(server, start + FIRST_COMMAND_MS, "/live", false);
+    } else {
+        for (unsigned long at = FIRST_COMMAND_MS; at < PHASE_MS; at += BOT_DASHBOARD_MIN_EDIT_MS) {
+            arrive(server, start + at, "/status", false);
+        }
+    }
+    for (const Step& step : CONTROLS) {
+        arrive(server, start + step.atMs, step.text, dashboard);
+    }
+    // getUpdates отдает сообщения по порядку прихода
+    std::sort(server.arrivals.begin(), server.arrivals.end(),
+              [](const Arrival& a, const Arrival& b) { return a.atMs < b.atMs; });
+
+    while (millis() - start < PHASE_MS) {
+        encoder_simulation_update(micros());
+        motor_update();
+        windowController.update();
+        bot.update(windowController);
+        // на ESP32 бот живет на своем ядре; здесь long poll стоит на месте виртуального времени,
+        // поэтому пока едет мотор, опрос короткий
+        bot.pollOnce(0, is_motor_busy() ? 0 : BOT_LONG_POLL_S);
+        delay(LOOP_STEP_MS);
+    }
+
+    PhaseResult result = {};
+    result.messages = server.deliveredTo("1001");
+    result.edits = server.deliveredBy("editMessageText");
+    result.calls = server.requests - server.updateRequests;
+    result.requests = server.requests;
+    result.writes = server.writes;
+    result.callWrites = server.writes - server.updateRequests;     // запрос - одна запись
+    for (const Delivery& delivery : server.delivered) {
+        if (delivery.body.find("EMERGENCY!!!") != std::string::npos) result.alerts++;
+    }
+    return result;
+}
+
+void print_phase(const char* name, const PhaseResult& result) {
+    Serial.print(name);
+    Serial.print(": messages ");
+    Serial.print(result.messages);
+    Serial.print(" (edits ");
+    Serial.print(result.edits);
+    Serial.print(", alerts ");
+    Serial.print(result.alerts);
+    Serial.print("), calls ");
+    Serial.print(result.calls);
+    Serial.print(", requests ");
+    Serial.print(result.requests);
+    Serial.print(", TLS writes ");
+    Serial.println(result.writes);
+}
+
+bool edit_contains(const StandInHttpsServer& server, const char* fragment) {
+    for (const Delivery& delivery : server.delivered) {
+        if (delivery.method == "editMessageText" && delivery.body.find(fragment) != std::string::npos) return true;
+    }
+    return false;
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Telegram live dashboard test ===");
+
+    MotorPlantConfig plant;
+    plant.hasEndStop = true;
+    plant.endStopTicks = 0;
+    motor_set_encoder(&encoder);
+    motor_setup();
+    encoder_simulation_setup(plant, &encoder);
+
+    // 1) как раньше
+    StandInHttpsServer oldServer;
+    PhaseResult before = run_phase(oldServer, false);
+    print_phase("Polling /status", before);
+
+    // 2) панель
+    StandInHttpsServer server;
+    PhaseResult after = run_phase(server, true);
+    print_phase("Live dashboard", after);
+
+    report(after.messages * 10 <= before.messages, "messages per hour down by an order of magnitude");
+    report(after.calls * 10 <= before.calls, "outbound API calls per hour down by an order of magnitude");
+    report(after.callWrites * 10 <= before.callWrites, "outbound TLS writes per hour down by an order of magnitude");
+    report(after.writes == after.requests && before.writes == before.requests, "one TLS write per request");
+    report(server.deliveredBy("sendMessage") == 2 && server.sentContains("inline_keyboard"),
+           "one dashboard message with a keyboard, one alert");
+    report(after.alerts == 1 && before.alerts > 1, "alert repeats skipped for the dashboard chat");
+    report(edit_contains(server, "АВАРИЯ") && edit_contains(server, "MANUAL") && edit_contains(server, "Окно: 3/9"),
+           "edits follow the emergency, mode and position");
+    report(after.edits <= (int)(PHASE_MS / BOT_DASHBOARD_MIN_EDIT_MS) / 10, "edits only on real changes");
+    report(server.callbackAnswers == CONTROLS_LEN && !server.sentContains("Режим работы изменен") &&
+           windowController.getConfig().currentMode == WindowMode::AUTO,
+           "buttons answered and applied without extra messages");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
@@ -0,0 +1 @@
+#include "../../controller/profiler.cpp"
@@ -0,0 +1 @@
+#include "../../controller/scheduler.cpp"
@@ -0,0 +1,45 @@
+#include "../../controller/sensors.h"
+#include <Arduino.h>
+
+// датчики без железа: комната медленно теплеет, показания дрожат в пределах шума датчиков,
+// CO2 на пять минут подскакивает выше критического - авария
+
+unsigned long room_start_ms = 0;            // начало фазы теста
+
+const unsigned long CO2_SPIKE_FROM_MS = 20UL * 60 * 1000;
+const unsigned long CO2_SPIKE_TO_MS = 25UL * 60 * 1000;
+
+// шум в [-1, 1], постоянный в пределах секунды
+static float noise(uint32_t salt) {
+    uint32_t x = (millis() / 1000) * 2654435761UL + salt * 40503UL;
+    x ^= x >> 15;
+    x *= 2246822519UL;
+    x ^= x >> 13;
+    return (x % 2001) / 1000.0f - 1.0f;
+}
+
+static float hours() {
+    return (millis() - room_start_ms) / 3600000.0f;
+}
+
+float get_room_temp() { return 22.0f + 0.6f * hours() + 0.05f * noise(1); }
+float get_outside_temp() { return 15.0f - 0.8f * hours() + 0.05f * noise(2); }
+bool get_room_sensor_error() { return false; }
+bool get_outside_sensor_error() { return false; }
+
+int get_last_co2_ppm() {
+    unsigned long t = millis() - room_start_ms;
+    if (t >= CO2_SPIKE_FROM_MS && t < CO2_SPIKE_TO_MS) return 2100 + (int)(20 * noise(3));
+    return 650 + (int)(20 * noise(3));
+}
+
+bool get_co2_read_error() { return false; }
+
+// время показаний - как при опросе: температура раз в 5 с, CO2 раз в 10 с
+unsigned long get_temp_read_time() { return millis() / 5000 * 5000; }
+unsigned long get_last_co2_read_time() { return millis() / 10000 * 10000; }
+
+// режим питания: экрана и кнопок в тесте нет
+void sensors_set_slow_polling(bool slow) {}
+void OLED_screen_set_power(bool on) {}
+void buttons_enable_wakeup() {}
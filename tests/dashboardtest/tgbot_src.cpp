@@ -0,0 +1 @@
+#include "../../controller/tgbot.cpp"
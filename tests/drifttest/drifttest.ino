@@ -0,0 +1,113 @@
+#include "../../controller/motor_impl.h"
+#include "../../controller/encoder.h"
+#include "../motortest/encoder_sim.h"
+
+// Долгий прогон случайных перемещений без хоуминга: уровни change_pos(), проценты
+// move_to_percent() и перенацеливание посреди хода на модели привода, у которой от задачи
+// к задаче плавают усиление и выбег. Ошибка положения вала относительно цели должна
+// оставаться ограниченной - каждая задача считается от фактического счета энкодера.
+// Для сравнения копим сумму остатков: так дрейфовал бы прежний относительный счет позиций.
+
+const int MOVES = 3000;
+const int REPORT_WINDOW = 500;
+const long POSITION_ERROR_BUDGET_TICKS = 12;          // 3% шага позиции
+const unsigned long SETTLE_MS = 300;
+
+MockEncoder encoder(32767);
+MotorPlantConfig plant;
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+void step_ms() {
+    encoder_simulation_update(micros());
+    motor_update();
+    delay(1);
+}
+
+void randomize_plant() {
+    MotorPlantConfig config = plant;
+    config.ticksPerSecPerDuty = plant.ticksPerSecPerDuty * random(85, 116) / 100.0f;
+    config.coastTau = plant.coastTau * random(70, 131) / 100.0f;
+    encoder_simulation_reconfigure(config);
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Position drift test ===");
+    randomSeed(1234);
+
+    motor_set_encoder(&encoder);
+    motor_setup();
+    encoder_simulation_setup(plant, &encoder);
+
+    long maxError = 0;
+    long windowMax = 0;
+    long relativeDrift = 0;             // сумма остатков - ошибка относительного счета
+    long maxRelativeDrift = 0;
+
+    for (int move = 0; move < MOVES; move++) {
+        randomize_plant();
+
+        int kind = random(0, 10);
+        if (kind < 6) {
+            change_pos(random(0, 10));
+        } else {
+            move_to_percent(random(0, 1001) / 10.0f);
+        }
+
+        // каждая десятая задача перенацеливается на полпути
+        if (kind == 9) {
+            for (int i = 0; i < 150 && is_motor_busy(); i++) {
+                step_ms();
+            }
+            change_pos(random(0, 10));
+        }
+
+        while (is_motor_busy()) {
+            step_ms();
+        }
+        for (unsigned long i = 0; i < SETTLE_MS; i++) {
+            step_ms();
+        }
+
+        long error = -get_simulated_shaft_ticks() - get_target_ticks();
+        relativeDrift += error;
+        if (labs(relativeDrift) > maxRelativeDrift) maxRelativeDrift = labs(relativeDrift);
+        if (labs(error) > maxError) maxError = labs(error);
+        if (labs(error) > windowMax) windowMax = labs(error);
+
+        if ((move + 1) % REPORT_WINDOW == 0) {
+            Serial.print("Moves ");
+            Serial.print(move + 1 - REPORT_WINDOW);
+            Serial.print("..");
+            Serial.print(move);
+            Serial.print(": max error ");
+            Serial.print(windowMax);
+            Serial.print(" ticks, relative accounting drift ");
+            Serial.println(relativeDrift);
+            windowMax = 0;
+        }
+    }
+
+    Serial.print("Max position error over ");
+    Serial.print(MOVES);
+    Serial.print(" moves: ");
+    Serial.print(maxError);
+    Serial.print(" ticks (relative accounting would reach ");
+    Serial.print(maxRelativeDrift);
+    Serial.println(" ticks)");
+    report(maxError <= POSITION_ERROR_BUDGET_TICKS, "position error bounded");
+    report(labs(-get_simulated_shaft_ticks() - get_position_ticks()) <= 3, "encoder agrees with shaft");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
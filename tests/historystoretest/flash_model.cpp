@@ -0,0 +1,57 @@
+#include <Arduino.h>
+#include "flash_model.h"
+#include <string.h>
+
+bool FlashModel::begin() {
+    return !lost;
+}
+
+size_t FlashModel::size(HistoryFile file) {
+    return lost ? 0 : files[(int)file].size();
+}
+
+bool FlashModel::read(HistoryFile file, size_t offset, void* data, size_t length) {
+    const std::vector<uint8_t>& bytes = files[(int)file];
+    if (lost || offset + length > bytes.size()) return false;
+    memcpy(data, bytes.data() + offset, length);
+    delayMicroseconds(length * readUsPerKB / 1024);
+    return true;
+}
+
+bool FlashModel::write(HistoryFile file, const void* data, size_t length) {
+    if (lost) return false;
+    files[(int)file].clear();
+    return put(file, static_cast<const uint8_t*>(data), length);
+}
+
+bool FlashModel::append(HistoryFile file, const void* data, size_t length) {
+    if (lost) return false;
+    return put(file, static_cast<const uint8_t*>(data), length);
+}
+
+bool FlashModel::remove(HistoryFile file) {
+    if (lost) return false;
+    files[(int)file].clear();
+    writeOps++;
+    return true;
+}
+
+void FlashModel::powerBack() {
+    lost = false;
+    cutAfterBytes = -1;
+}
+
+bool FlashModel::put(HistoryFile file, const uint8_t* data, size_t length) {
+    size_t written = length;
+    if (cutAfterBytes >= 0 && (long)length > cutAfterBytes) {
+        written = cutAfterBytes;
+        lost = true;
+    }
+    if (cutAfterBytes >= 0) cutAfterBytes -= written;
+
+    files[(int)file].insert(files[(int)file].end(), data, data + written);
+    bytesWritten += written;
+    writeOps++;
+    delayMicroseconds(written * writeUsPerKB / 1024);
+    return !lost;
+}
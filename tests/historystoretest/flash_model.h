@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../controller/history_store.h"
+#include <vector>
+
+// Flash в памяти для history_store.h: файлы - векторы байт, время чтения и записи - через
+// delayMicroseconds() (на хосте виртуальное) по скоростям LittleFS на ESP32 с запасом.
+// Пропадание питания: после cutAfterBytes записанных байт запись обрывается на полуслове,
+// все дальнейшие операции не проходят до powerBack(). write() при этом уже успел обрезать
+// файл - хуже, чем LittleFS, который держит старое содержимое до закрытия файла.
+
+class FlashModel : public HistoryStorage {
+public:
+    unsigned long readUsPerKB = 2000;           // 0.5 МБ/с
+    unsigned long writeUsPerKB = 20000;         // 50 КБ/с со стиранием
+    long cutAfterBytes = -1;                    // -1 - питание не пропадает
+
+    bool begin() override;
+    size_t size(HistoryFile file) override;
+    bool read(HistoryFile file, size_t offset, void* data, size_t length) override;
+    bool write(HistoryFile file, const void* data, size_t length) override;
+    bool append(HistoryFile file, const void* data, size_t length) override;
+    bool remove(HistoryFile file) override;
+
+    void powerBack();
+    bool powerLost() const { return lost; }
+
+    unsigned long bytesWritten = 0;             // всего, для износа
+    unsigned long writeOps = 0;
+
+private:
+    bool put(HistoryFile file, const uint8_t* data, size_t length);
+
+    std::vector<uint8_t> files[3];
+    bool lost = false;
+};
@@ -0,0 +1 @@
+#include "../../controller/hal.cpp"
@@ -0,0 +1 @@
+#include "../../controller/history_store.cpp"
@@ -0,0 +1,300 @@
+#include "../../controller/history_store.h"
+#include "flash_model.h"
+#include <math.h>
+#include <vector>
+
+// Журнал выученной истории (history_store.h) на модели flash (flash_model.h):
+// 1) чистая перезагрузка - истории те же, что до нее, со сдвигом часов
+// 2) загрузка при полном журнале за снимком укладывается в бюджет
+// 3) износ: байт и операций записи в сутки
+// 4) пока едет мотор, flash не пишется; отложенное уходит с первым замером после остановки
+// 5) питание пропадает на случайном байте записи: после загрузки истории - ровно такие, какими
+//    были после какого-то замера, не раньше последней завершенной пачки; следующие замеры после
+//    такой загрузки тоже переживают перезагрузку
+//
+// Время на хосте виртуальное, чтение и запись flash стоят времени по модели.
+
+const int POSITIONS = 10;
+const unsigned long MINUTE_MS = 60000UL;
+const unsigned long HOUR_MS = 3600000UL;
+const unsigned long BOOT_MS = 1500;
+const unsigned long RESTORE_BUDGET_MS = 50;
+const unsigned long BYTES_PER_DAY_BUDGET = 100UL * 1024UL;
+const int BASE_RECORDS = 400;                   // до сессии со сбоем: снимок и журнал за ним
+const int SESSION_RECORDS = 420;                // в сессии есть и пачки, и свертка
+const int AFTER_CRASH_RECORDS = 30;
+const int CRASH_RUNS = 200;
+const float MATCH_TOLERANCE = 1e-5f;
+
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+// замеры ========================================================================================================================//
+
+// окно стоит в позиции 20-40 минут, потом сдвигается на одну-две
+struct SampleSource {
+    uint32_t state;
+    int position;
+    int left;
+
+    uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    void sample(int& p, float& metric) {
+        if (left-- <= 0) {
+            int step = (int)(next() % 5) - 2;           // constrain() - макрос, next() только раз
+            position = constrain(position + step, 0, POSITIONS - 1);
+            left = 20 + next() % 20;
+        }
+        p = position;
+        metric = (next() % 10000) / 100.0f;
+    }
+};
+
+struct Fingerprint {
+    float weight[POSITIONS];
+    float metric[POSITIONS];
+    float weightLater[POSITIONS];
+};
+
+Fingerprint fingerprint(const PositionHistory* histories, unsigned long now) {
+    Fingerprint print;
+    for (int p = 0; p < POSITIONS; p++) {
+        print.weight[p] = histories[p].getTotalWeight(now);
+        print.metric[p] = histories[p].getWeightedMetric(now);
+        print.weightLater[p] = histories[p].getTotalWeight(now + 2 * HOUR_MS);
+    }
+    return print;
+}
+
+bool close(float a, float b) {
+    return fabsf(a - b) <= MATCH_TOLERANCE * fmaxf(1.0f, fabsf(b));
+}
+
+bool same(const Fingerprint& a, const Fingerprint& b) {
+    for (int p = 0; p < POSITIONS; p++) {
+        if (!close(a.weight[p], b.weight[p]) || !close(a.metric[p], b.metric[p]) ||
+            !close(a.weightLater[p], b.weightLater[p])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Замер в минуту, как WindowController::collectData()
+ * @param prints отпечаток историй после каждого замера
+ * @param durable сколько замеров уже точно во flash (пачка или снимок записаны целиком)
+ * @return сколько замеров успело пройти до пропадания питания
+ */
+int feed(PositionHistory* histories, FlashModel& flash, SampleSource& source, int count,
+         std::vector<Fingerprint>* prints = nullptr, int* durable = nullptr) {
+    for (int i = 0; i < count; i++) {
+        delay(MINUTE_MS);
+        int position;
+        float metric;
+        source.sample(position, metric);
+        HistoryStoreStats before = history_store_stats();
+        histories[position].addRecord(metric, millis());
+        history_store_record(position, metric, millis());
+        if (flash.powerLost()) return i;
+
+        if (prints != nullptr) prints->push_back(fingerprint(histories, millis()));
+        HistoryStoreStats after = history_store_stats();
+        if (durable != nullptr && (after.flushes != before.flushes || after.compactions != before.compactions)) {
+            *durable = i + 1;
+        }
+    }
+    return count;
+}
+
+PositionHistory live[POSITIONS];
+PositionHistory restored[POSITIONS];
+
+void reboot(PositionHistory* histories, FlashModel& flash) {
+    flash.powerBack();
+    delay(BOOT_MS);
+    history_store_begin(histories, POSITIONS, &flash);
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== History store test ===");
+    randomSeed(20);
+
+    // 1) чистая перезагрузка после суток работы
+    unsigned long worstRestoreMs = 0;
+    {
+        FlashModel flash;
+        SampleSource source = { 1, 5, 0 };
+        history_store_begin(live, POSITIONS, &flash);
+        feed(live, flash, source, 24 * 60);
+        history_store_flush();
+        Fingerprint before = fingerprint(live, millis());
+
+        reboot(restored, flash);
+        worstRestoreMs = max(worstRestoreMs, history_store_stats().restoreMs);
+        report(history_store_stats().restored && same(fingerprint(restored, millis()), before),
+               "clean reboot restores the learned histories");
+    }
+
+    // 2) загрузка: снимок и полный журнал за ним
+    {
+        FlashModel flash;
+        SampleSource source = { 2, 5, 0 };
+        history_store_begin(live, POSITIONS, &flash);
+        feed(live, flash, source, 2 * HISTORY_STORE_COMPACT_RECORDS + HISTORY_STORE_BATCH);
+        reboot(restored, flash);
+        HistoryStoreStats stats = history_store_stats();
+        worstRestoreMs = max(worstRestoreMs, stats.restoreMs);
+        Serial.print("Restore with a full log: ");
+        Serial.print(stats.restoredRecords);
+        Serial.print(" log records, ");
+        Serial.print(stats.restoreMs);
+        Serial.println(" ms");
+        report(stats.restoredRecords == HISTORY_STORE_COMPACT_RECORDS && stats.restoreMs <= RESTORE_BUDGET_MS,
+               "worst-case restore within 50 ms");
+    }
+
+    // 3) износ за сутки
+    {
+        FlashModel flash;
+        SampleSource source = { 3, 5, 0 };
+        history_store_begin(live, POSITIONS, &flash);
+        feed(live, flash, source, 24 * 60);
+        Serial.print("Flash per day: ");
+        Serial.print(flash.bytesWritten);
+        Serial.print(" B in ");
+        Serial.print(flash.writeOps);
+        Serial.print(" writes (");
+        Serial.print(history_store_stats().flushes);
+        Serial.print(" log batches, ");
+        Serial.print(history_store_stats().compactions);
+        Serial.print(" snapshots); a snapshot per sample would be ");
+        Serial.print((unsigned long)(24 * 60 * (sizeof(HistorySnapshotHeader) + sizeof(live))));
+        Serial.println(" B");
+        report(flash.bytesWritten <= BYTES_PER_DAY_BUDGET, "under 100 KB written per day");
+    }
+
+    // 4) мотор едет
+    {
+        FlashModel flash;
+        SampleSource source = { 5, 5, 0 };
+        history_store_begin(live, POSITIONS, &flash);
+        unsigned long start = flash.bytesWritten;
+        for (int i = 0; i < 2 * HISTORY_STORE_BATCH; i++) {
+            delay(MINUTE_MS);
+            int position;
+            float metric;
+            source.sample(position, metric);
+            live[position].addRecord(metric, millis());
+            history_store_record(position, metric, millis(), true);
+        }
+        bool deferred = flash.bytesWritten == start;
+        feed(live, flash, source, 1);
+        bool written = flash.bytesWritten > start;
+        Fingerprint before = fingerprint(live, millis());
+        reboot(restored, flash);
+        report(deferred && written && same(fingerprint(restored, millis()), before),
+               "writes wait while the motor moves and catch up after it stops");
+    }
+
+    // 5) питание пропадает посреди записи
+    FlashModel base;
+    static PositionHistory baseLive[POSITIONS];
+    SampleSource baseSource = { 4, 5, 0 };
+    history_store_begin(baseLive, POSITIONS, &base);
+    feed(baseLive, base, baseSource, BASE_RECORDS);
+    history_store_flush();
+
+    // сколько байт пишет сессия без сбоя
+    unsigned long sessionBytes;
+    {
+        FlashModel flash = base;
+        SampleSource source = baseSource;
+        history_store_begin(live, POSITIONS, &flash);
+        unsigned long start = flash.bytesWritten;
+        feed(live, flash, source, SESSION_RECORDS);
+        sessionBytes = flash.bytesWritten - start;
+    }
+
+    int consistent = 0;
+    int kept = 0;
+    int lostRecords = 0;
+    for (int run = 0; run < CRASH_RUNS; run++) {
+        FlashModel flash = base;
+        SampleSource source = baseSource;
+        history_store_begin(live, POSITIONS, &flash);
+
+        std::vector<Fingerprint> prints;
+        prints.push_back(fingerprint(live, millis()));
+        int durable = 0;
+        flash.cutAfterBytes = random(sessionBytes);
+        int fed = feed(live, flash, source, SESSION_RECORDS, &prints, &durable);
+
+        reboot(restored, flash);
+        worstRestoreMs = max(worstRestoreMs, history_store_stats().restoreMs);
+        Fingerprint after = fingerprint(restored, millis());
+        int match = -1;
+        for (int j = fed; j >= durable; j--) {
+            if (same(after, prints[j])) {
+                match = j;
+                break;
+            }
+        }
+        if (match < 0) {
+            Serial.print("Run ");
+            Serial.print(run);
+            Serial.print(": cut at byte ");
+            Serial.print(flash.cutAfterBytes);
+            Serial.print(", fed ");
+            Serial.print(fed);
+            Serial.print(", durable ");
+            Serial.print(durable);
+            Serial.println(" - restored state matches no sample");
+            continue;
+        }
+        consistent++;
+        lostRecords = max(lostRecords, fed - match);
+
+        // после такой загрузки новое тоже должно сохраняться
+        feed(restored, flash, source, AFTER_CRASH_RECORDS);
+        history_store_flush();
+        Fingerprint beforeReboot = fingerprint(restored, millis());
+        reboot(live, flash);
+        if (same(fingerprint(live, millis()), beforeReboot)) kept++;
+    }
+    Serial.print("Crash runs: ");
+    Serial.print(consistent);
+    Serial.print("/");
+    Serial.print(CRASH_RUNS);
+    Serial.print(" consistent, ");
+    Serial.print(kept);
+    Serial.print(" kept later samples, at most ");
+    Serial.print(lostRecords);
+    Serial.print(" samples lost (batch ");
+    Serial.print(HISTORY_STORE_BATCH);
+    Serial.println(")");
+    report(consistent == CRASH_RUNS, "power loss mid-write restores a consistent prefix, never older than the last batch");
+    report(kept == CRASH_RUNS, "samples after a crash restore survive the next reboot");
+    report(lostRecords <= HISTORY_STORE_BATCH, "at most one batch lost");
+
+    Serial.print("Worst restore: ");
+    Serial.print(worstRestoreMs);
+    Serial.println(" ms");
+    report(worstRestoreMs <= RESTORE_BUDGET_MS, "every restore within 50 ms");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
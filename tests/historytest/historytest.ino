@@ -0,0 +1,226 @@
+#include "../../controller/position_history.h"
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+// История позиции (position_history.h): ярусы с нарастающими суммами против прямого пересчета
+// exp(-возраст) по всем сырым замерам.
+// 1) равенство: случайные истории - подряд, с перерывами на часы и сутки, со слиянием в
+//    корзины, вытеснением и переносом опоры, запросы сразу и спустя время; расхождение -
+//    только округление метрики и веса корзин
+// 2) последние два замера для тренда - как были
+// 3) память: 10 позиций не больше прежних 180 записей по 8 байт, а охват - дни вместо 3 ч
+// 4) бенчмарк: выбор позиции (findBestPosition) - оба запроса по всем 10 позициям, против
+//    прежнего пересчета по 180 записям
+//
+// На хосте собирать с реальным временем, иначе micros() виртуальные.
+
+const int POSITIONS = 10;
+const int OLD_HISTORY_SIZE = 180;               // прежнее кольцо MetricRecord
+const int HISTORIES = 200;
+const int RECORDS_PER_HISTORY = 1200;
+const unsigned long MINUTE_MS = 60000UL;
+const unsigned long HOUR_MS = 3600000UL;
+const float WEIGHT_TOLERANCE = 1e-3f;           // относительная
+const float METRIC_TOLERANCE = 0.01f;           // метрика 0..100
+const unsigned long COVERAGE_MIN_MS = 72UL * HOUR_MS;
+const int BENCH_DECISIONS = 2000;
+const float BENCH_MIN_SPEEDUP = 10.0f;
+
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+// прямой пересчет, как было до нарастающих сумм =================================================================================//
+
+float brute_weighted_metric(const std::vector<MetricRecord>& records, unsigned long currentTime) {
+    if (records.empty()) return -1.0f;
+
+    float sumMetric = 0.0f;
+    float sumWeight = 0.0f;
+    for (const MetricRecord& record : records) {
+        float ageHours = (currentTime - record.timestamp) / 3600000.0f;
+        float weight = exp(-ageHours);
+        sumMetric += record.metric * weight;
+        sumWeight += weight;
+    }
+    return (sumWeight >= POSITION_HISTORY_MIN_WEIGHT) ? (sumMetric / sumWeight) : -1.0f;
+}
+
+float brute_total_weight(const std::vector<MetricRecord>& records, unsigned long currentTime) {
+    float totalWeight = 0.0f;
+    for (const MetricRecord& record : records) {
+        float ageHours = (currentTime - record.timestamp) / 3600000.0f;
+        totalWeight += exp(-ageHours);
+    }
+    return totalWeight;
+}
+
+// равенство =====================================================================================================================//
+
+float worstWeightError = 0.0f;
+float worstMetricError = 0.0f;
+
+bool same_answers(const PositionHistory& history, const std::vector<MetricRecord>& records, unsigned long currentTime) {
+    float weight = history.getTotalWeight(currentTime);
+    float expectedWeight = brute_total_weight(records, currentTime);
+    float weightError = fabsf(weight - expectedWeight) / fmaxf(expectedWeight, 1e-6f);
+    // исчезающе малые веса: важно лишь, что обе стороны ниже порога
+    if (expectedWeight < 1e-6f) weightError = (weight < POSITION_HISTORY_MIN_WEIGHT) ? 0.0f : 1.0f;
+    worstWeightError = fmaxf(worstWeightError, weightError);
+
+    float metric = history.getWeightedMetric(currentTime);
+    float expectedMetric = brute_weighted_metric(records, currentTime);
+    bool bothMissing = metric < 0.0f && expectedMetric < 0.0f;
+    // у самого порога округление может решить по-разному
+    bool atThreshold = fabsf(expectedWeight - POSITION_HISTORY_MIN_WEIGHT) < POSITION_HISTORY_MIN_WEIGHT * WEIGHT_TOLERANCE;
+    float metricError = (bothMissing || atThreshold) ? 0.0f : fabsf(metric - expectedMetric);
+    worstMetricError = fmaxf(worstMetricError, metricError);
+
+    return weightError <= WEIGHT_TOLERANCE && metricError <= METRIC_TOLERANCE;
+}
+
+// окно стоит в позиции от минут до часов, потом уходит на время от минуты до двух суток
+unsigned long next_gap_ms() {
+    if (random(100) < 85) return MINUTE_MS;
+    if (random(100) < 70) return (1 + random(180)) * MINUTE_MS;
+    return (3 + random(45)) * HOUR_MS;
+}
+
+// bench =========================================================================================================================//
+
+std::vector<MetricRecord> benchRecords[POSITIONS];
+PositionHistory benchHistories[POSITIONS];
+
+void fill_bench_histories(unsigned long now) {
+    for (int p = 0; p < POSITIONS; p++) {
+        benchRecords[p].clear();
+        benchHistories[p] = PositionHistory();
+        for (int i = 0; i < OLD_HISTORY_SIZE; i++) {
+            unsigned long at = now - (unsigned long)(OLD_HISTORY_SIZE - i) * MINUTE_MS * (p + 1);
+            float metric = random(1000) / 10.0f;
+            benchRecords[p].push_back({ metric, at });
+            benchHistories[p].addRecord(metric, at);
+        }
+    }
+}
+
+volatile float benchSink;
+
+unsigned long bench_decisions(bool brute, unsigned long now) {
+    unsigned long start = micros();
+    for (int decision = 0; decision < BENCH_DECISIONS; decision++) {
+        unsigned long at = now + decision * 1000UL;
+        float acc = 0.0f;
+        for (int p = 0; p < POSITIONS; p++) {
+            if (brute) {
+                acc += brute_weighted_metric(benchRecords[p], at) + brute_total_weight(benchRecords[p], at);
+            } else {
+                acc += benchHistories[p].getWeightedMetric(at) + benchHistories[p].getTotalWeight(at);
+            }
+        }
+        benchSink = acc;
+    }
+    return micros() - start;
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Position history test ===");
+    randomSeed(18);
+
+    // 1) равенство
+    bool allSame = true;
+    bool latestSame = true;
+    int queries = 0;
+    static PositionHistory history;
+    std::vector<MetricRecord> records;
+    for (int h = 0; h < HISTORIES; h++) {
+        history = PositionHistory();
+        records.clear();
+        // часть историй - через переполнение millis()
+        unsigned long now = (h % 4 == 0) ? 0xFFFFFFFFUL - 30UL * MINUTE_MS : 1000UL + random(100000);
+        for (int i = 0; i < RECORDS_PER_HISTORY; i++) {
+            float metric = random(1000) / 10.0f;
+            history.addRecord(metric, now);
+            records.push_back({ metric, now });
+            if (random(10) == 0) {
+                allSame &= same_answers(history, records, now);
+                allSame &= same_answers(history, records, now + random(12) * HOUR_MS);
+                queries += 2;
+            }
+
+            // 2) последние два замера
+            MetricRecord last;
+            MetricRecord prev;
+            if (history.latest(last, prev)) {
+                const MetricRecord& wantLast = records[records.size() - 1];
+                const MetricRecord& wantPrev = records[records.size() - 2];
+                latestSame &= fabsf(last.metric - wantLast.metric) < 0.006f &&
+                              labs((long)(last.timestamp - wantLast.timestamp)) <= 500;
+                latestSame &= fabsf(prev.metric - wantPrev.metric) < 0.006f &&
+                              labs((long)(prev.timestamp - wantPrev.timestamp)) <= 500;
+            }
+            now += next_gap_ms();
+        }
+    }
+    Serial.print("Queries ");
+    Serial.print(queries);
+    Serial.print(", worst weight error ");
+    Serial.print(worstWeightError * 1e6f, 1);
+    Serial.print(" ppm, worst metric error ");
+    Serial.println(worstMetricError, 6);
+    report(allSame, "compact history matches the brute-force weights and metric over all samples");
+    report(latestSame, "last two samples for the trend are kept");
+
+    // 3) память и охват: неделя подряд в одной позиции, последний ярус переполняется
+    history = PositionHistory();
+    records.clear();
+    unsigned long now = 1000;
+    bool longSame = true;
+    for (int i = 0; i < 7 * 24 * 60; i++, now += MINUTE_MS) {
+        float metric = random(1000) / 10.0f;
+        history.addRecord(metric, now);
+        records.push_back({ metric, now });
+        if (i % 97 == 0) longSame &= same_answers(history, records, now);
+    }
+    now -= MINUTE_MS;
+    unsigned long covered = now - history.oldestMs();
+    size_t ram = POSITIONS * sizeof(PositionHistory);
+    size_t oldRam = POSITIONS * OLD_HISTORY_SIZE * (sizeof(float) + sizeof(uint32_t));
+    Serial.print("RAM for 10 positions: ");
+    Serial.print((int)ram);
+    Serial.print(" B (was ");
+    Serial.print((int)oldRam);
+    Serial.print(" B), covers ");
+    Serial.print(covered / (float)HOUR_MS, 1);
+    Serial.println(" h of samples (was 3 h)");
+    report(ram <= oldRam, "no more RAM than the 180-record ring");
+    report(covered >= COVERAGE_MIN_MS, "days of samples per position");
+    report(longSame, "still matches the brute force once the coarsest tier is full");
+
+    // 4) бенчмарк
+    now = 100UL * HOUR_MS;
+    fill_bench_histories(now);
+    unsigned long bruteUs = bench_decisions(true, now);
+    unsigned long runningUs = bench_decisions(false, now);
+    float speedup = bruteUs / (float)max(runningUs, 1UL);
+    Serial.print("Decision (10 positions, both queries): brute force ");
+    Serial.print(bruteUs / (float)BENCH_DECISIONS, 2);
+    Serial.print(" us, running sums ");
+    Serial.print(runningUs / (float)BENCH_DECISIONS, 3);
+    Serial.print(" us, x");
+    Serial.println(speedup, 1);
+    report(speedup >= BENCH_MIN_SPEEDUP, "position choice at least 10x faster");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
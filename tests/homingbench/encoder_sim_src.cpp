@@ -0,0 +1 @@
+#include "../motortest/encoder_sim.cpp"
@@ -0,0 +1,145 @@
+#include "../../controller/motor_impl.h"
+#include "../../controller/encoder.h"
+#include "../motortest/encoder_sim.h"
+
+// Бенчмарк хоуминга на модели привода с двумя упорами и уплотнителем:
+// 1) быстрый двухфазный хоуминг из случайных положений - длительность и повторяемость нуля
+// 2) хоуминг с замером хода - ошибка измеренного хода
+// Для сравнения: прежний хоуминг только на фиксированных задержках (2 с разгона, 3 пропуска
+// по 100 мс, 200 + 300 + 300 мс подтверждений) тратил больше 3 с даже стоя у упора.
+
+const int QUICK_RUNS = 20;
+const int TRAVEL_RUNS = 5;
+const long TRUE_TRAVEL_TICKS = 4030;                    // реальный ход, не совпадает с MAX_MOTOR_POS
+const unsigned long QUICK_HOMING_BUDGET_MS = 1500;      // из полностью открытого положения
+const long ZERO_SPREAD_BUDGET_TICKS = 2;
+const long TRAVEL_ERROR_BUDGET_TICKS = 5;
+const unsigned long RUN_TIMEOUT_MS = 40000;
+
+MockEncoder encoder(32767);
+MotorPlantConfig plant;
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+// шаги модели и мотора, пока идет хоуминг или движение
+bool run_while_busy() {
+    unsigned long start = millis();
+    while (is_motor_busy()) {
+        encoder_simulation_update(micros());
+        motor_update();
+        delay(1);
+        if (millis() - start > RUN_TIMEOUT_MS) {
+            return false;
+        }
+    }
+    // ждем выбега
+    for (int i = 0; i < 300; i++) {
+        encoder_simulation_update(micros());
+        delay(1);
+    }
+    return true;
+}
+
+// уплотнитель и мотор от прогона к прогону немного разные
+void randomize_plant() {
+    MotorPlantConfig config = plant;
+    config.ticksPerSecPerDuty = plant.ticksPerSecPerDuty * random(90, 111) / 100.0f;
+    config.sealTicksPerVelocity = plant.sealTicksPerVelocity * random(80, 121) / 100.0f;
+    config.sealTicksPerDuty = plant.sealTicksPerDuty * random(80, 121) / 100.0f;
+    encoder_simulation_reconfigure(config);
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Homing benchmark ===");
+    randomSeed(42);
+
+    plant.hasEndStop = true;
+    plant.endStopTicks = 0;
+    plant.hasOpenStop = true;
+    plant.openStopTicks = -TRUE_TRAVEL_TICKS;
+    plant.sealTicksPerVelocity = 0.003f;
+    plant.sealTicksPerDuty = 0.01f;
+    plant.sealSetFraction = 0.3f;
+
+    motor_set_encoder(&encoder);
+    motor_setup();
+    encoder_simulation_setup(plant, &encoder);
+
+    // 1) быстрый хоуминг
+    unsigned long totalMs = 0;
+    unsigned long worstMs = 0;
+    unsigned long fromOpenMs = 0;
+    long minOffset = LONG_MAX;
+    long maxOffset = LONG_MIN;
+    bool allOk = true;
+    for (int run = 0; run < QUICK_RUNS; run++) {
+        randomize_plant();
+        int startPos = (run == 0) ? 9 : random(0, 10);
+        change_pos(startPos);
+        run_while_busy();
+
+        start_homing();
+        allOk &= run_while_busy() && get_homing_result() == 0;
+
+        unsigned long duration = get_homing_duration_ms();
+        totalMs += duration;
+        if (duration > worstMs) worstMs = duration;
+        if (run == 0) fromOpenMs = duration;
+
+        // где оказался ноль энкодера относительно настоящего упора
+        long offset = get_simulated_shaft_ticks() - get_encoder() - plant.endStopTicks;
+        if (offset < minOffset) minOffset = offset;
+        if (offset > maxOffset) maxOffset = offset;
+    }
+    Serial.print("Quick homing: mean ");
+    Serial.print(totalMs / QUICK_RUNS);
+    Serial.print(" ms, worst ");
+    Serial.print(worstMs);
+    Serial.print(" ms, from fully open ");
+    Serial.print(fromOpenMs);
+    Serial.print(" ms; zero offset ");
+    Serial.print(minOffset);
+    Serial.print("..");
+    Serial.print(maxOffset);
+    Serial.println(" ticks");
+    report(allOk, "quick homing succeeded on every run");
+    report(fromOpenMs <= QUICK_HOMING_BUDGET_MS, "quick homing time from fully open");
+    report(maxOffset - minOffset <= ZERO_SPREAD_BUDGET_TICKS, "zero repeatability");
+
+    // 2) хоуминг с замером хода
+    long worstTravelError = 0;
+    allOk = true;
+    for (int run = 0; run < TRAVEL_RUNS; run++) {
+        randomize_plant();
+        change_pos(random(0, 10));
+        run_while_busy();
+
+        start_homing(true);
+        allOk &= run_while_busy() && get_homing_result() == 0 && get_current_position_index() == 9;
+
+        long error = labs(get_travel_ticks() - TRUE_TRAVEL_TICKS);
+        if (error > worstTravelError) worstTravelError = error;
+        Serial.print("Travel run ");
+        Serial.print(run);
+        Serial.print(": measured ");
+        Serial.print(get_travel_ticks());
+        Serial.print(" ticks in ");
+        Serial.print(get_homing_duration_ms());
+        Serial.println(" ms");
+    }
+    report(allOk, "travel measurement succeeded and ended at position 9");
+    report(worstTravelError <= TRAVEL_ERROR_BUDGET_TICKS, "measured travel accuracy");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
@@ -0,0 +1 @@
+#include "../../controller/motion_profile.cpp"
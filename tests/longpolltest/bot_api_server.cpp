@@ -0,0 +1,295 @@
+#include <Arduino.h>
+#include "bot_api_server.h"
+#include <string.h>
+
+static long json_number(const std::string& body, const char* key) {
+    size_t at = body.find(key);
+    return (at != std::string::npos) ? atol(body.c_str() + at + strlen(key)) : 0;
+}
+
+static std::string json_string(const std::string& body, const char* key) {
+    size_t at = body.find(key);
+    if (at == std::string::npos) return "";
+    at += strlen(key);
+    size_t end = body.find('"', at);
+    return body.substr(at, end - at);
+}
+
+// Telegram пишет не-ASCII как \uXXXX, вне BMP - суррогатной парой
+static void add_json_string(std::string& out, const std::string& text) {
+    out += '"';
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = text[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c < 0x80) {
+            out += c;
+        } else {
+            int extra = (c >= 0xF0) ? 3 : (c >= 0xE0) ? 2 : 1;
+            uint32_t code = c & (0x3F >> extra);
+            for (int k = 0; k < extra; k++) code = (code << 6) | (text[++i] & 0x3F);
+            char escaped[16];
+            if (code >= 0x10000) {
+                code -= 0x10000;
+                snprintf(escaped, sizeof(escaped), "\\u%04x\\u%04x", 0xD800 + (code >> 10), 0xDC00 + (code & 0x3FF));
+            } else {
+                snprintf(escaped, sizeof(escaped), "\\u%04x", code);
+            }
+            out += escaped;
+        }
+    }
+    out += '"';
+}
+
+// соединение =====================================================================================================================//
+
+bool StandInHttpsServer::open(const char* host, uint16_t port) {
+    delay(handshakeMs);
+    if (unavailable()) return false;
+    handshakes++;
+    isOpen = true;
+    servedOnConnection = 0;
+    inbound.clear();
+    pending.clear();
+    pendingUpdates = false;
+    return true;
+}
+
+bool StandInHttpsServer::connected() {
+    checkDrop();
+    return isOpen;
+}
+
+void StandInHttpsServer::close() {
+    isOpen = false;
+    pending.clear();
+    pendingUpdates = false;
+}
+
+bool StandInHttpsServer::write(const char* data, size_t length) {
+    checkDrop();
+    if (!isOpen) return false;
+    writes++;
+    inbound.append(data, length);
+    size_t headersEnd = inbound.find("\r\n\r\n");
+    if (headersEnd == std::string::npos) return true;
+    size_t lengthAt = inbound.find("Content-Length: ");
+    size_t contentLength = (lengthAt != std::string::npos) ? atol(inbound.c_str() + lengthAt + 16) : 0;
+    if (inbound.size() < headersEnd + 4 + contentLength) return true;
+
+    std::string head = inbound.substr(0, headersEnd);
+    std::string body = inbound.substr(headersEnd + 4, contentLength);
+    inbound.erase(0, headersEnd + 4 + contentLength);
+    handle(head, body);
+    return true;
+}
+
+int StandInHttpsServer::read(char* buffer, size_t size, uint32_t timeoutMs) {
+    checkDrop();
+    if (!isOpen) return -1;
+    if (pending.empty() && !pendingUpdates) {
+        delay(timeoutMs);
+        return 0;
+    }
+
+    // getUpdates отвечает, когда пришло сообщение или вышел timeout
+    unsigned long readyAt = pendingReadyAt;
+    if (pendingUpdates) {
+        const Arrival* next = nextArrival(pendingOffset);
+        if (next != nullptr && next->atMs + rttMs / 2 < readyAt) {
+            readyAt = max(next->atMs, pendingRequestMs + rttMs / 2) + rttMs / 2;
+        }
+    }
+    if (readyAt > millis()) {
+        if (readyAt - millis() > timeoutMs) {
+            delay(timeoutMs);
+            checkDrop();
+            return isOpen ? 0 : -1;
+        }
+        delay(readyAt - millis());
+        checkDrop();
+        if (!isOpen) return -1;
+    }
+    if (pendingUpdates) {
+        pendingUpdates = false;
+        pending = updatesResponse(pendingOffset);
+    }
+
+    size_t n = min(size, pending.size());
+    memcpy(buffer, pending.data(), n);
+    pending.erase(0, n);
+    if (pending.empty() && closeAfterPending) {
+        closeAfterPending = false;
+        isOpen = false;
+    }
+    return (int)n;
+}
+
+bool StandInHttpsServer::unavailable() const {
+    return millis() >= outageFromMs && millis() < outageToMs;
+}
+
+void StandInHttpsServer::checkDrop() {
+    if (dropAtMs != 0 && millis() >= dropAtMs) {
+        dropAtMs = 0;
+        isOpen = false;
+    }
+    if (unavailable()) isOpen = false;
+}
+
+// Bot API =======================================================================================================================//
+
+const Arrival* StandInHttpsServer::nextArrival(long offset) const {
+    size_t index = (offset > FIRST_UPDATE_ID) ? offset - FIRST_UPDATE_ID : 0;
+    return (index < arrivals.size()) ? &arrivals[index] : nullptr;
+}
+
+std::string StandInHttpsServer::updatesResponse(long offset) {
+    std::string json = "{\"ok\":true,\"result\":[";
+    size_t first = (offset > FIRST_UPDATE_ID) ? offset - FIRST_UPDATE_ID : 0;
+    int count = 0;
+    for (size_t i = first; i < arrivals.size() && arrivals[i].atMs <= millis() && count < BOT_API_UPDATES_LIMIT; i++, count++) {
+        if (count > 0) json += ",";
+        json += "{\"update_id\":" + std::to_string(FIRST_UPDATE_ID + i);
+        if (arrivals[i].button) {
+            // кнопка под первым сообщением бота
+            json += ",\"callback_query\":{\"id\":\"" + std::to_string(880000 + i) + "\"" +
+                    ",\"from\":{\"id\":1001,\"is_bot\":false,\"first_name\":\"Test\"}" +
+                    ",\"message\":{\"message_id\":1,\"chat\":{\"id\":1001,\"type\":\"private\"}" +
+                    ",\"date\":1700000000,\"text\":\"panel\"},\"chat_instance\":\"-42\",\"data\":";
+            add_json_string(json, arrivals[i].text);
+            json += "}}";
+            continue;
+        }
+        json += ",\"message\":{\"message_id\":" + std::to_string(i + 1) +
+                ",\"from\":{\"id\":1001,\"is_bot\":false,\"first_name\":\"Test\"}" +
+                ",\"chat\":{\"id\":1001,\"first_name\":\"Test\",\"type\":\"private\"}" +
+                ",\"date\":1700000000,\"text\":";
+        add_json_string(json, arrivals[i].text);
+        json += "}}";
+    }
+    json += "]}";
+    return httpResponse(200, json);
+}
+
+std::string StandInHttpsServer::httpResponse(int status, const std::string& json) {
+    servedOnConnection++;
+    bool closing = closeEveryResponse || servedOnConnection >= keepaliveRequests;
+    closeAfterPending = closing;
+    const char* reason = (status == 200) ? "OK" : (status == 429) ? "Too Many Requests" : "Not Found";
+    return "HTTP/1.1 " + std::to_string(status) + " " + reason +
+           "\r\nServer: nginx\r\nContent-Type: application/json\r\nContent-Length: " +
+           std::to_string(json.size()) + "\r\nConnection: " + (closing ? "close" : "keep-alive") + "\r\n\r\n" + json;
+}
+
+bool StandInHttpsServer::takeToken(float& tokens, unsigned long& updatedMs, float rate, float burst) {
+    if (rate <= 0.0f) return true;
+    if (tokens < 0.0f) {
+        tokens = burst;
+        updatedMs = millis();
+    }
+    tokens = min(burst, tokens + (millis() - updatedMs) * rate / 1000.0f);
+    updatedMs = millis();
+    if (tokens < 1.0f) return false;
+    tokens -= 1.0f;
+    return true;
+}
+
+void StandInHttpsServer::handle(const std::string& head, const std::string& body) {
+    requests++;
+    pendingReadyAt = millis() + rttMs;
+    if (head.find("/getUpdates ") != std::string::npos) {
+        updateRequests++;
+        pendingUpdates = true;
+        pendingOffset = json_number(body, "\"offset\":");
+        pendingRequestMs = millis();
+        pendingReadyAt += json_number(body, "\"timeout\":") * 1000UL;
+        return;
+    }
+    if (head.find("/sendMessage ") != std::string::npos) {
+        handleSend("sendMessage", body);
+        return;
+    }
+    if (head.find("/editMessageText ") != std::string::npos) {
+        handleSend("editMessageText", body);
+        return;
+    }
+    if (head.find("/answerCallbackQuery ") != std::string::npos) {
+        callbackAnswers++;
+        for (Arrival& arrival : arrivals) {
+            if (arrival.button && arrival.answeredMs == 0 && arrival.atMs <= millis()) {
+                arrival.answeredMs = millis() + rttMs / 2;
+                break;
+            }
+        }
+        pending = httpResponse(200, "{\"ok\":true,\"result\":true}");
+        return;
+    }
+    pending = httpResponse(404, "{\"ok\":false,\"error_code\":404,\"description\":\"Not Found\"}");
+}
+
+void StandInHttpsServer::handleSend(const std::string& method, const std::string& body) {
+    if (failNextSends > 0) {
+        failNextSends--;
+        isOpen = false;
+        return;
+    }
+
+    std::string chatId = json_string(body, "\"chat_id\":\"");
+    ChatLimit* chat = nullptr;
+    for (ChatLimit& known : chats) {
+        if (known.chatId == chatId) chat = &known;
+    }
+    if (chat == nullptr) {
+        chats.push_back(ChatLimit{ chatId, -1.0f, 0, 0 });
+        chat = &chats.back();
+    }
+
+    if (millis() < chat->blockedUntilMs) ignoredRetryAfter++;
+    bool allowed = millis() >= chat->blockedUntilMs &&
+                   takeToken(chat->tokens, chat->updatedMs, chatRatePerS, chatBurst) &&
+                   takeToken(globalTokens, globalUpdatedMs, globalRatePerS, globalBurst);
+    if (!allowed) {
+        tooManyRequests++;
+        chat->blockedUntilMs = millis() + retryAfterS * 1000UL;
+        pending = httpResponse(429, "{\"ok\":false,\"error_code\":429,\"description\":\"Too Many Requests: retry after " +
+                                    std::to_string(retryAfterS) + "\",\"parameters\":{\"retry_after\":" +
+                                    std::to_string(retryAfterS) + "}}");
+        return;
+    }
+
+    delivered.push_back(Delivery{ millis(), chatId, method, body });
+    // ответ - первой отправке после сообщения
+    for (Arrival& arrival : arrivals) {
+        if (!arrival.button && arrival.answeredMs == 0 && arrival.atMs <= millis()) {
+            arrival.answeredMs = millis() + rttMs / 2;
+            break;
+        }
+    }
+    long messageId = (method == "editMessageText") ? json_number(body, "\"message_id\":") : (long)delivered.size();
+    pending = httpResponse(200, "{\"ok\":true,\"result\":{\"message_id\":" + std::to_string(messageId) + "}}");
+}
+
+bool StandInHttpsServer::sentContains(const char* fragment) const {
+    for (const Delivery& delivery : delivered) {
+        if (delivery.body.find(fragment) != std::string::npos) return true;
+    }
+    return false;
+}
+
+int StandInHttpsServer::deliveredTo(const char* chatId) const {
+    int count = 0;
+    for (const Delivery& delivery : delivered) {
+        if (delivery.chatId == chatId) count++;
+    }
+    return count;
+}
+
+int StandInHttpsServer::deliveredBy(const char* method) const {
+    int count = 0;
+    for (const Delivery& delivery : delivered) {
+        if (delivery.method == method) count++;
+    }
+    return count;
+}
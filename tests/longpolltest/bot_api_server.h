@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../../controller/bot_api.h"
+#include <string>
+#include <vector>
+
+// Подставной HTTPS-сервер Bot API для BotApiClient: разбирает HTTP-запросы, держит getUpdates
+// до timeout, считает рукопожатия TLS (каждый open()) и запросы. Время сети - через delay():
+// на хосте виртуальное, на плате настоящее.
+// Лимиты как у Telegram: сообщения в один чат и всего - корзинами токенов; превышение -
+// 429 с parameters.retry_after, запрос в чат раньше этого срока считается нарушением.
+// Обрыв соединения и недоступность сервера задаются по времени.
+
+struct Arrival {
+    unsigned long atMs;
+    std::string text;               // у кнопки - callback_data
+    unsigned long answeredMs;       // 0 - ответа еще не было
+    bool button;                    // нажатие кнопки (callback_query), а не сообщение
+};
+
+struct Delivery {
+    unsigned long atMs;
+    std::string chatId;
+    std::string method;             // sendMessage или editMessageText
+    std::string body;
+};
+
+class StandInHttpsServer : public BotSocket {
+public:
+    // сеть
+    unsigned long rttMs = 100;
+    unsigned long handshakeMs = 1200;           // ECDHE и проверка цепочки на ESP32
+    int keepaliveRequests = 100;                // после стольких ответов соединение закрывается
+    bool closeEveryResponse = false;
+    unsigned long dropAtMs = 0;                 // молча оборвать соединение в этот момент
+    unsigned long outageFromMs = 0;             // сервер недоступен
+    unsigned long outageToMs = 0;
+    int failNextSends = 0;                      // столько sendMessage подряд - обрыв вместо ответа
+
+    // лимиты, 0 - без лимита
+    float chatRatePerS = 0.0f;
+    float chatBurst = 1.0f;
+    float globalRatePerS = 0.0f;
+    float globalBurst = 30.0f;
+    unsigned long retryAfterS = 3;
+
+    // что видел сервер
+    int handshakes = 0;
+    int requests = 0;
+    int updateRequests = 0;                     // из них getUpdates
+    int writes = 0;                             // вызовов write() - записей TLS
+    int callbackAnswers = 0;
+    int tooManyRequests = 0;                    // ответов 429
+    int ignoredRetryAfter = 0;                  // запросов в чат до истечения retry_after
+    std::vector<Arrival> arrivals;              // входящие сообщения чата 1001 для getUpdates
+    std::vector<Delivery> delivered;            // принятые sendMessage и editMessageText
+
+    bool open(const char* host, uint16_t port) override;
+    bool connected() override;
+    void close() override;
+    bool write(const char* data, size_t length) override;
+    int read(char* buffer, size_t size, uint32_t timeoutMs) override;
+
+    bool sentContains(const char* fragment) const;
+    int deliveredTo(const char* chatId) const;
+    int deliveredBy(const char* method) const;
+
+private:
+    struct ChatLimit {
+        std::string chatId;
+        float tokens;
+        unsigned long updatedMs;
+        unsigned long blockedUntilMs;
+    };
+
+    bool unavailable() const;
+    void checkDrop();
+    const Arrival* nextArrival(long offset) const;
+    std::string updatesResponse(long offset);
+    std::string httpResponse(int status, const std::string& json);
+    bool takeToken(float& tokens, unsigned long& updatedMs, float rate, float burst);
+    void handle(const std::string& head, const std::string& body);
+    void handleSend(const std::string& method, const std::string& body);
+
+    static const long FIRST_UPDATE_ID = 5000;
+    bool isOpen = false;
+    int servedOnConnection = 0;
+    std::string inbound;
+    std::string pending;
+    bool pendingUpdates = false;                // getUpdates ждет сообщений, ответ соберется к pendingReadyAt
+    long pendingOffset = 0;
+    unsigned long pendingRequestMs = 0;
+    unsigned long pendingReadyAt = 0;
+    bool closeAfterPending = false;
+    std::vector<ChatLimit> chats;
+    float globalTokens = -1.0f;
+    unsigned long globalUpdatedMs = 0;
+};
@@ -0,0 +1 @@
+#include "../../controller/bot_link.cpp"
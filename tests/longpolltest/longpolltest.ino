@@ -0,0 +1,220 @@
+#include "../../controller/motor_impl.h"
+#include "../../controller/encoder.h"
+#include "../../controller/window_controller.h"
+#include "../../controller/tgbot.h"
+#include "../../controller/bot_api.h"
+#include "../motortest/encoder_sim.h"
+#include "bot_api_server.h"
+#include <algorithm>
+
+// Бот и BotApiClient против подставного HTTPS-сервера Bot API (bot_api_server.h): он держит
+// getUpdates до timeout и считает рукопожатия TLS.
+// 0) разбор getUpdates: текст в \uXXXX и суррогатных парах, offset
+// 1) как раньше: короткий опрос раз в секунду, сервер закрывает соединение после ответа
+// 2) long poll по постоянному соединению: задержка команда -> ответ и рукопожатия в час
+// 3) соединение молча оборвано, потом сервер полминуты недоступен - бот переподключается,
+//    на все команды ответ пришел
+//
+// Время на хосте виртуальное: час идет за доли секунды.
+
+const char* ssid = "";
+const char* password = "";
+const char* BOT_TOKEN = "123:TEST";
+std::vector<String> allowedUsers = { "1001" };
+
+const unsigned long PHASE_MS = 3600UL * 1000UL;
+const unsigned long MESSAGE_EVERY_MS = 90000;
+const unsigned long LATENCY_BUDGET_MS = 300;
+const unsigned long LOOP_STEP_MS = 10;
+
+const char* SCRIPT[] = {
+    "/status",
+    "/mode_manual",
+    "/set_position 3",
+    "/set_temp_ideal 23.5",
+    "/window",
+    "/mode_auto",
+};
+const int SCRIPT_LEN = sizeof(SCRIPT) / sizeof(SCRIPT[0]);
+
+// транспорт бота поверх BotApiClient - как на ESP32, только сокет подставной
+class StandInTransport : public BotTransport {
+public:
+    explicit StandInTransport(StandInHttpsServer& server) : api(server, BOT_TOKEN) {}
+
+    bool connect() override {
+        return true;
+    }
+
+    int poll(BotMessage* messages, int maxMessages, uint16_t waitS) override {
+        return api.getUpdates(messages, maxMessages, waitS);
+    }
+
+    BotSendResult send(const char* chatId, const char* text, const char* parseMode, const char* replyMarkup) override {
+        return api.sendMessage(chatId, text, parseMode, replyMarkup);
+    }
+
+    BotSendResult edit(const char* chatId, int32_t messageId, const char* text, const char* parseMode,
+                       const char* replyMarkup) override {
+        return api.editMessageText(chatId, messageId, text, parseMode, replyMarkup);
+    }
+
+    void answerCallback(const char* callbackId) override {
+        api.answerCallbackQuery(callbackId);
+    }
+
+    BotApiClient api;
+};
+
+// тест ==========================================================================================================================//
+
+MockEncoder encoder(32767);
+WindowController windowController;
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+// сообщения через MESSAGE_EVERY_MS со сдвигом, чтобы не попадать в такт опроса
+void schedule(StandInHttpsServer& server, unsigned long fromMs, unsigned long durationMs) {
+    uint32_t jitter = 12345;
+    int index = 0;
+    for (unsigned long at = fromMs + 5000; at < fromMs + durationMs - 10000; at += MESSAGE_EVERY_MS) {
+        jitter = jitter * 1103515245 + 12345;
+        Arrival arrival = { at + (jitter >> 16) % 5000, SCRIPT[index++ % SCRIPT_LEN], 0 };
+        server.arrivals.push_back(arrival);
+    }
+}
+
+struct PhaseResult {
+    int handshakes;
+    int requests;
+    int commands;
+    int answered;
+    unsigned long meanLatencyMs;
+    unsigned long p95LatencyMs;
+    unsigned long maxLatencyMs;
+};
+
+PhaseResult run_phase(StandInHttpsServer& server, uint16_t longPollS, unsigned long durationMs) {
+    StandInTransport transport(server);
+    TelegramBot bot;
+    bot.init(&transport, false);
+
+    unsigned long start = millis();
+    schedule(server, start, durationMs);
+    while (millis() - start < durationMs) {
+        encoder_simulation_update(micros());
+        motor_update();
+        windowController.update();
+        bot.update(windowController);
+        bot.pollOnce(0, longPollS);
+        delay(LOOP_STEP_MS);
+    }
+
+    PhaseResult result = {};
+    result.handshakes = server.handshakes;
+    result.requests = server.requests;
+    unsigned long totalMs = 0;
+    std::vector<unsigned long> latencies;
+    for (const Arrival& arrival : server.arrivals) {
+        result.commands++;
+        if (arrival.answeredMs == 0) continue;
+        result.answered++;
+        latencies.push_back(arrival.answeredMs - arrival.atMs);
+        totalMs += latencies.back();
+    }
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        result.meanLatencyMs = totalMs / latencies.size();
+        result.p95LatencyMs = latencies[(latencies.size() * 95) / 100];
+        result.maxLatencyMs = latencies.back();
+    }
+    return result;
+}
+
+void print_phase(const char* name, const PhaseResult& result) {
+    Serial.print(name);
+    Serial.print(": handshakes ");
+    Serial.print(result.handshakes);
+    Serial.print(", requests ");
+    Serial.print(result.requests);
+    Serial.print(", answered ");
+    Serial.print(result.answered);
+    Serial.print("/");
+    Serial.print(result.commands);
+    Serial.print(", latency mean ");
+    Serial.print(result.meanLatencyMs);
+    Serial.print(" ms, p95 ");
+    Serial.print(result.p95LatencyMs);
+    Serial.print(" ms, max ");
+    Serial.print(result.maxLatencyMs);
+    Serial.println(" ms");
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Telegram long poll test ===");
+
+    MotorPlantConfig plant;
+    plant.hasEndStop = true;
+    plant.endStopTicks = 0;
+    motor_set_encoder(&encoder);
+    motor_setup();
+    encoder_simulation_setup(plant, &encoder);
+
+    // 0) разбор ответа getUpdates
+    {
+        StandInHttpsServer server;
+        BotApiClient api(server, BOT_TOKEN);
+        Arrival greeting = { 0, "Привет 👋 \"бот\"", 0 };
+        server.arrivals.push_back(greeting);
+        BotMessage messages[BOT_API_UPDATES_LIMIT];
+        int count = api.getUpdates(messages, BOT_API_UPDATES_LIMIT, 0);
+        report(count == 1 && messages[0].chatId == "1001" && messages[0].text == "Привет 👋 \"бот\"",
+               "getUpdates decodes chat id and escaped UTF-8 text");
+        report(api.getUpdates(messages, BOT_API_UPDATES_LIMIT, 0) == 0, "offset acknowledges received updates");
+        report(api.sendMessage("1001", "a\"b\nc", "Markdown").status == BotSendStatus::SENT &&
+                   server.sentContains("\"text\":\"a\\\"b\\nc\""),
+               "sendMessage escapes text into JSON");
+    }
+
+    // 1) как раньше
+    StandInHttpsServer oldServer;
+    oldServer.closeEveryResponse = true;
+    PhaseResult before = run_phase(oldServer, 0, PHASE_MS);
+    print_phase("Short poll, new connection per request", before);
+
+    // 2) long poll
+    StandInHttpsServer server;
+    PhaseResult after = run_phase(server, BOT_LONG_POLL_S, PHASE_MS);
+    print_phase("Long poll, persistent connection", after);
+
+    report(before.answered == before.commands && after.answered == after.commands, "every command answered");
+    // хуже бюджета - только команда, пришедшая, пока сервер менял соединение (рукопожатие)
+    report(after.p95LatencyMs < LATENCY_BUDGET_MS, "command-to-reply latency below budget");
+    report(after.maxLatencyMs < server.handshakeMs + LATENCY_BUDGET_MS, "worst case is one handshake");
+    report(after.meanLatencyMs * 10 < before.meanLatencyMs, "latency well below the short-poll baseline");
+    report(after.handshakes * 100 <= before.handshakes, "handshakes per hour down by two orders of magnitude");
+    report(server.sentContains("=== System Status ===\\nTemperature"), "status reply sent as escaped JSON");
+
+    // 3) обрыв и недоступность сервера
+    StandInHttpsServer flakyServer;
+    flakyServer.dropAtMs = millis() + 200000;
+    flakyServer.outageFromMs = millis() + 360000;         // на него приходится команда
+    flakyServer.outageToMs = flakyServer.outageFromMs + 30000;
+    PhaseResult flaky = run_phase(flakyServer, BOT_LONG_POLL_S, 600000);
+    print_phase("Dropped connection and outage", flaky);
+    report(flaky.answered == flaky.commands, "commands answered across a drop and an outage");
+    report(flaky.handshakes >= 3 && flaky.handshakes <= 6, "reconnected without a handshake storm");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
@@ -0,0 +1 @@
+#include "../../controller/message_builder.cpp"
@@ -0,0 +1 @@
+#include "../../controller/position_history.cpp"
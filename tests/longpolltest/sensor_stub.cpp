@@ -0,0 +1,20 @@
+#include <Arduino.h>
+#include "../../controller/sensors.h"
+
+// датчики без железа: комната в норме, аварий нет
+
+float get_room_temp() { return 22.0f; }
+float get_outside_temp() { return 15.0f; }
+bool get_room_sensor_error() { return false; }
+bool get_outside_sensor_error() { return false; }
+int get_last_co2_ppm() { return 600; }
+bool get_co2_read_error() { return false; }
+
+// время показаний - как при опросе: температура раз в 5 с, CO2 раз в 10 с
+unsigned long get_temp_read_time() { return millis() / 5000 * 5000; }
+unsigned long get_last_co2_read_time() { return millis() / 10000 * 10000; }
+
+// режим питания: экрана и кнопок в тесте нет
+void sensors_set_slow_polling(bool slow) {}
+void OLED_screen_set_power(bool on) {}
+void buttons_enable_wakeup() {}
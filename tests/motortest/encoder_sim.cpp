@@ -0,0 +1,155 @@
+#include "encoder_sim.h"
+#include <Arduino.h>
+#include "../../controller/motor_impl.h"
+#include "../../controller/encoder_sampler.h"
+
+static MotorPlantConfig plant;
+static MockEncoder* mock_encoder = nullptr;
+static float velocity = 0.0f;
+static float shaft_position = 0.0f;
+static long shaft_ticks = 0;
+static unsigned long last_update_us = 0;
+static bool jammed = false;
+static unsigned long end_stop_hit_us = 0;
+static float window_position = 0.0f;    // створка за тягой, тики вала
+static float slip_shift = 0.0f;         // сдвиг середины зазора от проскальзывания струбцины
+static int coupled_side = 0;            // вал тянет створку: +1 - по ходу DIR=1, -1 - DIR=0, 0 - в зазоре
+
+// контакт с упором: знак +1 - упор закрытия, -1 - упор открытия, 0 - нет контакта
+static int contact_side = 0;
+static float seal_depth = 0.0f;         // наибольшее вминание за этот контакт
+
+void encoder_simulation_setup(const MotorPlantConfig& config, MockEncoder* encoder) {
+    plant = config;
+    mock_encoder = encoder;
+    velocity = 0.0f;
+    shaft_position = 0.0f;
+    shaft_ticks = 0;
+    window_position = 0.0f;
+    slip_shift = 0.0f;
+    coupled_side = 0;
+    jammed = false;
+    end_stop_hit_us = 0;
+    contact_side = 0;
+    seal_depth = 0.0f;
+    last_update_us = micros();
+    Serial.println("Motor plant simulation setup complete");
+}
+
+// вал внутри зазора створку не двигает, на краю зазора тянет ее (струбцина проскальзывает)
+static void apply_coupling() {
+    const float eps = 1e-3f;
+    float half = plant.backlashTicks / 2.0f;
+    float offset = shaft_position - window_position;
+    coupled_side = 0;
+    if (offset >= slip_shift + half - eps) {
+        float push = fmaxf(offset - slip_shift - half, 0.0f);
+        slip_shift += push * plant.slipClose;
+        window_position += push * (1.0f - plant.slipClose);
+        coupled_side = 1;
+    } else if (offset <= slip_shift - half + eps) {
+        float push = fmaxf(slip_shift - half - offset, 0.0f);
+        slip_shift -= push * plant.slipOpen;
+        window_position -= push * (1.0f - plant.slipOpen);
+        coupled_side = -1;
+    }
+}
+
+// створка за упором: ограничиваем вминанием уплотнителя, вал - краем зазора; true - есть контакт
+static bool apply_stop(float stop, int side, int pushDuty, unsigned long now_us) {
+    float depth = (window_position - stop) * side;
+    if (depth <= 0.0f) {
+        return false;
+    }
+    if (contact_side != side) {
+        contact_side = side;
+        seal_depth = fabsf(velocity) * plant.sealTicksPerVelocity;
+        if (side == 1) end_stop_hit_us = now_us;
+    }
+    seal_depth = fmaxf(seal_depth, pushDuty * plant.sealTicksPerDuty);
+
+    float allowed = (pushDuty > 0) ? seal_depth : seal_depth * plant.sealSetFraction;
+    if (depth > allowed) {
+        window_position = stop + side * allowed;
+    }
+    float edge = window_position + slip_shift + side * plant.backlashTicks / 2.0f;
+    if ((shaft_position - edge) * side > 0.0f) {
+        shaft_position = edge;
+        if (velocity * side > 0.0f) velocity = 0.0f;
+    }
+    return true;
+}
+
+void encoder_simulation_reconfigure(const MotorPlantConfig& config) {
+    plant = config;
+}
+
+void encoder_simulation_update(unsigned long current_time_us) {
+    float dt = (current_time_us - last_update_us) / 1000000.0f;
+    last_update_us = current_time_us;
+    if (dt <= 0.0f) return;
+
+    int duty = get_motor_pwm();
+    int driveSide = (get_motor_direction() == 1) ? 1 : -1;
+    bool loaded = plant.backlashTicks <= 0.0f || coupled_side == driveSide;
+    int deadband = plant.deadbandDuty + (loaded ? plant.loadDeadbandDuty : 0);
+    float tau = plant.coastTau;
+    float target = 0.0f;
+    if (duty > deadband) {
+        target = driveSide * plant.ticksPerSecPerDuty * duty;
+        tau = plant.driveTau;
+    }
+
+    velocity += (target - velocity) * (1.0f - expf(-dt / tau));
+    if (jammed || (duty > plant.deadbandDuty && duty <= deadband)) {
+        // заклинило или ШИМ крутит свободный вал, но не сдвигает створку
+        velocity = 0.0f;
+    }
+    shaft_position += velocity * dt;
+
+    float slipBefore = slip_shift;
+    apply_coupling();
+
+    int pushDuty = (duty > plant.deadbandDuty) ? duty : 0;
+    int pushSide = (get_motor_direction() == 1) ? 1 : -1;
+    bool touching = false;
+    if (plant.hasEndStop) {
+        touching |= apply_stop(plant.endStopTicks, 1, pushSide == 1 ? pushDuty : 0, current_time_us);
+    }
+    if (plant.hasOpenStop) {
+        touching |= apply_stop(plant.openStopTicks, -1, pushSide == -1 ? pushDuty : 0, current_time_us);
+    }
+    if (!touching) {
+        contact_side = 0;
+    } else {
+        slip_shift = slipBefore;        // прижатая к упору створка не проскальзывает
+    }
+
+    // каждое пересечение целого тика - фронт энкодера
+    long new_ticks = lroundf(shaft_position);
+    long edges = labs(new_ticks - shaft_ticks);
+    shaft_ticks = new_ticks;
+    mock_encoder->inject(edges);
+
+    encoder_sampler_sample(current_time_us);
+}
+
+float get_simulated_velocity() {
+    return velocity;
+}
+
+long get_simulated_shaft_ticks() {
+    return shaft_ticks;
+}
+
+long get_simulated_window_ticks() {
+    return lroundf(window_position);
+}
+
+void encoder_simulation_jam(bool jam) {
+    jammed = jam;
+}
+
+unsigned long get_end_stop_hit_us() {
+    return end_stop_hit_us;
+}
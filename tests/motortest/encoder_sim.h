@@ -0,0 +1,37 @@
+#pragma once
+
+// Модель привода: скорость вала - апериодическое звено от ШИМ с мертвой зоной,
+// после снятия ШИМ - выбег. Фронты энкодера подаются в MockEncoder, знак им дает
+// программное направление мотора, а не реальное вращение - как и на железе.
+// Каждый шаг модели заодно снимает отсчет сэмплера - как таймер на железе.
+struct MotorPlantConfig {
+    float ticksPerSecPerDuty = 5.0f;    // установившаяся скорость на единицу ШИМ
+    int   deadbandDuty = 40;            // ниже этого ШИМ вал не трогается
+    float driveTau = 0.06f;             // постоянная времени разгона, с
+    float coastTau = 0.03f;             // постоянная времени выбега, с
+    bool  hasEndStop = false;           // упор по ходу DIR=1 (закрытое окно)
+    long  endStopTicks = 0;             // положение упора, тики вала
+    bool  hasOpenStop = false;          // упор по ходу DIR=0 (полностью открыто)
+    long  openStopTicks = 0;
+    // уплотнитель на упорах: вал вминается от удара и под ШИМ, после снятия ШИМ
+    // отходит назад не полностью. По умолчанию упоры жесткие.
+    float sealTicksPerVelocity = 0.0f;  // вминание от удара, тики на тик/с скорости подхода
+    float sealTicksPerDuty = 0.0f;      // вминание под ШИМ, тики на единицу ШИМ
+    float sealSetFraction = 0.0f;       // доля вминания, остающаяся после снятия ШИМ
+    // тяга со струбциной между валом и створкой; упоры - у створки. По умолчанию жесткая.
+    float backlashTicks = 0.0f;         // полный зазор, тики вала
+    float slipOpen = 0.0f;              // доля хода вала, которую створка теряет при открытии (DIR=0)
+    float slipClose = 0.0f;
+    int   loadDeadbandDuty = 0;         // прибавка к мертвой зоне, пока вал тянет створку
+};
+
+class MockEncoder;
+
+void encoder_simulation_setup(const MotorPlantConfig& config, MockEncoder* encoder);
+void encoder_simulation_reconfigure(const MotorPlantConfig& config);  // новые параметры, положение вала сохраняется
+void encoder_simulation_update(unsigned long current_time_us);
+float get_simulated_velocity();         // реальная скорость вала, тики/с (знак - по направлению DIR=1)
+long get_simulated_shaft_ticks();       // реальное положение вала, тики
+long get_simulated_window_ticks();      // реальное положение створки, тики вала (без зазора совпадает с валом)
+void encoder_simulation_jam(bool jammed);   // заклинить вал посреди хода
+unsigned long get_end_stop_hit_us();    // когда вал последний раз пришел на упор (0 - не приходил)
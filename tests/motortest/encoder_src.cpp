@@ -0,0 +1 @@
+#include "../../controller/encoder.cpp"
@@ -0,0 +1,78 @@
+#include "encoder_test.h"
+#include <Arduino.h>
+#include "../../controller/encoder.h"
+
+// Нагрузка: ~4500 фронтов/с, каждые 5 с датчики температуры на 3 шинах OneWire
+// запрещают прерывания примерно на 3 x 0.7 мс при чтении scratchpad.
+const uint32_t EDGES_PER_MS = 4;
+const uint32_t SIM_DURATION_MS = 20 * 60 * 1000;    // 20 минут движения
+const uint32_t ONEWIRE_PERIOD_MS = 5000;
+const uint32_t ONEWIRE_MASK_MS = 3;
+const uint32_t PCNT_LIMIT = 32767;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+static void run_load(MockEncoder& enc) {
+    enc.begin();
+    enc.setDirection(1);
+    for (uint32_t ms = 0; ms < SIM_DURATION_MS; ms++) {
+        bool masked = (ms % ONEWIRE_PERIOD_MS) < ONEWIRE_MASK_MS;
+        enc.maskInterrupts(masked);
+        enc.inject(EDGES_PER_MS);
+    }
+    enc.maskInterrupts(false);
+}
+
+static void print_stats(MockEncoder& enc) {
+    EncoderStats stats = enc.getStats();
+    Serial.print(enc.name());
+    Serial.print(": injected=");
+    Serial.print((unsigned long)enc.injectedEdges());
+    Serial.print(", counted=");
+    Serial.print((unsigned long)stats.edges);
+    Serial.print(", overflows=");
+    Serial.print(stats.overflows);
+    Serial.print(", lost=");
+    Serial.println(stats.lostEdges);
+}
+
+int run_encoder_backend_tests() {
+    failures = 0;
+
+    MockEncoder pcnt(PCNT_LIMIT);
+    run_load(pcnt);
+    print_stats(pcnt);
+    check(pcnt.getStats().edges == pcnt.injectedEdges(), "pcnt counts every edge under interrupt masking");
+    check(pcnt.getStats().lostEdges == 0, "pcnt reports no lost edges");
+    check(pcnt.getStats().overflows == pcnt.injectedEdges() / PCNT_LIMIT, "pcnt overflows folded into 64-bit count");
+
+    MockEncoder isr;
+    run_load(isr);
+    print_stats(isr);
+    check(isr.getStats().edges + isr.getStats().lostEdges == isr.injectedEdges(), "isr lost edges accounted for");
+    check(isr.getStats().lostEdges > 0, "isr loses edges under interrupt masking");
+
+    // смена направления посреди счета: до смены - со старым знаком
+    MockEncoder dir(PCNT_LIMIT);
+    dir.begin();
+    dir.setDirection(-1);
+    dir.inject(40000);
+    dir.maskInterrupts(true);
+    dir.inject(30000);          // переполнение еще не обработано
+    dir.setDirection(1);
+    dir.inject(500);
+    dir.maskInterrupts(false);
+    check(dir.read() == -70000 + 500, "direction segments keep sign across pending overflow");
+
+    dir.write(0);
+    dir.inject(10);
+    check(dir.read() == 10, "write() rebases position");
+
+    return failures;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Проверки бэкендов энкодера на модели: возвращает число проваленных проверок
+int run_encoder_backend_tests();
@@ -0,0 +1,2 @@
+// Тестируем боевой код мотора, а не его копию
+#include "../../controller/motor_impl.cpp"
@@ -0,0 +1,231 @@
+#include "../../controller/motor_impl.h"
+#include "encoder_sim.h"
+#include "encoder_test.h"
+
+// Тесты бэкендов энкодера и движения мотора на модели привода:
+// 0) счет фронтов PCNT / ISR при запрещенных прерываниях, 64-битное расширение
+// 1) полный ход 0 -> 9: время установки и перерегулирование по профилю
+// 2) перенацеливание посреди хода с реверсом: пауза реверса, итоговая позиция без дрейфа
+// 3) заклинивание посреди хода: задача снимается со статусом STALLED за десятки мс
+// 4) хоуминг на упор: упор замечен за десятки мс (раньше - разгон 2 с и окна по 100 мс), ноль энкодера на упоре
+// loop() не должен блокироваться дольше нескольких миллисекунд.
+
+const long POS_TICKS = 400;                         // тиков на позицию (MAX_MOTOR_POS / MAX_POS)
+const unsigned long FULL_TRAVEL_BUDGET_MS = 1300;   // с ожиданием выбега; фиксированный ШИМ 150/255: ~1260 мс и выбег ~90 тиков
+const long OVERSHOOT_BUDGET_TICKS = 3;
+const unsigned long REVERSAL_DEAD_TIME_MS = 60;
+const unsigned long SETTLE_WAIT_MS = 300;           // ждем выбега после остановки
+const unsigned long LOOP_BUDGET_US = 3000;
+const unsigned long STALL_DETECT_BUDGET_MS = 80;
+const unsigned long HOMING_DETECT_BUDGET_MS = 60;
+
+enum TestPhase {
+    PHASE_FULL_TRAVEL,
+    PHASE_FULL_TRAVEL_SETTLE,
+    PHASE_RETARGET_START,
+    PHASE_RETARGET,
+    PHASE_RETARGET_SETTLE,
+    PHASE_STALL_START,
+    PHASE_STALL,
+    PHASE_HOMING,
+    PHASE_HOMING_SETTLE,
+    PHASE_FINISHED
+};
+
+MockEncoder encoder(32767);
+
+TestPhase phase = PHASE_FULL_TRAVEL;
+unsigned long phaseStartMs = 0;
+unsigned long moveDoneMs = 0;
+unsigned long maxLoopUs = 0;
+int callbackCount = 0;
+int failures = 0;
+
+// отслеживание паузы реверса
+int lastDriveDir = -1;
+unsigned long lastDriveMs = 0;
+unsigned long minReversalGapMs = 0xFFFFFFFF;
+
+unsigned long jamMs = 0;
+unsigned long homingStopMs = 0;
+unsigned long homingHitMs = 0;
+
+void on_move_finished(MotorMoveStatus status, int pos) {
+    callbackCount++;
+    Serial.print("Callback: status=");
+    Serial.print(static_cast<int>(status));
+    Serial.print(", pos=");
+    Serial.println(pos);
+}
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+void track_reversals() {
+    if (get_motor_pwm() == 0) return;
+    int dir = get_motor_direction();
+    if (lastDriveDir != -1 && dir != lastDriveDir) {
+        unsigned long gap = millis() - lastDriveMs;
+        if (gap < minReversalGapMs) minReversalGapMs = gap;
+    }
+    lastDriveDir = dir;
+    lastDriveMs = millis();
+}
+
+void enter(TestPhase next) {
+    phase = next;
+    phaseStartMs = millis();
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Motor motion test ===");
+
+    failures += run_encoder_backend_tests();
+
+    motor_set_encoder(&encoder);
+    motor_setup();
+    set_motor_move_callback(on_move_finished);
+    MotorPlantConfig plant;
+    plant.hasEndStop = true;            // закрытое окно: вал стартует на упоре
+    plant.endStopTicks = 0;
+    encoder_simulation_setup(plant, &encoder);
+
+    change_pos(9);
+    enter(PHASE_FULL_TRAVEL);
+}
+
+void loop() {
+    if (phase == PHASE_FINISHED) {
+        return;
+    }
+
+    unsigned long start = micros();
+    encoder_simulation_update(start);
+    motor_update();
+    unsigned long elapsed = micros() - start;
+    if (elapsed > maxLoopUs) maxLoopUs = elapsed;
+    track_reversals();
+
+    switch (phase) {
+        case PHASE_FULL_TRAVEL:
+            if (!is_motor_busy()) {
+                moveDoneMs = millis() - phaseStartMs;
+                enter(PHASE_FULL_TRAVEL_SETTLE);
+            }
+            break;
+
+        case PHASE_FULL_TRAVEL_SETTLE:
+            if (millis() - phaseStartMs >= SETTLE_WAIT_MS) {
+                long error = -get_simulated_shaft_ticks() - 9 * POS_TICKS;
+                Serial.print("Full travel: ");
+                Serial.print(moveDoneMs);
+                Serial.print(" ms, final error ");
+                Serial.print(error);
+                Serial.println(" ticks");
+                report(get_current_position_index() == 9, "full travel reached position 9");
+                report(moveDoneMs <= FULL_TRAVEL_BUDGET_MS, "full travel settle time");
+                report(labs(error) <= OVERSHOOT_BUDGET_TICKS, "full travel overshoot");
+
+                callbackCount = 0;
+                change_pos(0);
+                enter(PHASE_RETARGET_START);
+            }
+            break;
+
+        case PHASE_RETARGET_START:
+            // на полпути передумали: снова полностью открываем
+            if (-get_simulated_shaft_ticks() <= 9 * POS_TICKS / 2) {
+                report(is_motor_busy(), "move in flight at half travel");
+                change_pos(9);
+                enter(PHASE_RETARGET);
+            }
+            break;
+
+        case PHASE_RETARGET:
+            if (!is_motor_busy()) {
+                enter(PHASE_RETARGET_SETTLE);
+            }
+            break;
+
+        case PHASE_RETARGET_SETTLE:
+            if (millis() - phaseStartMs >= SETTLE_WAIT_MS) {
+                long shaftError = -get_simulated_shaft_ticks() - 9 * POS_TICKS;
+                long encoderError = -get_encoder() - 9 * POS_TICKS;
+                report(get_motor_move_status() == MotorMoveStatus::DONE, "retargeted move completed");
+                report(get_current_position_index() == 9, "retarget ended at position 9");
+                report(labs(shaftError) <= OVERSHOOT_BUDGET_TICKS, "no shaft drift after retarget");
+                report(shaftError == encoderError, "encoder agrees with shaft after reversal");
+                report(callbackCount == 1, "single completion callback");
+                report(minReversalGapMs >= REVERSAL_DEAD_TIME_MS, "reversal dead time respected");
+                report(maxLoopUs <= LOOP_BUDGET_US, "loop latency within budget");
+                Serial.print("Max loop latency: ");
+                Serial.print(maxLoopUs);
+                Serial.println(" us");
+
+                change_pos(0);
+                enter(PHASE_STALL_START);
+            }
+            break;
+
+        case PHASE_STALL_START:
+            if (-get_simulated_shaft_ticks() <= 5 * POS_TICKS) {
+                encoder_simulation_jam(true);
+                jamMs = millis();
+                enter(PHASE_STALL);
+            }
+            break;
+
+        case PHASE_STALL:
+            if (!is_motor_busy()) {
+                unsigned long detectMs = millis() - jamMs;
+                Serial.print("Stall detected after ");
+                Serial.print(detectMs);
+                Serial.println(" ms");
+                report(get_motor_move_status() == MotorMoveStatus::STALLED, "jammed move reported as stalled");
+                report(detectMs <= STALL_DETECT_BUDGET_MS, "stall detection latency");
+                report(get_current_position_index() == 5, "stalled move stops at nearest position");
+
+                encoder_simulation_jam(false);
+                start_homing();
+                enter(PHASE_HOMING);
+            }
+            break;
+
+        case PHASE_HOMING:
+            if (homingStopMs == 0 && get_simulated_velocity() == 0.0f && get_end_stop_hit_us() != 0 && get_motor_pwm() == 0) {
+                homingStopMs = millis();            // первый (быстрый) подход к упору
+                homingHitMs = get_end_stop_hit_us() / 1000;
+            }
+            if (!is_homing()) {
+                enter(PHASE_HOMING_SETTLE);
+            }
+            break;
+
+        case PHASE_HOMING_SETTLE:
+            if (millis() - phaseStartMs >= SETTLE_WAIT_MS) {
+                unsigned long detectMs = homingStopMs - homingHitMs;
+                Serial.print("Homing: end stop detected after ");
+                Serial.print(detectMs);
+                Serial.println(" ms");
+                report(get_homing_result() == 0, "homing succeeded");
+                report(homingStopMs != 0 && detectMs <= HOMING_DETECT_BUDGET_MS, "homing end stop detection latency");
+                report(get_encoder() == get_simulated_shaft_ticks(), "encoder zeroed at the end stop");
+                report(get_current_position_index() == 0, "homing resets position index");
+
+                Serial.print("=== TEST COMPLETED, failures: ");
+                Serial.print(failures);
+                Serial.println(" ===");
+                enter(PHASE_FINISHED);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    delay(1);
+}
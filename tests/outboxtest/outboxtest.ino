@@ -0,0 +1,202 @@
+#include "../../controller/bot_api.h"
+#include "../../controller/bot_outbox.h"
+#include "../longpolltest/bot_api_server.h"
+#include <stdio.h>
+
+// Очередь исходящих (bot_outbox.h) против подставного сервера Bot API с лимитами Telegram:
+// 1 сообщение в секунду в чат, 30 в секунду всего, превышение - 429 с retry_after.
+// 1) как раньше: пачка аварий рассылается sendMessage() с delay(1000) между чатами
+// 2) та же пачка через outbox: push() не ждет, в каждый чат одно сообщение - последнее
+// 3) пачка ответов в один чат: ни одного 429, все доставлены по порядку
+// 4) сервер строже наших корзин: 429 приходят, retry_after соблюдается, все доставлены
+// 5) сеть рвется на отправке: сообщение повторяется и доходит
+//
+// Время на хосте виртуальное.
+
+const char* BOT_TOKEN = "123:TEST";
+
+const char* CHATS[] = { "1001", "1002", "1003", "1004", "1005" };
+const int CHAT_COUNT = sizeof(CHATS) / sizeof(CHATS[0]);
+const int ALERT_BURST = 10;
+const unsigned long ALERT_EVERY_MS = 50;
+const int REPLY_BURST = BOT_OUTBOX_SLOTS;
+const unsigned long LOOP_STEP_MS = 10;
+const unsigned long DRAIN_LIMIT_MS = 120000;
+
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+void telegram_limits(StandInHttpsServer& server) {
+    server.chatRatePerS = 1.0f;
+    server.chatBurst = 3.0f;
+    server.globalRatePerS = 30.0f;
+    server.globalBurst = 30.0f;
+}
+
+// проход задачи бота: отправить все, что пропускают лимиты, и подождать такт
+void drain(BotOutbox& outbox, BotApiClient& api) {
+    unsigned long start = millis();
+    while (!outbox.empty() && millis() - start < DRAIN_LIMIT_MS) {
+        BotOutMessage* message;
+        while ((message = outbox.ready(millis())) != nullptr) {
+            BotSendResult result = api.sendMessage(message->chatId, message->text, message->parseMode);
+            outbox.complete(message, result, millis());
+        }
+        delay(LOOP_STEP_MS);
+    }
+}
+
+// ответы "reply N" дошли в чат все и по порядку
+bool delivered_in_order(const StandInHttpsServer& server, const char* chatId, int count) {
+    int expected = 0;
+    for (const Delivery& delivery : server.delivered) {
+        if (delivery.chatId != chatId) continue;
+        char fragment[32];
+        snprintf(fragment, sizeof(fragment), "reply %d\"", expected);
+        if (delivery.body.find(fragment) == std::string::npos) return false;
+        expected++;
+    }
+    return expected == count;
+}
+
+void print_stats(const char* title, const StandInHttpsServer& server, const BotOutboxStats& stats) {
+    Serial.print(title);
+    Serial.print(": delivered ");
+    Serial.print((int)server.delivered.size());
+    Serial.print(", 429 ");
+    Serial.print(server.tooManyRequests);
+    Serial.print(", coalesced ");
+    Serial.print(stats.coalesced);
+    Serial.print(", retried ");
+    Serial.print(stats.retried);
+    Serial.print(", dropped ");
+    Serial.println(stats.dropped);
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Telegram outbox test ===");
+
+    // 1) как раньше: рассылка блокирует вызывающего
+    {
+        StandInHttpsServer server;
+        telegram_limits(server);
+        BotApiClient api(server, BOT_TOKEN);
+        unsigned long blockedMs = 0;
+        for (int alert = 0; alert < ALERT_BURST; alert++) {
+            unsigned long start = millis();
+            for (int chat = 0; chat < CHAT_COUNT; chat++) {
+                api.sendMessage(CHATS[chat], " EMERGENCY!!! \n", "Markdown");
+                api.sendMessage(CHATS[chat], "=== System Status ===", "");
+                delay(1000);
+            }
+            blockedMs += millis() - start;
+        }
+        Serial.print("Blocking broadcast: delivered ");
+        Serial.print((int)server.delivered.size());
+        Serial.print(", 429 ");
+        Serial.print(server.tooManyRequests);
+        Serial.print(", caller blocked ");
+        Serial.print(blockedMs);
+        Serial.println(" ms");
+        report(blockedMs >= ALERT_BURST * CHAT_COUNT * 1000UL, "baseline broadcast blocks the caller");
+    }
+
+    // 2) пачка аварий через outbox
+    {
+        StandInHttpsServer server;
+        telegram_limits(server);
+        BotApiClient api(server, BOT_TOKEN);
+        BotOutbox outbox;
+        unsigned long blockedMs = 0;
+        bool queued = true;
+        for (int alert = 0; alert < ALERT_BURST; alert++) {
+            char text[64];
+            snprintf(text, sizeof(text), " EMERGENCY!!! \n=== System Status === alert %d", alert);
+            unsigned long start = millis();
+            for (int chat = 0; chat < CHAT_COUNT; chat++) {
+                queued = outbox.push(BotOutKind::STATUS, CHATS[chat], "=== System Status ===", "", millis()) && queued;
+                queued = outbox.push(BotOutKind::ALERT, CHATS[chat], text, "", millis()) && queued;
+            }
+            blockedMs += millis() - start;
+            delay(ALERT_EVERY_MS);
+        }
+        drain(outbox, api);
+        print_stats("Alert burst through the outbox", server, outbox.stats());
+
+        char last[32];
+        snprintf(last, sizeof(last), "alert %d\"", ALERT_BURST - 1);
+        bool onePerChat = true;
+        for (int chat = 0; chat < CHAT_COUNT; chat++) {
+            onePerChat = onePerChat && server.deliveredTo(CHATS[chat]) == 1;
+        }
+        report(queued && blockedMs == 0 && outbox.stats().dropped == 0, "push never waits");
+        report(onePerChat, "one send per chat for the whole burst");
+        report(server.sentContains(last), "the latest alert is the one delivered");
+        report(server.tooManyRequests == 0, "no 429 from the server");
+    }
+
+    // 3) пачка ответов в один чат
+    {
+        StandInHttpsServer server;
+        telegram_limits(server);
+        BotApiClient api(server, BOT_TOKEN);
+        BotOutbox outbox;
+        bool queued = true;
+        for (int i = 0; i < REPLY_BURST; i++) {
+            char text[32];
+            snprintf(text, sizeof(text), "reply %d", i);
+            queued = outbox.push(BotOutKind::REPLY, CHATS[0], text, "", millis()) && queued;
+        }
+        drain(outbox, api);
+        print_stats("Reply burst, limits as on the server", server, outbox.stats());
+        report(queued && delivered_in_order(server, CHATS[0], REPLY_BURST), "replies delivered in order");
+        report(server.tooManyRequests == 0, "token buckets keep under the server limits");
+    }
+
+    // 4) сервер строже наших корзин
+    {
+        StandInHttpsServer server;
+        telegram_limits(server);
+        server.chatBurst = 1.0f;
+        server.chatRatePerS = 0.5f;
+        server.retryAfterS = 5;
+        BotApiClient api(server, BOT_TOKEN);
+        BotOutbox outbox;
+        for (int i = 0; i < REPLY_BURST; i++) {
+            char text[32];
+            snprintf(text, sizeof(text), "reply %d", i);
+            outbox.push(BotOutKind::REPLY, CHATS[1], text, "", millis());
+        }
+        drain(outbox, api);
+        print_stats("Stricter server", server, outbox.stats());
+        report(server.tooManyRequests > 0, "server answers 429");
+        report(server.ignoredRetryAfter == 0, "retry_after honoured");
+        report(delivered_in_order(server, CHATS[1], REPLY_BURST), "all delivered in order after 429");
+    }
+
+    // 5) обрывы на отправке
+    {
+        StandInHttpsServer server;
+        telegram_limits(server);
+        server.failNextSends = 3;
+        BotApiClient api(server, BOT_TOKEN);
+        BotOutbox outbox;
+        outbox.push(BotOutKind::REPLY, CHATS[2], "reply 0", "", millis());
+        drain(outbox, api);
+        print_stats("Dropped sends", server, outbox.stats());
+        report(outbox.stats().retried > 0 && delivered_in_order(server, CHATS[2], 1), "failed send retried and delivered");
+    }
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
@@ -0,0 +1,190 @@
+#include "../../controller/motor_impl.h"
+#include "../../controller/encoder.h"
+#include "../../controller/position_store.h"
+#include "../motortest/encoder_sim.h"
+
+// Журнал положения на модели привода и хранилище в памяти:
+// 1) первая загрузка - записи нет, хоуминг
+// 2) сутки работы - число записей во flash
+// 3) чистая перезагрузка - положение восстановлено без хоуминга, створка там, где думаем
+// 4) вал заклинило, пока не было питания - пробный ход не проходит, хоуминг
+// 5) команда посреди пробного хода - едем к ней, без возврата и без хоуминга
+// 6) питание пропало посреди движения - запись грязная, нужен хоуминг
+// 7) испорченный последний слот пропускается
+
+const int MOVES_PER_DAY = 48;                       // раз в полчаса
+const int BURST_EVERY = 6;                          // каждая шестая - серия из трех движений подряд
+const unsigned long DAY_MS = 86400000UL;
+const unsigned long IDLE_STEP_MS = 1000;
+const float WRITES_PER_DAY_BUDGET = 2.0f * MOVES_PER_DAY;
+const unsigned long RESTORE_BOOT_BUDGET_MS = 500;      // с пробным ходом туда и обратно
+const long POSITION_ERROR_BUDGET_TICKS = 3;
+
+MockEncoder encoder(32767);
+MemoryPositionStorage storage;
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+void step_ms(unsigned long ms) {
+    encoder_simulation_update(micros());
+    motor_update();
+    position_store_update();
+    delay(ms);
+}
+
+void run_while_busy() {
+    while (is_motor_busy()) {
+        step_ms(1);
+    }
+    for (int i = 0; i < 300; i++) {
+        step_ms(1);
+    }
+}
+
+void idle_ms(unsigned long ms) {
+    for (unsigned long t = 0; t < ms; t += IDLE_STEP_MS) {
+        step_ms(IDLE_STEP_MS);
+    }
+}
+
+// перезагрузка: счет энкодера пропал, журнал читается заново
+bool reboot(unsigned long& bootMs) {
+    encoder.write(0);
+    unsigned long start = millis();
+    position_store_begin(&storage);
+    bool restored = position_store_restore();
+    if (!restored) {
+        start_homing();
+    }
+    while (is_motor_busy()) {                       // пробный ход после восстановления или хоуминг
+        step_ms(1);
+    }
+    bootMs = millis() - start;
+    run_while_busy();
+    return restored;
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Position store test ===");
+    randomSeed(7);
+
+    MotorPlantConfig plant;
+    plant.hasEndStop = true;
+    plant.endStopTicks = 0;
+    motor_set_encoder(&encoder);
+    motor_setup();
+    encoder_simulation_setup(plant, &encoder);
+
+    // 1) первая загрузка
+    unsigned long homingBootMs = 0;
+    report(!reboot(homingBootMs), "first boot has no saved position");
+    report(get_homing_result() == 0, "first boot homed");
+    idle_ms(POSITION_STORE_COMMIT_DELAY_MS + IDLE_STEP_MS);
+
+    // 2) сутки работы
+    uint32_t writesBefore = position_store_stats().writesTotal;
+    unsigned long dayStart = millis();
+    for (int move = 0; move < MOVES_PER_DAY; move++) {
+        int burst = (move % BURST_EVERY == 0) ? 3 : 1;
+        for (int i = 0; i < burst; i++) {
+            change_pos(random(0, 10));
+            run_while_busy();
+        }
+        idle_ms(DAY_MS / MOVES_PER_DAY - (millis() - dayStart) % (DAY_MS / MOVES_PER_DAY));
+    }
+    float writesPerDay = (position_store_stats().writesTotal - writesBefore) * (float)DAY_MS / (millis() - dayStart);
+    Serial.print("Flash writes per day: ");
+    Serial.println(writesPerDay, 1);
+    report(writesPerDay <= WRITES_PER_DAY_BUDGET, "flash writes per day");
+
+    // 3) чистая перезагрузка
+    change_pos(6);
+    run_while_busy();
+    idle_ms(POSITION_STORE_COMMIT_DELAY_MS + IDLE_STEP_MS);
+    unsigned long restoreBootMs = 0;
+    bool restored = reboot(restoreBootMs);
+    Serial.print("Boot to ready: restore ");
+    Serial.print(restoreBootMs);
+    Serial.print(" ms, homing ");
+    Serial.print(homingBootMs);
+    Serial.println(" ms");
+    report(restored && get_current_position_index() == 6, "clean reboot restores position");
+    report(restoreBootMs <= RESTORE_BOOT_BUDGET_MS, "restore boot time");
+    change_pos(0);
+    run_while_busy();
+    report(labs(get_simulated_shaft_ticks()) <= POSITION_ERROR_BUDGET_TICKS, "restored position matches the shaft");
+
+    // 4) вал заклинило без питания
+    idle_ms(POSITION_STORE_COMMIT_DELAY_MS + IDLE_STEP_MS);
+    encoder.write(0);
+    encoder_simulation_jam(true);
+    position_store_begin(&storage);
+    bool accepted = position_store_restore();
+    bool homingStarted = false;
+    for (int i = 0; i < 2000 && is_motor_busy() && !homingStarted; i++) {
+        step_ms(1);
+        homingStarted = is_homing();
+    }
+    encoder_simulation_jam(false);
+    run_while_busy();
+    report(accepted && homingStarted, "jammed shaft fails the restore jog and starts homing");
+    report(get_homing_result() == 0 && labs(get_simulated_shaft_ticks() - get_encoder()) <= POSITION_ERROR_BUDGET_TICKS,
+           "homing after failed jog re-zeroes the encoder");
+
+    // 5) команда посреди пробного хода
+    idle_ms(POSITION_STORE_COMMIT_DELAY_MS + IDLE_STEP_MS);
+    change_pos(3);
+    run_while_busy();
+    long step = get_position_ticks() / 3;
+    idle_ms(POSITION_STORE_COMMIT_DELAY_MS + IDLE_STEP_MS);
+    encoder.write(0);
+    position_store_begin(&storage);
+    bool jogRestored = position_store_restore();
+    for (int i = 0; i < 20; i++) {
+        step_ms(1);
+    }
+    bool jogging = is_motor_busy();
+    change_pos(5);
+    bool homedAfterRetarget = false;
+    while (is_motor_busy()) {
+        step_ms(1);
+        homedAfterRetarget |= is_homing();
+    }
+    run_while_busy();
+    report(jogRestored && jogging && !homedAfterRetarget && get_current_position_index() == 5 &&
+           labs(get_position_ticks() - 5 * step) <= step / 4 &&
+           labs(get_simulated_shaft_ticks() - get_encoder()) <= POSITION_ERROR_BUDGET_TICKS,
+           "command during the restore jog wins over the jog");
+
+    // 6) питание пропало посреди движения
+    idle_ms(POSITION_STORE_COMMIT_DELAY_MS + IDLE_STEP_MS);
+    change_pos(8);
+    for (int i = 0; i < 300; i++) {
+        step_ms(1);
+    }
+    cancel_pos_move();
+    unsigned long crashBootMs = 0;
+    report(!reboot(crashBootMs), "dirty journal forces homing");
+    report(get_homing_result() == 0 && labs(get_simulated_shaft_ticks() - get_encoder()) <= POSITION_ERROR_BUDGET_TICKS,
+           "homing after crash re-zeroes the encoder");
+
+    // 7) испорченный последний слот
+    idle_ms(POSITION_STORE_COMMIT_DELAY_MS + IDLE_STEP_MS);
+    uint32_t total = position_store_stats().writesTotal;
+    storage.corrupt((total - 1) % POSITION_STORE_SLOTS);
+    position_store_begin(&storage);
+    report(position_store_stats().writesTotal == total - 1, "corrupt record skipped, previous one used");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
@@ -0,0 +1,178 @@
+#include "../../controller/power.h"
+
+// Режим энергосбережения на виртуальном времени: задачи с периодами и ценой как в controller.ino,
+// часы - micros()/delayMicroseconds(), чтобы millis() внутри режима питания шел с ними вместе.
+// 1) NORMAL: в light sleep не уходим, экран горит
+// 2) ENERGY_SAVING: скважность и ток ниже, почти все время - light sleep
+// 3) экран гаснет после простоя, кнопка его будит
+// 4) датчики опрашиваются реже, пока показания стабильны, и снова чаще, когда нет
+// 5) пока мотор едет или бот на сети - без light sleep
+// 6) возврат в NORMAL включает экран и обычный опрос
+
+const uint32_t PHASE_US = 600000000UL;                  // 10 минут на режим
+const float SAVING_SLEEP_FRACTION_BUDGET = 0.9f;
+
+extern bool stubMotorBusy;
+extern bool stubNetworkBusy;
+extern float stubRoomTemp;
+extern bool stubSlowPolling;
+extern bool stubDisplayOn;
+
+class ArduinoClock : public SchedulerClock {
+public:
+    uint32_t nowUs() override { return micros(); }
+    void sleepUs(uint32_t us) override { delayMicroseconds(us); }
+};
+
+struct JobPeriods {
+    uint32_t motorIdleUs;
+    uint32_t buttonsUs;
+    uint32_t sensorsUs;
+    uint32_t windowUs;
+    uint32_t telegramUs;
+};
+
+const JobPeriods JOB_PERIODS[POWER_MODE_COUNT] = {
+    { 20000, 10000, 50000, 100000, 100000 },
+    { 200000, 25000, 200000, 1000000, 500000 }
+};
+
+ArduinoClock arduinoClock;
+int failures = 0;
+int motorJob, buttonsJob, sensorsJob, windowJob, telegramJob;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+const JobPeriods& job_periods() {
+    return JOB_PERIODS[(int)power_get_mode()];
+}
+
+void motor_job() {
+    delayMicroseconds(40);
+    scheduler_set_period(motorJob, stubMotorBusy ? 1000 : job_periods().motorIdleUs);
+}
+void buttons_job() { delayMicroseconds(15); }
+void display_job() {
+    if (power_display_on()) delayMicroseconds(2500);
+}
+void sensors_job() { delayMicroseconds(120); }
+void window_job() { delayMicroseconds(300); }
+void telegram_job() { delayMicroseconds(200); }
+void power_job() {
+    delayMicroseconds(30);
+    power_update();
+}
+
+void set_mode(PowerMode mode) {
+    power_set_mode(mode);
+    const JobPeriods& periods = job_periods();
+    scheduler_set_period(buttonsJob, periods.buttonsUs);
+    scheduler_set_period(sensorsJob, periods.sensorsUs);
+    scheduler_set_period(windowJob, periods.windowUs);
+    scheduler_set_period(telegramJob, periods.telegramUs);
+    scheduler_wake(motorJob);
+}
+
+void run_for(uint32_t us) {
+    uint32_t start = micros();
+    while (micros() - start < us) {
+        scheduler_loop();
+    }
+}
+
+uint64_t light_sleep_us() {
+    return power_mode_stats(PowerMode::ENERGY_SAVING).lightSleepUs;
+}
+
+void print_mode(const char* name, const PowerModeStats& stats) {
+    Serial.print(name);
+    Serial.print(": duty ");
+    Serial.print(stats.dutyCycle * 100.0f, 2);
+    Serial.print("%, light sleep ");
+    Serial.print(stats.lightSleepFraction * 100.0f, 1);
+    Serial.print("%, ~");
+    Serial.print(stats.estimatedCurrentMa, 1);
+    Serial.println(" mA");
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Power mode test ===");
+
+    power_begin(&arduinoClock);
+    scheduler_begin(power_scheduler_clock());
+    const JobPeriods& periods = job_periods();
+    motorJob = scheduler_every("motor", periods.motorIdleUs, motor_job);
+    buttonsJob = scheduler_every("buttons", periods.buttonsUs, buttons_job);
+    scheduler_every("display", 100000, display_job);
+    sensorsJob = scheduler_every("sensors", periods.sensorsUs, sensors_job);
+    windowJob = scheduler_every("window", periods.windowUs, window_job);
+    telegramJob = scheduler_every("telegram", periods.telegramUs, telegram_job);
+    scheduler_every("power", 1000000, power_job);
+
+    // 1) обычный режим
+    run_for(PHASE_US);
+    PowerModeStats normal = power_mode_stats(PowerMode::NORMAL);
+    report(normal.lightSleepUs == 0, "normal mode never light-sleeps");
+    report(stubDisplayOn && !stubSlowPolling, "normal mode keeps the display and sensor polling");
+
+    // 2-4) энергосбережение, показания стабильны
+    set_mode(PowerMode::ENERGY_SAVING);
+    run_for(POWER_DISPLAY_TIMEOUT_MS * 1000UL - 2000000UL);
+    bool litBeforeTimeout = stubDisplayOn;
+    run_for(4000000UL);
+    report(litBeforeTimeout && !stubDisplayOn, "display blanks after inactivity");
+    power_note_activity();
+    report(stubDisplayOn && power_display_on(), "button wakes the display");
+
+    run_for(PHASE_US - POWER_DISPLAY_TIMEOUT_MS * 1000UL - 2000000UL);
+    report(stubSlowPolling && power_sensors_stable(), "stable readings slow the sensor polling");
+
+    stubRoomTemp += 1.0f;
+    run_for(12000000UL);
+    report(!stubSlowPolling, "changing readings restore the sensor polling");
+    stubRoomTemp -= 1.0f;
+
+    PowerModeStats saving = power_mode_stats(PowerMode::ENERGY_SAVING);
+    print_mode("Normal", normal);
+    print_mode("Energy saving", saving);
+    report(saving.lightSleepFraction >= SAVING_SLEEP_FRACTION_BUDGET, "energy saving sleeps between deadlines");
+    report(saving.dutyCycle < normal.dutyCycle / 4, "energy saving duty cycle is lower");
+    report(saving.estimatedCurrentMa < normal.estimatedCurrentMa / 4, "energy saving current is lower");
+
+    // 5) мотор едет, бот на сети
+    stubMotorBusy = true;
+    scheduler_wake(motorJob);
+    uint64_t sleptBefore = light_sleep_us();
+    run_for(10000000UL);
+    report(light_sleep_us() == sleptBefore, "no light sleep while the motor moves");
+    stubMotorBusy = false;
+
+    stubNetworkBusy = true;
+    sleptBefore = light_sleep_us();
+    run_for(10000000UL);
+    report(light_sleep_us() == sleptBefore, "no light sleep while the bot is on the network");
+    stubNetworkBusy = false;
+
+    sleptBefore = light_sleep_us();
+    run_for(10000000UL);
+    report(light_sleep_us() > sleptBefore, "light sleep resumes when both are idle");
+
+    // 6) обратно
+    run_for(POWER_DISPLAY_TIMEOUT_MS * 1000UL + 2000000UL);
+    set_mode(PowerMode::NORMAL);
+    report(stubDisplayOn && !stubSlowPolling, "normal mode turns the display and polling back on");
+
+    power_print_stats();
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
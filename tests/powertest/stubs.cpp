@@ -0,0 +1,27 @@
+#include <Arduino.h>
+#include "../../controller/motor_impl.h"
+#include "../../controller/sensors.h"
+#include "../../controller/OLED_screen.h"
+#include "../../controller/buttons.h"
+#include "../../controller/bot_link.h"
+
+// железо режима питания: мотор, датчики, экран, кнопки и сеть бота задает тест
+
+bool stubMotorBusy = false;
+bool stubNetworkBusy = false;
+float stubRoomTemp = 22.0f;
+int stubCo2 = 600;
+bool stubSlowPolling = false;
+bool stubDisplayOn = true;
+
+bool is_motor_busy() { return stubMotorBusy; }
+bool bot_link_network_busy() { return stubNetworkBusy; }
+
+float get_room_temp() { return stubRoomTemp; }
+bool get_room_sensor_error() { return false; }
+int get_last_co2_ppm() { return stubCo2; }
+bool get_co2_read_error() { return false; }
+void sensors_set_slow_polling(bool slow) { stubSlowPolling = slow; }
+
+void OLED_screen_set_power(bool on) { stubDisplayOn = on; }
+void buttons_enable_wakeup() {}
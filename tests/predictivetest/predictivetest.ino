@@ -0,0 +1,170 @@
+#include "../../controller/window_controller.h"
+#include "room_plant.h"
+#include <math.h>
+#include <time.h>
+
+// Режим PREDICTIVE против AUTO (make_decision_auto_ST) в замкнутом контуре с комнатой
+// room_plant.h: три зимних дня, одни и те же сиды для обоих режимов. Считается по истинным
+// температуре и CO2 комнаты, а не по показаниям датчиков, со второго дня (первый - обучение):
+// 1) комфорт - доля минут с метрикой в пределах metricTarget + metricMargin, средняя метрика
+// 2) команды мотору и проеханные позиции
+// 3) перебор позиций по модели - в пределах бюджета
+//
+// Время на хосте виртуальное: перебор замеряется отдельно, по clock().
+
+const unsigned long SECOND_MS = 1000UL;
+const unsigned long MINUTE_MS = 60000UL;
+const unsigned long DAY_MS = 24UL * 3600000UL;
+const int DAYS = 3;
+const int SEEDS = 5;
+const float METRIC_LIMIT = 20.0f;                   // metricTarget + metricMargin по умолчанию
+const float EVALUATE_BUDGET_US = 100.0f;            // на хосте; на ESP32 тех же операций в ~20 раз дольше
+const int EVALUATE_RUNS = 20000;
+
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+// метрика, как WindowController::calculateTotalMetric() с WindowConfig по умолчанию
+float true_metric() {
+    float temp = constrain(fabsf(plant.temperature - 22.0f) * 5.0f, 0.0f, 100.0f);
+    float co2 = constrain(plant.co2 > 600.0f ? (plant.co2 - 600.0f) / 60.0f : 0.0f, 0.0f, 100.0f);
+    return temp + co2;
+}
+
+struct Score {
+    unsigned long minutes;
+    unsigned long comfortMinutes;
+    double metricSum;
+    unsigned long moves;
+    float travel;
+    unsigned long readyMinute;      // когда модель комнаты готова, 0 - не была
+};
+
+Score run(WindowMode mode, uint32_t seed) {
+    plant_reset(seed, 22.0f);
+    WindowController* controller = new WindowController();     // заново: модель и истории с нуля
+    controller->setMode(mode);
+
+    Score score = {};
+    unsigned long start = millis();
+    unsigned long movesBefore = 0;
+    float travelBefore = 0.0f;
+    for (unsigned long t = SECOND_MS; t <= DAYS * DAY_MS; t += SECOND_MS) {
+        delay(SECOND_MS);
+        plant_step(millis() - start, 1.0f);
+        controller->update();
+
+        if (t % MINUTE_MS != 0) continue;
+        if (score.readyMinute == 0 && controller->isRoomModelReady()) score.readyMinute = t / MINUTE_MS;
+        if (t == DAY_MS) {
+            movesBefore = plant.moves;
+            travelBefore = plant.travel;
+        }
+        if (t <= DAY_MS) continue;
+        float metric = true_metric();
+        score.minutes++;
+        if (metric <= METRIC_LIMIT) score.comfortMinutes++;
+        score.metricSum += metric;
+    }
+    score.moves = plant.moves - movesBefore;
+    score.travel = plant.travel - travelBefore;
+    delete controller;
+    return score;
+}
+
+void print_score(const char* name, const Score& s) {
+    Serial.print(name);
+    Serial.print(": comfort ");
+    Serial.print(100.0f * s.comfortMinutes / s.minutes, 1);
+    Serial.print("%, mean metric ");
+    Serial.print(s.metricSum / s.minutes, 2);
+    Serial.print(", moves ");
+    Serial.print(s.moves);
+    Serial.print(", travel ");
+    Serial.print(s.travel, 0);
+    Serial.println(" positions");
+}
+
+// перебор позиций отдельно: процессорное время, не виртуальное
+float plain_metric(const void* context, float temperature, float co2) {
+    return fabsf(temperature - 22.0f) * 5.0f + (co2 > 600.0f ? (co2 - 600.0f) / 60.0f : 0.0f);
+}
+
+void check_evaluate_budget() {
+    RoomModel model;
+    RoomState state = { 22.0f, 3.0f, 900.0f };
+    unsigned long when = 0;
+    for (int i = 0; i < 100; i++) {
+        state.temperature -= 0.05f * (i % 10);
+        state.co2 += 5.0f;
+        model.observe(state, i % 10, 10, when);
+        when += ROOM_MODEL_SAMPLE_MS;
+    }
+
+    float costs[ROOM_MODEL_MAX_POSITIONS];
+    float checksum = 0.0f;
+    clock_t begin = clock();
+    for (int i = 0; i < EVALUATE_RUNS; i++) {
+        state.co2 = 900.0f + (i % 7);
+        model.evaluate(state, ROOM_MODEL_MAX_POSITIONS, ROOM_MODEL_MAX_HORIZON, plain_metric, nullptr, costs);
+        checksum += costs[i % ROOM_MODEL_MAX_POSITIONS];
+    }
+    float us = (clock() - begin) * 1e6f / CLOCKS_PER_SEC / EVALUATE_RUNS;
+    Serial.print("Evaluate: ");
+    Serial.print(ROOM_MODEL_MAX_POSITIONS * ROOM_MODEL_MAX_HORIZON);
+    Serial.print(" steps, ");
+    Serial.print(us, 2);
+    Serial.print(" us on host (checksum ");
+    Serial.print(checksum, 0);
+    Serial.println(")");
+    report(us <= EVALUATE_BUDGET_US, "full position search within budget");
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Predictive mode test ===");
+
+    check_evaluate_budget();
+
+    Score autoTotal = {};
+    Score predictiveTotal = {};
+    unsigned long latestReady = 0;
+    bool everReady = true;
+    for (uint32_t seed = 1; seed <= SEEDS; seed++) {
+        Score a = run(WindowMode::AUTO, seed);
+        Score p = run(WindowMode::PREDICTIVE, seed);
+        Score* totals[2] = { &autoTotal, &predictiveTotal };
+        Score* scores[2] = { &a, &p };
+        for (int i = 0; i < 2; i++) {
+            totals[i]->minutes += scores[i]->minutes;
+            totals[i]->comfortMinutes += scores[i]->comfortMinutes;
+            totals[i]->metricSum += scores[i]->metricSum;
+            totals[i]->moves += scores[i]->moves;
+            totals[i]->travel += scores[i]->travel;
+        }
+        if (p.readyMinute == 0) everReady = false;
+        if (p.readyMinute > latestReady) latestReady = p.readyMinute;
+    }
+
+    print_score("AUTO", autoTotal);
+    print_score("PREDICTIVE", predictiveTotal);
+    Serial.print("Room model ready after at most ");
+    Serial.print(latestReady);
+    Serial.println(" min");
+
+    report(everReady, "room model identified in every run");
+    report(predictiveTotal.comfortMinutes >= autoTotal.comfortMinutes, "predictive keeps comfort at least as well as AUTO");
+    report(predictiveTotal.moves <= autoTotal.moves, "predictive moves the window no more often than AUTO");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
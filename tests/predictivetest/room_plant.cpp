@@ -0,0 +1,124 @@
+#include <Arduino.h>
+#include <math.h>
+#include "room_plant.h"
+#include "../../controller/sensors.h"
+#include "../../controller/motor_impl.h"
+
+RoomPlant plant;
+
+const float OUTDOOR_CO2 = 420.0f;
+const float WALL_RATE = 0.005f;             // 1/мин, теплопотери через стены
+const float INFILTRATION_RATE = 0.004f;     // 1/мин, воздух через щели
+const float WINDOW_AIR_RATE = 0.01f;        // 1/мин при полном открытии и тяге без разницы температур
+const float AIR_HEAT_SHARE = 0.2f;          // доля теплоемкости воздуха - остальное стены и мебель
+const float HEATER_RATE = 0.12f;            // °C/мин, батарея без термостата
+const float SUN_RATE = 0.04f;               // °C/мин в полдень
+const float PERSON_HEAT = 0.004f;           // °C/мин
+const float PERSON_CO2 = 8.0f;              // ppm/мин, бодрствует
+const float SLEEPER_CO2 = 5.0f;
+const float TEMP_NOISE = 0.06f;
+const float TEMP_STEP = 0.25f;
+const float CO2_NOISE = 15.0f;
+const float MOTOR_POSITIONS_PER_S = 0.5f;
+
+static float hour_of(unsigned long nowMs) {
+    return fmodf(6.0f + nowMs / 3600000.0f, 24.0f);  // прогон начинается в 6 утра
+}
+
+float plant_outside_temp(unsigned long nowMs) {
+    return 3.0f + 3.0f * sinf((hour_of(nowMs) - 9.0f) / 24.0f * 2.0f * PI);
+}
+
+int plant_occupants(unsigned long nowMs) {
+    float h = hour_of(nowMs);
+    if (h < 7.0f || h >= 23.0f) return 1;       // спит
+    if (h >= 9.0f && h < 18.0f) return 1;
+    return 2;
+}
+
+static float uniform() {
+    plant.noise = plant.noise * 1664525u + 1013904223u;
+    return ((plant.noise >> 8) + 0.5f) / 16777216.0f;
+}
+
+static float gauss() {
+    return sqrtf(-2.0f * logf(uniform())) * cosf(2.0f * PI * uniform());
+}
+
+void plant_reset(uint32_t seed, float startTemp) {
+    plant = {};
+    plant.temperature = startTemp;
+    plant.co2 = 600.0f;
+    plant.noise = seed;
+    plant.tempReading = startTemp;
+    plant.co2Reading = 600;
+}
+
+void plant_step(unsigned long nowMs, float dtS) {
+    float minutes = dtS / 60.0f;
+    float outside = plant_outside_temp(nowMs);
+    float h = hour_of(nowMs);
+    int people = plant_occupants(nowMs);
+    bool sleeping = h < 7.0f || h >= 23.0f;
+
+    // мотор
+    if (fabsf(plant.position - plant.target) > 1e-3f) {
+        float step = MOTOR_POSITIONS_PER_S * dtS;
+        float delta = plant.target - plant.position;
+        float moved = fabsf(delta) < step ? delta : (delta > 0 ? step : -step);
+        plant.position += moved;
+        plant.travel += fabsf(moved);
+    }
+
+    // воздух через окно: открытие^0.8, тяга растет с разницей температур
+    float opening = plant.position / 9.0f;
+    float air = INFILTRATION_RATE + WINDOW_AIR_RATE * powf(opening, 0.8f) * (1.0f + 0.03f * fabsf(outside - plant.temperature));
+    float sun = (h > 10.0f && h < 16.0f) ? SUN_RATE * sinf((h - 10.0f) / 6.0f * PI) : 0.0f;
+    float heat = HEATER_RATE + sun + PERSON_HEAT * people;
+    plant.temperature += minutes * (heat + (WALL_RATE + AIR_HEAT_SHARE * air) * (outside - plant.temperature));
+    float generation = people * (sleeping ? SLEEPER_CO2 : PERSON_CO2);
+    plant.co2 += minutes * (generation + air * (OUTDOOR_CO2 - plant.co2));
+
+    // опрос датчиков, как sensors.cpp
+    if (nowMs - plant.tempReadMs >= 5000) {
+        plant.tempReadMs = nowMs;
+        plant.tempReading = roundf((plant.temperature + TEMP_NOISE * gauss()) / TEMP_STEP) * TEMP_STEP;
+    }
+    if (nowMs - plant.co2ReadMs >= 10000) {
+        plant.co2ReadMs = nowMs;
+        plant.co2Reading = (int)roundf(plant.co2 + CO2_NOISE * gauss());
+    }
+}
+
+// датчики =======================================================================================================================//
+
+float get_room_temp() { return plant.tempReading; }
+float get_outside_temp() { return roundf(plant_outside_temp(millis()) / TEMP_STEP) * TEMP_STEP; }
+bool get_room_sensor_error() { return false; }
+bool get_outside_sensor_error() { return false; }
+int get_last_co2_ppm() { return plant.co2Reading; }
+bool get_co2_read_error() { return false; }
+unsigned long get_temp_read_time() { return plant.tempReadMs; }
+unsigned long get_last_co2_read_time() { return plant.co2ReadMs; }
+
+// мотор =========================================================================================================================//
+
+int change_pos(int pos) {
+    pos = constrain(pos, 0, 9);
+    if (pos != plant.target) plant.moves++;
+    plant.target = pos;
+    return pos;
+}
+
+int get_current_position_index() {
+    return (int)roundf(plant.position);
+}
+
+bool is_motor_busy() {
+    return fabsf(plant.position - plant.target) > 1e-3f;
+}
+
+MotorMoveStatus get_motor_move_status() {
+    if (plant.moves == 0) return MotorMoveStatus::IDLE;
+    return is_motor_busy() ? MotorMoveStatus::MOVING : MotorMoveStatus::DONE;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+// Комната для замкнутого контура: то, что контроллер делает с окном, меняет то, что он видит.
+// Зима: снаружи 0..6 °C по суткам, батарея, двое жильцов с утра до ночи, ночью один спит.
+// Модель намеренно не совпадает с room_model.h: обмен через окно растет как открытие^0.8 и
+// с разницей температур (тяга), днем греет солнце. Датчики - с шагом DS18B20 и шумом MH-Z19B,
+// мотор едет на позицию за 2 с.
+
+struct RoomPlant {
+    float temperature;          // °C
+    float co2;                  // ppm
+    float position;             // фактическое открытие, позиции 0..9
+    int target;
+    unsigned long minute;       // с начала прогона
+
+    // показания датчиков, как их видит контроллер
+    float tempReading;
+    int co2Reading;
+    unsigned long tempReadMs;
+    unsigned long co2ReadMs;
+    uint32_t noise;
+
+    unsigned long moves;        // команд мотору
+    float travel;               // позиций проехано
+};
+
+extern RoomPlant plant;
+
+void plant_reset(uint32_t seed, float startTemp);
+void plant_step(unsigned long nowMs, float dtS);    // физика и опрос датчиков
+float plant_outside_temp(unsigned long nowMs);
+int plant_occupants(unsigned long nowMs);
@@ -0,0 +1,90 @@
+#include "../../controller/profiler.h"
+
+// Профилировщик на виртуальном времени: блоки с известными длительностями.
+// 1) корзины лог-шкалы идут подряд, без дыр и перекрытий, значение попадает в свою
+// 2) p50/p99 с точностью до ширины корзины, max и среднее точные
+// 3) превышения бюджета считаются, у подсистем без бюджета - нет
+// 4) сводка для /perf и сброс
+
+const float BUCKET_ERROR = 0.25f;               // ширина корзины относительно нижней границы
+const int SAMPLES = 1000;
+
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+bool near(uint32_t got, uint32_t expected) {
+    return got >= expected && got <= expected + expected * BUCKET_ERROR + 1;
+}
+
+void timed_block(ProfileSection section, uint32_t us) {
+    ProfileScope scope(section);
+    delayMicroseconds(us);
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Profiler test ===");
+    profiler_begin();
+
+    // 1) корзины
+    bool contiguous = true;
+    for (int b = 1; b < PROFILER_BUCKETS; b++) {
+        contiguous &= profiler_bucket_upper_us(b) > profiler_bucket_upper_us(b - 1);
+    }
+    report(contiguous && profiler_bucket_upper_us(PROFILER_BUCKETS - 1) >= 10000000UL, "buckets are ordered and cover 10 s");
+
+    bool ownBucket = true;
+    uint32_t values[] = { 0, 1, 3, 4, 5, 7, 8, 100, 1000, 1023, 1024, 65535, 1000000 };
+    for (uint32_t us : values) {
+        profiler_reset();
+        profiler_record(ProfileSection::MOTOR, us);
+        for (int b = 0; b < PROFILER_BUCKETS; b++) {
+            if (profiler_bucket_count(ProfileSection::MOTOR, b) == 0) continue;
+            uint32_t lower = (b == 0) ? 0 : profiler_bucket_upper_us(b - 1) + 1;
+            ownBucket &= lower <= us && us <= profiler_bucket_upper_us(b);
+        }
+    }
+    report(ownBucket, "every value lands in the bucket that spans it");
+
+    // 2) окно: 98% по 200 мкс, 2% по 3000 мкс; экран: равномерно 1..1000 мкс
+    profiler_reset();
+    profiler_set_budget(ProfileSection::WINDOW, 2500);
+    for (int i = 0; i < SAMPLES; i++) {
+        timed_block(ProfileSection::WINDOW, (i % 50 == 0) ? 3000 : 200);
+        timed_block(ProfileSection::DISPLAY_DRAW, i + 1);
+    }
+    ProfileSummary window = profiler_summary(ProfileSection::WINDOW);
+    ProfileSummary draw = profiler_summary(ProfileSection::DISPLAY_DRAW);
+    profiler_print();
+
+    report(window.count == SAMPLES && draw.count == SAMPLES, "every scope recorded once");
+    report(near(window.p50Us, 200) && near(window.p99Us, 3000) && window.maxUs == 3000, "p50/p99/max of a bimodal section");
+    report(near(draw.p50Us, 500) && near(draw.p99Us, 990) && draw.maxUs == SAMPLES, "p50/p99/max of a uniform section");
+    report(fabsf(window.meanUs - (0.98f * 200 + 0.02f * 3000)) < 0.5f, "mean is exact");
+
+    // 3) бюджет
+    report(window.overruns == SAMPLES / 50 && window.budgetUs == 2500, "budget overruns counted");
+    report(draw.overruns == 0 && draw.budgetUs == 0, "no overruns without a budget");
+
+    // 4) отчет и сброс
+    char buffer[512];
+    MessageBuilder text(buffer, sizeof(buffer));
+    profiler_report(text);
+    report(strstr(text.c_str(), "window: n=1000") != nullptr && strstr(text.c_str(), "display draw") != nullptr &&
+           strstr(text.c_str(), "telegram") == nullptr && !text.truncated(), "/perf report lists the active sections");
+    profiler_reset();
+    report(profiler_summary(ProfileSection::WINDOW).count == 0 && profiler_summary(ProfileSection::WINDOW).budgetUs == 2500,
+           "reset clears counts and keeps budgets");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
@@ -0,0 +1,167 @@
+#include "../../controller/scheduler.h"
+
+// Планировщик на виртуальных часах: задачи с периодами и ценой как у подсистем контроллера,
+// телеграм иногда блокирует на сотни мс (HTTPS). Старт часов - за 5 с до переполнения micros().
+// 1) каждая периодическая задача выполнена нужное число раз, период не уплывает
+// 2) опоздание ограничено самой долгой чужой задачей, в среднем - единицы мкс
+// 3) loop() почти все время спит (раньше опрос в цикле занимал 100% CPU)
+// 4) переполнение бюджета и пропуски периодов считаются
+// 5) разовая задача, смена периода, внеочередной запуск, снятие задачи
+
+const uint32_t START_US = 0xFFFFFFFFUL - 5000000UL;
+const uint32_t RUN_US = 600000000UL;                    // 10 минут
+const uint32_t SLOW_TELEGRAM_US = 400000;              // блокирующий запрос
+const int SLOW_TELEGRAM_EVERY = 30;
+const uint32_t QUEUE_LATENESS_US = 5000;                // остальные задачи с тем же сроком
+const float SLEEP_FRACTION_BUDGET = 0.9f;
+
+VirtualSchedulerClock virtualClock(START_US);
+int failures = 0;
+
+int motorJob, buttonsJob, displayJob, sensorsJob, windowJob, telegramJob;
+uint32_t telegramCalls = 0;
+uint32_t slowTelegramCalls = 0;
+uint32_t oneShotAtUs = 0;
+int oneShotRuns = 0;
+int cancelledRuns = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+void motor_job() { virtualClock.advance(40); }
+void buttons_job() { virtualClock.advance(15); }
+void display_job() { virtualClock.advance(2500); }
+void sensors_job() { virtualClock.advance(120); }
+void window_job() { virtualClock.advance(300); }
+void telegram_job() {
+    telegramCalls++;
+    if (telegramCalls % SLOW_TELEGRAM_EVERY == 0) {
+        slowTelegramCalls++;
+        virtualClock.advance(SLOW_TELEGRAM_US);
+    } else {
+        virtualClock.advance(2000);
+    }
+}
+void one_shot_job() {
+    oneShotRuns++;
+    oneShotAtUs = virtualClock.nowUs();
+}
+void cancelled_job() { cancelledRuns++; }
+
+void run_for(uint32_t us) {
+    uint32_t start = virtualClock.nowUs();
+    while (virtualClock.nowUs() - start < us) {
+        scheduler_loop();
+    }
+}
+
+bool runs_match(int job, uint32_t elapsedUs) {
+    SchedulerJobStats stats;
+    scheduler_job_stats(job, stats);
+    long expected = elapsedUs / stats.periodUs;
+    long got = stats.runs + stats.skipped;
+    if (labs(got - expected) > 1) {
+        Serial.print(stats.name);
+        Serial.print(": runs + skipped ");
+        Serial.print(got);
+        Serial.print(", expected ");
+        Serial.println(expected);
+        return false;
+    }
+    return true;
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Scheduler test ===");
+
+    scheduler_begin(&virtualClock);
+    motorJob = scheduler_every("motor", 10000, motor_job, 1000);
+    buttonsJob = scheduler_every("buttons", 10000, buttons_job);
+    displayJob = scheduler_every("display", 100000, display_job);
+    sensorsJob = scheduler_every("sensors", 100000, sensors_job);
+    windowJob = scheduler_every("window", 200000, window_job);
+    telegramJob = scheduler_every("telegram", 1000000, telegram_job, 100000);
+
+    // 1-4) десять минут работы
+    uint64_t sleptBefore = virtualClock.sleptTotalUs();
+    uint32_t start = virtualClock.nowUs();
+    run_for(RUN_US);
+    uint32_t elapsed = virtualClock.nowUs() - start;
+    scheduler_print_stats();
+
+    bool allRuns = true;
+    int ids[] = { motorJob, buttonsJob, displayJob, sensorsJob, windowJob, telegramJob };
+    uint32_t worstLateness = 0;
+    float worstMeanLateness = 0;
+    for (int id : ids) {
+        allRuns &= runs_match(id, elapsed);
+        SchedulerJobStats stats;
+        scheduler_job_stats(id, stats);
+        if (stats.maxLatenessUs > worstLateness) worstLateness = stats.maxLatenessUs;
+        if (stats.meanLatenessUs > worstMeanLateness) worstMeanLateness = stats.meanLatenessUs;
+    }
+    report(allRuns, "every periodic job ran once per period");
+
+    SchedulerJobStats motor, telegram;
+    scheduler_job_stats(motorJob, motor);
+    scheduler_job_stats(telegramJob, telegram);
+    Serial.print("Worst lateness ");
+    Serial.print(worstLateness);
+    Serial.print(" us, worst mean ");
+    Serial.print(worstMeanLateness, 1);
+    Serial.println(" us");
+    report(worstLateness <= SLOW_TELEGRAM_US + QUEUE_LATENESS_US, "lateness bounded by the longest job");
+    report(motor.skipped > 0 && motor.skipped <= slowTelegramCalls * (SLOW_TELEGRAM_US / 10000 + 1),
+           "periods lost only behind blocking telegram calls");
+    report(telegram.overruns == slowTelegramCalls, "budget overruns counted");
+
+    float sleepFraction = (virtualClock.sleptTotalUs() - sleptBefore) / (float)elapsed;
+    float busyFraction = scheduler_busy_us() / (float)elapsed;
+    Serial.print("Asleep ");
+    Serial.print(sleepFraction * 100.0f, 1);
+    Serial.print("%, busy ");
+    Serial.print(busyFraction * 100.0f, 1);
+    Serial.println("%");
+    report(sleepFraction >= SLEEP_FRACTION_BUDGET, "loop sleeps between deadlines");
+    report(fabsf(sleepFraction + busyFraction - 1.0f) < 0.001f, "time is either asleep or in jobs");
+
+    // 5) разовая задача, смена периода, внеочередной запуск, снятие
+    uint32_t armedAt = virtualClock.nowUs();
+    scheduler_after("one-shot", 250000, one_shot_job);
+    run_for(1000000);
+    report(oneShotRuns == 1 && oneShotAtUs - armedAt >= 250000 && oneShotAtUs - armedAt <= 250000 + SLOW_TELEGRAM_US + QUEUE_LATENESS_US,
+           "one-shot job ran once at its deadline");
+
+    scheduler_reset_stats();
+    start = virtualClock.nowUs();
+    scheduler_set_period(windowJob, 50000);
+    run_for(1000000);
+    report(runs_match(windowJob, virtualClock.nowUs() - start), "period change takes effect");
+
+    scheduler_set_period(sensorsJob, 60000000);
+    run_for(1000);
+    scheduler_reset_stats();
+    scheduler_wake(sensorsJob);
+    run_for(20000);
+    SchedulerJobStats sensors;
+    scheduler_job_stats(sensorsJob, sensors);
+    report(sensors.runs == 1 && sensors.maxLatenessUs <= 20000, "wake runs the job out of turn");
+
+    int cancelled = scheduler_every("cancelled", 10000, cancelled_job);
+    run_for(50000);
+    int runsBefore = cancelledRuns;
+    scheduler_cancel(cancelled);
+    run_for(100000);
+    report(runsBefore > 0 && cancelledRuns == runsBefore, "cancelled job no longer runs");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
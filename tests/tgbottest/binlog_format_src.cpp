@@ -0,0 +1 @@
+#include "../../controller/binlog_format.cpp"
@@ -0,0 +1 @@
+#include "../../controller/binlog.cpp"
@@ -0,0 +1 @@
+#include "../../controller/encoder_sampler.cpp"
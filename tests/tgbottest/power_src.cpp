@@ -0,0 +1 @@
+#include "../../controller/power.cpp"
@@ -0,0 +1,208 @@
+#include "../../controller/motor_impl.h"
+#include "../../controller/encoder.h"
+#include "../../controller/window_controller.h"
+#include "../../controller/tgbot.h"
+#include "../motortest/encoder_sim.h"
+#include <mutex>
+#include <vector>
+
+// Бот в своей задаче против подставного Bot API: каждый запрос держит сеть, как
+// TLS-запрос к серверу (обычный - RTT_MS, каждый HANDSHAKE_EVERY-й - с рукопожатием).
+// 1) как раньше: бот опрашивается из цикла управления - худшая задержка цикла
+// 2) бот в задаче на ядре 0 - та же нагрузка, задержка цикла управления
+// 3) команды из чата выполнены управлением, ответы дошли: режим, позиция, параметр, хоуминг
+
+const char* ssid = "";
+const char* password = "";
+const char* BOT_TOKEN = "";
+std::vector<String> allowedUsers = { "1001" };
+
+const unsigned long RTT_MS = 300;
+const unsigned long HANDSHAKE_MS = 2500;
+const int HANDSHAKE_EVERY = 10;
+const unsigned long PHASE_MS = 20000;
+const unsigned long MESSAGE_EVERY_MS = 1500;
+const unsigned long LOOP_LATENCY_BUDGET_US = 50000;          // много меньше одного RTT; на хосте с одним ядром
+                                                             // задача бота делит процессор с циклом
+
+// подставной Bot API: сообщения из сценария, отправленное копится для проверки
+class StandInBotApi : public BotTransport {
+public:
+    bool connect() override {
+        request();
+        return true;
+    }
+
+    int poll(BotMessage* messages, int maxMessages, uint16_t waitS) override {
+        request();
+        std::lock_guard<std::mutex> lock(mutex);
+        int count = 0;
+        while (count < maxMessages && !inbox.empty()) {
+            messages[count].chatId = "1001";
+            messages[count].text = inbox.front();
+            inbox.erase(inbox.begin());
+            count++;
+        }
+        return count;
+    }
+
+    BotSendResult send(const char* chatId, const char* text, const char* parseMode, const char* replyMarkup) override {
+        request();
+        std::lock_guard<std::mutex> lock(mutex);
+        sent.push_back(text);
+        return { BotSendStatus::SENT, 0, (int32_t)sent.size() };
+    }
+
+    BotSendResult edit(const char* chatId, int32_t messageId, const char* text, const char* parseMode,
+                       const char* replyMarkup) override {
+        return send(chatId, text, parseMode, replyMarkup);
+    }
+
+    void answerCallback(const char* callbackId) override {
+        request();
+    }
+
+    void push(const char* text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        inbox.push_back(text);
+    }
+
+    bool sentContains(const char* fragment) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const String& text : sent) {
+            if (strstr(text.c_str(), fragment) != nullptr) return true;
+        }
+        return false;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        inbox.clear();
+        sent.clear();
+    }
+
+private:
+    void request() {
+        requests++;
+        delay((requests % HANDSHAKE_EVERY == 0) ? HANDSHAKE_MS : RTT_MS);
+    }
+
+    std::mutex mutex;
+    std::vector<String> inbox;
+    std::vector<String> sent;
+    int requests = 0;
+};
+
+const char* SCRIPT[] = {
+    "/status",
+    "/mode_manual",
+    "/set_position 6",
+    "/set_temp_ideal 23.5",
+    "/homing",
+    "/status",                  // пока идет хоуминг, позиция не принимается
+    "/set_position 2",
+    "/status",
+};
+const int SCRIPT_LEN = sizeof(SCRIPT) / sizeof(SCRIPT[0]);
+
+MockEncoder encoder(32767);
+WindowController windowController;
+StandInBotApi botApi;
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+// цикл управления: модель привода, мотор, окно, сторона управления бота
+unsigned long run_control(TelegramBot& bot, bool pollInline) {
+    unsigned long start = millis();
+    unsigned long lastIterationUs = micros();
+    unsigned long worstUs = 0;
+    int scriptIndex = 0;
+    unsigned long nextMessageMs = start;
+
+    while (millis() - start < PHASE_MS) {
+        unsigned long nowUs = micros();
+        if (nowUs - lastIterationUs > worstUs) worstUs = nowUs - lastIterationUs;
+        lastIterationUs = nowUs;
+
+        if (scriptIndex < SCRIPT_LEN && millis() >= nextMessageMs) {
+            botApi.push(SCRIPT[scriptIndex++]);
+            nextMessageMs = millis() + MESSAGE_EVERY_MS;
+        }
+
+        encoder_simulation_update(micros());
+        motor_update();
+        windowController.update();
+        bot.update(windowController);
+        if (pollInline) {
+            bot.pollOnce();
+        }
+        delay(1);
+    }
+    return worstUs;
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Telegram task test ===");
+
+    MotorPlantConfig plant;
+    plant.hasEndStop = true;
+    plant.endStopTicks = 0;
+    motor_set_encoder(&encoder);
+    motor_setup();
+    encoder_simulation_setup(plant, &encoder);
+
+    // 1) как раньше - из цикла управления
+    TelegramBot inlineBot;
+    inlineBot.init(&botApi, false);
+    unsigned long inlineWorstUs = run_control(inlineBot, true);
+
+    // 2-3) в своей задаче
+    WindowConfig config = windowController.getConfig();
+    config.currentMode = WindowMode::AUTO;
+    config.tempIdeal = 22.0f;
+    windowController.setConfig(config);
+    change_pos(0);
+    while (is_motor_busy()) {
+        encoder_simulation_update(micros());
+        motor_update();
+        delay(1);
+    }
+    botApi.clear();
+
+    TelegramBot taskBot;
+    taskBot.init(&botApi);
+    unsigned long taskWorstUs = run_control(taskBot, false);
+    taskBot.stop();
+
+    Serial.print("Worst control loop gap: bot in loop ");
+    Serial.print(inlineWorstUs / 1000);
+    Serial.print(" ms, bot in own task ");
+    Serial.print(taskWorstUs / 1000.0f, 1);
+    Serial.println(" ms");
+    report(taskWorstUs <= LOOP_LATENCY_BUDGET_US, "control loop never waits for the network");
+    report(inlineWorstUs >= RTT_MS * 1000UL, "inline bot blocked the loop (baseline)");
+
+    report(botApi.sentContains("System Status"), "status answered from the snapshot");
+    report(windowController.getConfig().currentMode == WindowMode::MANUAL &&
+           botApi.sentContains("MANUAL (ручной)"), "mode change applied and confirmed");
+    report(windowController.getConfig().tempIdeal == 23.5f &&
+           botApi.sentContains("Идеальная температура: 23.50"), "parameter applied and confirmed");
+    report(botApi.sentContains("КАЛИБРОВКА УСПЕШНО"), "homing result reported when it finished");
+    report(get_current_position_index() == 2 && botApi.sentContains("Целевая позиция: **2/9**"),
+           "position command executed by the control side");
+    BotLinkStats link = bot_link_stats();
+    report(link.commandsDropped == 0 && link.repliesDropped == 0, "no queue overflow");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
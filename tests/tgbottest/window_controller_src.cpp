@@ -0,0 +1 @@
+#include "../../controller/window_controller.cpp"
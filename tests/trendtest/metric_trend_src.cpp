@@ -0,0 +1 @@
+#include "../../controller/metric_trend.cpp"
@@ -0,0 +1,288 @@
+#include "../../controller/metric_trend.h"
+#include "../../controller/position_history.h"
+#include <math.h>
+
+// Тренд метрики для прогноза в WindowController::update(): прежний наклон по двум последним
+// минутным замерам истории позиции против MetricTrend по каждому показанию датчиков
+// (температура раз в 5 с, CO2 раз в 10 с).
+// 1) точность: на чистой прямой наклон точный, на шуме - около нуля и без уверенности
+// 2) реплей: суточные сценарии с шумом DS18B20 (шаг 0.25 °C) и MH-Z19B, решение раз в минуту.
+//    Правильное решение - по истинной метрике через predictionTime. Ложные - окно тронули
+//    зря, запаздывание - с какой минуты после правильного решение принято на самом деле.
+//    Прежнее правило: метрика плоха и прогноз плох; новое: плох прогноз - сглаженная метрика
+//    плюс наклон, умноженный на уверенность (make_decision_auto_ST).
+//
+// Время на хосте виртуальное.
+
+const unsigned long SECOND_MS = 1000UL;
+const unsigned long MINUTE_MS = 60000UL;
+const unsigned long TEMP_INTERVAL_MS = 5000UL;
+const unsigned long CO2_INTERVAL_MS = 10000UL;
+const unsigned long DECISION_INTERVAL_MS = 60000UL;
+const float PREDICTION_TIME_S = 180.0f;         // WindowConfig::predictionTime
+const float METRIC_LIMIT = 20.0f;               // metricTarget + metricMargin
+const float TEMP_NOISE = 0.06f;                 // °C до округления до 0.25
+const float TEMP_STEP = 0.25f;                  // 10 бит
+const float CO2_NOISE = 15.0f;                  // ppm
+const int SEEDS = 20;
+
+int failures = 0;
+
+void report(bool ok, const char* what) {
+    Serial.print(ok ? "PASS: " : "FAIL: ");
+    Serial.println(what);
+    if (!ok) failures++;
+}
+
+// метрики, как в WindowController с WindowConfig по умолчанию
+float temperature_metric(float temperature) {
+    return constrain(fabsf(temperature - 22.0f) * 5.0f, 0.0f, 100.0f);
+}
+
+float co2_metric(int co2) {
+    return constrain(co2 > 600 ? (co2 - 600) / 60.0f : 0.0f, 0.0f, 100.0f);
+}
+
+// сценарии =====================================================================================================================//
+
+struct Scenario {
+    const char* name;
+    unsigned long durationMs;
+    float (*temperature)(float minutes);
+    float (*co2)(float minutes);
+};
+
+// люди пришли: CO2 растет 20 ppm/мин
+float rise_temp(float m) { return 22.4f; }
+float rise_co2(float m) { return m < 30 ? 620.0f : fminf(620.0f + (m - 30) * 20.0f, 1900.0f); }
+
+// проветрили: CO2 спадает с постоянной 15 мин
+float airing_temp(float m) { return 22.2f; }
+float airing_co2(float m) { return 700.0f + 1250.0f * expf(-m / 15.0f); }
+
+// около порога: метрика ~19, CO2 медленно гуляет
+float plateau_temp(float m) { return 22.3f; }
+float plateau_co2(float m) { return 1650.0f + 20.0f * sinf(m / 40.0f * 2.0f * PI); }
+
+// комната прогревается на 5 °C за 3 ч
+float warming_temp(float m) { return 22.0f + m / 36.0f; }
+float warming_co2(float m) { return 650.0f; }
+
+// стабильно плохо: окно надо трогать каждую минуту
+float stuffy_temp(float m) { return 25.0f; }
+float stuffy_co2(float m) { return 1200.0f; }
+
+const Scenario SCENARIOS[] = {
+    { "CO2 rise", 150 * MINUTE_MS, rise_temp, rise_co2 },
+    { "airing", 90 * MINUTE_MS, airing_temp, airing_co2 },
+    { "plateau", 180 * MINUTE_MS, plateau_temp, plateau_co2 },
+    { "warming", 180 * MINUTE_MS, warming_temp, warming_co2 },
+    { "stuffy", 60 * MINUTE_MS, stuffy_temp, stuffy_co2 },
+};
+const int SCENARIO_COUNT = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+float true_metric(const Scenario& s, unsigned long ms) {
+    float m = ms / (float)MINUTE_MS;
+    return temperature_metric(s.temperature(m)) + co2_metric((int)roundf(s.co2(m)));
+}
+
+// шум датчиков =================================================================================================================//
+
+struct Noise {
+    uint32_t state;
+
+    float uniform() {
+        state = state * 1664525u + 1013904223u;
+        return ((state >> 8) + 0.5f) / 16777216.0f;
+    }
+
+    float gauss() {
+        return sqrtf(-2.0f * logf(uniform())) * cosf(2.0f * PI * uniform());
+    }
+};
+
+// реплей =======================================================================================================================//
+
+struct ReplayResult {
+    int decisions;
+    int spurious;       // окно тронули, а через predictionTime метрика в норме
+    int missed;
+    long reactionMin;   // первое решение минус первое правильное, мин; -1 - правильных нет
+};
+
+void tally(ReplayResult& r, bool act, bool truth, int minute, int& firstAct, int firstTruth) {
+    r.decisions++;
+    if (act && !truth) r.spurious++;
+    if (!act && truth) r.missed++;
+    if (act && firstAct < 0) firstAct = minute;
+}
+
+/**
+ * @brief Прогоняет сценарий через оба способа прогноза
+ * @param before прежний: наклон по двум последним минутным замерам
+ * @param after MetricTrend по каждому показанию
+ */
+void replay(const Scenario& s, uint32_t seed, ReplayResult& before, ReplayResult& after) {
+    Noise noise = { seed };
+    static PositionHistory history;
+    history = PositionHistory();
+    MetricTrend temperatureTrend;
+    MetricTrend co2Trend;
+
+    unsigned long start = millis();
+    float temperature = s.temperature(0);
+    int co2 = (int)roundf(s.co2(0));
+    int firstTruth = -1;
+    int firstBefore = -1;
+    int firstAfter = -1;
+    before = {};
+    after = {};
+
+    for (unsigned long t = SECOND_MS; t <= s.durationMs; t += SECOND_MS) {
+        unsigned long now = start + t;
+        float minutes = t / (float)MINUTE_MS;
+        if (t % TEMP_INTERVAL_MS == 0) {
+            float raw = s.temperature(minutes) + TEMP_NOISE * noise.gauss();
+            temperature = roundf(raw / TEMP_STEP) * TEMP_STEP;
+            temperatureTrend.addSample(temperature_metric(temperature), now);
+        }
+        if (t % CO2_INTERVAL_MS == 0) {
+            co2 = (int)roundf(s.co2(minutes) + CO2_NOISE * noise.gauss());
+            co2Trend.addSample(co2_metric(co2), now);
+        }
+        if (t % DECISION_INTERVAL_MS != 0) continue;
+
+        int minute = t / MINUTE_MS;
+        float metric = temperature_metric(temperature) + co2_metric(co2);
+        bool truth = true_metric(s, t + (unsigned long)(PREDICTION_TIME_S * 1000)) > METRIC_LIMIT;
+        if (truth && firstTruth < 0) firstTruth = minute;
+
+        // прежний calculateMetricTrend(): замер истории раз в минуту, наклон по двум последним
+        history.addRecord(metric, now);
+        MetricRecord last;
+        MetricRecord prev;
+        float oldSlope = 0.0f;
+        if (history.count >= 3 && history.latest(last, prev) && last.timestamp != prev.timestamp) {
+            oldSlope = (last.metric - prev.metric) / ((last.timestamp - prev.timestamp) / 1000.0f);
+        }
+        float oldPredicted = metric + oldSlope * PREDICTION_TIME_S;
+        tally(before, metric > METRIC_LIMIT && oldPredicted > METRIC_LIMIT, truth, minute, firstBefore, firstTruth);
+
+        TrendEstimate trend = trend_combine(temperatureTrend.estimate(now), 1.0f, co2Trend.estimate(now), 1.0f);
+        float predicted = trend.level + trend.slope * trend.confidence * PREDICTION_TIME_S;
+        tally(after, predicted > METRIC_LIMIT, truth, minute, firstAfter, firstTruth);
+    }
+    before.reactionMin = (firstTruth < 0 || firstBefore < 0) ? -1 : firstBefore - firstTruth;
+    after.reactionMin = (firstTruth < 0 || firstAfter < 0) ? -1 : firstAfter - firstTruth;
+    delay(s.durationMs);
+}
+
+// точность =====================================================================================================================//
+
+void check_accuracy() {
+    MetricTrend line;
+    unsigned long start = millis();
+    for (int i = 0; i <= 120; i++) {
+        line.addSample(10.0f + 0.02f * i * 5, start + i * TEMP_INTERVAL_MS);   // 0.02 в секунду
+    }
+    TrendEstimate exact = line.estimate(start + 120 * TEMP_INTERVAL_MS);
+    Serial.print("Line: slope ");
+    Serial.print(exact.slope, 5);
+    Serial.print(", level ");
+    Serial.print(exact.level, 3);
+    Serial.print(", confidence ");
+    Serial.println(exact.confidence, 3);
+    report(fabsf(exact.slope - 0.02f) < 1e-4f && fabsf(exact.level - 22.0f) < 0.01f && exact.confidence > 0.99f,
+           "clean line: exact slope and level, full confidence");
+
+    MetricTrend flat;
+    Noise noise = { 7 };
+    float worstConfidence = 0.0f;
+    for (int i = 0; i <= 2000; i++) {
+        unsigned long now = start + i * TEMP_INTERVAL_MS;
+        flat.addSample(temperature_metric(roundf((22.3f + TEMP_NOISE * noise.gauss()) / TEMP_STEP) * TEMP_STEP), now);
+        if (i > 50) worstConfidence = fmaxf(worstConfidence, flat.estimate(now).confidence);
+    }
+    Serial.print("Quantized noise: worst confidence ");
+    Serial.println(worstConfidence, 3);
+    report(worstConfidence < 0.5f, "sensor noise alone never gets half confidence");
+
+    MetricTrend stale;
+    stale.addSample(1.0f, start);
+    for (int i = 1; i <= 30; i++) stale.addSample(1.0f + i, start + i * TEMP_INTERVAL_MS);
+    TrendEstimate old = stale.estimate(start + 30 * TEMP_INTERVAL_MS + 10 * MINUTE_MS);
+    report(old.slope == 0.0f && old.confidence == 0.0f, "no fresh samples - no trend");
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println("=== Metric trend test ===");
+
+    check_accuracy();
+
+    int spuriousBefore = 0;
+    int spuriousAfter = 0;
+    int missedBefore = 0;
+    int missedAfter = 0;
+    bool notLater = true;
+    long totalBefore = 0;
+    long totalAfter = 0;
+    for (int i = 0; i < SCENARIO_COUNT; i++) {
+        ReplayResult sumBefore = {};
+        ReplayResult sumAfter = {};
+        long reactionBefore = 0;
+        long reactionAfter = 0;
+        int reactions = 0;
+        for (int seed = 1; seed <= SEEDS; seed++) {
+            ReplayResult before;
+            ReplayResult after;
+            replay(SCENARIOS[i], seed * 7919u + i, before, after);
+            sumBefore.decisions += before.decisions;
+            sumBefore.spurious += before.spurious;
+            sumBefore.missed += before.missed;
+            sumAfter.spurious += after.spurious;
+            sumAfter.missed += after.missed;
+            if (before.reactionMin >= 0 && after.reactionMin >= 0) {
+                reactionBefore += before.reactionMin;
+                reactionAfter += after.reactionMin;
+                reactions++;
+            }
+        }
+        Serial.print(SCENARIOS[i].name);
+        Serial.print(": ");
+        Serial.print(sumBefore.decisions);
+        Serial.print(" decisions, spurious ");
+        Serial.print(sumBefore.spurious);
+        Serial.print(" -> ");
+        Serial.print(sumAfter.spurious);
+        Serial.print(", missed ");
+        Serial.print(sumBefore.missed);
+        Serial.print(" -> ");
+        Serial.print(sumAfter.missed);
+        if (reactions > 0) {
+            Serial.print(", reaction ");
+            Serial.print(reactionBefore / (float)reactions, 1);
+            Serial.print(" -> ");
+            Serial.print(reactionAfter / (float)reactions, 1);
+            Serial.print(" min");
+            if (reactionAfter > reactionBefore) notLater = false;
+            totalBefore += reactionBefore;
+            totalAfter += reactionAfter;
+        }
+        Serial.println();
+        spuriousBefore += sumBefore.spurious;
+        spuriousAfter += sumAfter.spurious;
+        missedBefore += sumBefore.missed;
+        missedAfter += sumAfter.missed;
+    }
+    report(spuriousAfter * 2 <= spuriousBefore, "at least half fewer spurious decisions");
+    report(missedAfter <= missedBefore, "no more missed decisions");
+    report(notLater && totalAfter < totalBefore, "earlier reaction to real rises");
+
+    Serial.print("=== TEST COMPLETED, failures: ");
+    Serial.print(failures);
+    Serial.println(" ===");
+}
+
+void loop() {
+}
@@ -0,0 +1,49 @@
+// Декодер дампа Serial с кадрами двоичного журнала: текст проходит как есть,
+// кадры превращаются в строки по таблице событий из controller/binlog_events.h.
+//
+//   g++ -O2 -std=c++17 -I controller tools/binlog_decode/binlog_decode.cpp controller/binlog_format.cpp -o binlog_decode
+//   ./binlog_decode serial_dump.bin            (или из stdin)
+
+#include "binlog_format.h"
+#include <stdio.h>
+
+int main(int argc, char** argv) {
+    FILE* in = stdin;
+    if (argc > 1) {
+        in = fopen(argv[1], "rb");
+        if (in == nullptr) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    BinlogFrameParser parser;
+    bool lineOpen = false;          // кадр посреди строки текста - с новой строки
+    unsigned long records = 0, badFrames = 0;
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        switch (parser.feed((uint8_t)c)) {
+            case BinlogFrameParser::TEXT:
+                fputc(c, stdout);
+                lineOpen = (c != '\n');
+                break;
+            case BinlogFrameParser::RECORD: {
+                char line[256];
+                binlog_format_record(parser.record(), line, sizeof(line));
+                if (lineOpen) fputc('\n', stdout);
+                puts(line);
+                lineOpen = false;
+                records++;
+                break;
+            }
+            case BinlogFrameParser::BAD_FRAME:
+                badFrames++;
+                break;
+            case BinlogFrameParser::PENDING:
+                break;
+        }
+    }
+
+    fprintf(stderr, "%lu records, %lu bad frames\n", records, badFrames);
+    return 0;
+}
@@ -0,0 +1,244 @@
+// Перебор настроек WindowConfig в замкнутом контуре: каждая комбинация прогоняется через
+// run_closed_loop() (tests/algotest/closed_loop.h) - контроллер прошивки, комната RoomSim и мотор
+// MotorSim - по всем сценариям улицы, прогоны идут параллельно на пуле с кражей работы (work_pool.h).
+// Строка таблицы печатается, как только комбинация досчитана; в конце - лучшие по средней метрике
+// и скорость в симулированных сутках в секунду.
+//
+//   cmake -S . -B build && cmake --build build -j --target sweep
+//   ./build/sweep                      все комбинации, по 7 суток на сценарий
+//   ./build/sweep --days 3 --limit 200 --threads 8 --csv > sweep.csv
+//   ./build/sweep --scaling --limit 64 скорость на 1, 2, 4... потоках
+//
+// Оценка - по мерке WindowConfig() по умолчанию, а не по конфигу прогона (см. closed_loop.h).
+
+#include "closed_loop.h"
+#include "work_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static const unsigned long DAY_MS = 24UL * 3600000UL;
+
+// сетка ========================================================================================================================//
+
+struct SweepAxis {
+    const char* name;
+    void (*apply)(WindowConfig& config, float value);
+    std::vector<float> values;
+};
+
+// общие для всех режимов
+static const SweepAxis COMMON_AXES[] = {
+    { "margin", [](WindowConfig& c, float v) { c.metricMargin = v; }, { 10.0f, 20.0f, 30.0f } },
+    { "predict", [](WindowConfig& c, float v) { c.predictionTime = v; }, { 60.0f, 180.0f, 600.0f } },
+    { "tmul", [](WindowConfig& c, float v) { c.tempWeightMultiplier = v; }, { 3.0f, 5.0f, 8.0f } },
+    { "co2div", [](WindowConfig& c, float v) { c.co2WeightDivisor = v; }, { 40.0f, 60.0f, 90.0f } },
+};
+
+static const SweepAxis BINARY_AXES[] = {
+    { "open", [](WindowConfig& c, float v) { c.binaryOpenThreshold = v; }, { 20.0f, 30.0f, 45.0f } },
+    { "close", [](WindowConfig& c, float v) { c.binaryCloseThreshold = v; }, { 5.0f, 10.0f } },
+};
+
+static const SweepAxis SHORT_TERM_AXES[] = {
+    { "sens", [](WindowConfig& c, float v) { c.shortTermSensitivity = v; }, { 1.0f, 2.0f, 4.0f } },
+};
+
+static const SweepAxis PREDICTIVE_AXES[] = {
+    { "horizon", [](WindowConfig& c, float v) { c.predictiveHorizon = (unsigned short)v; }, { 10.0f, 15.0f, 30.0f } },
+    { "movecost", [](WindowConfig& c, float v) { c.predictiveMoveCost = v; }, { 0.5f, 1.0f, 2.0f } },
+};
+
+struct Candidate {
+    WindowMode mode;
+    const char* modeName;
+    WindowConfig config;
+    std::string label;          // значения осей
+};
+
+static void add_combinations(std::vector<Candidate>& out, WindowMode mode, const char* modeName,
+                             const std::vector<const SweepAxis*>& axes) {
+    std::vector<size_t> digit(axes.size(), 0);
+    for (;;) {
+        Candidate candidate;
+        candidate.mode = mode;
+        candidate.modeName = modeName;
+        for (size_t i = 0; i < axes.size(); i++) {
+            float value = axes[i]->values[digit[i]];
+            axes[i]->apply(candidate.config, value);
+            char part[32];
+            snprintf(part, sizeof(part), "%s%s=%g", i ? " " : "", axes[i]->name, value);
+            candidate.label += part;
+        }
+        out.push_back(candidate);
+
+        // следующая комбинация - как счетчик с основаниями по числу значений осей
+        size_t i = 0;
+        while (i < axes.size() && ++digit[i] == axes[i]->values.size()) digit[i++] = 0;
+        if (i == axes.size()) return;
+    }
+}
+
+template <size_t N>
+static std::vector<const SweepAxis*> with_axes(const SweepAxis (&extra)[N]) {
+    std::vector<const SweepAxis*> axes;
+    for (const SweepAxis& axis : COMMON_AXES) axes.push_back(&axis);
+    for (const SweepAxis& axis : extra) axes.push_back(&axis);
+    return axes;
+}
+
+static std::vector<Candidate> build_grid() {
+    std::vector<Candidate> grid;
+    std::vector<const SweepAxis*> common;
+    for (const SweepAxis& axis : COMMON_AXES) common.push_back(&axis);
+
+    add_combinations(grid, WindowMode::AUTO, "AUTO", common);
+    add_combinations(grid, WindowMode::BINARY, "BINARY", with_axes(BINARY_AXES));
+    add_combinations(grid, WindowMode::SHORT_TERM, "SHORT_TERM", with_axes(SHORT_TERM_AXES));
+    add_combinations(grid, WindowMode::PREDICTIVE, "PREDICTIVE", with_axes(PREDICTIVE_AXES));
+    return grid;
+}
+
+// сценарии улицы, у всех комбинаций одни и те же
+static const RoomSimConfig SCENARIOS[] = {
+    RoomSimConfig(OutdoorProfile::WINTER, 1),
+    RoomSimConfig(OutdoorProfile::SPRING, 2),
+    RoomSimConfig(OutdoorProfile::SUMMER, 3),
+    RoomSimConfig(OutdoorProfile::HEATWAVE, 4),
+};
+static const int SCENARIO_COUNT = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+static ClosedLoopScore run_candidate(const Candidate& candidate, int days) {
+    ClosedLoopScore total;
+    for (const RoomSimConfig& scenario : SCENARIOS) {
+        ClosedLoopScore score = run_closed_loop(scenario, candidate.config, candidate.mode, days * DAY_MS);
+        total.minutes += score.minutes;
+        total.comfortMinutes += score.comfortMinutes;
+        total.metricSum += score.metricSum;
+        total.co2PpmHours += score.co2PpmHours;
+        total.moves += score.moves;
+        total.travel += score.travel;
+        total.heaterKwh += score.heaterKwh;
+    }
+    return total;
+}
+
+// таблица ======================================================================================================================//
+
+static void print_header(bool csv) {
+    if (csv) {
+        printf("id,mode,params,comfort_percent,mean_metric,co2_ppm_hours,moves,travel_positions\n");
+        return;
+    }
+    printf("%5s  %-10s  %-62s  %7s  %6s  %9s  %5s  %9s\n",
+           "id", "mode", "params", "comfort", "metric", "co2 ppm*h", "moves", "positions");
+}
+
+static void print_row(FILE* out, bool csv, size_t id, const Candidate& candidate, const ClosedLoopScore& score) {
+    const char* format = csv ? "%zu,%s,%s,%.2f,%.3f,%.0f,%lu,%.0f\n"
+                             : "%5zu  %-10s  %-62s  %6.1f%%  %6.2f  %9.0f  %5lu  %9.0f\n";
+    fprintf(out, format, id, candidate.modeName, candidate.label.c_str(), score.comfortPercent(), score.meanMetric(),
+            score.co2PpmHours, score.moves, score.travel);
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// перебор: строки по мере готовности, в конце - лучшие и скорость
+static int sweep(const std::vector<Candidate>& grid, int days, int threads, int top, bool csv) {
+    WorkPool pool(threads);
+    std::vector<ClosedLoopScore> scores(grid.size());
+    std::mutex output;
+
+    print_header(csv);
+    fflush(stdout);
+    auto start = std::chrono::steady_clock::now();
+    pool.run(grid.size(), [&](size_t index, int) {
+        scores[index] = run_candidate(grid[index], days);
+        std::lock_guard<std::mutex> guard(output);
+        print_row(stdout, csv, index, grid[index], scores[index]);
+        fflush(stdout);
+    });
+    double wallS = seconds_since(start);
+    double simulatedDays = (double)grid.size() * SCENARIO_COUNT * days;
+
+    // сводка; при --csv - в stderr, чтобы в stdout остался чистый CSV
+    std::vector<size_t> order(grid.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return scores[a].meanMetric() < scores[b].meanMetric();
+    });
+    FILE* summary = csv ? stderr : stdout;
+    fprintf(summary, "\nBest %d by mean metric:\n", top);
+    for (int i = 0; i < top && i < (int)order.size(); i++) {
+        print_row(summary, false, order[i], grid[order[i]], scores[order[i]]);
+    }
+    fprintf(summary, "%zu runs, %.0f simulated days in %.1f s on %d threads: %.0f days/s, %zu steals\n",
+            grid.size(), simulatedDays, wallS, pool.threads(), simulatedDays / wallS, pool.steals());
+    return 0;
+}
+
+// та же пачка на 1, 2, 4... потоках, без таблицы
+static int scaling(const std::vector<Candidate>& grid, int days, int maxThreads) {
+    std::vector<int> counts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) counts.push_back(threads);
+    counts.push_back(maxThreads);
+
+    double simulatedDays = (double)grid.size() * SCENARIO_COUNT * days;
+    double baseRate = 0.0;
+    printf("%zu runs x %d scenarios x %d days, %d hardware threads\n", grid.size(), SCENARIO_COUNT, days,
+           WorkPool::hardwareThreads());
+    printf("%7s  %8s  %8s  %10s\n", "threads", "seconds", "days/s", "efficiency");
+    for (int threads : counts) {
+        WorkPool pool(threads);
+        auto start = std::chrono::steady_clock::now();
+        pool.run(grid.size(), [&](size_t index, int) { run_candidate(grid[index], days); });
+        double rate = simulatedDays / seconds_since(start);
+        if (threads == 1) baseRate = rate;
+        printf("%7d  %8.2f  %8.0f  %9.0f%%\n", threads, simulatedDays / rate, rate, 100.0 * rate / (baseRate * threads));
+        fflush(stdout);
+    }
+    return 0;
+}
+
+static int usage() {
+    fprintf(stderr, "usage: sweep [--days N] [--threads N] [--limit N] [--top N] [--csv] [--scaling]\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    int days = 7;
+    int threads = 0;
+    int limit = 0;
+    int top = 10;
+    bool csv = false;
+    bool scale = false;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--days") == 0 && hasValue) days = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--limit") == 0 && hasValue) limit = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--top") == 0 && hasValue) top = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--csv") == 0) csv = true;
+        else if (strcmp(argv[i], "--scaling") == 0) scale = true;
+        else return usage();
+    }
+    if (days <= 0) return usage();
+    if (threads <= 0) threads = WorkPool::hardwareThreads();
+
+    std::vector<Candidate> grid = build_grid();
+    if (limit > 0 && (size_t)limit < grid.size()) {
+        // равномерная выборка по всей сетке, а не первые комбинации одного режима
+        std::vector<Candidate> sample;
+        for (int i = 0; i < limit; i++) sample.push_back(grid[grid.size() * i / limit]);
+        grid.swap(sample);
+    }
+
+    return scale ? scaling(grid, days, threads) : sweep(grid, days, threads, top, csv);
+}
@@ -0,0 +1,88 @@
+#include "work_pool.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// отрезок задач потока; по кэш-линии на поток, чтобы свои блокировки не мешали соседям
+struct alignas(64) WorkRange {
+    std::mutex lock;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+WorkPool::WorkPool(int threads) : threadCount(threads > 0 ? threads : hardwareThreads()) {
+}
+
+int WorkPool::hardwareThreads() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? (int)count : 1;
+}
+
+static bool take_own(WorkRange& range, size_t& index) {
+    std::lock_guard<std::mutex> guard(range.lock);
+    if (range.begin >= range.end) return false;
+    index = range.begin++;
+    return true;
+}
+
+// вторая половина остатка самого загруженного соседа - себе; false - красть нечего, работа кончилась
+static bool steal(std::vector<WorkRange>& ranges, int self) {
+    int count = (int)ranges.size();
+    for (;;) {
+        int victim = -1;
+        size_t most = 0;
+        for (int i = 1; i < count; i++) {
+            WorkRange& range = ranges[(self + i) % count];
+            std::lock_guard<std::mutex> guard(range.lock);
+            size_t left = range.end - range.begin;
+            if (left > most) {
+                most = left;
+                victim = (self + i) % count;
+            }
+        }
+        if (victim < 0) return false;
+
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> guard(ranges[victim].lock);
+            size_t left = ranges[victim].end - ranges[victim].begin;
+            if (left == 0) continue;                        // опередил другой вор или сам хозяин
+            end = ranges[victim].end;
+            begin = end - (left + 1) / 2;
+            ranges[victim].end = begin;
+        }
+        // взятое - только у этого потока, пока не ляжет в его отрезок: задача не выполнится дважды
+        std::lock_guard<std::mutex> guard(ranges[self].lock);
+        ranges[self].begin = begin;
+        ranges[self].end = end;
+        return true;
+    }
+}
+
+void WorkPool::run(size_t count, const std::function<void(size_t index, int worker)>& task) {
+    std::vector<WorkRange> ranges(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        ranges[i].begin = count * i / threadCount;
+        ranges[i].end = count * (i + 1) / threadCount;
+    }
+
+    std::atomic<size_t> steals(0);
+    auto worker = [&](int self) {
+        for (;;) {
+            size_t index;
+            if (take_own(ranges[self], index)) {
+                task(index, self);
+                continue;
+            }
+            if (!steal(ranges, self)) return;
+            steals.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threadCount; i++) pool.emplace_back(worker, i);
+    worker(0);                                              // вызывающий поток - тоже рабочий
+    for (std::thread& thread : pool) thread.join();
+    stealCount = steals.load();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+
+// Пул потоков с кражей работы для пачки независимых задач 0..count-1.
+//
+// Номера задач делятся на непрерывные отрезки по потокам. Поток берет задачи с начала своего
+// отрезка, а опустев - крадет у самого загруженного соседа вторую половину его остатка. Прогоны
+// разной длины (PREDICTIVE дороже AUTO) так выравниваются без общей очереди, за которую бились
+// бы все ядра: свой отрезок - под своей блокировкой, чужая трогается только при краже.
+
+class WorkPool {
+public:
+    explicit WorkPool(int threads);     // 0 - по числу ядер
+
+    int threads() const { return threadCount; }
+
+    // task(index, worker) для каждого index из 0..count-1, вернется, когда все выполнены
+    void run(size_t count, const std::function<void(size_t index, int worker)>& task);
+
+    size_t steals() const { return stealCount; }     // краж за последний run()
+
+    static int hardwareThreads();
+
+private:
+    int threadCount;
+    size_t stealCount = 0;
+};